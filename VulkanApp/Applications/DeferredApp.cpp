@@ -1,4 +1,5 @@
 #include "DeferredApp.h"
+#include <random>
 
 DeferredApp::~DeferredApp()
 {
@@ -8,197 +9,81 @@ DeferredApp::~DeferredApp()
 	}
 }
 
-void DeferredApp::draw()
+// Describe the attachments and subpasses, the render targets and render pass are created from this graph
+void DeferredApp::createRenderGraph()
 {
-	auto& previousFrame = mFrames[activeFrameIndex];
+	mRenderGraph = std::make_unique<RenderGraph>(*mDevice);
 
-	// Get next active frame
-	VkSemaphore imageAcquired = previousFrame->requestSemaphore();	// Get a semaphore from the pool of the previous frame
-	VkResult result = mSwapchain->acquireNextImageIndex(imageAcquired, activeFrameIndex);
+	// CREATE ATTACHMENTS
+	// SUBPASS 1 OUTPUT (LIGHTING)
+	// 0 - swapchain image
+	mRenderGraph->addSwapchainAttachment(mSwapchain->format());
 
-	if (result != VK_SUCCESS)
+	// SUBPASS 0 OUTPUT (GEOMETRY PASS)
+	// 1 - Position (unpacked only, the packed layout reconstructs it from depth)
+	if (!mPackedGBuffer)
 	{
-		throw std::runtime_error("Could not acquire next swapchain image!");
+		// Get supported format for position attachment - use higher precision floats
+		mPrecisionFormat = chooseSupportedFormat(
+			{ VK_FORMAT_R32G32B32A32_SFLOAT },
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+		);
+
+		mPositionAttachmentIndex = mRenderGraph->addAttachment(mPrecisionFormat);
 	}
 
-	auto& activeFrame = mFrames[activeFrameIndex];
+	// 2 - Normals
+	mNormalAttachmentIndex = mRenderGraph->addAttachment(mPackedGBuffer ? mPackedNormalFormat : mColourFormat);
 
-	updatePerFrameResources();
+	// 3 - Albedo (+ specular in alpha if packed)
+	mAlbedoAttachmentIndex = mRenderGraph->addAttachment(mColourFormat);
 
-	// Wait until idle then reset command pools + synchronisation objects
-	activeFrame->wait();
-	activeFrame->reset();
-
-	// Request the required synchronisation objects
-	VkSemaphore renderFinished = activeFrame->requestSemaphore();
-	VkFence drawFence = activeFrame->requestFence();
-
-	const Queue& queue = mDevice->queue(mGraphicsQueueFamily, 0);
-
-	CommandBuffer& primaryCmdBuffer = activeFrame->requestCommandBuffer(queue, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-
-	recordCommands(primaryCmdBuffer);		// Only record commands once the image at imageIndex is available (not being used by the queue)
-
-
-	queue.submit(imageAcquired, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, renderFinished,
-		primaryCmdBuffer, drawFence);
-
-	queue.present(renderFinished, *mSwapchain, activeFrameIndex);
-}
-
-// Prepare rendertargets and frames
-void DeferredApp::createRenderTargetAndFrames()
-{
-	//auto& device = mSwapchain->device();
-	auto& swapchainExtent = mSwapchain->extent();
-	VkFormat swapchainFormat = mSwapchain->format();
-	VkImageUsageFlags swapchainUsage = mSwapchain->usage();
-
-	// Get supported format for position attachment - use higher precision floats
-	mPrecisionFormat = chooseSupportedFormat(
-		{ VK_FORMAT_R32G32B32A32_SFLOAT },
-		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-	);	
-	
-	// High precision not required
-	mColourFormat = chooseSupportedFormat(
-		{ VK_FORMAT_R8G8B8A8_UNORM },
-		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-	);
-
-	// Get supported format for depth buffer
-	mDepthFormat = chooseSupportedFormat(
-		{ VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT },
-		VK_IMAGE_TILING_OPTIMAL,
-		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
-
-
-	for (auto& image : mSwapchain->images())
+	// 4 - Specular (unpacked only)
+	if (!mPackedGBuffer)
 	{
-		// IMAGES + RENDERTARGET + RESOURCE REFERENCE
-
-		// SUBPASS 1 OUTPUT (LIGHTING)
-		// 0 - swapchain image
-		Image swapchainImage(*mDevice,
-			image,
-			swapchainExtent,
-			swapchainFormat,
-			swapchainUsage);
-
-		// SUBPASS 0 OUTPUT (GEOMETRY PASS)
-		// 1 - Position
-		mPositionAttachmentIndex = 1;
-		Image positionImage(*mDevice,
-			swapchainExtent,
-			mPrecisionFormat,
-			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		// 2 - Normals
-		mNormalAttachmentIndex = 2;
-		Image normalImage(*mDevice,
-			swapchainExtent,
-			mColourFormat,
-			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		// 3 - Albedo 
-		mAlbedoAttachmentIndex = 3;
-		Image albedoImage(*mDevice,
-			swapchainExtent,
-			mColourFormat,
-			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		// 4 - Specular
-		mSpecularAttachmentIndex = 4;
-		Image specularImage(*mDevice,
-			swapchainExtent,
-			mColourFormat,
-			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		// 5 - Depth
-		mDepthAttachmentIndex = 5;
-		Image depthImage(*mDevice,
-			swapchainExtent,
-			mDepthFormat,
-			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-
-		std::vector<Image> renderTargetImages;
-		renderTargetImages.push_back(std::move(swapchainImage));
-		renderTargetImages.push_back(std::move(positionImage));
-		renderTargetImages.push_back(std::move(normalImage));
-		renderTargetImages.push_back(std::move(albedoImage));
-		renderTargetImages.push_back(std::move(specularImage));
-		renderTargetImages.push_back(std::move(depthImage));
-
-		// Create Render Target + Frame
-		std::unique_ptr<RenderTarget> renderTarget = std::make_unique<RenderTarget>(std::move(renderTargetImages));
-		mFrames.push_back(std::make_unique<Frame>(*mDevice, std::move(renderTarget), mThreadCount));
+		mSpecularAttachmentIndex = mRenderGraph->addAttachment(mColourFormat);
 	}
-}
 
-void DeferredApp::createRenderPass()
-{
-	// Attachment 0 = Swapchain
-	// Attachment 1 = Position
-	// Attachment 2 = Normal
-	// Attachment 3 = Albedo
-	// Attachment 4 = Specular
-	// Attachment 5 = Depth
+	// 5 - Depth
+	mDepthAttachmentIndex = mRenderGraph->addAttachment(mDepthFormat);
 
 	// CREATE SUBPASS OBJECTS
+	// Shader variants are compiled for bindless materials and the packed G-buffer (see compile_shaders.bat)
+	std::string bindless = mBindlessMaterials ? "_bindless" : "";
+	std::string packed = mPackedGBuffer ? "_packed" : "";
+
 	uint32_t subpassCount = 2;
 	mSubpasses.resize(subpassCount);
-	mSubpasses[0] = std::make_unique<Subpass>("Shaders/DeferredApp/geometry_vert.spv", "Shaders/DeferredApp/geometry_frag.spv");
-	mSubpasses[1] = std::make_unique<Subpass>("Shaders/Common/fullscreen_vert.spv", "Shaders/DeferredApp/lighting_frag.spv");
+	mSubpasses[0] = std::make_unique<Subpass>("Shaders/DeferredApp/geometry_vert.spv", "Shaders/DeferredApp/geometry" + bindless + packed + "_frag.spv");
+	mSubpasses[1] = std::make_unique<Subpass>("Shaders/Common/fullscreen_vert.spv", "Shaders/DeferredApp/lighting" + packed + "_frag.spv");
 
 	// Set input and output attachments
 	std::vector<uint32_t> inputAttachments{};
 	std::vector<uint32_t> outputAttachments{};
 	
 	// SUBPASS 0 (GEOMETRY)
-	outputAttachments = { mPositionAttachmentIndex, mNormalAttachmentIndex, mAlbedoAttachmentIndex, mSpecularAttachmentIndex, mDepthAttachmentIndex };
+	outputAttachments = mPackedGBuffer ?
+		std::vector<uint32_t>{ mNormalAttachmentIndex, mAlbedoAttachmentIndex, mDepthAttachmentIndex } :
+		std::vector<uint32_t>{ mPositionAttachmentIndex, mNormalAttachmentIndex, mAlbedoAttachmentIndex, mSpecularAttachmentIndex, mDepthAttachmentIndex };
 	mSubpasses[0]->setOutputAttachments(outputAttachments);
 
 	// SUBPASS 1 (LIGHTING)
-	inputAttachments = outputAttachments;
+	// Depth stays bound as the depth attachment so light volumes can be depth tested
+	// The packed layout also reads it to reconstruct position, the render pass then keeps it in a read only layout
+	inputAttachments = mPackedGBuffer ?
+		std::vector<uint32_t>{ mNormalAttachmentIndex, mAlbedoAttachmentIndex, mDepthAttachmentIndex } :
+		std::vector<uint32_t>{ mPositionAttachmentIndex, mNormalAttachmentIndex, mAlbedoAttachmentIndex, mSpecularAttachmentIndex };
 	mSubpasses[1]->setInputAttachments(inputAttachments);
 
-	// CREATE SUBPASS INFOS
-	std::vector<SubpassInfo> subpassInfos(subpassCount);
+	outputAttachments = { 0, mDepthAttachmentIndex };
+	mSubpasses[1]->setOutputAttachments(outputAttachments);
+	mSubpasses[1]->setCoversFramebuffer(true);
 
-	for (uint32_t i = 0; i < subpassCount; ++i)
-	{
-		subpassInfos[i] = { mSubpasses[i]->inputAttachments(), mSubpasses[i]->outputAttachments() };
-	}
+	// Light volumes are drawn in subpass 1 after the fullscreen pass
+	mLightVolumeSubpass = std::make_unique<Subpass>("Shaders/DeferredApp/light_volume_vert.spv", "Shaders/DeferredApp/light_volume" + packed + "_frag.spv");
 
-	// CREATE LOAD/STORE INFOS FOR ATTACHMENTS
-	std::vector<LoadStoreInfo> loadStoreInfos = {};
-
-	// Swapchain load/store
-	loadStoreInfos.push_back({ VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE });
-	// Position load/store
-	loadStoreInfos.push_back({ VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE });
-	// Normal load/store
-	loadStoreInfos.push_back({ VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE });
-	// Albedo load/store
-	loadStoreInfos.push_back({ VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE });
-	// specular load / store
-	loadStoreInfos.push_back({ VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE });
-	// Depth load/store
-	loadStoreInfos.push_back({ VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE });
-
-	// CREATE RENDERPASS OBJECT
-	mRenderPass = std::make_unique<RenderPass>(*mDevice,
-		mFrames.back()->renderTarget().attachments(),
-		subpassInfos,
-		loadStoreInfos);
+	mRenderGraph->compile(mSubpasses);
 }
 
 // Create layouts which will be updated at most once per frame
@@ -219,7 +104,7 @@ void DeferredApp::createPerFrameDescriptorSetLayouts()
 
 	// Pipeline 1
 	// INPUT ATTACHMENTS
-	for (uint32_t i = 0; i < mSubpasses[1]->inputAttachments().size() - 1; ++i)
+	for (uint32_t i = 0; i < mSubpasses[1]->inputAttachments().size(); ++i)
 	{
 		ShaderResource attachment(i,
 			VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT,
@@ -229,14 +114,31 @@ void DeferredApp::createPerFrameDescriptorSetLayouts()
 		pipelineResources[1].push_back(std::move(attachment));
 	}
 
+	// STORAGE BUFFERS
+	// Lights buffer - light volumes are sized in the vertex shader
+	ShaderResource lightBuffer(4,
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		1,
+		VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+
+	pipelineResources[1].push_back(std::move(lightBuffer));
+
+	// Light cluster buffer
+	ShaderResource clusterBuffer(5,
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		1,
+		VK_SHADER_STAGE_FRAGMENT_BIT);
+
+	pipelineResources[1].push_back(std::move(clusterBuffer));
+
 	// UNIFORM BUFFERS
-	// Lights buffer
-	ShaderResource lightBuffer(pipelineResources[1].size(),
+	// VP buffer - view depth selects the cluster, light volumes are projected to the screen
+	ShaderResource vpBuffer_lights(6,
 		VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
 		1,
-		VK_SHADER_STAGE_FRAGMENT_BIT);
+		VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
 
-	pipelineResources[1].push_back(std::move(lightBuffer));
+	pipelineResources[1].push_back(std::move(vpBuffer_lights));
 
 	// Create sets in frame objects
 	for (auto& frame : mFrames)
@@ -253,61 +155,75 @@ void DeferredApp::createPipelines()
 {
 	mPipelineLayouts.resize(mSubpasses.size());
 	mPipelines.resize(mSubpasses.size());
-	std::vector<std::vector<ShaderModule>> shaderModules(mSubpasses.size());
 
-	// PIPELINE 0
-	// CREATE SHADER MODULES
-	std::vector<char> vertexCode = readFile(mSubpasses[0]->vertexShaderSource());
-	shaderModules[0].emplace_back(*mDevice,
-		vertexCode,
-		VK_SHADER_STAGE_VERTEX_BIT);
-
-	std::vector<char> fragCode = readFile(mSubpasses[0]->fragmentShaderSource());
-	shaderModules[0].emplace_back(*mDevice,
-		fragCode,
-		VK_SHADER_STAGE_FRAGMENT_BIT);
+	// SPECIALIZATION CONSTANTS
+	// LIGHTING - clip planes and light cluster grid
+	SpecializationConstants lightingConstants;
+	lightingConstants.set(SPECIALIZATION_Z_NEAR, mNearPlane);
+	lightingConstants.set(SPECIALIZATION_Z_FAR, mFarPlane);
+	LightClusters::setSpecializationConstants(lightingConstants);
+	lightingConstants.set(SPECIALIZATION_CLUSTERED_LIGHTING, static_cast<VkBool32>(!mLightVolumes));
+	mSubpasses[1]->setFragmentSpecializationConstants(lightingConstants);
+
+	// LIGHT VOLUMES - near plane decides when a light's quad must cover the screen, clip planes linearise depth
+	SpecializationConstants lightVolumeConstants;
+	lightVolumeConstants.set(SPECIALIZATION_Z_NEAR, mNearPlane);
+	lightVolumeConstants.set(SPECIALIZATION_Z_FAR, mFarPlane);
+	mLightVolumeSubpass->setVertexSpecializationConstants(lightVolumeConstants);
+	mLightVolumeSubpass->setFragmentSpecializationConstants(lightVolumeConstants);
 
+	// PIPELINE 0
 	// CREATE PIPELINE LAYOUT
 	std::vector<std::reference_wrapper<const DescriptorSetLayout>> descriptorSetLayouts = { mFrames[0]->descriptorSetLayout(0) , *mPerMaterialDescriptorSetLayout };
 
 	mPipelineLayouts[0] = std::make_unique<PipelineLayout>(*mDevice, descriptorSetLayouts, mPushConstantRange);
 
 	// CREATE PIPELINE
-	mPipelines[0] = std::make_unique<GraphicsPipeline>(*mDevice,
-				shaderModules[0],
-				*mSwapchain,
-				*mPipelineLayouts[0],
-				*mRenderPass,
-				0,
-				VK_TRUE,
-				VK_TRUE);
+	// G-buffer outputs are opaque so blending stays off on every attachment
+	PipelineState geometryState;
+	geometryState.setVertexInputState(PipelineState::meshVertexInputState());
+	createPipelineAsync(0, geometryState);
 
 	// PIPELINE 1
-	// CREATE SHADER MODULES
-	vertexCode = readFile(mSubpasses[1]->vertexShaderSource());
-	shaderModules[1].emplace_back(*mDevice,
-		vertexCode,
-		VK_SHADER_STAGE_VERTEX_BIT);
-
-	fragCode = readFile(mSubpasses[1]->fragmentShaderSource());
-	shaderModules[1].emplace_back(*mDevice,
-		fragCode,
-		VK_SHADER_STAGE_FRAGMENT_BIT);
-
 	// CREATE PIPELINE LAYOUT
 	descriptorSetLayouts = { mFrames[0]->descriptorSetLayout(1) };
 
 	mPipelineLayouts[1] = std::make_unique<PipelineLayout>(*mDevice, descriptorSetLayouts);
 
 	// CREATE PIPELINE
-	mPipelines[1] = std::make_unique<GraphicsPipeline>(*mDevice,
-		shaderModules[1],
-		*mSwapchain,
-		*mPipelineLayouts[1],
-		*mRenderPass,
-		1,
-		VK_FALSE,
-		VK_FALSE);
+	createPipelineAsync(1, PipelineState::fullscreen());
+
+	// LIGHT VOLUME PIPELINE (SUBPASS 1)
+	// Shares the lighting layout, each light adds its contribution on top of the fullscreen pass
+	if (mLightVolumes)
+	{
+		PipelineState lightVolumeState;
+
+		// Quads are built in the vertex shader and may be wound either way
+		RasterizationState rasterizationState;
+		rasterizationState.cullMode = VK_CULL_MODE_NONE;
+		lightVolumeState.setRasterizationState(rasterizationState);
+
+		// Quads sit at the front of the light's range so geometry in front of the light fails the depth test
+		DepthStencilState depthStencilState;
+		depthStencilState.depthWriteEnable = VK_FALSE;
+		depthStencilState.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+		lightVolumeState.setDepthStencilState(depthStencilState);
+
+		ColourBlendAttachmentState additiveBlend;
+		additiveBlend.blendEnable = VK_TRUE;
+		additiveBlend.dstColourBlendFactor = VK_BLEND_FACTOR_ONE;
+		additiveBlend.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		lightVolumeState.setColourBlendAttachmentState(0, additiveBlend);
+
+		mJobSystem->submit([this, lightVolumeState](size_t threadIndex) {
+			mLightVolumePipeline = &mPipelineRegistry->request(*mLightVolumeSubpass,
+				*mPipelineLayouts[1],
+				*mRenderPass,
+				1,
+				lightVolumeState);
+			}, mPipelineCounter);
+	}
 }
 
 void DeferredApp::createPerFrameResources()
@@ -316,28 +232,31 @@ void DeferredApp::createPerFrameResources()
 
 	// Buffer sizes
 	VkDeviceSize vpBufferSize = sizeof(uboVP);
-	VkDeviceSize lightBufferSize = sizeof(uboLights);
 
-	// Create uniform buffers
-	for (size_t i = 0; i < static_cast<size_t>(mSwapchain->details().imageCount); ++i)
+	// Create uniform buffers for each frame in flight
+	for (size_t i = 0; i < mFrames.size(); ++i)
 	{
 		mVPBufferIndex = mFrames[i]->createBuffer(vpBufferSize,
 			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-		mLightBufferIndex = mFrames[i]->createBuffer(lightBufferSize,
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 	}
 
 	createLights();
+
+	// Light buffers + clusters for each frame in flight, the culling pipeline compiles alongside the subpass pipelines
+	mLightClusters = std::make_unique<LightClusters>(*mDevice, static_cast<uint32_t>(mFrames.size()), mPointLightCount, mNearPlane, mFarPlane);
+
+	mJobSystem->submit([this](size_t threadIndex) {
+		mLightClusters->createPipeline();
+		}, mPipelineCounter);
 }
 
 void DeferredApp::createPerFrameDescriptorSets()
 {
-
-	for (size_t i = 0; i < static_cast<size_t>(mSwapchain->imageCount()); ++i)
+	for (uint32_t frameIndex = 0; frameIndex < mFrames.size(); ++frameIndex)
 	{
+		auto& frame = mFrames[frameIndex];
+
 		BindingMap<uint32_t> bufferIndices{};
 		BindingMap<uint32_t> imageIndices{};
 
@@ -346,25 +265,38 @@ void DeferredApp::createPerFrameDescriptorSets()
 		bufferIndices[0][0] = mVPBufferIndex;
 
 		// - DESCRIPTOR SET
-		mFrames[i]->createDescriptorSet(0, imageIndices, bufferIndices);
+		frame->createDescriptorSet(0, *mRenderTargets[0], imageIndices, bufferIndices);
 
 		bufferIndices.clear();
 		imageIndices.clear();
 
 		// PIPELINE 1
-		// - BINDING MAP TO PER FRAME BUFFERS
-		imageIndices[0][0] = mPositionAttachmentIndex;
-		imageIndices[1][0] = mNormalAttachmentIndex;
-		imageIndices[2][0] = mAlbedoAttachmentIndex;
-		imageIndices[3][0] = mSpecularAttachmentIndex;
+		// - DESCRIPTOR SET (one per render target)
+		// Light buffers are owned by the light clusters so are bound through a resource reference
+		auto& lightBuffer = mLightClusters->lightBuffer(frameIndex);
+		auto& clusterBuffer = mLightClusters->clusterBuffer(frameIndex);
 
-		bufferIndices[4][0] = mLightBufferIndex;
+		for (uint32_t target = 0; target < mRenderTargets.size(); ++target)
+		{
+			auto& targetImages = mRenderTargets[target]->imageViews();
 
-		// - DESCRIPTOR SET
-		mFrames[i]->createDescriptorSet(1, imageIndices, bufferIndices);
+			// Input attachments are bound in subpass order from binding 0
+			DescriptorResourceReference descriptorSetResourceReference;
+			auto lightingInputs = mSubpasses[1]->inputAttachments();
+			for (uint32_t i = 0; i < lightingInputs.size(); ++i)
+			{
+				descriptorSetResourceReference.bindInputImage(targetImages[lightingInputs[i]], i, 0);
+			}
 
-		bufferIndices.clear();
-		imageIndices.clear();
+			descriptorSetResourceReference.bindBuffer(lightBuffer, 0, lightBuffer.size(), 4, 0);
+			descriptorSetResourceReference.bindBuffer(clusterBuffer, 0, clusterBuffer.size(), 5, 0);
+
+			bufferIndices[6][0] = mVPBufferIndex;
+
+			frame->createDescriptorSet(1, descriptorSetResourceReference, bufferIndices, target);
+
+			bufferIndices.clear();
+		}
 	}
 }
 
@@ -377,17 +309,33 @@ void DeferredApp::updatePerFrameResources()
 
 	// Set light values
 	// - Point lights
-	mLights.pointLights[0].position.x = 100 * sin(sumTime);
-	mLights.pointLights[2].position.x = -100 * sin(sumTime);
+	// The first lights sweep across the scene, the remaining lights bob around their origins
+	const float sweepDistance[MAX_POINT_LIGHTS] = { 100.0f, 0.0f, -100.0f };
+	for (uint32_t i = 0; i < mLightManager.pointLightCount(); ++i)
+	{
+		glm::vec4 offset = i < MAX_POINT_LIGHTS ?
+			glm::vec4(sweepDistance[i] * sin(sumTime), 0.0f, 0.0f, 0.0f) :
+			glm::vec4(0.0f, 5.0f * sin(sumTime + i), 0.0f, 0.0f);
 
-	// - Flash light
-	glm::mat4 invView = glm::inverse(mCameraMatrices.V);	// Get invView to transform from view to world space
-	mLights.flashLight.position = invView * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);		// Flash light position is camera position ((0, 0, 0) in view space)
-	mLights.flashLight.direction = invView * glm::vec4(0.0f, 0.0f, -1.0f, 0.0f);	// Flash light position is camera direction ((0, 0, -1) in view space)
+		mLightManager.setPosition(i, glm::vec3(mPointLightOrigins[i] + offset));
+	}
 
 	// Update buffers
+	// Only lights intersecting the view frustum are uploaded, their positions are transformed to view space as they are culled
+	// Note that flashlight pos and dir are already in view space so no conversion is necessary
 	mFrames[activeFrameIndex]->updateBuffer(mVPBufferIndex, mCameraMatrices);
-	mFrames[activeFrameIndex]->updateBuffer(mLightBufferIndex, mLights);
+	mLightManager.update(mCameraMatrices.V, mCameraMatrices.P);
+	mLightClusters->updateLights(activeFrameIndex, mFlashLight, mLightManager.visibleLights());
+}
+
+void DeferredApp::setPointLightCount(uint32_t pointLightCount)
+{
+	mPointLightCount = pointLightCount;
+}
+
+void DeferredApp::setLightVolumes(bool lightVolumes)
+{
+	mLightVolumes = lightVolumes;
 }
 
 // Set required extensions + features
@@ -403,143 +351,130 @@ void DeferredApp::getRequiredExtenstionAndFeatures(std::vector<const char*>& req
 
 void DeferredApp::createLights()
 {
-	// Point Light identical starting positions + intensity
-	for (auto& pointLight : mLights.pointLights)
+	mLightManager.clear();
+	mLightManager.reserve(mPointLightCount);
+	mPointLightOrigins.resize(mPointLightCount);
+
+	// First point lights have identical starting positions + intensity
+	const glm::vec4 colours[MAX_POINT_LIGHTS] = {
+		glm::vec4(1.0, 0.5, 0.5, 1.0),
+		glm::vec4(0.5, 1.0, 0.5, 1.0),
+		glm::vec4(0.5, 0.5, 1.0, 1.0) };
+
+	for (uint32_t i = 0; i < std::min(mPointLightCount, MAX_POINT_LIGHTS); ++i)
 	{
+		PointLight pointLight;
+
 		// Position + intensity
-		pointLight.position.x = 0.0f;
-		pointLight.position.y = 30.0f;
-		pointLight.position.z = 0.0f;
+		mPointLightOrigins[i] = glm::vec4(0.0f, 30.0f, 0.0f, 1.0f);
+		pointLight.position = mPointLightOrigins[i];
 		pointLight.intensityAndAttenuation.x = 50.0f;
 
 		// Attenuation constants
 		pointLight.intensityAndAttenuation.y = 0.07f;	// Kq
 		pointLight.intensityAndAttenuation.z = 0.14f;	// Kl
 		pointLight.intensityAndAttenuation.w = 1.0f;	// Kc
+
+		// Colours
+		pointLight.colour = colours[i];
+
+		mLightManager.addPointLight(pointLight);
+	}
+
+	// Remaining point lights are small, randomly coloured and scattered through the scene
+	std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+	std::default_random_engine generator;
+
+	for (uint32_t i = MAX_POINT_LIGHTS; i < mPointLightCount; ++i)
+	{
+		PointLight pointLight;
+
+		mPointLightOrigins[i] = glm::vec4(
+			distribution(generator) * 240.0f - 120.0f,
+			distribution(generator) * 75.0f + 5.0f,
+			distribution(generator) * 90.0f - 45.0f,
+			1.0f);
+		pointLight.position = mPointLightOrigins[i];
+		pointLight.intensityAndAttenuation = glm::vec4(10.0f, 1.0f, 0.35f, 1.0f);
+		pointLight.colour = glm::vec4(distribution(generator), distribution(generator), distribution(generator), 1.0f);
+
+		mLightManager.addPointLight(pointLight);
 	}
-	// Colours
-	mLights.pointLights[0].colour = glm::vec4(1.0, 0.5, 0.5, 1.0);
-	mLights.pointLights[1].colour = glm::vec4(0.5, 1.0, 0.5, 1.0);
-	mLights.pointLights[2].colour = glm::vec4(0.5, 0.5, 1.0, 1.0);
 
 	// Flash Light
 	// Position and direction always the same since can be taken from view space
 	// e.g. position will always be (0,0,0) and direction will be (0,0,-1)
-	mLights.flashLight.position = glm::vec4(0.0);
-	mLights.flashLight.direction = glm::vec4(0.0, 0.0, -1.0, 0.0);
-	mLights.flashLight.intensityAndAttenuation = glm::vec4(75.0f, 0.07f, 0.14f, 1.0f);
-	mLights.flashLight.colour = glm::vec4(1.0);
+	mFlashLight.position = glm::vec4(0.0);
+	mFlashLight.direction = glm::vec4(0.0, 0.0, -1.0, 0.0);
+	mFlashLight.intensityAndAttenuation = glm::vec4(75.0f, 0.07f, 0.14f, 1.0f);
+	mFlashLight.colour = glm::vec4(1.0);
 
-	mLights.flashLight.innerCutOff = cos(glm::radians(20.0f)); // This should set an overall cone of 40 degrees
-	mLights.flashLight.outerCutOff = cos(glm::radians(30.0f)); // This should set an overall cone of 60 degrees
+	mFlashLight.innerCutOff = cos(glm::radians(20.0f)); // This should set an overall cone of 40 degrees
+	mFlashLight.outerCutOff = cos(glm::radians(30.0f)); // This should set an overall cone of 60 degrees
 
 }
 
 void DeferredApp::recordCommands(CommandBuffer& primaryCmdBuffer) // Current image is swapchain index
 {
 	auto& frame = mFrames[activeFrameIndex];
-	auto& framebuffer = mFramebuffers[activeFrameIndex];
+	auto& renderTarget = *mRenderTargets[activeImageIndex];
+	auto& framebuffer = mFramebuffers[activeImageIndex];
 
 	primaryCmdBuffer.beginRecording();
 
-	// Set all clear values
-	std::vector<VkClearValue> clearValues;
-	clearValues.resize(frame->renderTarget().imageViews().size());
-
-	// All but the last render target are colour attachments
-	for (size_t i = 0; i < clearValues.size(); ++i)
+	// LIGHT CULLING
+	// Lights are uploaded in view space, light volumes do not read the clusters
+	if (!mLightVolumes)
 	{
-		clearValues[i].color = { 0.0f, 0.0f, 0.0f, 0.0f };
-		
+		mLightClusters->recordCulling(primaryCmdBuffer, activeFrameIndex, mCameraMatrices.P, glm::mat4(1.0f));
 	}
-	// Final attachment is depth attachment
-	clearValues.back().depthStencil.depth = 1.0f;
-
 
-	//clearValue.depthStencil.depth = 1.0f;
 	// BEGIN RENDERPASS / SUBPASS 0
-	primaryCmdBuffer.beginRenderPass(frame->renderTarget(),
+	primaryCmdBuffer.beginRenderPass(renderTarget,
 		*mRenderPass,
 		*framebuffer,
-		clearValues,
+		mRenderGraph->clearValues(),
 		VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-	// Split meshes to draw equally between threads
-	// Create vector of references to meshes
-	std::vector<std::reference_wrapper<Mesh>> meshList;
-	for (auto& model : mModelList)
-	{
-		for (size_t i = 0; i < model.meshCount(); ++i)
-		{
-			meshList.push_back(model.mesh(i));
-		}
-	}
-
-	uint32_t meshCount = static_cast<uint32_t>(meshList.size());
-	float avgMeshesPerBuffer = static_cast<float>(meshCount) / mThreadCount;
-	uint32_t remainderMeshes;
-
-	uint32_t meshesPerBuffer = static_cast<uint32_t> (std::floor(avgMeshesPerBuffer));
-	if (meshesPerBuffer == 0)
-	{
-		remainderMeshes = meshCount;
-	}
-	else
-	{
-		remainderMeshes = meshCount % meshesPerBuffer;
-	}
-
-	uint32_t meshStart = 0;
+	// Split the draw list into one batch per thread and record each batch to a secondary command buffer
+	uint32_t meshCount = static_cast<uint32_t>(mDrawList.size());
+	uint32_t meshesPerBuffer = std::max<uint32_t>(1, (meshCount + mThreadCount - 1) / mThreadCount);
 
-	// Vector for results of tasks pushed to threadpool
-	std::vector<std::future<CommandBuffer*>> futureSecondaryCommandBuffers;
+	std::vector<CommandBuffer*> secondaryCommandBufferPtrs((meshCount + meshesPerBuffer - 1) / meshesPerBuffer);
 
-	for (uint32_t i = 0; i < mThreadCount; ++i)
-	{
-		// Get the end index for the last mesh which will be handled by this buffer
-		uint32_t meshEnd = std::min(meshCount, meshStart + meshesPerBuffer);
-
-		// If there are still remainder draws then add a draw to this command buffer
-		// Latter command buffers may contain fewer draws
-		if (remainderMeshes > 0)
-		{
-			meshEnd++;
-			remainderMeshes--;
-		}
+	mJobSystem->parallelFor(meshCount, meshesPerBuffer, [&](uint32_t meshStart, uint32_t meshEnd, size_t threadIndex) {
+		secondaryCommandBufferPtrs[meshStart / meshesPerBuffer] = recordSecondaryCommandBuffers(&primaryCmdBuffer, mDrawList, meshStart, meshEnd, threadIndex);
+		});
 
-		// Push lambda function to threadpool for running
-		auto futureResult = mThreadPool.push([=, &primaryCmdBuffer](size_t threadIndex) {
-			return recordSecondaryCommandBuffers(&primaryCmdBuffer, meshList, meshStart, meshEnd, threadIndex);
-			});
-
-		futureSecondaryCommandBuffers.push_back(std::move(futureResult));
-
-		meshStart = meshEnd;
-	}
-
-	std::vector<CommandBuffer* > secondaryCommandBufferPtrs;
-
-	for (auto& fut : futureSecondaryCommandBuffers)
+	// Submit the secondary command buffers to the primary command buffer.
+	if (!secondaryCommandBufferPtrs.empty())
 	{
-		secondaryCommandBufferPtrs.push_back(fut.get());
+		primaryCmdBuffer.executeCommands(secondaryCommandBufferPtrs);
 	}
 
-	// Submit the secondary command buffers to the primary command buffer.
-	primaryCmdBuffer.executeCommands(secondaryCommandBufferPtrs);
-
 	// START SUBPASS 1
 	// (Draw single triangle and render lighting)
 	primaryCmdBuffer.nextSubpass(VK_SUBPASS_CONTENTS_INLINE);
 
 	primaryCmdBuffer.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelines[1]);
+	setViewportAndScissor(primaryCmdBuffer);
 
-	std::vector<std::reference_wrapper<const DescriptorSet>> descriptorGroup{ frame->descriptorSet(1) };
+	std::vector<std::reference_wrapper<const DescriptorSet>> descriptorGroup{ frame->descriptorSet(1, activeImageIndex) };
 
 	primaryCmdBuffer.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelineLayouts[1],
 		0, descriptorGroup);
 
 	primaryCmdBuffer.draw(3, 1, 0, 0);
 
+	// Draw one quad per visible point light, same descriptor set as the fullscreen pass
+	// Lights have been culled and uploaded for this frame before recording, the upload is clamped to the light buffer size
+	uint32_t lightVolumeCount = std::min(mLightManager.visibleLightCount(), mLightClusters->maxPointLights());
+	if (mLightVolumes && lightVolumeCount > 0)
+	{
+		primaryCmdBuffer.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, *mLightVolumePipeline);
+		primaryCmdBuffer.draw(6, lightVolumeCount, 0, 0);
+	}
+
 	// End Render Pass
 	primaryCmdBuffer.endRenderPass();
 
@@ -549,7 +484,7 @@ void DeferredApp::recordCommands(CommandBuffer& primaryCmdBuffer) // Current ima
 }
 
 
-CommandBuffer* DeferredApp::recordSecondaryCommandBuffers(CommandBuffer* primaryCommandBuffer, std::vector<std::reference_wrapper<Mesh>> meshList, uint32_t meshStart, uint32_t meshEnd, size_t threadIndex)
+CommandBuffer* DeferredApp::recordSecondaryCommandBuffers(CommandBuffer* primaryCommandBuffer, const std::vector<std::reference_wrapper<Mesh>>& meshList, uint32_t meshStart, uint32_t meshEnd, size_t threadIndex)
 {
 	auto& frame = mFrames[activeFrameIndex];
 
@@ -561,15 +496,26 @@ CommandBuffer* DeferredApp::recordSecondaryCommandBuffers(CommandBuffer* primary
 		| VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, primaryCommandBuffer);
 
 	cmdBuffer.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelines[0]);
+	setViewportAndScissor(cmdBuffer);
+
+	// Bindless materials are all held in one set so descriptor sets are only bound once
+	if (mBindlessMaterials)
+	{
+		std::vector<std::reference_wrapper<const DescriptorSet>> descriptorSetGroup{ frame->descriptorSet(0), *mBindlessDescriptorSet };
+
+		cmdBuffer.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelineLayouts[0],
+			0, descriptorSetGroup);
+	}
 
 	for (uint32_t i = meshStart; i < meshEnd; ++i)
 	{
 		Mesh& thisMesh = meshList[i];
 
-		// "Push" constants to given shader stage directly
+		// "Push" constants to given shader stages directly
+		DrawPushConstant drawPushConstant{ thisMesh.model(), thisMesh.materialID() };
 		cmdBuffer.pushConstant(*mPipelineLayouts[0],
-			VK_SHADER_STAGE_VERTEX_BIT,
-			thisMesh.model());
+			mPushConstantRange.stageFlags,
+			drawPushConstant);
 
 		std::vector<std::reference_wrapper<const Buffer>> vertexBuffers{ thisMesh.vertexBuffer() };	// Buffers to bind
 		std::vector<VkDeviceSize> offsets{ 0 };														// Offsets into buffers being bound
@@ -577,11 +523,14 @@ CommandBuffer* DeferredApp::recordSecondaryCommandBuffers(CommandBuffer* primary
 
 		cmdBuffer.bindIndexBuffer(thisMesh.indexBuffer(), 0, VK_INDEX_TYPE_UINT32);
 
-		std::vector<std::reference_wrapper<const DescriptorSet>> descriptorSetGroup{ frame->descriptorSet(0, threadIndex),
-			*mPerMaterialDescriptorSets[thisMesh.materialID()] };
+		if (!mBindlessMaterials)
+		{
+			std::vector<std::reference_wrapper<const DescriptorSet>> descriptorSetGroup{ frame->descriptorSet(0),
+				*mPerMaterialDescriptorSets[thisMesh.materialID()] };
 
-		cmdBuffer.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelineLayouts[0],
-			0, descriptorSetGroup);
+			cmdBuffer.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelineLayouts[0],
+				0, descriptorSetGroup);
+		}
 
 		// Execute pipeline
 		cmdBuffer.drawIndexed(thisMesh.indexCount(), 1, 0, 0, 0);
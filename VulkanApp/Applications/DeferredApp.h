@@ -7,11 +7,15 @@ public:
 	DeferredApp() = default;
 	~DeferredApp();
 
-	virtual void draw();
+	// - Setters
+	// Number of point lights in the scene, the first MAX_POINT_LIGHTS sweep across the scene and the rest are scattered, must be set before init
+	void setPointLightCount(uint32_t pointLightCount);
+	// Shade point lights with instanced light volumes instead of clustered light lists, must be set before init
+	void setLightVolumes(bool lightVolumes);
+
 private:
 	// Variables
 	uint32_t mVPBufferIndex{ 0 };
-	uint32_t mLightBufferIndex{ 0 };
 
 	// RENDERPASS 0
 	// Subpass attachment indices
@@ -27,16 +31,21 @@ private:
 	float lastTime{ 0.0f };
 	float sumTime{ 0.0f };
 
-	// Buffer compositions
-	struct uboLights {
-		PointLight pointLights[3];
-		SpotLight flashLight;	// Note that flashlight contains view position which will be used for lighting calculations
-	} mLights;
+	// Lights
+	uint32_t mPointLightCount{ MAX_POINT_LIGHTS };
+	bool mLightVolumes{ false };					// Point lights are drawn as screen space quads bounding their range
+	LightManager mLightManager;					// World space point lights, the visible lights are uploaded in view space
+	std::vector<glm::vec4> mPointLightOrigins;		// Positions the point lights are animated around
+	SpotLight mFlashLight;							// Note that flashlight contains view position which will be used for lighting calculations
+
+	// SUBPASS 1
+	std::unique_ptr<LightClusters> mLightClusters;		// Light buffer + light lists for each view space cluster
+	std::unique_ptr<Subpass> mLightVolumeSubpass;		// Light volume shaders, drawn in subpass 1 after the fullscreen lighting
+	GraphicsPipeline* mLightVolumePipeline{ nullptr };
 
 	// Functions
 	// - Create Functions
-	virtual void createRenderTargetAndFrames();
-	virtual void createRenderPass();
+	virtual void createRenderGraph();
 	virtual void createPerFrameDescriptorSetLayouts();
 	virtual void createPipelines();
 	virtual void createPerFrameResources();
@@ -50,9 +59,9 @@ private:
 	void createLights();
 
 	// - Record Functions
-	void recordCommands(CommandBuffer & primaryCmdBuffer);
+	virtual void recordCommands(CommandBuffer& primaryCmdBuffer);
 	CommandBuffer* recordSecondaryCommandBuffers(CommandBuffer * primaryCommandBuffer,
-		std::vector<std::reference_wrapper<Mesh>> meshList,
+		const std::vector<std::reference_wrapper<Mesh>>& meshList,
 		uint32_t meshStart,
 		uint32_t meshEnd,
 		size_t threadIndex);
@@ -1,4 +1,5 @@
 #include "ForwardApp.h"
+#include <random>
 
 ForwardApp::~ForwardApp()
 {
@@ -8,178 +9,90 @@ ForwardApp::~ForwardApp()
 	}
 }
 
-void ForwardApp::draw()
+// Describe the attachments and subpasses, the render targets and render pass are created from this graph
+void ForwardApp::createRenderGraph()
 {
-	auto& previousFrame = mFrames[activeFrameIndex];
+	mRenderGraph = std::make_unique<RenderGraph>(*mDevice);
 
-	VkSemaphore imageAcquired = previousFrame->requestSemaphore();
+	// CREATE ATTACHMENTS
+	// 0 - swapchain image
+	mRenderGraph->addSwapchainAttachment(mSwapchain->format());
 
-	// TODO : get this semaphore form previous frame
-	// Get next active frame
-	VkResult result = mSwapchain->acquireNextImageIndex(imageAcquired, activeFrameIndex);
+	// 1 - colour image
+	mColourAttachmentIndex = mRenderGraph->addAttachment(mColourFormat);
 
-	if (result != VK_SUCCESS)
-	{
-		throw std::runtime_error("Could not acquire next swapchain image!");
-	}
-
-	auto& activeFrame = mFrames[activeFrameIndex];
-
-	updatePerFrameResources();
-
-	// Wait until idle then reset command pools + synchronisation objects
-	activeFrame->wait();
-	activeFrame->reset();
-
-	// Request the required synchronisation objects
-	VkSemaphore renderFinished = activeFrame->requestSemaphore();
-	VkFence drawFence = activeFrame->requestFence();
-
-	const Queue& queue = mDevice->queue(mGraphicsQueueFamily, 0);
-
-	CommandBuffer& primaryCmdBuffer = activeFrame->requestCommandBuffer(queue, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-
-	recordCommands(primaryCmdBuffer);		// Only record commands once the image at imageIndex is available (not being used by the queue)
-
-
-	queue.submit(imageAcquired, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, renderFinished,
-		primaryCmdBuffer, drawFence);
-
-	queue.present(renderFinished, *mSwapchain, activeFrameIndex);
-}
-
-// Prepare rendertargets and frames
-void ForwardApp::createRenderTargetAndFrames()
-{
-	//auto& device = mSwapchain->device();
-	auto& swapchainExtent = mSwapchain->extent();
-	VkFormat swapchainFormat = mSwapchain->format();
-	VkImageUsageFlags swapchainUsage = mSwapchain->usage();
-
-	// Get supported format for colour attachment
-	mColourFormat = chooseSupportedFormat(
-		{ VK_FORMAT_R8G8B8A8_UNORM },
-		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-	);
-
-	// Get supported format for depth buffer
-	mDepthFormat = chooseSupportedFormat(
-		{ VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT },
-		VK_IMAGE_TILING_OPTIMAL,
-		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
-
-	for (auto& image : mSwapchain->images())
-	{
-		// IMAGES + RENDERTARGET + RESOURCE REFERENCE
-
-		// 0 - swapchain image
-		Image swapchainImage(*mDevice,
-			image,
-			swapchainExtent,
-			swapchainFormat,
-			swapchainUsage);
-
-		// 1 - colour image
-		mColourAttachmentIndex = 1;
-		Image colourImage(*mDevice,
-			swapchainExtent,
-			mColourFormat,
-			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		// 2 - depth image
-		mDepthAttachmentIndex = 2;
-		Image depthImage(*mDevice,
-			swapchainExtent,
-			mDepthFormat,
-			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-
-		std::vector<Image> renderTargetImages;
-		renderTargetImages.push_back(std::move(swapchainImage));
-		renderTargetImages.push_back(std::move(colourImage));
-		renderTargetImages.push_back(std::move(depthImage));
-
-		// Create Render Target + Frame
-		std::unique_ptr<RenderTarget> renderTarget = std::make_unique<RenderTarget>(std::move(renderTargetImages));
-		mFrames.push_back(std::make_unique<Frame>(*mDevice, std::move(renderTarget), mThreadCount));
-	}
-}
+	VkClearValue colourClearValue = {};
+	colourClearValue.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+	mRenderGraph->setClearValue(mColourAttachmentIndex, colourClearValue);
 
-void ForwardApp::createRenderPass()
-{
-	// Attachment 0 = Swapchain
-	// Attachment 1 = Colour
-	// Attachment 2 = Depth
+	// 2 - depth image
+	mDepthAttachmentIndex = mRenderGraph->addAttachment(mDepthFormat);
 
 	// CREATE SUBPASS OBJECTS
-	std::unique_ptr<Subpass> firstPass = std::make_unique<Subpass>("Shaders/ForwardApp/vert.spv", "Shaders/ForwardApp/frag.spv");
+	// The depth prepass has no fragment shader
+	std::unique_ptr<Subpass> depthPass = std::make_unique<Subpass>("Shaders/ForwardApp/depth_vert.spv");
+	std::unique_ptr<Subpass> forwardPass = std::make_unique<Subpass>("Shaders/ForwardApp/vert.spv", mBindlessMaterials ? "Shaders/ForwardApp/bindless_frag.spv" : "Shaders/ForwardApp/frag.spv");
 	std::unique_ptr<Subpass> secondPass = std::make_unique<Subpass>("Shaders/Common/fullscreen_vert.spv", "Shaders/ForwardApp/second_frag.spv");
 
-	std::vector<uint32_t> outputAttachments = { 1, 2 };
-
-	firstPass->setOutputAttachments(outputAttachments);
+	std::vector<uint32_t> depthOutputAttachments = { mDepthAttachmentIndex };
 
-	std::vector<uint32_t> inputAttachments = { 1, 2 };
-
-	secondPass->setInputAttachments(inputAttachments);
-
-	mSubpasses.push_back(std::move(firstPass));
-	mSubpasses.push_back(std::move(secondPass));
+	depthPass->setOutputAttachments(depthOutputAttachments);
 
-	// CREATE SUBPASS INFOS
-	std::vector<SubpassInfo> subpassInfos = {};
+	// Depth is tested against the prepass but not written
+	std::vector<uint32_t> outputAttachments = { mColourAttachmentIndex, mDepthAttachmentIndex };
 
-	// First Subpass
-	subpassInfos.push_back({ mSubpasses[0]->inputAttachments(), mSubpasses[0]->outputAttachments() });
-	// Second Subpass
-	subpassInfos.push_back({ mSubpasses[1]->inputAttachments(), mSubpasses[1]->outputAttachments() });
+	forwardPass->setOutputAttachments(outputAttachments);
 
-	// CREATE LOAD/STORE INFOS
-	std::vector<LoadStoreInfo> loadStoreInfos = {};
+	std::vector<uint32_t> inputAttachments = { mColourAttachmentIndex, mDepthAttachmentIndex };
 
-	// swapchain load/store
-	loadStoreInfos.push_back({ VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE });
-	// Colour load/store
-	loadStoreInfos.push_back({ VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE });
-	// Depth load/store
-	loadStoreInfos.push_back({ VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE });
+	secondPass->setInputAttachments(inputAttachments);
+	secondPass->setCoversFramebuffer(true);
 
-	// CREATE RENDERPASS OBJECT
-	mRenderPass = std::make_unique<RenderPass>(*mDevice,
-		mFrames.back()->renderTarget().attachments(),
-		subpassInfos,
-		loadStoreInfos);
+	mSubpasses.push_back(std::move(depthPass));
+	mSubpasses.push_back(std::move(forwardPass));
+	mSubpasses.push_back(std::move(secondPass));
 
+	mRenderGraph->compile(mSubpasses);
 }
 
 // Create layouts which will be updated at most once per frame
 // A layout must be created for each pipeline
 void ForwardApp::createPerFrameDescriptorSetLayouts()
 {
+	// Pipeline 1
+	// UNIFORM BUFFERS
+	ShaderResource depthVPBuffer(0,
+		VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+		1,
+		VK_SHADER_STAGE_VERTEX_BIT);
 
-	// Pipeline 1 
+	std::vector<ShaderResource> depthResources{ depthVPBuffer };
+
+	// Pipeline 2 
 	// UNIFORM BUFFERS
 
-	// VP buffer
+	// VP buffer (projection is also used to find the fragment's tile)
 	ShaderResource vpBuffer(0,
 		VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
 		1,
-		VK_SHADER_STAGE_VERTEX_BIT);
+		VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
 
+	// STORAGE BUFFERS
 	// Lights buffer
 	ShaderResource lightBuffer(1,
-		VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
 		1,
-		VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+		VK_SHADER_STAGE_FRAGMENT_BIT);
 
-	std::vector<ShaderResource> uniformResources{vpBuffer, lightBuffer};
+	// Light clusters
+	ShaderResource clusterBuffer(2,
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		1,
+		VK_SHADER_STAGE_FRAGMENT_BIT);
 
-	//uniformResources.push_back(lightsBuffer);
+	std::vector<ShaderResource> uniformResources{vpBuffer, lightBuffer, clusterBuffer};
 
-	// Pipeline 2
+	// Pipeline 3
 	// INPUT ATTACHMENTS
 	ShaderResource depthAttachment(0,
 		VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT,
@@ -198,82 +111,72 @@ void ForwardApp::createPerFrameDescriptorSetLayouts()
 	{
 		// NOTE : Per frame descriptor set index should always be 0
 		// Layout for Pipeline 1
-		frame->createDescriptorSetLayout(uniformResources, 0);
+		frame->createDescriptorSetLayout(depthResources, 0);
 
 		// Layout for Pipeline 2
-		frame->createDescriptorSetLayout(attachmentResources, 1);
+		frame->createDescriptorSetLayout(uniformResources, 1);
+
+		// Layout for Pipeline 3
+		frame->createDescriptorSetLayout(attachmentResources, 2);
 	}
 }
 
-void ForwardApp::createPipelines()
+void ForwardApp::setPointLightCount(uint32_t pointLightCount)
 {
-	// PIPELINE 1
-	// CREATE SHADER MODULES
-	std::vector<ShaderModule> shaderModules;
+	mPointLightCount = pointLightCount;
+}
 
-	std::vector<char> vertexCode = readFile(mSubpasses[0]->vertexShaderSource());
-	shaderModules.emplace_back(*mDevice,
-		vertexCode,
-		VK_SHADER_STAGE_VERTEX_BIT);
+void ForwardApp::createPipelines()
+{
+	mPipelineLayouts.resize(mSubpasses.size());
+	mPipelines.resize(mSubpasses.size());
 
-	std::vector<char> fragCode = readFile(mSubpasses[0]->fragmentShaderSource());
-	shaderModules.emplace_back(*mDevice,
-		fragCode,
-		VK_SHADER_STAGE_FRAGMENT_BIT);
+	// SPECIALIZATION CONSTANTS
+	// Clip planes and light cluster grid are used to find the fragment's cluster
+	SpecializationConstants lightingConstants;
+	lightingConstants.set(SPECIALIZATION_Z_NEAR, mNearPlane);
+	lightingConstants.set(SPECIALIZATION_Z_FAR, mFarPlane);
+	LightClusters::setSpecializationConstants(lightingConstants);
+	mSubpasses[1]->setFragmentSpecializationConstants(lightingConstants);
 
+	// PIPELINE 1
 	// CREATE PIPELINE LAYOUT
-	std::vector<std::reference_wrapper<const DescriptorSetLayout>> descriptorSetLayouts = { mFrames[0]->descriptorSetLayout(0) , *mPerMaterialDescriptorSetLayout };
+	// The model matrix is pushed with the same range as the forward pass
+	std::vector<std::reference_wrapper<const DescriptorSetLayout>> depthDescriptorSetLayouts = { mFrames[0]->descriptorSetLayout(0) };
 
-	std::unique_ptr<PipelineLayout> firstLayout = std::make_unique<PipelineLayout>(*mDevice, descriptorSetLayouts, mPushConstantRange);
+	mPipelineLayouts[0] = std::make_unique<PipelineLayout>(*mDevice, depthDescriptorSetLayouts, mPushConstantRange);
 
 	// CREATE PIPELINE
-	std::unique_ptr<Pipeline> firstPipeline =
-		std::make_unique<GraphicsPipeline>(*mDevice,
-			shaderModules,
-			*mSwapchain,
-			*firstLayout,
-			*mRenderPass,
-			0,
-			VK_TRUE,
-			VK_TRUE);
-
-	// Store pipeline + layout
-	mPipelineLayouts.push_back(std::move(firstLayout));
-	mPipelines.push_back(std::move(firstPipeline));
+	PipelineState depthState;
+	depthState.setVertexInputState(PipelineState::meshVertexInputState());
+	createPipelineAsync(0, depthState);
 
 	// PIPELINE 2
-	// CREATE SHADER MODULES
-	std::vector<ShaderModule> secondShaderModules = {};
-
-	vertexCode = readFile(mSubpasses[1]->vertexShaderSource());
-	secondShaderModules.emplace_back(*mDevice,
-		vertexCode,
-		VK_SHADER_STAGE_VERTEX_BIT);
+	// CREATE PIPELINE LAYOUT
+	std::vector<std::reference_wrapper<const DescriptorSetLayout>> descriptorSetLayouts = { mFrames[0]->descriptorSetLayout(1) , *mPerMaterialDescriptorSetLayout };
 
-	fragCode = readFile(mSubpasses[1]->fragmentShaderSource());
-	secondShaderModules.emplace_back(*mDevice,
-		fragCode,
-		VK_SHADER_STAGE_FRAGMENT_BIT);
+	mPipelineLayouts[1] = std::make_unique<PipelineLayout>(*mDevice, descriptorSetLayouts, mPushConstantRange);
 
+	// CREATE PIPELINE
+	// Lit output is opaque so blending is not needed
+	// Only fragments matching the prepass depth are shaded, depth is already written
+	DepthStencilState forwardDepthStencilState;
+	forwardDepthStencilState.depthWriteEnable = VK_FALSE;
+	forwardDepthStencilState.depthCompareOp = VK_COMPARE_OP_EQUAL;
+
+	PipelineState forwardState;
+	forwardState.setVertexInputState(PipelineState::meshVertexInputState());
+	forwardState.setDepthStencilState(forwardDepthStencilState);
+	createPipelineAsync(1, forwardState);
+
+	// PIPELINE 3
 	// CREATE PIPELINE LAYOUT
-	std::vector<std::reference_wrapper<const DescriptorSetLayout>> secondDescriptorSetLayouts = { mFrames[0]->descriptorSetLayout(1) };
+	std::vector<std::reference_wrapper<const DescriptorSetLayout>> secondDescriptorSetLayouts = { mFrames[0]->descriptorSetLayout(2) };
 
-	std::unique_ptr<PipelineLayout> secondLayout = std::make_unique<PipelineLayout>(*mDevice, secondDescriptorSetLayouts);
+	mPipelineLayouts[2] = std::make_unique<PipelineLayout>(*mDevice, secondDescriptorSetLayouts);
 
 	// CREATE PIPELINE
-	std::unique_ptr<Pipeline> secondPipeline =
-		std::make_unique<GraphicsPipeline>(*mDevice,
-			secondShaderModules,
-			*mSwapchain,
-			*secondLayout,
-			*mRenderPass,
-			1,
-			VK_FALSE,
-			VK_FALSE);
-
-	// Store pipeline + layout
-	mPipelineLayouts.push_back(std::move(secondLayout));
-	mPipelines.push_back(std::move(secondPipeline));
+	createPipelineAsync(2, PipelineState::fullscreen());
 }
 
 void ForwardApp::createPerFrameResources()
@@ -282,45 +185,62 @@ void ForwardApp::createPerFrameResources()
 
 	// Buffer sizes
 	VkDeviceSize vpBufferSize = sizeof(uboVP);
-	VkDeviceSize lightBufferSize = sizeof(uboLights);
 
-	// Create uniform buffers
-	for (size_t i = 0; i < static_cast<size_t>(mSwapchain->details().imageCount); ++i)
+	// Create uniform buffers for each frame in flight
+	for (size_t i = 0; i < mFrames.size(); ++i)
 	{
 		mVPBufferIndex = mFrames[i]->createBuffer(vpBufferSize,
 			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-		mLightBufferIndex = mFrames[i]->createBuffer(lightBufferSize,
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 	}
 
 	createLights();
+
+	// Light buffers + clusters for each frame in flight, the culling pipeline compiles alongside the subpass pipelines
+	mLightClusters = std::make_unique<LightClusters>(*mDevice, static_cast<uint32_t>(mFrames.size()), mPointLightCount, mNearPlane, mFarPlane);
+
+	mJobSystem->submit([this](size_t threadIndex) {
+		mLightClusters->createPipeline();
+		}, mPipelineCounter);
 }
 
 void ForwardApp::createPerFrameDescriptorSets()
 {
-
-	for (size_t i = 0; i < static_cast<size_t>(mSwapchain->imageCount()); ++i)
+	for (uint32_t frameIndex = 0; frameIndex < mFrames.size(); ++frameIndex)
 	{
+		auto& frame = mFrames[frameIndex];
+
 		// PIPELINE 1
 		// - BINDING MAP TO PER FRAME BUFFERS
 		BindingMap<uint32_t> bufferIndices;
 		bufferIndices[0][0] = mVPBufferIndex;
-		bufferIndices[1][0] = mLightBufferIndex;
 
 		// - DESCRIPTOR SET
-		mFrames[i]->createDescriptorSet(0, {}, bufferIndices);
+		frame->createDescriptorSet(0, *mRenderTargets[0], {}, bufferIndices);
 
 		// PIPELINE 2
+		// - RESOURCE REFERENCES
+		DescriptorResourceReference descriptorSetResourceReference;
+
+		auto& lightBuffer = mLightClusters->lightBuffer(frameIndex);
+		auto& clusterBuffer = mLightClusters->clusterBuffer(frameIndex);
+		descriptorSetResourceReference.bindBuffer(lightBuffer, 0, lightBuffer.size(), 1, 0);
+		descriptorSetResourceReference.bindBuffer(clusterBuffer, 0, clusterBuffer.size(), 2, 0);
+
+		// - DESCRIPTOR SET
+		frame->createDescriptorSet(1, descriptorSetResourceReference, bufferIndices);
+
+		// PIPELINE 3
 		// - BINDING MAP TO RENDERTARGET IMAGE INDICES
 		BindingMap<uint32_t> imageIndices;
 		imageIndices[0][0] = mColourAttachmentIndex;
 		imageIndices[1][0] = mDepthAttachmentIndex;
 
-		// - DESCRIPTOR SET
-		mFrames[i]->createDescriptorSet(1, imageIndices, {});
+		// - DESCRIPTOR SET (one per render target)
+		for (uint32_t target = 0; target < mRenderTargets.size(); ++target)
+		{
+			frame->createDescriptorSet(2, *mRenderTargets[target], imageIndices, {}, target);
+		}
 	}
 }
 
@@ -333,16 +253,23 @@ void ForwardApp::updatePerFrameResources()
 
 	// Set light values
 	// - Point lights
-	mLights.pointLights[0].position.x = 100 * sin(sumTime);
-	mLights.pointLights[2].position.x = -100 * sin(sumTime);
+	// The first lights sweep across the scene, the remaining lights bob around their origins
+	const float sweepDistance[MAX_POINT_LIGHTS] = { 100.0f, 0.0f, -100.0f };
+	for (uint32_t i = 0; i < mLightManager.pointLightCount(); ++i)
+	{
+		glm::vec4 offset = i < MAX_POINT_LIGHTS ?
+			glm::vec4(sweepDistance[i] * sin(sumTime), 0.0f, 0.0f, 0.0f) :
+			glm::vec4(0.0f, 5.0f * sin(sumTime + i), 0.0f, 0.0f);
 
-	// - Flash light
-	glm::mat4 invView = glm::transpose(mCameraMatrices.V);
-	mLights.flashLight.position = invView * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);	// Flash light position is camera position
+		mLightManager.setPosition(i, glm::vec3(mPointLightOrigins[i] + offset));
+	}
 
 	// Update buffers
+	// Only lights intersecting the view frustum are uploaded, their positions are transformed to view space as they are culled
+	// Note that flashlight pos and dir are already in view space so no conversion is necessary
 	mFrames[activeFrameIndex]->updateBuffer(mVPBufferIndex, mCameraMatrices);
-	mFrames[activeFrameIndex]->updateBuffer(mLightBufferIndex, mLights);
+	mLightManager.update(mCameraMatrices.V, mCameraMatrices.P);
+	mLightClusters->updateLights(activeFrameIndex, mFlashLight, mLightManager.visibleLights());
 }
 
 // Set required extensions + features
@@ -358,129 +285,105 @@ void ForwardApp::getRequiredExtenstionAndFeatures(std::vector<const char*>& requ
 
 void ForwardApp::createLights()
 {
-	// Point Light identical starting positions + intensity
-	for (auto& pointLight : mLights.pointLights)
+	mLightManager.clear();
+	mLightManager.reserve(mPointLightCount);
+	mPointLightOrigins.resize(mPointLightCount);
+
+	// First point lights have identical starting positions + intensity
+	const glm::vec4 colours[MAX_POINT_LIGHTS] = {
+		glm::vec4(1.0, 0.5, 0.5, 1.0),
+		glm::vec4(0.5, 1.0, 0.5, 1.0),
+		glm::vec4(0.5, 0.5, 1.0, 1.0) };
+
+	for (uint32_t i = 0; i < std::min(mPointLightCount, MAX_POINT_LIGHTS); ++i)
 	{
+		PointLight pointLight;
+
 		// Position + intensity
-		pointLight.position.x = 0.0f;
-		pointLight.position.y = 30.0f;
-		pointLight.position.z = 0.0f;
+		mPointLightOrigins[i] = glm::vec4(0.0f, 30.0f, 0.0f, 1.0f);
+		pointLight.position = mPointLightOrigins[i];
 		pointLight.intensityAndAttenuation.x = 50.0f;
 
 		// Attenuation constants
 		pointLight.intensityAndAttenuation.y = 0.07f;	// Kq
 		pointLight.intensityAndAttenuation.z = 0.14f;	// Kl
 		pointLight.intensityAndAttenuation.w = 1.0f;	// Kc
+
+		// Colours
+		pointLight.colour = colours[i];
+
+		mLightManager.addPointLight(pointLight);
+	}
+
+	// Remaining point lights are small, randomly coloured and scattered through the scene
+	std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+	std::default_random_engine generator;
+
+	for (uint32_t i = MAX_POINT_LIGHTS; i < mPointLightCount; ++i)
+	{
+		PointLight pointLight;
+
+		mPointLightOrigins[i] = glm::vec4(
+			distribution(generator) * 240.0f - 120.0f,
+			distribution(generator) * 75.0f + 5.0f,
+			distribution(generator) * 90.0f - 45.0f,
+			1.0f);
+		pointLight.position = mPointLightOrigins[i];
+		pointLight.intensityAndAttenuation = glm::vec4(10.0f, 1.0f, 0.35f, 1.0f);
+		pointLight.colour = glm::vec4(distribution(generator), distribution(generator), distribution(generator), 1.0f);
+
+		mLightManager.addPointLight(pointLight);
 	}
-	// Colours
-	mLights.pointLights[0].colour = glm::vec4(1.0, 0.5, 0.5, 1.0);
-	mLights.pointLights[1].colour = glm::vec4(0.5, 1.0, 0.5, 1.0);
-	mLights.pointLights[2].colour = glm::vec4(0.5, 0.5, 1.0, 1.0);
 
 	// Flash Light
 	// Position and direction always the same since can be taken from view space
 	// e.g. position will always be (0,0,0) and direction will be (0,0,-1)
-	mLights.flashLight.position = glm::vec4(0.0);
-	mLights.flashLight.direction = glm::vec4(0.0, 0.0, -1.0, 0.0);
-	mLights.flashLight.intensityAndAttenuation = glm::vec4(75.0f, 0.07f, 0.14f, 1.0f);
-	mLights.flashLight.colour = glm::vec4(1.0);
+	mFlashLight.position = glm::vec4(0.0);
+	mFlashLight.direction = glm::vec4(0.0, 0.0, -1.0, 0.0);
+	mFlashLight.intensityAndAttenuation = glm::vec4(75.0f, 0.07f, 0.14f, 1.0f);
+	mFlashLight.colour = glm::vec4(1.0);
 
-	mLights.flashLight.innerCutOff = cos(glm::radians(20.0f)); // This should set an overall cone of 40 degrees
-	mLights.flashLight.outerCutOff = cos(glm::radians(30.0f)); // This should set an overall cone of 60 degrees
+	mFlashLight.innerCutOff = cos(glm::radians(20.0f)); // This should set an overall cone of 40 degrees
+	mFlashLight.outerCutOff = cos(glm::radians(30.0f)); // This should set an overall cone of 60 degrees
 
 }
 
 void ForwardApp::recordCommands(CommandBuffer& primaryCmdBuffer) // Current image is swapchain index
 {
 	auto& frame = mFrames[activeFrameIndex];
-	auto& framebuffer = mFramebuffers[activeFrameIndex];
+	auto& renderTarget = *mRenderTargets[activeImageIndex];
+	auto& framebuffer = mFramebuffers[activeImageIndex];
 
 	primaryCmdBuffer.beginRecording();
 
-	std::vector<VkClearValue> clearValues;
-	clearValues.resize(frame->renderTarget().imageViews().size());
-	clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };				// Clear values for swapchain image (colour)
-	clearValues[1].color = { 1.0f, 1.0f, 1.0f, 1.0f };				// Clear values for attachment 1 (colour)
-	clearValues[2].depthStencil.depth = 1.0f;						// Clear values for attachment 2 (depth)
+	// LIGHT CULLING
+	// Lights are uploaded in view space
+	mLightClusters->recordCulling(primaryCmdBuffer, activeFrameIndex, mCameraMatrices.P, glm::mat4(1.0f));
 
 	// TODO : update renderpass function
-	primaryCmdBuffer.beginRenderPass(frame->renderTarget(),
+	primaryCmdBuffer.beginRenderPass(renderTarget,
 		*mRenderPass,
 		*framebuffer,
-		clearValues,
+		mRenderGraph->clearValues(),
 		VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-	// Split meshes to draw equally between threads
-
-	// Create vector of references to meshes
-	std::vector<std::reference_wrapper<Mesh>> meshList;
-	for (auto& model : mModelList)
-	{
-		for (size_t i = 0; i < model.meshCount(); ++i)
-		{
-			meshList.push_back(model.mesh(i));
-		}
-	}
-
-	uint32_t meshCount = static_cast<uint32_t>(meshList.size());
-	float avgMeshesPerBuffer = static_cast<float>(meshCount) / mThreadCount;
-	uint32_t remainderMeshes;
-
-	uint32_t meshesPerBuffer = static_cast<uint32_t> (std::floor(avgMeshesPerBuffer));
-	if (meshesPerBuffer == 0)
-	{
-		remainderMeshes = meshCount;
-	}
-	else
-	{
-		remainderMeshes = meshCount % meshesPerBuffer;
-	}
-
-	uint32_t meshStart = 0;
-
-	// Vector for results of tasks pushed to threadpool
-	std::vector<std::future<CommandBuffer*>> futureSecondaryCommandBuffers;
-
-	for (uint32_t i = 0; i < mThreadCount; ++i)
-	{
-		// Get the end index for the last mesh which will be handled by this buffer
-		uint32_t meshEnd = std::min(meshCount, meshStart + meshesPerBuffer);
-
-		// If there are still remainder draws then add a draw to this command buffer
-		// Latter command buffers may contain fewer draws
-		if (remainderMeshes > 0)
-		{
-			meshEnd++;
-			remainderMeshes--;
-		}
+	// SUBPASS 0 - DEPTH PREPASS
+	recordMeshes(primaryCmdBuffer, 0);
 
-		// Push lambda function to threadpool for running
-		auto futureResult = mThreadPool.push([=, &primaryCmdBuffer](size_t threadIndex) {
-			return recordSecondaryCommandBuffers(&primaryCmdBuffer, meshList, meshStart, meshEnd, threadIndex);
-			});
+	// SUBPASS 1 - FORWARD LIGHTING
+	primaryCmdBuffer.nextSubpass(VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-		futureSecondaryCommandBuffers.push_back(std::move(futureResult));
-
-		meshStart = meshEnd;
-	}
-
-	std::vector<CommandBuffer* > secondaryCommandBufferPtrs;
-
-	for (auto& fut : futureSecondaryCommandBuffers)
-	{
-		secondaryCommandBufferPtrs.push_back(fut.get());
-	}
-
-	// Submit the secondary command buffers to the primary command buffer.
-	primaryCmdBuffer.executeCommands(secondaryCommandBufferPtrs);
+	recordMeshes(primaryCmdBuffer, 1);
 
+	// SUBPASS 2
 	primaryCmdBuffer.nextSubpass(VK_SUBPASS_CONTENTS_INLINE);
 
-	primaryCmdBuffer.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelines[1]);
+	primaryCmdBuffer.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelines[2]);
+	setViewportAndScissor(primaryCmdBuffer);
 
-	std::vector<std::reference_wrapper<const DescriptorSet>> descriptorGroup{ frame->descriptorSet(1) };
+	std::vector<std::reference_wrapper<const DescriptorSet>> descriptorGroup{ frame->descriptorSet(2, activeImageIndex) };
 
-	primaryCmdBuffer.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelineLayouts[1],
+	primaryCmdBuffer.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelineLayouts[2],
 		0, descriptorGroup);
 
 	primaryCmdBuffer.draw(3, 1, 0, 0);
@@ -494,7 +397,26 @@ void ForwardApp::recordCommands(CommandBuffer& primaryCmdBuffer) // Current imag
 }
 
 
-CommandBuffer* ForwardApp::recordSecondaryCommandBuffers(CommandBuffer* primaryCommandBuffer, std::vector<std::reference_wrapper<Mesh>> meshList, uint32_t meshStart, uint32_t meshEnd, size_t threadIndex)
+void ForwardApp::recordMeshes(CommandBuffer& primaryCmdBuffer, uint32_t subpassIndex)
+{
+	// Split the draw list into one batch per thread and record each batch to a secondary command buffer
+	uint32_t meshCount = static_cast<uint32_t>(mDrawList.size());
+	uint32_t meshesPerBuffer = std::max<uint32_t>(1, (meshCount + mThreadCount - 1) / mThreadCount);
+
+	std::vector<CommandBuffer*> secondaryCommandBufferPtrs((meshCount + meshesPerBuffer - 1) / meshesPerBuffer);
+
+	mJobSystem->parallelFor(meshCount, meshesPerBuffer, [&](uint32_t meshStart, uint32_t meshEnd, size_t threadIndex) {
+		secondaryCommandBufferPtrs[meshStart / meshesPerBuffer] = recordSecondaryCommandBuffers(&primaryCmdBuffer, mDrawList, meshStart, meshEnd, threadIndex, subpassIndex);
+		});
+
+	// Submit the secondary command buffers to the primary command buffer.
+	if (!secondaryCommandBufferPtrs.empty())
+	{
+		primaryCmdBuffer.executeCommands(secondaryCommandBufferPtrs);
+	}
+}
+
+CommandBuffer* ForwardApp::recordSecondaryCommandBuffers(CommandBuffer* primaryCommandBuffer, const std::vector<std::reference_wrapper<Mesh>>& meshList, uint32_t meshStart, uint32_t meshEnd, size_t threadIndex, uint32_t subpassIndex)
 {
 	auto& frame = mFrames[activeFrameIndex];
 
@@ -505,16 +427,39 @@ CommandBuffer* ForwardApp::recordSecondaryCommandBuffers(CommandBuffer* primaryC
 	cmdBuffer.beginRecording(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
 		| VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, primaryCommandBuffer);
 
-	cmdBuffer.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelines[0]);
+	cmdBuffer.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelines[subpassIndex]);
+	setViewportAndScissor(cmdBuffer);
+
+	auto& pipelineLayout = *mPipelineLayouts[subpassIndex];
+
+	// The depth prepass does not sample materials
+	bool bindMaterials = subpassIndex != 0;
+
+	// Bindless materials are all held in one set so descriptor sets are only bound once
+	if (!bindMaterials)
+	{
+		std::vector<std::reference_wrapper<const DescriptorSet>> descriptorSetGroup{ frame->descriptorSet(subpassIndex) };
+
+		cmdBuffer.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout,
+			0, descriptorSetGroup);
+	}
+	else if (mBindlessMaterials)
+	{
+		std::vector<std::reference_wrapper<const DescriptorSet>> descriptorSetGroup{ frame->descriptorSet(subpassIndex), *mBindlessDescriptorSet };
+
+		cmdBuffer.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout,
+			0, descriptorSetGroup);
+	}
 
 	for (uint32_t i = meshStart; i < meshEnd; ++i)
 	{
 		Mesh& thisMesh = meshList[i];
 
-		// "Push" constants to given shader stage directly
-		cmdBuffer.pushConstant(*mPipelineLayouts[0],
-			VK_SHADER_STAGE_VERTEX_BIT,
-			thisMesh.model());
+		// "Push" constants to given shader stages directly
+		DrawPushConstant drawPushConstant{ thisMesh.model(), thisMesh.materialID() };
+		cmdBuffer.pushConstant(pipelineLayout,
+			mPushConstantRange.stageFlags,
+			drawPushConstant);
 
 		std::vector<std::reference_wrapper<const Buffer>> vertexBuffers{ thisMesh.vertexBuffer() };	// Buffers to bind
 		std::vector<VkDeviceSize> offsets{ 0 };														// Offsets into buffers being bound
@@ -522,11 +467,14 @@ CommandBuffer* ForwardApp::recordSecondaryCommandBuffers(CommandBuffer* primaryC
 
 		cmdBuffer.bindIndexBuffer(thisMesh.indexBuffer(), 0, VK_INDEX_TYPE_UINT32);
 
-		std::vector<std::reference_wrapper<const DescriptorSet>> descriptorSetGroup{ frame->descriptorSet(0, threadIndex),
-			*mPerMaterialDescriptorSets[thisMesh.materialID()] };
+		if (bindMaterials && !mBindlessMaterials)
+		{
+			std::vector<std::reference_wrapper<const DescriptorSet>> descriptorSetGroup{ frame->descriptorSet(subpassIndex),
+				*mPerMaterialDescriptorSets[thisMesh.materialID()] };
 
-		cmdBuffer.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelineLayouts[0],
-			0, descriptorSetGroup);
+			cmdBuffer.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout,
+				0, descriptorSetGroup);
+		}
 
 		// Execute pipeline
 		cmdBuffer.drawIndexed(thisMesh.indexCount(), 1, 0, 0, 0);
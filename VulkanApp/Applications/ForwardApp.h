@@ -4,6 +4,8 @@
 // A simple application using:
 // - Basic Shading
 // - Depth buffer
+// - Depth prepass so the forward pass only shades visible fragments
+// - Forward+ lighting with clustered light lists
 // - Multiple subpasses
 // - Multithreaded command buffer submission
 class ForwardApp : public VulkanRenderer
@@ -12,11 +14,15 @@ public:
 	ForwardApp() = default;
 	~ForwardApp();
 
-	virtual void draw();
+	// - Setters
+	// Number of point lights in the scene, the first MAX_POINT_LIGHTS sweep across the scene and the rest are scattered, must be set before init
+	void setPointLightCount(uint32_t pointLightCount);
+
 private:
 	// Variables
 	uint32_t mVPBufferIndex{ 0 };
-	uint32_t mLightBufferIndex{ 0 };
+
+	std::unique_ptr<LightClusters> mLightClusters;		// Light buffer + light lists for each view space cluster
 
 	uint32_t mColourAttachmentIndex{ 0 };
 	uint32_t mDepthAttachmentIndex{ 0 };
@@ -24,16 +30,15 @@ private:
 	float lastTime{ 0.0f };
 	float sumTime{ 0.0f };
 
-	// Buffer compositions
-	struct uboLights {
-		PointLight pointLights[3];
-		SpotLight flashLight;
-	} mLights;
+	// Lights
+	uint32_t mPointLightCount{ MAX_POINT_LIGHTS };
+	LightManager mLightManager;					// World space point lights, the visible lights are uploaded in view space
+	std::vector<glm::vec4> mPointLightOrigins;		// Positions the point lights are animated around
+	SpotLight mFlashLight;							// View space so it is uploaded unchanged
 
 	// Functions
 	// - Create Functions
-	virtual void createRenderTargetAndFrames();
-	virtual void createRenderPass();
+	virtual void createRenderGraph();
 	virtual void createPerFrameDescriptorSetLayouts();
 	virtual void createPipelines();
 	virtual void createPerFrameResources();
@@ -47,11 +52,14 @@ private:
 	void createLights();
 
 	// - Record Functions
-	void recordCommands(CommandBuffer& primaryCmdBuffer);
+	virtual void recordCommands(CommandBuffer& primaryCmdBuffer);
+	// Record the draw list to secondary command buffers split between threads and execute them in the current subpass
+	void recordMeshes(CommandBuffer& primaryCmdBuffer, uint32_t subpassIndex);
 	CommandBuffer* recordSecondaryCommandBuffers(CommandBuffer* primaryCommandBuffer, 
-		std::vector<std::reference_wrapper<Mesh>> meshList,
+		const std::vector<std::reference_wrapper<Mesh>>& meshList,
 		uint32_t meshStart, 
 		uint32_t meshEnd, 
-		size_t threadIndex);
+		size_t threadIndex,
+		uint32_t subpassIndex);
 };
 
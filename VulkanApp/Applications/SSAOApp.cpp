@@ -1,6 +1,26 @@
 #include "SSAOApp.h"
 #include <random>
 
+namespace {
+	// Reduced resolution attachments are written as colour attachments and sampled by later subpasses, which also list them as inputs
+	const VkImageUsageFlags REDUCED_ATTACHMENT_USAGE = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+	// Dependencies between the separate render passes are global as their attachments are sampled at other pixels
+	VkSubpassDependency subpassDependency(uint32_t srcSubpass, VkPipelineStageFlags srcStageMask, VkAccessFlags srcAccessMask,
+		uint32_t dstSubpass, VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask)
+	{
+		VkSubpassDependency dependency = {};
+		dependency.srcSubpass = srcSubpass;
+		dependency.srcStageMask = srcStageMask;
+		dependency.srcAccessMask = srcAccessMask;
+		dependency.dstSubpass = dstSubpass;
+		dependency.dstStageMask = dstStageMask;
+		dependency.dstAccessMask = dstAccessMask;
+
+		return dependency;
+	}
+}
+
 SSAOApp::~SSAOApp()
 {
 	if (mDevice)
@@ -9,219 +29,335 @@ SSAOApp::~SSAOApp()
 	}
 }
 
-void SSAOApp::draw()
+// Describe the attachments and subpasses, the render targets and render pass are created from this graph
+void SSAOApp::createRenderGraph()
 {
-	auto& previousFrame = mFrames[activeFrameIndex];
+	mRenderGraph = std::make_unique<RenderGraph>(*mDevice);
 
-	// Get next active frame
-	VkSemaphore imageAcquired = previousFrame->requestSemaphore();	// Get a semaphore from the pool of the previous frame
-	VkResult result = mSwapchain->acquireNextImageIndex(imageAcquired, activeFrameIndex);
+	// High precision not required
+	mColourFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+	// REDUCED RESOLUTION SSAO
+	// Downsample, SSAO and blur attachments are held in reduced size targets outside of the graph (see createReducedTargets)
+	// The G-buffer is written by a render pass of its own before them so it is loaded by the main render pass
+	bool reducedResolution = ssaoDownsample() > 1;
+
+	// CREATE ATTACHMENTS
+	// Image usage, load/store ops and whether an attachment can be transient are derived by the graph
+	// SUBPASS 4 OUTPUT (LIGHTING)
+	// 0 - swapchain image
+	mRenderGraph->addSwapchainAttachment(mSwapchain->format());
 
-	if (result != VK_SUCCESS)
+	// Occlusion is a single channel, the packed layout stores it as such
+	VkFormat occlusionFormat = mPackedGBuffer ? VK_FORMAT_R8_UNORM : mColourFormat;
+	VkFormat normalFormat = mPackedGBuffer ? mPackedNormalFormat : mColourFormat;
+
+	if (reducedResolution)
 	{
-		throw std::runtime_error("Could not acquire next swapchain image!");
-	}
+		// GEOMETRY RENDER PASS OUTPUT
+		// Loaded in the layout the geometry render pass leaves them in, normals and depth are also sampled by the downsample subpass
+		// 1 - Normals
+		mNormalAttachmentIndex = mRenderGraph->addLoadedAttachment(normalFormat, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+
+		// 2 - Albedo (+ specular in alpha if packed)
+		mAlbedoAttachmentIndex = mRenderGraph->addLoadedAttachment(mColourFormat, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+
+		// 3 - Specular (unpacked only)
+		if (!mPackedGBuffer)
+		{
+			mSpecularAttachmentIndex = mRenderGraph->addLoadedAttachment(mColourFormat, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+		}
+
+		// 4 - Depth (3 if packed)
+		mDepthAttachmentIndex = mRenderGraph->addLoadedAttachment(mDepthFormat, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
 
-	auto& activeFrame = mFrames[activeFrameIndex];
+		// UPSAMPLE OUTPUT
+		// 5 - Full resolution occlusion (4 if packed)
+		mUpsampleAttachmentIndex = mRenderGraph->addAttachment(occlusionFormat);
 
-	updatePerFrameResources();
+		// REDUCED TARGET ATTACHMENTS
+		mReducedFormats.clear();
 
-	// Wait until idle then reset command pools + synchronisation objects
-	activeFrame->wait();
-	activeFrame->reset();
+		// DOWNSAMPLE OUTPUT
+		// 0 - Depth (raw depth values, not linearised)
+		mDownsampleDepthAttachmentIndex = static_cast<uint32_t>(mReducedFormats.size());
+		mReducedFormats.push_back(VK_FORMAT_R32_SFLOAT);
 
-	// Request the required synchronisation objects
-	VkSemaphore renderFinished = activeFrame->requestSemaphore();
-	VkFence drawFence = activeFrame->requestFence();
+		// 1 - Normals
+		mDownsampleNormalAttachmentIndex = static_cast<uint32_t>(mReducedFormats.size());
+		mReducedFormats.push_back(normalFormat);
 
-	const Queue& queue = mDevice->queue(mGraphicsQueueFamily, 0);
+		// SSAO OUTPUT
+		// 2 - SSAO
+		mSSAOAttachmentIndex = static_cast<uint32_t>(mReducedFormats.size());
+		mReducedFormats.push_back(occlusionFormat);
+
+		// HORIZONTAL BLUR OUTPUT
+		// 3 - Horizontally blurred SSAO
+		mBlurIntermediateAttachmentIndex = static_cast<uint32_t>(mReducedFormats.size());
+		mReducedFormats.push_back(occlusionFormat);
+
+		// VERTICAL BLUR OUTPUT
+		// 4 - Blur
+		mBlurAttachmentIndex = static_cast<uint32_t>(mReducedFormats.size());
+		mReducedFormats.push_back(occlusionFormat);
+	}
+	else
+	{
+		// SUBPASS 3 OUTPUT (VERTICAL BLUR PASS)
+		// 1 - Blur
+		mBlurAttachmentIndex = mRenderGraph->addAttachment(occlusionFormat);
 
-	CommandBuffer& primaryCmdBuffer = activeFrame->requestCommandBuffer(queue, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+		// SUBPASS 1 OUTPUT (SSAO PASS)
+		// 2 - SSAO (SSAO kernel only, later indices are one lower with GTAO)
+		if (!mUseGroundTruthAO)
+		{
+			mSSAOAttachmentIndex = mRenderGraph->addAttachment(occlusionFormat);
+		}
 
-	recordCommands(primaryCmdBuffer);		// Only record commands once the image at imageIndex is available (not being used by the queue)
+		// SUBPASS 0 OUTPUT (GEOMETRY PASS)
+		// 3 - Normals
+		mNormalAttachmentIndex = mRenderGraph->addAttachment(normalFormat);
 
-	queue.submit(imageAcquired, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, renderFinished,
-		primaryCmdBuffer, drawFence);
+		// 4 - Albedo (+ specular in alpha if packed)
+		mAlbedoAttachmentIndex = mRenderGraph->addAttachment(mColourFormat);
 
-	queue.present(renderFinished, *mSwapchain, activeFrameIndex);
-}
+		// 5 - Specular (unpacked only)
+		if (!mPackedGBuffer)
+		{
+			mSpecularAttachmentIndex = mRenderGraph->addAttachment(mColourFormat);
+		}
 
-// Prepare rendertargets and frames
-void SSAOApp::createRenderTargetAndFrames()
-{
-	//auto& device = mSwapchain->device();
-	auto& swapchainExtent = mSwapchain->extent();
-	VkFormat swapchainFormat = mSwapchain->format();
-	VkImageUsageFlags swapchainUsage = mSwapchain->usage();
+		// 6 - Depth (5 if packed)
+		// GTAO's depth prepass already wrote depth before the render pass, it is loaded and the geometry subpass only tests against it
+		if (mUseGroundTruthAO)
+		{
+			mDepthAttachmentIndex = mRenderGraph->addLoadedAttachment(mDepthFormat, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+		}
+		else
+		{
+			mDepthAttachmentIndex = mRenderGraph->addAttachment(mDepthFormat);
+		}
 
-	// High precision not required
-	mColourFormat = VK_FORMAT_R8G8B8A8_UNORM;
+		// SUBPASS 2 OUTPUT (HORIZONTAL BLUR PASS)
+		// 7 - Horizontally blurred SSAO (6 if packed)
+		mBlurIntermediateAttachmentIndex = mRenderGraph->addAttachment(occlusionFormat);
+	}
 
-	// Get supported format for depth buffer
-	mDepthFormat = chooseSupportedFormat(
-		{ VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT },
-		VK_IMAGE_TILING_OPTIMAL,
-		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+	// CREATE SUBPASS OBJECTS
+	// Shader variants are compiled for bindless materials and the packed G-buffer (see compile_shaders.bat)
+	std::string bindless = mBindlessMaterials ? "_bindless" : "";
+	std::string packed = mPackedGBuffer ? "_packed" : "";
 
-	// NOTE ON IMAGE USAGE:
-	// VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT - always use if image will be stored and sampled/loaded in a future subpass
-	// VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT - use if attachment will be referenced as a subpass input in renderpass creation
-	// VK_IMAGE_USAGE_SAMPLED_BIT - use if image will be sampled
+	// Downsample and upsample subpasses surround SSAO and blur when they run at reduced resolution
+	// Both blur directions use the same shader, the direction is specialised
+	mSubpasses.clear();
+	mSubpasses.push_back(std::make_unique<Subpass>("Shaders/SSAOApp/geometry_vert.spv", "Shaders/SSAOApp/geometry" + bindless + packed + "_frag.spv"));
 
-	for (auto& image : mSwapchain->images())
+	if (reducedResolution)
 	{
-		// IMAGES + RENDERTARGET + RESOURCE REFERENCE
+		mDownsampleSubpassIndex = static_cast<uint32_t>(mSubpasses.size());
+		mSubpasses.push_back(std::make_unique<Subpass>("Shaders/Common/fullscreen_vert.spv", "Shaders/SSAOApp/downsample_frag.spv"));
+	}
 
-		// SUBPASS 3 OUTPUT (LIGHTING)
-		// 0 - swapchain image
-		Image swapchainImage(*mDevice,
-			image,
-			swapchainExtent,
-			swapchainFormat,
-			swapchainUsage);
+	// GTAO occlusion is computed before the render pass and read by the first blur
+	if (!mUseGroundTruthAO)
+	{
+		mSSAOSubpassIndex = static_cast<uint32_t>(mSubpasses.size());
+		mSubpasses.push_back(std::make_unique<Subpass>("Shaders/Common/fullscreen_viewRay_vert.spv", "Shaders/SSAOApp/ssao" + packed + "_frag.spv"));
+	}
 
-		// SUBPASS 2 OUTPUT (BLUR PASS)
-		// 1 - Blur
-		mBlurAttachmentIndex = 1;
-		Image blurImage(*mDevice,
-			swapchainExtent,
-			//mSSAOFormat,
-			mColourFormat,
-			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	mBlurHorizontalSubpassIndex = static_cast<uint32_t>(mSubpasses.size());
+	mSubpasses.push_back(std::make_unique<Subpass>("Shaders/Common/fullscreen_vert.spv", "Shaders/SSAOApp/blur" + packed + "_frag.spv"));
 
-		// SUBPASS 1 OUTPUT (SSAO PASS)
-		// 2 - SSAO
-		mSSAOAttachmentIndex = 2;
-		Image ssaoImage(*mDevice,
-			swapchainExtent,
-			//mSSAOFormat,
-			mColourFormat,
-			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	mBlurVerticalSubpassIndex = static_cast<uint32_t>(mSubpasses.size());
+	mSubpasses.push_back(std::make_unique<Subpass>("Shaders/Common/fullscreen_vert.spv", "Shaders/SSAOApp/blur" + packed + "_frag.spv"));
 
-		// 3 - Normals
-		mNormalAttachmentIndex = 3;
-		Image normalImage(*mDevice,
-			swapchainExtent,
-			mColourFormat,
-			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		// 4 - Albedo 
-		mAlbedoAttachmentIndex = 4;
-		Image albedoImage(*mDevice,
-			swapchainExtent,
-			mColourFormat,
-			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		// 5 - Specular
-		mSpecularAttachmentIndex = 5;
-		Image specularImage(*mDevice,
-			swapchainExtent,
-			mColourFormat,
-			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		// 6 - Depth
-		mDepthAttachmentIndex = 6;
-		Image depthImage(*mDevice,
-			swapchainExtent,
-			mDepthFormat,
-			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-
-		std::vector<Image> renderTargetImages;
-		renderTargetImages.push_back(std::move(swapchainImage));
-		renderTargetImages.push_back(std::move(blurImage));
-		renderTargetImages.push_back(std::move(ssaoImage));
-		renderTargetImages.push_back(std::move(normalImage));
-		renderTargetImages.push_back(std::move(albedoImage));
-		renderTargetImages.push_back(std::move(specularImage));
-		renderTargetImages.push_back(std::move(depthImage));
-
-		// Create Render Target + Frame
-		std::unique_ptr<RenderTarget> renderTarget = std::make_unique<RenderTarget>(std::move(renderTargetImages));
-		mFrames.push_back(std::make_unique<Frame>(*mDevice, std::move(renderTarget), mThreadCount));
+	if (reducedResolution)
+	{
+		mUpsampleSubpassIndex = static_cast<uint32_t>(mSubpasses.size());
+		mSubpasses.push_back(std::make_unique<Subpass>("Shaders/Common/fullscreen_vert.spv", "Shaders/SSAOApp/upsample_frag.spv"));
 	}
-}
-
-void SSAOApp::createRenderPass()
-{
-	// Attachment 0 = Swapchain
-	// Attachment 1 = Blur
-	// Attachment 2 = SSAO
-	// Attachment 3 = Normal
-	// Attachment 4 = Albedo
-	// Attachment 5 = Specular
-	// Attachment 6 = Depth
 
-	// CREATE SUBPASS OBJECTS
-	uint32_t subpassCount = 4;
-	mSubpasses.resize(subpassCount);
-	mSubpasses[0] = std::make_unique<Subpass>("Shaders/SSAOApp/geometry_vert.spv", "Shaders/SSAOApp/geometry_frag.spv");
-	mSubpasses[1] =	std::make_unique<Subpass>("Shaders/Common/fullscreen_viewRay_vert.spv", "Shaders/SSAOApp/ssao_frag.spv");
-	mSubpasses[2] =	std::make_unique<Subpass>("Shaders/Common/fullscreen_vert.spv", "Shaders/SSAOApp/blur_frag.spv");
-	mSubpasses[3] = std::make_unique<Subpass>("Shaders/Common/fullscreen_viewRay_vert.spv", "Shaders/SSAOApp/lighting_frag.spv");
+	mLightingSubpassIndex = static_cast<uint32_t>(mSubpasses.size());
+	mSubpasses.push_back(std::make_unique<Subpass>("Shaders/Common/fullscreen_viewRay_vert.spv", "Shaders/SSAOApp/lighting" + packed + "_frag.spv"));
 
 	// Set input and output attachments
-	// Note that these inputs and outputs are not used to define when an attachment will be used for a subpass load
-	// They are used to inform the renderpass creation of what layout each attachment image should have at each subpass so that the necessary image transitions can take place
-	// Therefore, even if an image is sampled rather than subpass loaded it should be listed as an input
+	// Inputs inform the renderpass creation of what layout each attachment image should have at each subpass
+	// Therefore, even if an image is sampled rather than subpass loaded it should be listed as an input and also set as sampled
 	std::vector<uint32_t> inputAttachments{};
 	std::vector<uint32_t> outputAttachments{};
 
 	// SUBPASS 0 (GEOMETRY)
-	outputAttachments = { mNormalAttachmentIndex, mAlbedoAttachmentIndex, mSpecularAttachmentIndex, mDepthAttachmentIndex };
+	outputAttachments = mPackedGBuffer ?
+		std::vector<uint32_t>{ mNormalAttachmentIndex, mAlbedoAttachmentIndex, mDepthAttachmentIndex } :
+		std::vector<uint32_t>{ mNormalAttachmentIndex, mAlbedoAttachmentIndex, mSpecularAttachmentIndex, mDepthAttachmentIndex };
 	mSubpasses[0]->setOutputAttachments(outputAttachments);
+	mGeometryAttachments = outputAttachments;
 
-	// SUBPASS 1 (SSAO)
-	inputAttachments = { mDepthAttachmentIndex, mNormalAttachmentIndex };
-	outputAttachments = { mSSAOAttachmentIndex };
-	mSubpasses[1]->setInputAttachments(inputAttachments);
-	mSubpasses[1]->setOutputAttachments(outputAttachments);
+	// Downsample to blur subpasses are given reduced target attachment indices at reduced resolution
+	// DOWNSAMPLE (reduced resolution only)
+	// The full resolution depth and normals are sampled from the previous render pass so are not attachments of this subpass
+	if (reducedResolution)
+	{
+		outputAttachments = { mDownsampleDepthAttachmentIndex, mDownsampleNormalAttachmentIndex };
+		mSubpasses[mDownsampleSubpassIndex]->setOutputAttachments(outputAttachments);
+		mSubpasses[mDownsampleSubpassIndex]->setCoversFramebuffer(true);
+	}
+
+	// SSAO
+	// Depth and normals at the SSAO resolution are also used to weight the blur
+	uint32_t ssaoDepthAttachmentIndex = reducedResolution ? mDownsampleDepthAttachmentIndex : mDepthAttachmentIndex;
+	uint32_t ssaoNormalAttachmentIndex = reducedResolution ? mDownsampleNormalAttachmentIndex : mNormalAttachmentIndex;
 
-	// SUBPASS 2 (BLUR)
-	inputAttachments = outputAttachments;
+	if (!mUseGroundTruthAO)
+	{
+		inputAttachments = { ssaoDepthAttachmentIndex, ssaoNormalAttachmentIndex };
+		outputAttachments = { mSSAOAttachmentIndex };
+		mSubpasses[mSSAOSubpassIndex]->setInputAttachments(inputAttachments);
+		mSubpasses[mSSAOSubpassIndex]->setSampledAttachments(inputAttachments);
+		mSubpasses[mSSAOSubpassIndex]->setOutputAttachments(outputAttachments);
+		mSubpasses[mSSAOSubpassIndex]->setCoversFramebuffer(true);
+	}
+
+	// HORIZONTAL BLUR
+	// GTAO occlusion is not an attachment so only depth + normals are inputs
+	inputAttachments = mUseGroundTruthAO ?
+		std::vector<uint32_t>{ ssaoDepthAttachmentIndex, ssaoNormalAttachmentIndex } :
+		std::vector<uint32_t>{ mSSAOAttachmentIndex, ssaoDepthAttachmentIndex, ssaoNormalAttachmentIndex };
+	outputAttachments = { mBlurIntermediateAttachmentIndex };
+	mSubpasses[mBlurHorizontalSubpassIndex]->setInputAttachments(inputAttachments);
+	mSubpasses[mBlurHorizontalSubpassIndex]->setSampledAttachments(inputAttachments);
+	mSubpasses[mBlurHorizontalSubpassIndex]->setOutputAttachments(outputAttachments);
+	mSubpasses[mBlurHorizontalSubpassIndex]->setCoversFramebuffer(true);
+
+	// VERTICAL BLUR
+	inputAttachments = { mBlurIntermediateAttachmentIndex, ssaoDepthAttachmentIndex, ssaoNormalAttachmentIndex };
 	outputAttachments = { mBlurAttachmentIndex };
-	mSubpasses[2]->setInputAttachments(inputAttachments);
-	mSubpasses[2]->setOutputAttachments(outputAttachments);
+	mSubpasses[mBlurVerticalSubpassIndex]->setInputAttachments(inputAttachments);
+	mSubpasses[mBlurVerticalSubpassIndex]->setSampledAttachments(inputAttachments);
+	mSubpasses[mBlurVerticalSubpassIndex]->setOutputAttachments(outputAttachments);
+	mSubpasses[mBlurVerticalSubpassIndex]->setCoversFramebuffer(true);
+
+	// UPSAMPLE (reduced resolution only)
+	// Full resolution depth is subpass loaded, the low resolution depth and occlusion are sampled from the reduced render pass
+	if (reducedResolution)
+	{
+		inputAttachments = { mDepthAttachmentIndex };
+		outputAttachments = { mUpsampleAttachmentIndex };
+		mSubpasses[mUpsampleSubpassIndex]->setInputAttachments(inputAttachments);
+		mSubpasses[mUpsampleSubpassIndex]->setOutputAttachments(outputAttachments);
+		mSubpasses[mUpsampleSubpassIndex]->setCoversFramebuffer(true);
+	}
 
-	// SUBPASS 3 (LIGHTING)
-	inputAttachments = { mDepthAttachmentIndex, mNormalAttachmentIndex, mAlbedoAttachmentIndex, mSpecularAttachmentIndex, mBlurAttachmentIndex };
-	mSubpasses[3]->setInputAttachments(inputAttachments);
+	// LIGHTING
+	uint32_t occlusionAttachmentIndex = reducedResolution ? mUpsampleAttachmentIndex : mBlurAttachmentIndex;
+	inputAttachments = mPackedGBuffer ?
+		std::vector<uint32_t>{ mDepthAttachmentIndex, mNormalAttachmentIndex, mAlbedoAttachmentIndex, occlusionAttachmentIndex } :
+		std::vector<uint32_t>{ mDepthAttachmentIndex, mNormalAttachmentIndex, mAlbedoAttachmentIndex, mSpecularAttachmentIndex, occlusionAttachmentIndex };
+	mSubpasses[mLightingSubpassIndex]->setInputAttachments(inputAttachments);
+	mSubpasses[mLightingSubpassIndex]->setCoversFramebuffer(true);
+
+	// At reduced resolution the graph only holds the main render pass, the subpasses before upsample have render passes of their own
+	mRenderGraph->compile(mSubpasses, reducedResolution ? mUpsampleSubpassIndex : 0);
+}
 
-	// CREATE SUBPASS INFOS
-	std::vector<SubpassInfo> subpassInfos(subpassCount);
+// At reduced resolution the geometry subpass and the downsample to blur subpasses are recorded in render passes before the main render pass
+// Every attachment of both is sampled after its last write so is left in the read only layout
+void SSAOApp::createRenderPass()
+{
+	VulkanRenderer::createRenderPass();
 
-	for (uint32_t i = 0; i < subpassCount; ++i)
+	if (ssaoDownsample() == 1)
 	{
-		subpassInfos[i] = { mSubpasses[i]->inputAttachments(), mSubpasses[i]->outputAttachments() };
+		return;
 	}
 
-	// CREATE LOAD/STORE INFOS FOR ATTACHMENTS
-	// LOAD_OP - what to do with the image at the start of the renderpass
-	// STORE_OP - what to do with the image at the end of the renderpass
-	std::vector<LoadStoreInfo> loadStoreInfos = {};
+	// Written at colour output and by the depth tests, read by fragment shaders (sampled and as input attachments)
+	VkPipelineStageFlags attachmentStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+		VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	VkAccessFlags attachmentWrites = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	VkAccessFlags shaderReads = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
 
-	// Swapchain load/store
-	loadStoreInfos.push_back({ VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE });
+	// GEOMETRY RENDER PASS
+	// Attachments match the main render target's G-buffer so its images are used by the geometry framebuffers
+	auto& targetAttachments = mRenderTargets[0]->attachments();
+	auto& clearValues = mRenderGraph->clearValues();
 
-	size_t attachmentCount = mFrames[0]->renderTarget().attachments().size();
+	std::vector<Attachment> attachments;
+	std::vector<LoadStoreInfo> loadStoreInfos;
+	SubpassInfo geometrySubpass;
+	mGeometryClearValues.clear();
 
-	// Remaining load stores should all be discarded after renderpass is complete
-	for (size_t i = 0; i < attachmentCount - 1; ++i)
+	for (uint32_t attachmentIndex : mGeometryAttachments)
 	{
-		loadStoreInfos.push_back({ VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE });
+		geometrySubpass.outputAttachments.push_back(static_cast<uint32_t>(attachments.size()));
+
+		attachments.push_back(targetAttachments[attachmentIndex]);
+		attachments.back().finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		loadStoreInfos.push_back({ VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE });
+		mGeometryClearValues.push_back(clearValues[attachmentIndex]);
 	}
 
-	// CREATE RENDERPASS OBJECT
-	mRenderPass = std::make_unique<RenderPass>(*mDevice,
-		mFrames.back()->renderTarget().attachments(),
-		subpassInfos,
-		loadStoreInfos);
+	// The previous frame's main render pass read the same images, the reduced and main render passes read them next
+	std::vector<VkSubpassDependency> dependencies = {
+		subpassDependency(VK_SUBPASS_EXTERNAL, attachmentStages | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, attachmentWrites,
+			0, attachmentStages, attachmentWrites | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT),
+		subpassDependency(0, attachmentStages, attachmentWrites,
+			VK_SUBPASS_EXTERNAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, shaderReads) };
+
+	mGeometryRenderPass = std::make_unique<RenderPass>(*mDevice, attachments, std::vector<SubpassInfo>{ geometrySubpass }, loadStoreInfos, dependencies);
+
+	// REDUCED RESOLUTION RENDER PASS
+	// Every subpass writes its whole (reduced size) framebuffer so nothing is loaded
+	// Only the downsampled depth and the blurred result are read afterwards, by the upsample subpass
+	attachments.clear();
+	loadStoreInfos.clear();
+
+	for (uint32_t i = 0; i < mReducedFormats.size(); ++i)
+	{
+		attachments.emplace_back(mReducedFormats[i], VK_SAMPLE_COUNT_1_BIT, REDUCED_ATTACHMENT_USAGE);
+		attachments.back().finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		bool readAfterRenderPass = i == mDownsampleDepthAttachmentIndex || i == mBlurAttachmentIndex;
+		loadStoreInfos.push_back({ VK_ATTACHMENT_LOAD_OP_DONT_CARE, readAfterRenderPass ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE });
+	}
+
+	// The downsample subpass samples the G-buffer written by the geometry render pass
+	// Later subpasses sample the outputs of any earlier subpass, the upsample subpass samples the stored outputs
+	std::vector<SubpassInfo> subpassInfos;
+	dependencies = { subpassDependency(VK_SUBPASS_EXTERNAL, attachmentStages, attachmentWrites,
+		0, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT) };
+
+	for (uint32_t i = mDownsampleSubpassIndex; i < mUpsampleSubpassIndex; ++i)
+	{
+		auto& subpass = *mSubpasses[i];
+		uint32_t subpassIndex = i - mDownsampleSubpassIndex;
+		subpassInfos.push_back({ subpass.inputAttachments(), subpass.outputAttachments() });
+
+		for (uint32_t earlierSubpass = 0; earlierSubpass < subpassIndex; ++earlierSubpass)
+		{
+			dependencies.push_back(subpassDependency(earlierSubpass, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				subpassIndex, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, shaderReads));
+		}
+
+		auto outputs = subpass.outputAttachments();
+		bool writesStoredAttachment = std::any_of(outputs.begin(), outputs.end(), [&](uint32_t attachment) {
+			return loadStoreInfos[attachment].storeOp == VK_ATTACHMENT_STORE_OP_STORE; });
+		if (writesStoredAttachment)
+		{
+			dependencies.push_back(subpassDependency(subpassIndex, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				VK_SUBPASS_EXTERNAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT));
+		}
+	}
+
+	mReducedRenderPass = std::make_unique<RenderPass>(*mDevice, attachments, subpassInfos, loadStoreInfos, dependencies);
 }
 
 // Create layouts which will be updated at most once per frame
@@ -240,51 +376,98 @@ void SSAOApp::createPerFrameDescriptorSetLayouts()
 
 	pipelineResources[0].push_back(std::move(vpBuffer));
 
-	// Pipeline 1
-	// VP buffer
-	ShaderResource vpBuffer_SSAO(0,
-		VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-		1,
-		VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
-	pipelineResources[1].push_back(std::move(vpBuffer_SSAO));
+	// Downsample pipeline (reduced resolution only)
+	if (ssaoDownsample() > 1)
+	{
+		// Full resolution depth + normal samplers
+		for (uint32_t i = 0; i < 2; ++i)
+		{
+			ShaderResource attachmentSampler(i,
+				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+				1,
+				VK_SHADER_STAGE_FRAGMENT_BIT);
 
-	// Depth sampler
-	ShaderResource depthSampler(1,
-		VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-		1,
-		VK_SHADER_STAGE_FRAGMENT_BIT);
-	pipelineResources[1].push_back(std::move(depthSampler));
+			pipelineResources[mDownsampleSubpassIndex].push_back(std::move(attachmentSampler));
+		}
+	}
 
-	// Normal sampler
-	ShaderResource normalSampler(2,
-		VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-		1,
-		VK_SHADER_STAGE_FRAGMENT_BIT);
-	pipelineResources[1].push_back(std::move(normalSampler));
+	// SSAO pipeline (SSAO kernel only)
+	if (!mUseGroundTruthAO)
+	{
+		// VP buffer
+		ShaderResource vpBuffer_SSAO(0,
+			VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+			1,
+			VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+		pipelineResources[mSSAOSubpassIndex].push_back(std::move(vpBuffer_SSAO));
 
-	// Noise sampler
-	ShaderResource noiseSampler(3,
-		VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-		1,
-		VK_SHADER_STAGE_FRAGMENT_BIT);
-	pipelineResources[1].push_back(std::move(noiseSampler));
+		// Depth sampler
+		ShaderResource depthSampler(1,
+			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			1,
+			VK_SHADER_STAGE_FRAGMENT_BIT);
+		pipelineResources[mSSAOSubpassIndex].push_back(std::move(depthSampler));
 
-	// SSAO Buffer
-	ShaderResource ssaoBuffer(4,
-		VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-		1,
-		VK_SHADER_STAGE_FRAGMENT_BIT);
-	pipelineResources[1].push_back(std::move(ssaoBuffer));
+		// Normal sampler
+		ShaderResource normalSampler(2,
+			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			1,
+			VK_SHADER_STAGE_FRAGMENT_BIT);
+		pipelineResources[mSSAOSubpassIndex].push_back(std::move(normalSampler));
 
-	// Pipeline 2
-	// SSAO input sampler
-	ShaderResource ssaoSampler(0,
-		VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-		1,
-		VK_SHADER_STAGE_FRAGMENT_BIT);
-	pipelineResources[2].push_back(std::move(ssaoSampler));
+		// Noise sampler
+		ShaderResource noiseSampler(3,
+			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			1,
+			VK_SHADER_STAGE_FRAGMENT_BIT);
+		pipelineResources[mSSAOSubpassIndex].push_back(std::move(noiseSampler));
+
+		// SSAO Buffer
+		ShaderResource ssaoBuffer(4,
+			VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+			1,
+			VK_SHADER_STAGE_FRAGMENT_BIT);
+		pipelineResources[mSSAOSubpassIndex].push_back(std::move(ssaoBuffer));
+	}
+
+	// Blur pipelines
+	// Occlusion (SSAO attachment or GTAO image), depth + normal samplers
+	for (uint32_t blurSubpassIndex : { mBlurHorizontalSubpassIndex, mBlurVerticalSubpassIndex })
+	{
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			ShaderResource attachmentSampler(i,
+				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+				1,
+				VK_SHADER_STAGE_FRAGMENT_BIT);
+
+			pipelineResources[blurSubpassIndex].push_back(std::move(attachmentSampler));
+		}
+	}
+
+	// Upsample pipeline (reduced resolution only)
+	if (ssaoDownsample() > 1)
+	{
+		// Full resolution depth input attachment
+		ShaderResource depthAttachment(0,
+			VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT,
+			1,
+			VK_SHADER_STAGE_FRAGMENT_BIT);
+		pipelineResources[mUpsampleSubpassIndex].push_back(std::move(depthAttachment));
 
-	// Pipeline 3
+		// Low resolution depth + occlusion samplers
+		for (uint32_t i = 1; i < 3; ++i)
+		{
+			ShaderResource attachmentSampler(i,
+				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+				1,
+				VK_SHADER_STAGE_FRAGMENT_BIT);
+
+			pipelineResources[mUpsampleSubpassIndex].push_back(std::move(attachmentSampler));
+		}
+	}
+
+	// Lighting pipeline
 	// BIND INPUT ATTACHMENTS
 
 		// VP buffer
@@ -293,25 +476,32 @@ void SSAOApp::createPerFrameDescriptorSetLayouts()
 		1,
 		VK_SHADER_STAGE_VERTEX_BIT);
 
-	pipelineResources[3].push_back(std::move(vpBuffer_lights));
+	pipelineResources[mLightingSubpassIndex].push_back(std::move(vpBuffer_lights));
 
 	// For each pipeline define input attachment shader resources
-	for (uint32_t i = 1; i <= mSubpasses[3]->inputAttachments().size(); ++i)
+	for (uint32_t i = 1; i <= mSubpasses[mLightingSubpassIndex]->inputAttachments().size(); ++i)
 	{
 		ShaderResource attachment(i,
 			VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT,
 			1,
 			VK_SHADER_STAGE_FRAGMENT_BIT);
 
-		pipelineResources[3].push_back(std::move(attachment));
+		pipelineResources[mLightingSubpassIndex].push_back(std::move(attachment));
 	}
 
 	// Lights buffer
 	ShaderResource lightBuffer(6,
-		VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
 		1,
 		VK_SHADER_STAGE_FRAGMENT_BIT);
-	pipelineResources[3].push_back(std::move(lightBuffer));
+	pipelineResources[mLightingSubpassIndex].push_back(std::move(lightBuffer));
+
+	// Light cluster buffer
+	ShaderResource clusterBuffer(7,
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		1,
+		VK_SHADER_STAGE_FRAGMENT_BIT);
+	pipelineResources[mLightingSubpassIndex].push_back(std::move(clusterBuffer));
 
 	// Create set layouts in frame objects for each pipeline
 	for (auto& frame : mFrames)
@@ -323,26 +513,82 @@ void SSAOApp::createPerFrameDescriptorSetLayouts()
 	}
 }
 
+void SSAOApp::setSSAOSampleCount(uint32_t sampleCount)
+{
+	mSSAOSampleCount = std::clamp(sampleCount, 1u, static_cast<uint32_t>(SSAO_MAX_SAMPLE_COUNT));
+}
+
+void SSAOApp::setSSAOBlurRadius(uint32_t radius)
+{
+	mSSAOBlurRadius = std::clamp(radius, 1u, static_cast<uint32_t>(SSAO_MAX_BLUR_RADIUS));
+}
+
+void SSAOApp::setSSAODownsample(uint32_t downsample)
+{
+	mSSAODownsample = std::clamp(downsample, 1u, static_cast<uint32_t>(SSAO_MAX_DOWNSAMPLE));
+}
+
+void SSAOApp::setGroundTruthAO(bool groundTruthAO)
+{
+	mUseGroundTruthAO = groundTruthAO;
+}
+
+// GTAO is computed at full resolution before the render pass so the downsample setting is ignored, it is kept in case GTAO is turned off
+uint32_t SSAOApp::ssaoDownsample() const
+{
+	return mUseGroundTruthAO ? 1 : mSSAODownsample;
+}
+
+void SSAOApp::setPointLightCount(uint32_t pointLightCount)
+{
+	mPointLightCount = pointLightCount;
+}
+
 void SSAOApp::createPipelines()
 {
 	mPipelineLayouts.resize(mSubpasses.size());
 	mPipelines.resize(mSubpasses.size());
-	std::vector<std::vector<ShaderModule>> shaderModules(mSubpasses.size());
 
-	// Create shader modules
-	for (size_t i = 0; i < shaderModules.size(); ++i)
+	// SPECIALIZATION CONSTANTS
+	// SSAO - sample count and clip planes used to linearise depth
+	SpecializationConstants ssaoConstants;
+	ssaoConstants.set(SPECIALIZATION_SSAO_SAMPLE_COUNT, static_cast<int32_t>(mSSAOSampleCount));
+	ssaoConstants.set(SPECIALIZATION_Z_NEAR, mNearPlane);
+	ssaoConstants.set(SPECIALIZATION_Z_FAR, mFarPlane);
+	if (!mUseGroundTruthAO)
 	{
-		std::vector<char> vertexCode = readFile(mSubpasses[i]->vertexShaderSource());
-		shaderModules[i].emplace_back(*mDevice,
-			vertexCode,
-			VK_SHADER_STAGE_VERTEX_BIT);
+		mSubpasses[mSSAOSubpassIndex]->setFragmentSpecializationConstants(ssaoConstants);
+	}
 
-		std::vector<char> fragCode = readFile(mSubpasses[i]->fragmentShaderSource());
-		shaderModules[i].emplace_back(*mDevice,
-			fragCode,
-			VK_SHADER_STAGE_FRAGMENT_BIT);
+	// BLUR - clip planes, kernel radius and direction
+	SpecializationConstants blurConstants;
+	blurConstants.set(SPECIALIZATION_Z_NEAR, mNearPlane);
+	blurConstants.set(SPECIALIZATION_Z_FAR, mFarPlane);
+	blurConstants.set(SPECIALIZATION_SSAO_BLUR_RADIUS, static_cast<int32_t>(mSSAOBlurRadius));
+
+	blurConstants.set(SPECIALIZATION_SSAO_BLUR_VERTICAL, static_cast<VkBool32>(false));
+	mSubpasses[mBlurHorizontalSubpassIndex]->setFragmentSpecializationConstants(blurConstants);
+
+	blurConstants.set(SPECIALIZATION_SSAO_BLUR_VERTICAL, static_cast<VkBool32>(true));
+	mSubpasses[mBlurVerticalSubpassIndex]->setFragmentSpecializationConstants(blurConstants);
+
+	// DOWNSAMPLE + UPSAMPLE - footprint of each downsampled texel and clip planes used to compare depths
+	if (ssaoDownsample() > 1)
+	{
+		SpecializationConstants downsampleConstants;
+		downsampleConstants.set(SPECIALIZATION_SSAO_DOWNSAMPLE, static_cast<int32_t>(ssaoDownsample()));
+
+		mSubpasses[mDownsampleSubpassIndex]->setFragmentSpecializationConstants(downsampleConstants);
+		mSubpasses[mUpsampleSubpassIndex]->setFragmentSpecializationConstants(ssaoConstants);
 	}
 
+	// LIGHTING - clip planes and light cluster grid
+	SpecializationConstants lightingConstants;
+	lightingConstants.set(SPECIALIZATION_Z_NEAR, mNearPlane);
+	lightingConstants.set(SPECIALIZATION_Z_FAR, mFarPlane);
+	LightClusters::setSpecializationConstants(lightingConstants);
+	mSubpasses[mLightingSubpassIndex]->setFragmentSpecializationConstants(lightingConstants);
+
 	// PIPELINE 0 - this pipeline has the addition layout for per material descriptors and also requires a push constant range due to use of push constants
 	// CREATE PIPELINE LAYOUT
 	std::vector<std::reference_wrapper<const DescriptorSetLayout>> descriptorSetLayouts = { mFrames[0]->descriptorSetLayout(0) , *mPerMaterialDescriptorSetLayout };
@@ -350,17 +596,33 @@ void SSAOApp::createPipelines()
 	mPipelineLayouts[0] = std::make_unique<PipelineLayout>(*mDevice, descriptorSetLayouts, mPushConstantRange);
 
 	// CREATE PIPELINE
-	mPipelines[0] = std::make_unique<GraphicsPipeline>(*mDevice,
-		shaderModules[0],
-		*mSwapchain,
-		*mPipelineLayouts[0],
-		*mRenderPass,
-		0,
-		VK_TRUE,
-		VK_TRUE);
+	// G-buffer outputs are opaque so blending stays off on every attachment
+	// At reduced resolution each pipeline is created for its subpass within the geometry, reduced or main render pass
+	bool reducedResolution = ssaoDownsample() > 1;
+
+	PipelineState geometryState;
+	geometryState.setVertexInputState(PipelineState::meshVertexInputState());
+
+	// With GTAO depth is loaded from the prepass so only fragments on the nearest surface are shaded
+	if (mUseGroundTruthAO)
+	{
+		DepthStencilState geometryDepthStencilState;
+		geometryDepthStencilState.depthWriteEnable = VK_FALSE;
+		geometryDepthStencilState.depthCompareOp = VK_COMPARE_OP_EQUAL;
+		geometryState.setDepthStencilState(geometryDepthStencilState);
+	}
+
+	if (reducedResolution)
+	{
+		createPipelineAsync(0, geometryState, *mGeometryRenderPass, 0);
+	}
+	else
+	{
+		createPipelineAsync(0, geometryState);
+	}
 
 	// Remaining pipelines can be generated in the same fashion as they all draw their descriptor set layout from the frame objects
-	for (size_t i = 1; i < shaderModules.size(); ++i)
+	for (size_t i = 1; i < mSubpasses.size(); ++i)
 	{
 		uint32_t subpassIndex = static_cast<uint32_t>(i);
 
@@ -370,14 +632,38 @@ void SSAOApp::createPipelines()
 		mPipelineLayouts[i] = std::make_unique<PipelineLayout>(*mDevice, descriptorSetLayouts);
 
 		// CREATE PIPELINE
-		mPipelines[i] = std::make_unique<GraphicsPipeline>(*mDevice,
-			shaderModules[i],
-			*mSwapchain,
-			*mPipelineLayouts[i],
-			*mRenderPass,
-			subpassIndex,
-			VK_FALSE,
-			VK_FALSE);
+		if (!reducedResolution)
+		{
+			createPipelineAsync(subpassIndex, PipelineState::fullscreen());
+		}
+		else if (subpassIndex < mUpsampleSubpassIndex)
+		{
+			createPipelineAsync(subpassIndex, PipelineState::fullscreen(), *mReducedRenderPass, subpassIndex - mDownsampleSubpassIndex);
+		}
+		else
+		{
+			createPipelineAsync(subpassIndex, PipelineState::fullscreen(), *mRenderPass, subpassIndex - mUpsampleSubpassIndex);
+		}
+	}
+
+	// GROUND TRUTH AO
+	// The depth prepass has its own render pass, it shares the geometry vertex shader and pipeline 0's layout
+	if (mUseGroundTruthAO)
+	{
+		mGroundTruthAO = std::make_unique<GroundTruthAO>(*mDevice, mDepthFormat, mNearPlane, mFarPlane);
+		mDepthPrepassSubpass = std::make_unique<Subpass>("Shaders/SSAOApp/geometry_vert.spv");
+
+		PipelineState depthPrepassState;
+		depthPrepassState.setVertexInputState(PipelineState::meshVertexInputState());
+
+		mJobSystem->submit([this, depthPrepassState](size_t threadIndex) {
+			mGroundTruthAO->createPipeline();
+			mDepthPrepassPipeline = &mPipelineRegistry->request(*mDepthPrepassSubpass,
+				*mPipelineLayouts[0],
+				mGroundTruthAO->depthRenderPass(),
+				0,
+				depthPrepassState);
+			}, mPipelineCounter);
 	}
 }
 
@@ -386,23 +672,25 @@ void SSAOApp::createPerFrameResources()
 	// CREATE UNIFORM BUFFERS
 	// Buffer sizes
 	VkDeviceSize vpBufferSize = sizeof(uboVP);
-	VkDeviceSize lightBufferSize = sizeof(uboLights);
 
-	// Create VP and lighting buffers
+	// Create VP buffers
 	for (size_t i = 0; i < mFrames.size(); ++i)
 	{
 		mVPBufferIndex = mFrames[i]->createBuffer(vpBufferSize,
 			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-		mLightBufferIndex = mFrames[i]->createBuffer(lightBufferSize,
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 	}
 
 	// Lights
 	createLights();
 
+	// Light buffers + clusters for each frame in flight, the culling pipeline compiles alongside the subpass pipelines
+	mLightClusters = std::make_unique<LightClusters>(*mDevice, static_cast<uint32_t>(mFrames.size()), mPointLightCount, mNearPlane, mFarPlane);
+
+	mJobSystem->submit([this](size_t threadIndex) {
+		mLightClusters->createPipeline();
+		}, mPipelineCounter);
+
 	// SSAO kernel + noise texture
 	createSSAOResources();
 
@@ -413,79 +701,167 @@ void SSAOApp::createPerFrameResources()
 
 void SSAOApp::createPerFrameDescriptorSets()
 {
-	for (size_t i = 0; i < mFrames.size(); ++i)
+	// GTAO images and reduced targets are sized by the swapchain extent and GTAO renders into the render targets' depth
+	// so both are recreated with the descriptor sets
+	bool reducedResolution = ssaoDownsample() > 1;
+	if (mUseGroundTruthAO)
 	{
+		mGroundTruthAO->createImages(mRenderTargets, mDepthAttachmentIndex);
+	}
+
+	if (reducedResolution)
+	{
+		createReducedTargets();
+	}
+
+	for (uint32_t frameIndex = 0; frameIndex < mFrames.size(); ++frameIndex)
+	{
+		auto& frame = mFrames[frameIndex];
+
 		// Bind image and buffers to resource reference
 		DescriptorResourceReference descriptorSetResourceReference;
 		BindingMap<uint32_t> bufferIndices;
 
-		// Get render target images to create sampler desctiptors
-		auto& targetImages = mFrames[i]->renderTarget().imageViews();
-
 		//************************************
 
-		// PIPELINE 0 (Lighting)
-		// - RESOURCE REFERENCES
-		// VP buffer
-		bufferIndices[0][0] = mVPBufferIndex;
-
-		// - DESCRIPTOR SET
-		mFrames[i]->createDescriptorSet(0, descriptorSetResourceReference, bufferIndices);
-
-		descriptorSetResourceReference.reset();
-		bufferIndices.clear();
-
-		// PIPELINE 1
+		// PIPELINE 0 (Geometry)
 		// - RESOURCE REFERENCES
 		// VP buffer
 		bufferIndices[0][0] = mVPBufferIndex;
 
-		// Depth sampler
-		descriptorSetResourceReference.bindImage(targetImages[mDepthAttachmentIndex], *mDepthSampler, 1, 0);
-
-		// Normal sampler
-		descriptorSetResourceReference.bindImage(targetImages[mNormalAttachmentIndex], *mNormalSampler, 2, 0);
-
-		// Noise sampler
-		descriptorSetResourceReference.bindImage(mNoiseTexture->imageView(), *mNoiseSampler, 3, 0);
-
-		// SSAO kernel buffer
-		bufferIndices[4][0] = mSSAOBufferIndex;
-
 		// - DESCRIPTOR SET
-		mFrames[i]->createDescriptorSet(1, descriptorSetResourceReference, bufferIndices);
+		frame->createDescriptorSet(0, descriptorSetResourceReference, bufferIndices);
 
 		descriptorSetResourceReference.reset();
 		bufferIndices.clear();
 
-		// PIPELINE 2
-		// - RESOURCE REFERENCES
-		// Input attachments
-		descriptorSetResourceReference.bindImage(targetImages[mSSAOAttachmentIndex], *mSSAOSampler, 0, 0);
-
-		// - DESCRIPTOR SET
-		mFrames[i]->createDescriptorSet(2, descriptorSetResourceReference, bufferIndices);
-
-		descriptorSetResourceReference.reset();
-		bufferIndices.clear();
-
-		// PIPELINE 3 (Lighting)
-		// - RESOURCE REFERENCES
-		bufferIndices[0][0] = mVPBufferIndex;
-
-		descriptorSetResourceReference.bindInputImage(targetImages[mDepthAttachmentIndex], 1, 0);
-		descriptorSetResourceReference.bindInputImage(targetImages[mNormalAttachmentIndex], 2, 0);
-		descriptorSetResourceReference.bindInputImage(targetImages[mAlbedoAttachmentIndex], 3, 0);
-		descriptorSetResourceReference.bindInputImage(targetImages[mSpecularAttachmentIndex], 4, 0);
-		descriptorSetResourceReference.bindInputImage(targetImages[mBlurAttachmentIndex], 5, 0);
-
-		bufferIndices[6][0] = mLightBufferIndex;
-
-		
-
-		// - DESCRIPTOR SET
-		mFrames[i]->createDescriptorSet(3, descriptorSetResourceReference, bufferIndices);
-
+		// Remaining pipelines reference attachments so a set is created for each render target
+		for (uint32_t target = 0; target < mRenderTargets.size(); ++target)
+		{
+			// Get render target images to create sampler desctiptors
+			// SSAO and blur attachments are in the frame's reduced target at reduced resolution
+			auto& targetImages = mRenderTargets[target]->imageViews();
+			auto& ssaoImages = reducedResolution ? mReducedTargets[frameIndex]->imageViews() : targetImages;
+
+			// DOWNSAMPLE PIPELINE (reduced resolution only)
+			if (reducedResolution)
+			{
+				// - RESOURCE REFERENCES
+				descriptorSetResourceReference.bindImage(targetImages[mDepthAttachmentIndex], *mDepthSampler, 0, 0);
+				descriptorSetResourceReference.bindImage(targetImages[mNormalAttachmentIndex], *mNormalSampler, 1, 0);
+
+				// - DESCRIPTOR SET
+				frame->createDescriptorSet(mDownsampleSubpassIndex, descriptorSetResourceReference, bufferIndices, target);
+
+				descriptorSetResourceReference.reset();
+				bufferIndices.clear();
+			}
+
+			// SSAO PIPELINE (SSAO kernel only)
+			if (!mUseGroundTruthAO)
+			{
+				// - RESOURCE REFERENCES
+				// VP buffer
+				bufferIndices[0][0] = mVPBufferIndex;
+
+				// Depth + normal samplers, the downsampled attachments are point sampled as filtering across their texels mixes unrelated surfaces
+				if (reducedResolution)
+				{
+					descriptorSetResourceReference.bindImage(ssaoImages[mDownsampleDepthAttachmentIndex], *mDownsampleSampler, 1, 0);
+					descriptorSetResourceReference.bindImage(ssaoImages[mDownsampleNormalAttachmentIndex], *mDownsampleSampler, 2, 0);
+				}
+				else
+				{
+					descriptorSetResourceReference.bindImage(targetImages[mDepthAttachmentIndex], *mDepthSampler, 1, 0);
+					descriptorSetResourceReference.bindImage(targetImages[mNormalAttachmentIndex], *mNormalSampler, 2, 0);
+				}
+
+				// Noise sampler
+				descriptorSetResourceReference.bindImage(mNoiseTexture->imageView(), *mNoiseSampler, 3, 0);
+
+				// SSAO kernel buffer
+				bufferIndices[4][0] = mSSAOBufferIndex;
+
+				// - DESCRIPTOR SET
+				frame->createDescriptorSet(mSSAOSubpassIndex, descriptorSetResourceReference, bufferIndices, target);
+
+				descriptorSetResourceReference.reset();
+				bufferIndices.clear();
+			}
+
+			// BLUR PIPELINES
+			// Occlusion is read from the previous subpass (or the render target's GTAO image), depth + normals match the SSAO resolution
+			std::pair<uint32_t, uint32_t> blurPasses[] = {
+				{ mBlurHorizontalSubpassIndex, mSSAOAttachmentIndex },
+				{ mBlurVerticalSubpassIndex, mBlurIntermediateAttachmentIndex } };
+
+			for (auto& [blurSubpassIndex, occlusionAttachmentIndex] : blurPasses)
+			{
+				// - RESOURCE REFERENCES
+				if (mUseGroundTruthAO && blurSubpassIndex == mBlurHorizontalSubpassIndex)
+				{
+					descriptorSetResourceReference.bindImage(mGroundTruthAO->occlusionImageView(target), *mSSAOSampler, 0, 0);
+				}
+				else
+				{
+					descriptorSetResourceReference.bindImage(ssaoImages[occlusionAttachmentIndex], *mSSAOSampler, 0, 0);
+				}
+
+				if (reducedResolution)
+				{
+					descriptorSetResourceReference.bindImage(ssaoImages[mDownsampleDepthAttachmentIndex], *mDownsampleSampler, 1, 0);
+					descriptorSetResourceReference.bindImage(ssaoImages[mDownsampleNormalAttachmentIndex], *mDownsampleSampler, 2, 0);
+				}
+				else
+				{
+					descriptorSetResourceReference.bindImage(targetImages[mDepthAttachmentIndex], *mDepthSampler, 1, 0);
+					descriptorSetResourceReference.bindImage(targetImages[mNormalAttachmentIndex], *mNormalSampler, 2, 0);
+				}
+
+				// - DESCRIPTOR SET
+				frame->createDescriptorSet(blurSubpassIndex, descriptorSetResourceReference, bufferIndices, target);
+
+				descriptorSetResourceReference.reset();
+				bufferIndices.clear();
+			}
+
+			// UPSAMPLE PIPELINE (reduced resolution only)
+			if (reducedResolution)
+			{
+				// - RESOURCE REFERENCES
+				descriptorSetResourceReference.bindInputImage(targetImages[mDepthAttachmentIndex], 0, 0);
+				descriptorSetResourceReference.bindImage(ssaoImages[mDownsampleDepthAttachmentIndex], *mDownsampleSampler, 1, 0);
+				descriptorSetResourceReference.bindImage(ssaoImages[mBlurAttachmentIndex], *mDownsampleSampler, 2, 0);
+
+				// - DESCRIPTOR SET
+				frame->createDescriptorSet(mUpsampleSubpassIndex, descriptorSetResourceReference, bufferIndices, target);
+
+				descriptorSetResourceReference.reset();
+				bufferIndices.clear();
+			}
+
+			// LIGHTING PIPELINE
+			// - RESOURCE REFERENCES
+			bufferIndices[0][0] = mVPBufferIndex;
+
+			// Input attachments are bound in subpass order from binding 1
+			auto lightingInputs = mSubpasses[mLightingSubpassIndex]->inputAttachments();
+			for (uint32_t i = 0; i < lightingInputs.size(); ++i)
+			{
+				descriptorSetResourceReference.bindInputImage(targetImages[lightingInputs[i]], i + 1, 0);
+			}
+
+			auto& lightBuffer = mLightClusters->lightBuffer(frameIndex);
+			auto& clusterBuffer = mLightClusters->clusterBuffer(frameIndex);
+			descriptorSetResourceReference.bindBuffer(lightBuffer, 0, lightBuffer.size(), 6, 0);
+			descriptorSetResourceReference.bindBuffer(clusterBuffer, 0, clusterBuffer.size(), 7, 0);
+
+			// - DESCRIPTOR SET
+			frame->createDescriptorSet(mLightingSubpassIndex, descriptorSetResourceReference, bufferIndices, target);
+
+			descriptorSetResourceReference.reset();
+			bufferIndices.clear();
+		}
 	}
 }
 
@@ -496,13 +872,13 @@ void SSAOApp::createSSAOResources()
 
 	uboSSAO ssaoBuffer;
 	// Radius and Bias
-	ssaoBuffer.radius = 2.;
+	ssaoBuffer.radius = mAORadius;
 	ssaoBuffer.bias = 0.025;
 	ssaoBuffer.power = 8.0;
 
 	// KERNEL
 	auto& kernel = ssaoBuffer.ssaoKernel;
-	for (size_t i = 0; i < SAMPLE_COUNT; ++i)
+	for (size_t i = 0; i < mSSAOSampleCount; ++i)
 	{
 		// x and y in rnage of [-1,1]
 		// z in range of [0,1] creating a hemisphere of samples rather than sphere
@@ -516,7 +892,7 @@ void SSAOApp::createSSAOResources()
 		sample *= distribution(generator);
 
 		// Use accelerating interpolation so that samples are weighted towards the centre of the hemisphere
-		float scale = (float)i / SAMPLE_COUNT;
+		float scale = (float)i / mSSAOSampleCount;
 		scale = lerp(0.1f, 1.0f, scale * scale);
 		sample *= scale;
 
@@ -611,6 +987,56 @@ void SSAOApp::createAttachmentSamplers()
 		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
 		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
 
+	// Reduced resolution attachments are read texel for texel
+	mDownsampleSampler = std::make_unique<Sampler>(
+		*mDevice,
+		VK_FALSE,
+		0.0f,
+		0.0f,
+		0.0f,
+		0.0f,
+		VK_FILTER_NEAREST,
+		VK_FILTER_NEAREST,
+		VK_SAMPLER_MIPMAP_MODE_NEAREST,
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+
+}
+
+// Reduced targets are held for each frame in flight at the reduced extent set by setViewportAndScissor
+// The geometry framebuffers use the G-buffer images of each render target so are recreated with them
+void SSAOApp::createReducedTargets()
+{
+	mGeometryFramebuffers.clear();
+	mReducedFramebuffers.clear();
+	mReducedTargets.clear();
+
+	uint32_t downsample = ssaoDownsample();
+	VkExtent2D extent = mSwapchain->extent();
+	extent.width = (extent.width + downsample - 1) / downsample;
+	extent.height = (extent.height + downsample - 1) / downsample;
+
+	for (size_t i = 0; i < mFrames.size(); ++i)
+	{
+		std::vector<Image> images;
+		for (VkFormat format : mReducedFormats)
+		{
+			images.emplace_back(*mDevice,
+				extent,
+				format,
+				REDUCED_ATTACHMENT_USAGE,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		}
+
+		mReducedTargets.push_back(std::make_unique<RenderTarget>(std::move(images)));
+		mReducedFramebuffers.push_back(std::make_unique<Framebuffer>(*mDevice, *mReducedRenderPass, *mReducedTargets.back()));
+	}
+
+	for (auto& renderTarget : mRenderTargets)
+	{
+		mGeometryFramebuffers.push_back(std::make_unique<Framebuffer>(*mDevice, *mGeometryRenderPass, *renderTarget, mGeometryAttachments));
+	}
 }
 
 
@@ -623,27 +1049,23 @@ void SSAOApp::updatePerFrameResources()
 
 	// Set light values
 	// - Point lights
-	mLights.pointLights[0].position.x = 100 * sin(sumTime);
-	mLights.pointLights[1].position.x = 0;
-	mLights.pointLights[2].position.x = -100 * sin(sumTime);
-
-	// set yz values
-	for (auto& light : mLights.pointLights)
+	// The first lights sweep across the scene, the remaining lights bob around their origins
+	const float sweepDistance[MAX_POINT_LIGHTS] = { 100.0f, 0.0f, -100.0f };
+	for (uint32_t i = 0; i < mLightManager.pointLightCount(); ++i)
 	{
-		light.position.y = 30.0f;
-		light.position.z = 0.0f;
-	}
+		glm::vec4 offset = i < MAX_POINT_LIGHTS ?
+			glm::vec4(sweepDistance[i] * sin(sumTime), 0.0f, 0.0f, 0.0f) :
+			glm::vec4(0.0f, 5.0f * sin(sumTime + i), 0.0f, 0.0f);
 
-	// Convert positions to view space
-	// Note that flashlight pos and dir are already in view space so no conversion is necessary
-	for (auto& light : mLights.pointLights)
-	{
-		light.position = mCameraMatrices.V * light.position;
+		mLightManager.setPosition(i, glm::vec3(mPointLightOrigins[i] + offset));
 	}
 
 	// Update buffers
+	// Only lights intersecting the view frustum are uploaded, their positions are transformed to view space as they are culled
+	// Note that flashlight pos and dir are already in view space so no conversion is necessary
 	mFrames[activeFrameIndex]->updateBuffer(mVPBufferIndex, mCameraMatrices);
-	mFrames[activeFrameIndex]->updateBuffer(mLightBufferIndex, mLights);
+	mLightManager.update(mCameraMatrices.V, mCameraMatrices.P);
+	mLightClusters->updateLights(activeFrameIndex, mFlashLight, mLightManager.visibleLights());
 }
 
 // Set required extensions + features
@@ -659,156 +1081,231 @@ void SSAOApp::getRequiredExtenstionAndFeatures(std::vector<const char*>& require
 
 void SSAOApp::createLights()
 {
-	// Point Light identical starting positions + intensity
-	for (auto& pointLight : mLights.pointLights)
+	mLightManager.clear();
+	mLightManager.reserve(mPointLightCount);
+	mPointLightOrigins.resize(mPointLightCount);
+
+	// First point lights have identical starting positions + intensity
+	const glm::vec4 colours[MAX_POINT_LIGHTS] = {
+		glm::vec4(1.0, 0.5, 0.5, 1.0),
+		glm::vec4(0.5, 1.0, 0.5, 1.0),
+		glm::vec4(0.5, 0.5, 1.0, 1.0) };
+
+	for (uint32_t i = 0; i < std::min(mPointLightCount, MAX_POINT_LIGHTS); ++i)
 	{
+		PointLight pointLight;
+
 		// Position + intensity
-		pointLight.position.x = 0.0f;
-		pointLight.position.y = 30.0f;
-		pointLight.position.z = 0.0f;
+		mPointLightOrigins[i] = glm::vec4(0.0f, 30.0f, 0.0f, 1.0f);
+		pointLight.position = mPointLightOrigins[i];
 		pointLight.intensityAndAttenuation.x = 50.0f;
 
 		// Attenuation constants
 		pointLight.intensityAndAttenuation.y = 0.07f;	// Kq
 		pointLight.intensityAndAttenuation.z = 0.14f;	// Kl
 		pointLight.intensityAndAttenuation.w = 1.0f;	// Kc
+
+		// Colours
+		pointLight.colour = colours[i];
+
+		mLightManager.addPointLight(pointLight);
+	}
+
+	// Remaining point lights are small, randomly coloured and scattered through the scene
+	std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+	std::default_random_engine generator;
+
+	for (uint32_t i = MAX_POINT_LIGHTS; i < mPointLightCount; ++i)
+	{
+		PointLight pointLight;
+
+		mPointLightOrigins[i] = glm::vec4(
+			distribution(generator) * 240.0f - 120.0f,
+			distribution(generator) * 75.0f + 5.0f,
+			distribution(generator) * 90.0f - 45.0f,
+			1.0f);
+		pointLight.position = mPointLightOrigins[i];
+		pointLight.intensityAndAttenuation = glm::vec4(10.0f, 1.0f, 0.35f, 1.0f);
+		pointLight.colour = glm::vec4(distribution(generator), distribution(generator), distribution(generator), 1.0f);
+
+		mLightManager.addPointLight(pointLight);
 	}
-	// Colours
-	mLights.pointLights[0].colour = glm::vec4(1.0, 0.5, 0.5, 1.0);
-	mLights.pointLights[1].colour = glm::vec4(0.5, 1.0, 0.5, 1.0);
-	mLights.pointLights[2].colour = glm::vec4(0.5, 0.5, 1.0, 1.0);
 
 	// Flash Light
 	// Position and direction always the same since can be taken from view space
 	// e.g. position will always be (0,0,0) and direction will be (0,0,-1)
-	mLights.flashLight.position = glm::vec4(0.0);
-	mLights.flashLight.direction = glm::vec4(0.0, 0.0, -1.0, 0.0);
-	mLights.flashLight.intensityAndAttenuation = glm::vec4(75.0f, 0.07f, 0.14f, 1.0f);
-	mLights.flashLight.colour = glm::vec4(1.0);
+	mFlashLight.position = glm::vec4(0.0);
+	mFlashLight.direction = glm::vec4(0.0, 0.0, -1.0, 0.0);
+	mFlashLight.intensityAndAttenuation = glm::vec4(75.0f, 0.07f, 0.14f, 1.0f);
+	mFlashLight.colour = glm::vec4(1.0);
 
-	mLights.flashLight.innerCutOff = cos(glm::radians(20.0f)); // This should set an overall cone of 40 degrees
-	mLights.flashLight.outerCutOff = cos(glm::radians(30.0f)); // This should set an overall cone of 60 degrees
+	mFlashLight.innerCutOff = cos(glm::radians(20.0f)); // This should set an overall cone of 40 degrees
+	mFlashLight.outerCutOff = cos(glm::radians(30.0f)); // This should set an overall cone of 60 degrees
 
 }
 
 void SSAOApp::recordCommands(CommandBuffer& primaryCmdBuffer) // Current image is swapchain index
 {
-	auto& frame = mFrames[activeFrameIndex];
-	auto& framebuffer = mFramebuffers[activeFrameIndex];
+	auto& renderTarget = *mRenderTargets[activeImageIndex];
+	auto& framebuffer = mFramebuffers[activeImageIndex];
 
 	primaryCmdBuffer.beginRecording();
 
-	// Set all clear values
-	std::vector<VkClearValue> clearValues;
-	clearValues.resize(frame->renderTarget().imageViews().size());
+	// LIGHT CULLING
+	// Lights are uploaded in view space
+	mLightClusters->recordCulling(primaryCmdBuffer, activeFrameIndex, mCameraMatrices.P, glm::mat4(1.0f));
 
-	// All but the last render target are colour attachments
-	for (size_t i = 0; i < clearValues.size(); ++i)
+	// GROUND TRUTH AO
+	// Compute cannot run inside the render pass so depth is rendered by a prepass and occlusion is ready before the render pass begins
+	// The prepass renders into the render target's depth which the render pass then loads
+	if (mUseGroundTruthAO)
 	{
-		clearValues[i].color = { 0.0f, 0.0f, 0.0f, 1.0f };
-
+		recordDepthPrepass(primaryCmdBuffer);
+		mGroundTruthAO->recordOcclusion(primaryCmdBuffer, activeImageIndex, mCameraMatrices.P, mAORadius);
 	}
-	// Final attachment is depth attachment
-	clearValues.back().depthStencil.depth = 1.0f;
 
-	//clearValue.depthStencil.depth = 1.0f;
-	// BEGIN RENDERPASS / SUBPASS 0
-	primaryCmdBuffer.beginRenderPass(frame->renderTarget(),
-		*mRenderPass,
-		*framebuffer,
-		clearValues,
-		VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
-
-	// TODO : implement transparency ordering
-	// Split meshes to draw equally between threads
-	// Create vector of references to meshes
-	std::vector<std::reference_wrapper<Mesh>> meshList;
-	for (auto& model : mModelList)
+	// REDUCED RESOLUTION SSAO
+	// The G-buffer and the reduced resolution subpasses have render passes of their own, the main render pass then upsamples and lights
+	if (ssaoDownsample() > 1)
 	{
-		for (size_t i = 0; i < model.meshCount(); ++i)
-		{
-			auto& mesh = model.mesh(i);
-			meshList.push_back(mesh);
-		}
-	}
+		// GEOMETRY RENDER PASS
+		primaryCmdBuffer.beginRenderPass(renderTarget,
+			*mGeometryRenderPass,
+			*mGeometryFramebuffers[activeImageIndex],
+			mGeometryClearValues,
+			VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-	uint32_t meshCount = static_cast<uint32_t>(meshList.size());
-	float avgMeshesPerBuffer = static_cast<float>(meshCount) / mThreadCount;
-	uint32_t remainderMeshes;
+		recordGeometry(primaryCmdBuffer);
 
-	uint32_t meshesPerBuffer = static_cast<uint32_t> (std::floor(avgMeshesPerBuffer));
-	if (meshesPerBuffer == 0)
-	{
-		remainderMeshes = meshCount;
+		primaryCmdBuffer.endRenderPass();
+
+		// REDUCED RESOLUTION RENDER PASS
+		// Nothing is cleared so no clear values are given
+		primaryCmdBuffer.beginRenderPass(*mReducedTargets[activeFrameIndex],
+			*mReducedRenderPass,
+			*mReducedFramebuffers[activeFrameIndex],
+			{},
+			VK_SUBPASS_CONTENTS_INLINE);
+
+		recordFullscreenSubpasses(primaryCmdBuffer, mDownsampleSubpassIndex, mUpsampleSubpassIndex, ssaoDownsample());
+
+		primaryCmdBuffer.endRenderPass();
+
+		// MAIN RENDER PASS
+		primaryCmdBuffer.beginRenderPass(renderTarget,
+			*mRenderPass,
+			*framebuffer,
+			mRenderGraph->clearValues(),
+			VK_SUBPASS_CONTENTS_INLINE);
+
+		recordFullscreenSubpasses(primaryCmdBuffer, mUpsampleSubpassIndex, static_cast<uint32_t>(mSubpasses.size()), 1);
+
+		primaryCmdBuffer.endRenderPass();
 	}
 	else
 	{
-		remainderMeshes = meshCount % meshesPerBuffer;
-	}
+		// BEGIN RENDERPASS / SUBPASS 0
+		primaryCmdBuffer.beginRenderPass(renderTarget,
+			*mRenderPass,
+			*framebuffer,
+			mRenderGraph->clearValues(),
+			VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-	uint32_t meshStart = 0;
+		recordGeometry(primaryCmdBuffer);
 
-	// Vector for results of tasks pushed to threadpool
-	std::vector<std::future<CommandBuffer*>> futureSecondaryCommandBuffers;
+		// Record remaining subpasses on primary comman buffers
+		// All remaining subpass perform fragment shader operations rendered to a full screen triangle
+		primaryCmdBuffer.nextSubpass(VK_SUBPASS_CONTENTS_INLINE);
+		recordFullscreenSubpasses(primaryCmdBuffer, 1, static_cast<uint32_t>(mSubpasses.size()), 1);
 
-	for (uint32_t i = 0; i < mThreadCount; ++i)
-	{
-		// Get the end index for the last mesh which will be handled by this buffer
-		uint32_t meshEnd = std::min(meshCount, meshStart + meshesPerBuffer);
+		// End Render Pass
+		primaryCmdBuffer.endRenderPass();
+	}
 
-		// If there are still remainder draws then add a draw to this command buffer
-		// Latter command buffers may contain fewer draws
-		if (remainderMeshes > 0)
-		{
-			meshEnd++;
-			remainderMeshes--;
-		}
+	// STOP RECORDING
+	primaryCmdBuffer.endRecording();
 
-		// Push lambda function to threadpool for running
-		auto futureResult = mThreadPool.push([=, &primaryCmdBuffer](size_t threadIndex) {
-			return recordSecondaryCommandBuffers(&primaryCmdBuffer, meshList, meshStart, meshEnd, threadIndex);
-			});
+}
 
-		futureSecondaryCommandBuffers.push_back(std::move(futureResult));
+// Geometry draws are recorded to secondary command buffers in parallel, the geometry subpass must be the current subpass
+void SSAOApp::recordGeometry(CommandBuffer& primaryCmdBuffer)
+{
+	// TODO : implement transparency ordering
+	// Split the draw list into one batch per thread and record each batch to a secondary command buffer
+	uint32_t meshCount = static_cast<uint32_t>(mDrawList.size());
+	uint32_t meshesPerBuffer = std::max<uint32_t>(1, (meshCount + mThreadCount - 1) / mThreadCount);
 
-		meshStart = meshEnd;
-	}
+	std::vector<CommandBuffer*> secondaryCommandBufferPtrs((meshCount + meshesPerBuffer - 1) / meshesPerBuffer);
 
-	std::vector<CommandBuffer* > secondaryCommandBufferPtrs;
+	mJobSystem->parallelFor(meshCount, meshesPerBuffer, [&](uint32_t meshStart, uint32_t meshEnd, size_t threadIndex) {
+		secondaryCommandBufferPtrs[meshStart / meshesPerBuffer] = recordSecondaryCommandBuffers(&primaryCmdBuffer, mDrawList, meshStart, meshEnd, threadIndex);
+		});
 
-	for (auto& fut : futureSecondaryCommandBuffers)
+	// Submit the secondary command buffers to the primary command buffer.
+	if (!secondaryCommandBufferPtrs.empty())
 	{
-		secondaryCommandBufferPtrs.push_back(fut.get());
+		primaryCmdBuffer.executeCommands(secondaryCommandBufferPtrs);
 	}
+}
 
-	// Submit the secondary command buffers to the primary command buffer.
-	primaryCmdBuffer.executeCommands(secondaryCommandBufferPtrs);
+void SSAOApp::recordFullscreenSubpasses(CommandBuffer& primaryCmdBuffer, uint32_t firstPipeline, uint32_t endPipeline, uint32_t downsample)
+{
+	auto& frame = mFrames[activeFrameIndex];
 
-	// Record remaining subpasses on primary comman buffers
-	// All remaining subpass perform fragment shader operations rendered to a full screen triangle
-	for (uint32_t i = 1; i < mSubpasses.size(); ++i)
+	for (uint32_t i = firstPipeline; i < endPipeline; ++i)
 	{
-		primaryCmdBuffer.nextSubpass(VK_SUBPASS_CONTENTS_INLINE);
+		if (i != firstPipeline)
+		{
+			primaryCmdBuffer.nextSubpass(VK_SUBPASS_CONTENTS_INLINE);
+		}
 
 		primaryCmdBuffer.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelines[i]);
+		setViewportAndScissor(primaryCmdBuffer, downsample);
 
-		std::vector<std::reference_wrapper<const DescriptorSet>> descriptorGroup{ frame->descriptorSet(i) };
+		std::vector<std::reference_wrapper<const DescriptorSet>> descriptorGroup{ frame->descriptorSet(i, activeImageIndex) };
 
 		primaryCmdBuffer.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelineLayouts[i],
 			0, descriptorGroup);
 
 		primaryCmdBuffer.drawFullscreen();
 	}
-	
-	// End Render Pass
-	primaryCmdBuffer.endRenderPass();
+}
 
-	// STOP RECORDING
-	primaryCmdBuffer.endRecording();
+void SSAOApp::recordDepthPrepass(CommandBuffer& primaryCmdBuffer)
+{
+	auto& frame = mFrames[activeFrameIndex];
 
+	mGroundTruthAO->beginDepthPrepass(primaryCmdBuffer, activeImageIndex);
+
+	primaryCmdBuffer.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, *mDepthPrepassPipeline);
+	setViewportAndScissor(primaryCmdBuffer);
+
+	// Only the VP buffer is read so materials are not bound
+	std::vector<std::reference_wrapper<const DescriptorSet>> descriptorGroup{ frame->descriptorSet(0) };
+	primaryCmdBuffer.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelineLayouts[0],
+		0, descriptorGroup);
+
+	// Depth only draws are cheap so they are recorded inline
+	for (Mesh& thisMesh : mDrawList)
+	{
+		DrawPushConstant drawPushConstant{ thisMesh.model(), thisMesh.materialID() };
+		primaryCmdBuffer.pushConstant(*mPipelineLayouts[0],
+			mPushConstantRange.stageFlags,
+			drawPushConstant);
+
+		std::vector<std::reference_wrapper<const Buffer>> vertexBuffers{ thisMesh.vertexBuffer() };
+		std::vector<VkDeviceSize> offsets{ 0 };
+		primaryCmdBuffer.bindVertexBuffers(0, vertexBuffers, offsets);
+
+		primaryCmdBuffer.bindIndexBuffer(thisMesh.indexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+
+		primaryCmdBuffer.drawIndexed(thisMesh.indexCount(), 1, 0, 0, 0);
+	}
+
+	primaryCmdBuffer.endRenderPass();
 }
 
-CommandBuffer* SSAOApp::recordSecondaryCommandBuffers(CommandBuffer* primaryCommandBuffer, std::vector<std::reference_wrapper<Mesh>> meshList, uint32_t meshStart, uint32_t meshEnd, size_t threadIndex)
+CommandBuffer* SSAOApp::recordSecondaryCommandBuffers(CommandBuffer* primaryCommandBuffer, const std::vector<std::reference_wrapper<Mesh>>& meshList, uint32_t meshStart, uint32_t meshEnd, size_t threadIndex)
 {
 	auto& frame = mFrames[activeFrameIndex];
 
@@ -820,15 +1317,26 @@ CommandBuffer* SSAOApp::recordSecondaryCommandBuffers(CommandBuffer* primaryComm
 		| VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, primaryCommandBuffer);
 
 	cmdBuffer.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelines[0]);
+	setViewportAndScissor(cmdBuffer);
+
+	// Bindless materials are all held in one set so descriptor sets are only bound once
+	if (mBindlessMaterials)
+	{
+		std::vector<std::reference_wrapper<const DescriptorSet>> descriptorSetGroup{ frame->descriptorSet(0), *mBindlessDescriptorSet };
+
+		cmdBuffer.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelineLayouts[0],
+			0, descriptorSetGroup);
+	}
 
 	for (uint32_t i = meshStart; i < meshEnd; ++i)
 	{
 		Mesh& thisMesh = meshList[i];
 
-		// "Push" constants to given shader stage directly
+		// "Push" constants to given shader stages directly
+		DrawPushConstant drawPushConstant{ thisMesh.model(), thisMesh.materialID() };
 		cmdBuffer.pushConstant(*mPipelineLayouts[0],
-			VK_SHADER_STAGE_VERTEX_BIT,
-			thisMesh.model());
+			mPushConstantRange.stageFlags,
+			drawPushConstant);
 
 		std::vector<std::reference_wrapper<const Buffer>> vertexBuffers{ thisMesh.vertexBuffer() };	// Buffers to bind
 		std::vector<VkDeviceSize> offsets{ 0 };														// Offsets into buffers being bound
@@ -836,11 +1344,14 @@ CommandBuffer* SSAOApp::recordSecondaryCommandBuffers(CommandBuffer* primaryComm
 
 		cmdBuffer.bindIndexBuffer(thisMesh.indexBuffer(), 0, VK_INDEX_TYPE_UINT32);
 
-		std::vector<std::reference_wrapper<const DescriptorSet>> descriptorSetGroup{ frame->descriptorSet(0, threadIndex),
-			*mPerMaterialDescriptorSets[thisMesh.materialID()] };
+		if (!mBindlessMaterials)
+		{
+			std::vector<std::reference_wrapper<const DescriptorSet>> descriptorSetGroup{ frame->descriptorSet(0),
+				*mPerMaterialDescriptorSets[thisMesh.materialID()] };
 
-		cmdBuffer.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelineLayouts[0],
-			0, descriptorSetGroup);
+			cmdBuffer.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, *mPipelineLayouts[0],
+				0, descriptorSetGroup);
+		}
 
 		// Execute pipeline
 		cmdBuffer.drawIndexed(thisMesh.indexCount(), 1, 0, 0, 0);
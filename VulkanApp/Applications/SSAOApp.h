@@ -1,13 +1,32 @@
 #pragma once
 #include "Renderer/VulkanRenderer.h"
 
+#define SSAO_MAX_SAMPLE_COUNT 64	// Must match MAX_SAMPLE_COUNT in ssao.frag
+#define SSAO_MAX_DOWNSAMPLE 4
+#define SSAO_MAX_BLUR_RADIUS 16
+
 class SSAOApp : public VulkanRenderer
 {
 public:
 	SSAOApp() = default;
 	~SSAOApp();
 
-	virtual void draw();
+	// - Setters
+	// Number of SSAO kernel samples (e.g. 16, 32 or 64) clamped to SSAO_MAX_SAMPLE_COUNT, must be set before init
+	void setSSAOSampleCount(uint32_t sampleCount);
+	// Radius in texels of each pass of the separable bilateral blur clamped to SSAO_MAX_BLUR_RADIUS, must be set before init
+	// A wider blur hides the noise of a lower sample count
+	void setSSAOBlurRadius(uint32_t radius);
+	// Resolution divisor for SSAO and its blur (1 = full, 2 = half, 4 = quarter) clamped to SSAO_MAX_DOWNSAMPLE, must be set before init
+	// Above 1 depth and normals are downsampled first and the blurred result is upsampled with depth aware weights before lighting
+	// The G-buffer, the reduced resolution subpasses and lighting are then recorded in three render passes so the reduced targets can be smaller
+	void setSSAODownsample(uint32_t downsample);
+	// Evaluate occlusion with the tiled compute GTAO pass instead of the SSAO kernel for comparison, must be set before init
+	// GTAO reads a depth prepass at full resolution so the downsample setting is ignored, both share the bilateral blur
+	// The G-buffer pass loads the prepass depth and only shades fragments which pass an equal depth test
+	void setGroundTruthAO(bool groundTruthAO);
+	// Number of point lights in the scene, the first MAX_POINT_LIGHTS sweep across the scene and the rest are scattered, must be set before init
+	void setPointLightCount(uint32_t pointLightCount);
 
 private:
 	// SSAO Resources
@@ -17,18 +36,56 @@ private:
 	std::unique_ptr<Sampler> mNormalSampler;
 	std::unique_ptr<Sampler> mNoiseSampler;
 
+	// GROUND TRUTH AO (replaces SUBPASS 1)
+	std::unique_ptr<GroundTruthAO> mGroundTruthAO;			// Depth prepass into the render target's depth + compute occlusion, recorded before the render pass
+	std::unique_ptr<Subpass> mDepthPrepassSubpass;			// Geometry vertex shader only
+	GraphicsPipeline* mDepthPrepassPipeline{ nullptr };
+
 	// SUBPASS 2
 	std::unique_ptr<Sampler> mSSAOSampler;
 
+	// REDUCED RESOLUTION
+	// A render pass cannot mix attachment sizes so the geometry subpass and the downsample to blur subpasses have their own render passes
+	// The geometry render pass writes the main render target's G-buffer which the main render pass then loads
+	std::unique_ptr<Sampler> mDownsampleSampler;	// Point sampler for the downsampled attachments
+	std::unique_ptr<RenderPass> mGeometryRenderPass;
+	std::unique_ptr<RenderPass> mReducedRenderPass;
+	std::vector<uint32_t> mGeometryAttachments;						// Main render target attachments written by the geometry render pass
+	std::vector<VkClearValue> mGeometryClearValues;
+	std::vector<VkFormat> mReducedFormats;							// Index maps to a reduced target attachment
+	std::vector<std::unique_ptr<Framebuffer>> mGeometryFramebuffers;	// Index maps to a render target
+	std::vector<std::unique_ptr<RenderTarget>> mReducedTargets;		// Index maps to a frame in flight
+	std::vector<std::unique_ptr<Framebuffer>> mReducedFramebuffers;	// Index maps to a frame in flight
+
+	// SUBPASS 3
+	std::unique_ptr<LightClusters> mLightClusters;		// Light buffer + light lists for each view space cluster
+
 	// UBO indices
 	uint32_t mVPBufferIndex{ 0 };
-	uint32_t mLightBufferIndex{ 0 };
 	uint32_t mSSAOBufferIndex{ 0 };
 
+	// SUBPASS INDICES
+	// Downsample and upsample subpasses are only added at reduced resolution, their indices are 0 otherwise
+	// At reduced resolution the downsample subpass is the first subpass of the reduced render pass and upsample the first of the main render pass
+	// The SSAO subpass is not added with GTAO so its index must not be used
+	uint32_t mDownsampleSubpassIndex{ 0 };
+	uint32_t mSSAOSubpassIndex{ 1 };
+	uint32_t mBlurHorizontalSubpassIndex{ 2 };
+	uint32_t mBlurVerticalSubpassIndex{ 3 };
+	uint32_t mUpsampleSubpassIndex{ 0 };
+	uint32_t mLightingSubpassIndex{ 4 };
+
 	// ATTACHMENT INDICES
-	// SUBPASS 2
+	// At reduced resolution the downsample, SSAO and blur attachments index the reduced targets, the others index the main render targets
+	// REDUCED RESOLUTION
+	uint32_t mDownsampleDepthAttachmentIndex{ 0 };
+	uint32_t mDownsampleNormalAttachmentIndex{ 0 };
+	uint32_t mUpsampleAttachmentIndex{ 0 };
+	// SUBPASS 3
 	uint32_t mBlurAttachmentIndex{ 0 };
-	// SUBPASS 1
+	// SUBPASS 2
+	uint32_t mBlurIntermediateAttachmentIndex{ 0 };
+	// SUBPASS 1 (SSAO kernel only)
 	uint32_t mSSAOAttachmentIndex{ 0 };
 	// SUBPASS 0
 	uint32_t mNormalAttachmentIndex{ 0 };
@@ -40,15 +97,23 @@ private:
 	float lastTime{ 0.0f };
 	float sumTime{ 0.0f };
 
+	// SSAO quality, specialised into the SSAO shader
+	uint32_t mSSAOSampleCount{ SSAO_MAX_SAMPLE_COUNT };
+	uint32_t mSSAODownsample{ 1 };
+	uint32_t mSSAOBlurRadius{ 4 };
+	bool mUseGroundTruthAO{ false };
+	float mAORadius{ 2.0f };			// View space sampling radius of both SSAO and GTAO
+
+	// Lights
+	uint32_t mPointLightCount{ MAX_POINT_LIGHTS };
+	LightManager mLightManager;					// World space point lights, the visible lights are uploaded in view space
+	std::vector<glm::vec4> mPointLightOrigins;		// Positions the point lights are animated around
+	SpotLight mFlashLight;							// Note that flashlight contains view position which will be used for lighting calculations
+
 	// Buffer compositions
-	struct uboLights {
-		PointLight pointLights[3];
-		SpotLight flashLight;	// Note that flashlight contains view position which will be used for lighting calculations
-	} mLights;
 
-#define SAMPLE_COUNT 64
 	struct uboSSAO {
-		glm::vec4 ssaoKernel[SAMPLE_COUNT];
+		glm::vec4 ssaoKernel[SSAO_MAX_SAMPLE_COUNT];
 		float radius;
 		float bias;
 		float power;
@@ -56,7 +121,7 @@ private:
 
 	// Functions
 	// - Create Functions
-	virtual void createRenderTargetAndFrames();
+	virtual void createRenderGraph();
 	virtual void createRenderPass();
 	virtual void createPerFrameDescriptorSetLayouts();
 	virtual void createPipelines();
@@ -64,6 +129,7 @@ private:
 	virtual void createPerFrameDescriptorSets();
 
 	// -- Support
+	uint32_t ssaoDownsample() const;	// Resolution divisor in use, always 1 with GTAO
 	virtual void updatePerFrameResources();
 	virtual void getRequiredExtenstionAndFeatures(std::vector<const char*>& requiredExtensions,
 		VkPhysicalDeviceFeatures& requiredFeatures);
@@ -72,11 +138,16 @@ private:
 	void createLights();
 	void createSSAOResources();
 	void createAttachmentSamplers();
+	void createReducedTargets();
 
 	// - Record Functions
-	void recordCommands(CommandBuffer& primaryCmdBuffer);
+	virtual void recordCommands(CommandBuffer& primaryCmdBuffer);
+	void recordDepthPrepass(CommandBuffer& primaryCmdBuffer);
+	void recordGeometry(CommandBuffer& primaryCmdBuffer);
+	// Record pipelines firstPipeline up to endPipeline as consecutive subpasses of the current render pass, starting in the current subpass
+	void recordFullscreenSubpasses(CommandBuffer& primaryCmdBuffer, uint32_t firstPipeline, uint32_t endPipeline, uint32_t downsample);
 	CommandBuffer* recordSecondaryCommandBuffers(CommandBuffer* primaryCommandBuffer,
-		std::vector<std::reference_wrapper<Mesh>> meshList,
+		const std::vector<std::reference_wrapper<Mesh>>& meshList,
 		uint32_t meshStart,
 		uint32_t meshEnd,
 		size_t threadIndex);
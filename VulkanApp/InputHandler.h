@@ -1,5 +1,6 @@
 #pragma once
 #include <GLFW/glfw3.h>
+#include <chrono>
 #include <vector>
 
 #include "Commands.h"
@@ -17,6 +18,13 @@ public:
 	virtual void init() = 0;
 	virtual bool handleInput(std::vector<CommandPtr>& commandList, float deltaTime) = 0;
 
+	// Time at which input was last sampled by handleInput (used for latency measurement)
+	std::chrono::steady_clock::time_point sampleTime() const
+	{
+		return mSampleTime;
+	};
+
 protected:
 	GLFWwindow* mWindow;
+	std::chrono::steady_clock::time_point mSampleTime;
 };
\ No newline at end of file
@@ -9,6 +9,8 @@ InputHandlerMouse::InputHandlerMouse(GLFWwindow* window)
 
 bool InputHandlerMouse::handleInput(std::vector<CommandPtr>& commandList, float deltaTime)
 {
+	mSampleTime = std::chrono::steady_clock::now();
+
 	handleMouse(commandList, deltaTime);
 	handleKeyboard(commandList, deltaTime);
 
@@ -0,0 +1,273 @@
+#include "BarrierBatch.h"
+
+#include "Buffer.h"
+#include "CommandBuffer.h"
+#include "Device.h"
+#include "Image.h"
+
+namespace {
+	const VkAccessFlags2KHR WRITE_ACCESS_MASK =
+		VK_ACCESS_2_SHADER_WRITE_BIT_KHR |
+		VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR |
+		VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR |
+		VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR |
+		VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR |
+		VK_ACCESS_2_HOST_WRITE_BIT_KHR |
+		VK_ACCESS_2_MEMORY_WRITE_BIT_KHR;
+
+	// Flags above bit 31 only exist in synchronization2 and are replaced by the original flags which cover them
+	VkAccessFlags legacyAccessFlags(VkAccessFlags2KHR accessMask)
+	{
+		VkAccessFlags legacyMask = static_cast<VkAccessFlags>(accessMask);
+
+		if (accessMask & (VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR | VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR))
+		{
+			legacyMask |= VK_ACCESS_SHADER_READ_BIT;
+		}
+		if (accessMask & VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR)
+		{
+			legacyMask |= VK_ACCESS_SHADER_WRITE_BIT;
+		}
+
+		return legacyMask;
+	}
+
+	VkPipelineStageFlags legacyStageFlags(VkPipelineStageFlags2KHR stageMask)
+	{
+		VkPipelineStageFlags legacyMask = static_cast<VkPipelineStageFlags>(stageMask);
+
+		if (stageMask & (VK_PIPELINE_STAGE_2_COPY_BIT_KHR | VK_PIPELINE_STAGE_2_RESOLVE_BIT_KHR |
+			VK_PIPELINE_STAGE_2_BLIT_BIT_KHR | VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR))
+		{
+			legacyMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+		}
+		if (stageMask & (VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT_KHR | VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT_KHR))
+		{
+			legacyMask |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+		}
+		if (stageMask & VK_PIPELINE_STAGE_2_PRE_RASTERIZATION_SHADERS_BIT_KHR)
+		{
+			legacyMask |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+		}
+
+		return legacyMask;
+	}
+
+	bool subresourceStatesMatch(const ImageSubresourceState& a, const ImageSubresourceState& b)
+	{
+		return a.layout == b.layout &&
+			a.writeStageMask == b.writeStageMask && a.writeAccessMask == b.writeAccessMask &&
+			a.readStageMask == b.readStageMask && a.readAccessMask == b.readAccessMask;
+	}
+}
+
+BarrierBatch::BarrierBatch(Device& device) :
+	mDevice(device)
+{
+}
+
+bool BarrierBatch::empty() const
+{
+	return mImageBarriers.empty() && mBufferBarriers.empty();
+}
+
+void BarrierBatch::transitionImage(Image& image,
+	VkImageLayout newLayout,
+	VkPipelineStageFlags2KHR dstStageMask,
+	VkAccessFlags2KHR dstAccessMask,
+	uint32_t baseMipLevel,
+	uint32_t mipLevelCount,
+	uint32_t baseArrayLayer,
+	uint32_t arrayLayerCount)
+{
+	uint32_t mipLevelEnd = mipLevelCount == VK_REMAINING_MIP_LEVELS ? image.mipLevelCount() : baseMipLevel + mipLevelCount;
+	uint32_t arrayLayerEnd = arrayLayerCount == VK_REMAINING_ARRAY_LAYERS ? image.arrayLayerCount() : baseArrayLayer + arrayLayerCount;
+
+	for (uint32_t layer = baseArrayLayer; layer < arrayLayerEnd; ++layer)
+	{
+		// Consecutive mip levels in the same state share one barrier
+		uint32_t mipLevel = baseMipLevel;
+		while (mipLevel < mipLevelEnd)
+		{
+			ImageSubresourceState oldState = image.subresourceState(mipLevel, layer);
+
+			uint32_t runEnd = mipLevel + 1;
+			while (runEnd < mipLevelEnd && subresourceStatesMatch(image.subresourceState(runEnd, layer), oldState))
+			{
+				++runEnd;
+			}
+
+			ImageSubresourceState newState = oldState;
+			VkPipelineStageFlags2KHR srcStageMask = oldState.writeStageMask;
+
+			bool writeAccess = (dstAccessMask & WRITE_ACCESS_MASK) != 0;
+			bool write = writeAccess || oldState.layout != newLayout;
+			if (write)
+			{
+				// Writes and layout transitions must also wait for the readers of the previous write
+				srcStageMask |= oldState.readStageMask;
+
+				// A read only layout transition is made visible to the barrier's destination, so it counts as those readers
+				newState.layout = newLayout;
+				newState.writeStageMask = dstStageMask;
+				newState.writeAccessMask = dstAccessMask & WRITE_ACCESS_MASK;
+				newState.readStageMask = writeAccess ? 0 : dstStageMask;
+				newState.readAccessMask = writeAccess ? 0 : dstAccessMask;
+			}
+			else
+			{
+				newState.readStageMask |= dstStageMask;
+				newState.readAccessMask |= dstAccessMask;
+			}
+
+			// A read needs no barrier if nothing was written, or if an earlier barrier already made the write visible to these stages and accesses
+			bool covered = !write &&
+				(oldState.writeStageMask == 0 ||
+				((dstStageMask & ~oldState.readStageMask) == 0 && (dstAccessMask & ~oldState.readAccessMask) == 0));
+
+			if (!covered)
+			{
+				VkImageMemoryBarrier2KHR imageBarrier = {};
+				imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+				imageBarrier.srcStageMask = srcStageMask;
+				imageBarrier.srcAccessMask = oldState.writeAccessMask;		// Only writes need to be made available
+				imageBarrier.dstStageMask = dstStageMask;
+				imageBarrier.dstAccessMask = dstAccessMask;
+				imageBarrier.oldLayout = oldState.layout;
+				imageBarrier.newLayout = newLayout;
+				imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				imageBarrier.image = image.handle();
+				imageBarrier.subresourceRange.aspectMask = image.aspectMask();
+				imageBarrier.subresourceRange.baseMipLevel = mipLevel;
+				imageBarrier.subresourceRange.levelCount = runEnd - mipLevel;
+				imageBarrier.subresourceRange.baseArrayLayer = layer;
+				imageBarrier.subresourceRange.layerCount = 1;
+
+				mImageBarriers.push_back(imageBarrier);
+			}
+
+			for (uint32_t i = mipLevel; i < runEnd; ++i)
+			{
+				image.setSubresourceState(i, layer, newState);
+			}
+
+			mipLevel = runEnd;
+		}
+	}
+}
+
+void BarrierBatch::bufferBarrier(const Buffer& buffer,
+	VkPipelineStageFlags2KHR srcStageMask,
+	VkAccessFlags2KHR srcAccessMask,
+	VkPipelineStageFlags2KHR dstStageMask,
+	VkAccessFlags2KHR dstAccessMask,
+	VkDeviceSize offset,
+	VkDeviceSize size)
+{
+	VkBufferMemoryBarrier2KHR bufferBarrier = {};
+	bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+	bufferBarrier.srcStageMask = srcStageMask;
+	bufferBarrier.srcAccessMask = srcAccessMask;
+	bufferBarrier.dstStageMask = dstStageMask;
+	bufferBarrier.dstAccessMask = dstAccessMask;
+	bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.buffer = buffer.handle();
+	bufferBarrier.offset = offset;
+	bufferBarrier.size = size;
+
+	mBufferBarriers.push_back(bufferBarrier);
+}
+
+void BarrierBatch::flush(CommandBuffer& commandBuffer)
+{
+	if (empty())
+	{
+		return;
+	}
+
+	if (mDevice.synchronization2Enabled())
+	{
+		VkDependencyInfoKHR dependencyInfo = {};
+		dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+		dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(mBufferBarriers.size());
+		dependencyInfo.pBufferMemoryBarriers = mBufferBarriers.data();
+		dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(mImageBarriers.size());
+		dependencyInfo.pImageMemoryBarriers = mImageBarriers.data();
+
+		mDevice.cmdPipelineBarrier2(commandBuffer.handle(), dependencyInfo);
+	}
+	else
+	{
+		flushLegacy(commandBuffer);
+	}
+
+	mImageBarriers.clear();
+	mBufferBarriers.clear();
+}
+
+// Stage and access bits shared with the original flags have the same values, synchronization2 only bits are mapped to the original flags
+// Stages are combined across barriers as vkCmdPipelineBarrier takes a single src and dst stage mask
+void BarrierBatch::flushLegacy(CommandBuffer& commandBuffer)
+{
+	VkPipelineStageFlags srcStageMask = 0;
+	VkPipelineStageFlags dstStageMask = 0;
+
+	std::vector<VkImageMemoryBarrier> imageBarriers;
+	imageBarriers.reserve(mImageBarriers.size());
+	for (auto& barrier2 : mImageBarriers)
+	{
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = legacyAccessFlags(barrier2.srcAccessMask);
+		barrier.dstAccessMask = legacyAccessFlags(barrier2.dstAccessMask);
+		barrier.oldLayout = barrier2.oldLayout;
+		barrier.newLayout = barrier2.newLayout;
+		barrier.srcQueueFamilyIndex = barrier2.srcQueueFamilyIndex;
+		barrier.dstQueueFamilyIndex = barrier2.dstQueueFamilyIndex;
+		barrier.image = barrier2.image;
+		barrier.subresourceRange = barrier2.subresourceRange;
+
+		imageBarriers.push_back(barrier);
+		srcStageMask |= legacyStageFlags(barrier2.srcStageMask);
+		dstStageMask |= legacyStageFlags(barrier2.dstStageMask);
+	}
+
+	std::vector<VkBufferMemoryBarrier> bufferBarriers;
+	bufferBarriers.reserve(mBufferBarriers.size());
+	for (auto& barrier2 : mBufferBarriers)
+	{
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = legacyAccessFlags(barrier2.srcAccessMask);
+		barrier.dstAccessMask = legacyAccessFlags(barrier2.dstAccessMask);
+		barrier.srcQueueFamilyIndex = barrier2.srcQueueFamilyIndex;
+		barrier.dstQueueFamilyIndex = barrier2.dstQueueFamilyIndex;
+		barrier.buffer = barrier2.buffer;
+		barrier.offset = barrier2.offset;
+		barrier.size = barrier2.size;
+
+		bufferBarriers.push_back(barrier);
+		srcStageMask |= legacyStageFlags(barrier2.srcStageMask);
+		dstStageMask |= legacyStageFlags(barrier2.dstStageMask);
+	}
+
+	// No stage is not valid without synchronization2
+	if (srcStageMask == 0)
+	{
+		srcStageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	}
+	if (dstStageMask == 0)
+	{
+		dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+	}
+
+	vkCmdPipelineBarrier(
+		commandBuffer.handle(),
+		srcStageMask, dstStageMask,
+		0,
+		0, nullptr,
+		static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.empty() ? nullptr : bufferBarriers.data(),
+		static_cast<uint32_t>(imageBarriers.size()), imageBarriers.empty() ? nullptr : imageBarriers.data());
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "Common.h"
+
+class Buffer;
+class CommandBuffer;
+class Device;
+class Image;
+
+// Collects image and buffer barriers and records them with a single pipeline barrier on flush
+// Image barriers are derived from the image's tracked subresource states so only the new layout and access are given
+// Uses synchronization2 if the device has it enabled, otherwise the barriers are recorded with vkCmdPipelineBarrier
+class BarrierBatch
+{
+public:
+	BarrierBatch(Device& device);
+	~BarrierBatch() = default;
+
+	BarrierBatch(const BarrierBatch&) = delete;
+
+	// - Getters
+	bool empty() const;
+
+	// - Barrier Recording
+	// Transition a range of subresources to a layout for access at the given stages
+	// Reads in the same layout only add a barrier (from the last writer) if an earlier barrier has not already covered their stages and accesses
+	void transitionImage(Image& image,
+		VkImageLayout newLayout,
+		VkPipelineStageFlags2KHR dstStageMask,
+		VkAccessFlags2KHR dstAccessMask,
+		uint32_t baseMipLevel = 0,
+		uint32_t mipLevelCount = VK_REMAINING_MIP_LEVELS,
+		uint32_t baseArrayLayer = 0,
+		uint32_t arrayLayerCount = VK_REMAINING_ARRAY_LAYERS);
+
+	// Buffers are not tracked so the source access must be given
+	void bufferBarrier(const Buffer& buffer,
+		VkPipelineStageFlags2KHR srcStageMask,
+		VkAccessFlags2KHR srcAccessMask,
+		VkPipelineStageFlags2KHR dstStageMask,
+		VkAccessFlags2KHR dstAccessMask,
+		VkDeviceSize offset = 0,
+		VkDeviceSize size = VK_WHOLE_SIZE);
+
+	// Record every collected barrier and clear the batch
+	void flush(CommandBuffer& commandBuffer);
+
+private:
+	Device& mDevice;
+
+	std::vector<VkImageMemoryBarrier2KHR> mImageBarriers;
+	std::vector<VkBufferMemoryBarrier2KHR> mBufferBarriers;
+
+	// - Support
+	void flushLegacy(CommandBuffer& commandBuffer);
+};
@@ -76,7 +76,7 @@ void CommandBuffer::beginRecording(VkCommandBufferUsageFlags flags, CommandBuffe
 		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
 		inheritanceInfo.renderPass = currentRenderPass.renderPass->handle();
 		inheritanceInfo.framebuffer = currentRenderPass.framebuffer->handle();
-		inheritanceInfo.subpass = 0;	
+		inheritanceInfo.subpass = currentRenderPass.subpass;
 		beginInfo.pInheritanceInfo = &inheritanceInfo;
 	}
 
@@ -103,6 +103,7 @@ void CommandBuffer::beginRenderPass(const RenderTarget& renderTarget,
 	// Set bindings
 	mRenderPassBinding.renderPass = &renderPass;
 	mRenderPassBinding.framebuffer = &framebuffer;
+	mRenderPassBinding.subpass = 0;
 
 	// Create begin info
 	VkRenderPassBeginInfo renderPassBeginInfo = {};
@@ -127,6 +128,16 @@ void CommandBuffer::bindPipeline(VkPipelineBindPoint bindPoint, const Pipeline&
 	vkCmdBindPipeline(mHandle, bindPoint, pipeline.handle());
 }
 
+void CommandBuffer::setViewport(const VkViewport& viewport)
+{
+	vkCmdSetViewport(mHandle, 0, 1, &viewport);
+}
+
+void CommandBuffer::setScissor(const VkRect2D& scissor)
+{
+	vkCmdSetScissor(mHandle, 0, 1, &scissor);
+}
+
 
 void CommandBuffer::bindVertexBuffers(uint32_t firstBinding, const std::vector<std::reference_wrapper<const Buffer>>& buffers, const std::vector<VkDeviceSize>& offsets)
 {
@@ -173,6 +184,12 @@ void CommandBuffer::drawIndexed(uint32_t indexCount, uint32_t instanceCount, uin
 	vkCmdDrawIndexed(mHandle, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
 }
 
+// Must be recorded outside of a render pass with a compute pipeline bound
+void CommandBuffer::dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+	vkCmdDispatch(mHandle, groupCountX, groupCountY, groupCountZ);
+}
+
 void CommandBuffer::executeCommands(const std::vector<CommandBuffer*>& commandBuffers)
 {
 	assert(mLevel == VK_COMMAND_BUFFER_LEVEL_PRIMARY && "Command must be executed with a Primary Command Buffer!");
@@ -189,95 +206,8 @@ void CommandBuffer::executeCommands(const std::vector<CommandBuffer*>& commandBu
 void CommandBuffer::nextSubpass(VkSubpassContents subpassContentsRecordingStrategy)
 {
 	vkCmdNextSubpass(mHandle, subpassContentsRecordingStrategy);
-}
 
-// TODO : pass in struct to define resource range - currently this will only work for images which match the values here
-// TODO : expand functionality to allow for other types of transitions
-// Set up image memory barriers and transition image from one layout to another
-void CommandBuffer::transitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t baseMipLevel, uint32_t mipLevelCount)
-{
-	// Create buffer
-	//VkCommandBuffer commandBuffer = beginCommandBuffer(device, commandPool);
-
-	VkImageMemoryBarrier imageMemoryBarrier = {};
-	imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	imageMemoryBarrier.oldLayout = oldLayout;									// Layout to transition from
-	imageMemoryBarrier.newLayout = newLayout;									// Layout to transition to
-	imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;			// Queue family to transition from
-	imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;			// Queue family to transition to
-	imageMemoryBarrier.image = image;											// Image being accessed and modified as part of barrier
-	imageMemoryBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;	// Aspect of image being altered
-	imageMemoryBarrier.subresourceRange.baseMipLevel = baseMipLevel;			// First mip level to start alterations on
-	imageMemoryBarrier.subresourceRange.levelCount = mipLevelCount;	// Number of mip levels to alter starting from baseMipLevel
-	imageMemoryBarrier.subresourceRange.baseArrayLayer = 0;						// First Layer to start alterations on
-	imageMemoryBarrier.subresourceRange.layerCount = 1;							// Number of layers to alter starting from baseArrayLayer
-
-
-	VkPipelineStageFlags srcStage;
-	VkPipelineStageFlags dstStage;
-
-	// If transitioning from new image to image ready to receive data...
-	if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
-	{
-		imageMemoryBarrier.srcAccessMask = 0;									// No source memory dependency
-		imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;		// Destination requires write access to an image or buffer in a copy or clear operation
-
-		srcStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;		// No source stage dependecy (TOP indicates a previous pipeline execution)
-		dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;			// Transition must happen before TRANSFER stage
-
-	}
-	// If transitioning from transfer destination to shader readable
-	else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-	{
-		imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;	// Source requires write access to an image or buffer in a copy or clear operation
-		imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;		// Destination requires read access to a shader resource
-
-		srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;							// Transition must happen before TRANSFER stage
-		dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;					// Transition must happen after FRAGMENT_SHADER stage
-	} 
-	// If transitioning from transfer source to shader readable
-	else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-	{
-		imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;		// Source requires read access to an image or buffer in a copy or clear operation
-		imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;		// Destination requires read access to a shader resource
-
-		srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;							// Transition must happen before TRANSFER stage
-		dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;					// Transition must happen after FRAGMENT_SHADER stage
-	}
-	// If transitioning from transfer destination to source
-	else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
-	{
-		imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;	// Source requires write access to an image or buffer in a copy or clear operation
-		imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;		// Destination requires requires read access to an image or buffer in a copy or clear operation
-
-		srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;							// Transition must happen before TRANSFER stage
-		dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;							// Transition must happen after TRANSFER stage
-		// TODO : src and dst stage the same so operation must happen during this stage?
-	}
-	else if(oldLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
-	{
-		imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;		// Source requires write access to an image or buffer in a copy or clear operation
-		imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;	// Destination requires requires read access to an image or buffer in a copy or clear operation
-
-		srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;							// Transition must happen before TRANSFER stage
-		dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;							// Transition must happen after TRANSFER stage
-	}
-	else
-	{
-		throw std::runtime_error("The requested layout transition is not currently supported by this application!");
-	}
-	
-
-	vkCmdPipelineBarrier(
-		mHandle,
-		srcStage, dstStage,			// Pipeline stages (match to src and dst AccessMasks)
-		0,							// Dependency flags
-		0, nullptr,					// Memory Barrier count + data
-		0, nullptr,					// Buffer Memory Barrier count + data
-		1, &imageMemoryBarrier		// Image Memory Batrrier count + data
-	);
-
-	//endAndSubmitCommandBuffer(device, commandPool, queue, commandBuffer);
+	++mRenderPassBinding.subpass;
 }
 
 // TODO : pass in required subresource values
@@ -289,7 +219,7 @@ void CommandBuffer::copyBufferToImage(Buffer& srcBuffer, Image& image)
 	imageRegion.bufferOffset = 0;											// Offset into data
 	imageRegion.bufferRowLength = 0;										// Row length of data to calculate data spacing
 	imageRegion.bufferImageHeight = 0;										// Image height to calculate data spacing
-	imageRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;	// Which aspect of image to copy
+	imageRegion.imageSubresource.aspectMask = image.aspectMask();			// Which aspect of image to copy
 	imageRegion.imageSubresource.mipLevel = 0;								// Mipmap level to copy
 	imageRegion.imageSubresource.baseArrayLayer = 0;						// Starting array layer (if array)
 	imageRegion.imageSubresource.layerCount = 1;							// Number of layers to copy starting at baseArrayLayer
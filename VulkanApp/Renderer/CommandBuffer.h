@@ -17,6 +17,8 @@ struct RenderPassBinding
 	RenderPass* renderPass = nullptr;
 
 	Framebuffer* framebuffer = nullptr;
+
+	uint32_t subpass = 0;		// Inherited by secondary command buffers
 };
 
 // Class handles all command buffer operations
@@ -42,6 +44,8 @@ public:
 		const std::vector<VkClearValue>& clearValues,
 		VkSubpassContents subpassContentsRecordingStrategy = VK_SUBPASS_CONTENTS_INLINE);
 	void bindPipeline(VkPipelineBindPoint bindPoint, const Pipeline& pipeline);
+	void setViewport(const VkViewport& viewport);
+	void setScissor(const VkRect2D& scissor);
 
 	// TODO : need to update this to be able to take several values
 	// TODO : pipeline layout reference should be bound when the pipeline is bound (should retrieve from the render pass object binding (does not exist at the moment))
@@ -72,16 +76,14 @@ public:
 	void drawFullscreen();
 	void drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance);
 
+	void dispatch(uint32_t groupCountX, uint32_t groupCountY = 1, uint32_t groupCountZ = 1);
+
 	void executeCommands(const std::vector<CommandBuffer*>& commandBuffers);
 
 	void nextSubpass(VkSubpassContents subpassContentsRecordingStrategy = VK_SUBPASS_CONTENTS_INLINE);
 
-	// -- Transition and copy operations
-	void transitionImageLayout(VkImage image, 
-		VkImageLayout oldLayout,
-		VkImageLayout newLayout, 
-		uint32_t baseMipLevel = 0,
-		uint32_t mipLevelCount = 1);
+	// -- Copy operations
+	// Layout transitions are recorded with a BarrierBatch, images must be in the layouts given here
 	void copyBufferToImage(Buffer& srcBuffer, Image& image);
 	void copyBuffer(Buffer& srcBuffer, Buffer& dstBuffer);
 	void blitImage(Image& srcImage, 
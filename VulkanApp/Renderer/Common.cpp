@@ -19,3 +19,23 @@ float lerp(float a, float b, float f)
 {
 	return a + f * (b - a);
 }
+
+std::array<glm::vec4, 6> frustumPlanes(const glm::mat4& viewProjection)
+{
+	// Rows of the matrix (glm is column major)
+	glm::mat4 rows = glm::transpose(viewProjection);
+	std::array<glm::vec4, 6> planes = {
+		rows[3] + rows[0],		// Left
+		rows[3] - rows[0],		// Right
+		rows[3] + rows[1],		// Bottom
+		rows[3] - rows[1],		// Top
+		rows[2],				// Near
+		rows[3] - rows[2] };	// Far
+
+	for (auto& plane : planes)
+	{
+		plane /= glm::length(glm::vec3(plane));
+	}
+
+	return planes;
+}
@@ -18,9 +18,21 @@
 #include <vector>
 
 // *** Max Value Constants ***
-const uint32_t MAX_MATERIALS = 2048;
 const float MAX_LOD		= 15.0f;	// This should support all mip levels for textures of resolution up to 16K resolution
 const uint32_t MAX_OBJECTS	= 10;
+const uint32_t MAX_POINT_LIGHTS = 3;	// Point lights which sweep across the scene in each app, further lights are scattered
+const uint32_t MAX_FRAMES_IN_FLIGHT = 2;	// Number of frames the CPU may record ahead of the GPU (independent of swapchain image count)
+const uint32_t MATERIAL_DESCRIPTOR_SETS = 256;	// Sets in the first material descriptor pool (later pools grow)
+const uint32_t MAX_DESCRIPTOR_POOL_SETS = 1024;	// Largest pool a DescriptorAllocator will create, further pools are the same size
+const uint32_t MAX_BINDLESS_TEXTURES = 16384;	// Upper bound on the bindless texture array, clamped to device limits
+const uint32_t MAX_BINDLESS_MATERIALS = 16384;	// Upper bound on entries in the bindless material buffer
+
+// *** Light Clusters ***
+// Passed to the cluster shaders as specialization constants
+const uint32_t CLUSTER_GRID_X = 16;				// Screen tiles horizontally
+const uint32_t CLUSTER_GRID_Y = 9;				// Screen tiles vertically
+const uint32_t CLUSTER_GRID_Z = 24;				// View depth slices, spaced exponentially between the clip planes
+const uint32_t MAX_LIGHTS_PER_CLUSTER = 256;	// Further lights intersecting a cluster are dropped
 
 
 /// *** BindingMap ***
@@ -30,6 +42,13 @@ const uint32_t MAX_OBJECTS	= 10;
 template <typename T>
 using BindingMap = std::map<uint32_t, std::map<uint32_t, T>>;
 
+// Combine the hash of value into seed (as boost::hash_combine)
+template <typename T>
+inline void hashCombine(size_t& seed, const T& value)
+{
+	seed ^= std::hash<T>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
 // Check to see if format is a depth stencil format
 // See "_D" and "_S" formats in following documentation:
 // https://www.khronos.org/registry/vulkan/specs/1.2-extensions/html/vkspec.html#formats-compatibility
@@ -39,4 +58,8 @@ bool isDepthOnlyFormat(VkFormat format);
 
 float lerp(float a, float b, float f);
 
+// Extract the normalised left, right, bottom, top, near and far planes from a view projection matrix (depth range is 0 to 1)
+// A point is inside a plane when dot(plane.xyz, point) + plane.w >= 0
+std::array<glm::vec4, 6> frustumPlanes(const glm::mat4& viewProjection);
+
 
@@ -0,0 +1,64 @@
+#include "DescriptorAllocator.h"
+
+#include "DescriptorPool.h"
+#include "DescriptorSetLayout.h"
+#include "Device.h"
+
+DescriptorAllocator::DescriptorAllocator(Device& device, const DescriptorSetLayout& descriptorSetLayout, uint32_t initialSets, VkDescriptorPoolCreateFlags flags) :
+	mDevice(device), mDescriptorSetLayout(descriptorSetLayout), mFlags(flags),
+	mNextPoolSets(std::max(initialSets, 1u))
+{
+	createPool();
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+}
+
+const DescriptorSetLayout& DescriptorAllocator::descriptorSetLayout() const
+{
+	return mDescriptorSetLayout;
+}
+
+// Allocation stays in the active pool until it is full
+// Sets are never freed individually, pools are only emptied together by reset,
+// so allocation moves forward through the chain and full pools are never revisited
+DescriptorPool& DescriptorAllocator::requestPool()
+{
+	auto& activePool = *mPools[mActivePool];
+	if (activePool.allocatedSets() < activePool.maxSets())
+	{
+		return activePool;
+	}
+
+	// Pools after the active one were emptied by the last reset
+	if (mActivePool + 1 < mPools.size())
+	{
+		++mActivePool;
+	}
+	else
+	{
+		createPool();
+	}
+
+	return *mPools[mActivePool];
+}
+
+// Pools are reset in bulk with vkResetDescriptorPool and reused from the first pool
+void DescriptorAllocator::reset()
+{
+	for (auto& pool : mPools)
+	{
+		pool->reset();
+	}
+
+	mActivePool = 0;
+}
+
+void DescriptorAllocator::createPool()
+{
+	mPools.push_back(std::make_unique<DescriptorPool>(mDevice, mDescriptorSetLayout, mNextPoolSets, mFlags));
+	mActivePool = static_cast<uint32_t>(mPools.size() - 1);
+
+	mNextPoolSets = std::min(mNextPoolSets * 2, std::max(MAX_DESCRIPTOR_POOL_SETS, mNextPoolSets));
+}
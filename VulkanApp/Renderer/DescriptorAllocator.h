@@ -0,0 +1,39 @@
+#pragma once
+#include "Common.h"
+
+class Device;
+class DescriptorPool;
+class DescriptorSetLayout;
+
+// Chain of descriptor pools for a single layout which grows instead of running out of sets
+// Each new pool holds twice as many sets as the last (up to MAX_DESCRIPTOR_POOL_SETS),
+// pool sizes follow the layout's descriptor counts per set
+// Pools are kept on reset so a steady state frame allocates without creating pools
+class DescriptorAllocator
+{
+public:
+	DescriptorAllocator(Device& device, const DescriptorSetLayout& descriptorSetLayout, uint32_t initialSets, VkDescriptorPoolCreateFlags flags = 0);
+	~DescriptorAllocator();
+
+	DescriptorAllocator(const DescriptorAllocator&) = delete;
+
+	// - Getters
+	const DescriptorSetLayout& descriptorSetLayout() const;
+
+	// - Allocation
+	DescriptorPool& requestPool();		// Returns a pool with space for at least one more set
+	void reset();						// Resets every pool, all sets allocated from this allocator become invalid
+
+private:
+	Device& mDevice;
+	const DescriptorSetLayout& mDescriptorSetLayout;
+	VkDescriptorPoolCreateFlags mFlags;
+
+	std::vector<std::unique_ptr<DescriptorPool>> mPools;
+	uint32_t mActivePool{ 0 };
+	uint32_t mNextPoolSets;
+
+	// - Support
+	void createPool();
+};
+
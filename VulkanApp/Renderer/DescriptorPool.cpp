@@ -4,7 +4,8 @@
 #include "DescriptorSetLayout.h"
 
 // Creates a descriptor pool based on a Descriptor Set Layout which can allocate "maxSets" number of sets
-DescriptorPool::DescriptorPool(Device& device, const DescriptorSetLayout& descriptorSetLayout, uint32_t maxSets) :
+// Pools for layouts with update after bind bindings must be created with VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT
+DescriptorPool::DescriptorPool(Device& device, const DescriptorSetLayout& descriptorSetLayout, uint32_t maxSets, VkDescriptorPoolCreateFlags flags) :
 	mDevice(device), mDescriptorSetLayout(descriptorSetLayout), mMaxSets(maxSets)
 {
 	const auto& layoutBindings = descriptorSetLayout.layoutBindings();
@@ -24,6 +25,7 @@ DescriptorPool::DescriptorPool(Device& device, const DescriptorSetLayout& descri
 
 	VkDescriptorPoolCreateInfo poolCreateInfo = {};
 	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.flags = flags;
 	poolCreateInfo.maxSets = maxSets;											// Maximum number of descriptor sets which can be created from pool
 	poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());		// Amount of Pool Sizes being passed
 	poolCreateInfo.pPoolSizes = poolSizes.data();
@@ -76,6 +78,8 @@ void DescriptorPool::reset()
 	{
 		vkResetDescriptorPool(mDevice.logicalDevice(), mHandle, 0);
 	}
+
+	mAllocatedSets = 0;
 }
 
 VkDescriptorSet DescriptorPool::allocate(uint32_t numberOfSets)
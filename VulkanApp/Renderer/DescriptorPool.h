@@ -7,7 +7,7 @@ class DescriptorSetLayout;
 class DescriptorPool
 {
 public:
-	DescriptorPool(Device& device, const DescriptorSetLayout& descriptorSetLayout, uint32_t maxSets);
+	DescriptorPool(Device& device, const DescriptorSetLayout& descriptorSetLayout, uint32_t maxSets, VkDescriptorPoolCreateFlags flags = 0);
 	~DescriptorPool();
 
 	DescriptorPool(const DescriptorPool&) = delete;
@@ -5,14 +5,28 @@
 #include "ImageView.h"
 #include "Sampler.h"
 
+// Compare the underlying handles so wrappers around the same Vulkan objects are equal
+bool ResourceBinding::operator==(const ResourceBinding& other) const
+{
+	auto bufferHandle = [](const Buffer* buffer) { return buffer ? buffer->handle() : VK_NULL_HANDLE; };
+	auto imageViewHandle = [](const ImageView* imageView) { return imageView ? imageView->handle() : VK_NULL_HANDLE; };
+	auto samplerHandle = [](const Sampler* sampler) { return sampler ? sampler->handle() : VK_NULL_HANDLE; };
+
+	return bufferHandle(buffer) == bufferHandle(other.buffer) &&
+		offset == other.offset &&
+		range == other.range &&
+		imageViewHandle(imageView) == imageViewHandle(other.imageView) &&
+		samplerHandle(sampler) == samplerHandle(other.sampler);
+}
+
 void DescriptorResourceReference::reset()
 {
 	mResourceBindings.clear();
 }
 
-void DescriptorResourceReference::generateDescriptorImageInfo(VkDescriptorImageInfo& imageInfo, uint32_t bindingIndex, uint32_t arrayIndex)
+void DescriptorResourceReference::generateDescriptorImageInfo(VkDescriptorImageInfo& imageInfo, uint32_t bindingIndex, uint32_t arrayIndex) const
 {
-	ResourceBinding& resource = mResourceBindings.at(bindingIndex).at(arrayIndex);
+	const ResourceBinding& resource = mResourceBindings.at(bindingIndex).at(arrayIndex);
 
 	if (resource.imageView == nullptr)
 	{
@@ -34,9 +48,9 @@ void DescriptorResourceReference::generateDescriptorImageInfo(VkDescriptorImageI
 
 }
 
-void DescriptorResourceReference::generateDescriptorBufferInfo(VkDescriptorBufferInfo& bufferInfo, uint32_t bindingIndex, uint32_t arrayIndex)
+void DescriptorResourceReference::generateDescriptorBufferInfo(VkDescriptorBufferInfo& bufferInfo, uint32_t bindingIndex, uint32_t arrayIndex) const
 {
-	ResourceBinding& resource = mResourceBindings.at(bindingIndex).at(arrayIndex);
+	const ResourceBinding& resource = mResourceBindings.at(bindingIndex).at(arrayIndex);
 
 	if (resource.buffer == nullptr)
 	{
@@ -50,7 +64,7 @@ void DescriptorResourceReference::generateDescriptorBufferInfo(VkDescriptorBuffe
 }
 
 // Generate infos for all bound resources
-void DescriptorResourceReference::generateDescriptorInfos(BindingMap<VkDescriptorImageInfo>& imageInfos, BindingMap<VkDescriptorBufferInfo>& bufferInfos)
+void DescriptorResourceReference::generateDescriptorInfos(BindingMap<VkDescriptorImageInfo>& imageInfos, BindingMap<VkDescriptorBufferInfo>& bufferInfos) const
 {
 	for (auto& binding : mResourceBindings)
 	{
@@ -14,6 +14,8 @@ struct ResourceBinding
 	VkDeviceSize		range{ 0 };
 	const ImageView*	imageView{ nullptr };
 	const Sampler*		sampler{ nullptr };
+
+	bool operator==(const ResourceBinding& other) const;
 };
 
 // Contains actual resources references in descriptor bindings
@@ -29,9 +31,9 @@ public:
 
 	// - Management
 	void reset();
-	void generateDescriptorImageInfo(VkDescriptorImageInfo& imageInfo, uint32_t bindingIndex, uint32_t arrayIndex);
-	void generateDescriptorBufferInfo(VkDescriptorBufferInfo& bufferInfo, uint32_t bindingIndex, uint32_t arrayIndex);
-	void generateDescriptorInfos(BindingMap<VkDescriptorImageInfo>& imageInfos, BindingMap<VkDescriptorBufferInfo>& bufferInfos);
+	void generateDescriptorImageInfo(VkDescriptorImageInfo& imageInfo, uint32_t bindingIndex, uint32_t arrayIndex) const;
+	void generateDescriptorBufferInfo(VkDescriptorBufferInfo& bufferInfo, uint32_t bindingIndex, uint32_t arrayIndex) const;
+	void generateDescriptorInfos(BindingMap<VkDescriptorImageInfo>& imageInfos, BindingMap<VkDescriptorBufferInfo>& bufferInfos) const;
 
 
 	void bindBuffer(const Buffer& buffer, const VkDeviceSize offset, const VkDeviceSize range, const uint32_t bindingIndex, const uint32_t arrayIndex);
@@ -1,7 +1,6 @@
 #include "DescriptorSet.h"
 
 #include "DescriptorPool.h"
-#include "DescriptorSetLayout.h"
 #include "Device.h"
 
 DescriptorSet::DescriptorSet(Device& device,
@@ -10,13 +9,12 @@ DescriptorSet::DescriptorSet(Device& device,
 	const BindingMap<VkDescriptorImageInfo>& imageInfos,
 	const BindingMap<VkDescriptorBufferInfo>& bufferInfos) :
 	mDevice(device),
-	mDescriptorPool(descriptorPool),
-	mImageInfos(imageInfos),
-	mBufferInfos(bufferInfos),
 	mDescriptorSetLayout(descriptorSetLayout),
-	mHandle(descriptorPool.allocate())
+	mDescriptorPool(descriptorPool),
+	mHandle(descriptorPool.allocate()),
+	mDescriptorInfos(descriptorSetLayout.descriptorCount())
 {
-	prepareWriteOperations();
+	setDescriptorInfos(imageInfos, bufferInfos);
 }
 
 DescriptorSet::DescriptorSet(Device& device,
@@ -25,13 +23,12 @@ DescriptorSet::DescriptorSet(Device& device,
 	const BindingMap<VkDescriptorBufferInfo>& bufferInfos,
 	const BindingMap<VkDescriptorImageInfo>& imageInfos) :
 	mDevice(device),
-	mDescriptorPool(descriptorPool),
-	mImageInfos(imageInfos),
-	mBufferInfos(bufferInfos),
 	mDescriptorSetLayout(descriptorSetLayout),
-	mHandle(descriptorPool.allocate())
+	mDescriptorPool(descriptorPool),
+	mHandle(descriptorPool.allocate()),
+	mDescriptorInfos(descriptorSetLayout.descriptorCount())
 {
-	prepareWriteOperations();
+	setDescriptorInfos(imageInfos, bufferInfos);
 }
 
 Device& DescriptorSet::device() const
@@ -44,146 +41,113 @@ VkDescriptorSet DescriptorSet::handle() const
 	return mHandle;
 }
 
-const BindingMap<VkDescriptorImageInfo>& DescriptorSet::imageInfos() const
+DescriptorPool& DescriptorSet::descriptorPool() const
 {
-	return mImageInfos;
+	return mDescriptorPool;
 }
 
-const BindingMap<VkDescriptorBufferInfo>& DescriptorSet::bufferInfos() const
+const std::vector<DescriptorInfo>& DescriptorSet::descriptorInfos() const
 {
-	return mBufferInfos;
+	return mDescriptorInfos;
 }
 
 // If passed vector is empty then update all bindings, otherwise only update selected bindings
-// Before updating, check if binding is already updated
+// Bindings which are already updated are skipped
 // Updating bindings changes the buffer/image which a binding refers to
 // This should only be called after the object is initialised or after a call of reset() with new image and buffer infos
 void DescriptorSet::update(const std::vector<uint32_t>& bindingsToUpdate)
 {
-	std::vector<VkWriteDescriptorSet> writeOperationsToPerform;
+	uint32_t requestedBindings = 0;
 
 	// If empty, update all
 	if (bindingsToUpdate.empty())
 	{
-		for (auto& writeOperation : mWriteOperations)
-		{
-			// if not already updated then add to writeOperationsToPerform
-			if (std::find(mUpdatedBindings.begin(), mUpdatedBindings.end(), writeOperation.dstBinding) == mUpdatedBindings.end())
-			{
-				writeOperationsToPerform.push_back(writeOperation);
-			}
-		}
+		requestedBindings = mBindingMask;
 	}
-	else 
+	else
 	{
-		// Otherwise just update bindingsToUpdate
-		for (auto& writeOperation : mWriteOperations)
+		for (uint32_t binding : bindingsToUpdate)
 		{
-			// if update requested then add to writeOperationsToPerform if not already updated
-			if (std::find(bindingsToUpdate.begin(), bindingsToUpdate.end(), writeOperation.dstBinding) != bindingsToUpdate.end() &&
-				std::find(mUpdatedBindings.begin(), mUpdatedBindings.end(), writeOperation.dstBinding) == mUpdatedBindings.end())
-			{
-				writeOperationsToPerform.push_back(writeOperation);
-			}
+			requestedBindings |= 1u << binding;
 		}
+		requestedBindings &= mBindingMask;
 	}
 
-	// Update descriptor sets
-	if (!writeOperationsToPerform.empty())
-	{
-		vkUpdateDescriptorSets(mDevice.logicalDevice(),
-			static_cast<uint32_t>(writeOperationsToPerform.size()),
-			writeOperationsToPerform.data(),
-			0,
-			nullptr);
-	}
+	uint32_t pendingBindings = requestedBindings & ~mUpdatedBindings;
 
-	// add list of updated bindings
-	for (auto& writeOperation : writeOperationsToPerform)
+	// Write every pending binding in one call
+	if (pendingBindings != 0)
 	{
-		mUpdatedBindings.push_back(writeOperation.dstBinding);
+		vkUpdateDescriptorSetWithTemplate(mDevice.logicalDevice(),
+			mHandle,
+			mDescriptorSetLayout.updateTemplate(pendingBindings),
+			mDescriptorInfos.data());
+
+		mUpdatedBindings |= pendingBindings;
 	}
+}
 
+// Write a single image descriptor immediately e.g. to add an element to a descriptor array
+// The binding is not added to the update mask so sparse arrays are never written in full by update()
+// The binding must be update after bind if the set may be in use by the device
+void DescriptorSet::writeImage(uint32_t bindingIndex, uint32_t descriptorIndex, const VkDescriptorImageInfo& imageInfo)
+{
+	auto& descriptorInfo = mDescriptorInfos[mDescriptorSetLayout.descriptorOffset(bindingIndex) + descriptorIndex].image;
+	descriptorInfo = imageInfo;
+
+	VkWriteDescriptorSet setWrite = {};
+	setWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	setWrite.dstSet = mHandle;
+	setWrite.dstBinding = bindingIndex;
+	setWrite.dstArrayElement = descriptorIndex;
+	setWrite.descriptorType = mDescriptorSetLayout.layoutBinding(bindingIndex).descriptorType;
+	setWrite.descriptorCount = 1;
+	setWrite.pImageInfo = &descriptorInfo;
+
+	vkUpdateDescriptorSets(mDevice.logicalDevice(), 1, &setWrite, 0, nullptr);
 }
 
-// Clear updated binding vector
-// If a non-empty info vector is passed prepare new write operations
+// Clear updated bindings
+// If a non-empty info map is passed replace the stored infos
 void DescriptorSet::reset(const BindingMap<VkDescriptorImageInfo>& newImageInfos, const BindingMap<VkDescriptorBufferInfo>& newBufferInfos)
 {
-	mUpdatedBindings.clear();
+	mUpdatedBindings = 0;
 
-	// Prepare new write operations
-	if (!newImageInfos.empty() && !newBufferInfos.empty())
+	if (!newImageInfos.empty() || !newBufferInfos.empty())
 	{
-		mImageInfos = newImageInfos;
-		mBufferInfos = newBufferInfos;
+		std::fill(mDescriptorInfos.begin(), mDescriptorInfos.end(), DescriptorInfo{});
+		mBindingMask = 0;
 
-		mWriteOperations.clear();
-		prepareWriteOperations();
+		setDescriptorInfos(newImageInfos, newBufferInfos);
 	}
-	
 }
 
-void DescriptorSet::prepareWriteOperations()
+// Copy infos into the flat array at the offsets given by the layout
+void DescriptorSet::setDescriptorInfos(const BindingMap<VkDescriptorImageInfo>& imageInfos, const BindingMap<VkDescriptorBufferInfo>& bufferInfos)
 {
-	prepareImageWriteOperations();
-	prepareBufferWriteOperations();
-}
-
-void DescriptorSet::prepareImageWriteOperations()
-{
-	for (auto& binding : mImageInfos)
+	for (auto& binding : imageInfos)
 	{
-		uint32_t bindingIndex = binding.first;
-		auto& bindingContents = binding.second;
+		uint32_t offset = mDescriptorSetLayout.descriptorOffset(binding.first);
+		assertCompleteBinding(binding.first, binding.second);
 
-		VkDescriptorType descriptorType = mDescriptorSetLayout.layoutBinding(bindingIndex).descriptorType;
-
-		for (auto& descriptor : bindingContents)
+		for (auto& descriptor : binding.second)
 		{
-			uint32_t descriptorIndex = descriptor.first;
-			auto& descriptorInfo = descriptor.second;
-
-			VkWriteDescriptorSet setWrite = {};
-			setWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			setWrite.dstSet = mHandle;											// Desctriptor set to update
-			setWrite.dstBinding = bindingIndex;									// Binding to update (matches with binding on layout/shader)
-			setWrite.dstArrayElement = descriptorIndex;							// Index in array to update
-			setWrite.descriptorType = descriptorType;		// Type of descriptor
-			setWrite.descriptorCount = 1;										// amount to update
-			setWrite.pImageInfo = &descriptorInfo;								// Information about image data to bind
-
-			mWriteOperations.push_back(setWrite);
+			mDescriptorInfos[offset + descriptor.first].image = descriptor.second;
 		}
-	}
-	
 
-}
+		mBindingMask |= 1u << binding.first;
+	}
 
-void DescriptorSet::prepareBufferWriteOperations()
-{
-	for (auto& binding : mBufferInfos)
+	for (auto& binding : bufferInfos)
 	{
-		uint32_t bindingIndex = binding.first;
-		auto& bindingContents = binding.second;
+		uint32_t offset = mDescriptorSetLayout.descriptorOffset(binding.first);
+		assertCompleteBinding(binding.first, binding.second);
 
-		VkDescriptorType descriptorType = mDescriptorSetLayout.layoutBinding(bindingIndex).descriptorType;
-
-		for (auto& descriptor : bindingContents)
+		for (auto& descriptor : binding.second)
 		{
-			uint32_t descriptorIndex = descriptor.first;
-			auto& descriptorInfo = descriptor.second;
-
-			VkWriteDescriptorSet setWrite = {};
-			setWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			setWrite.dstSet = mHandle;											// Desctriptor set to update
-			setWrite.dstBinding = bindingIndex;									// Binding to update (matches with binding on layout/shader)
-			setWrite.dstArrayElement = descriptorIndex;							// Index in array to update
-			setWrite.descriptorType = descriptorType;							// Type of descriptor
-			setWrite.descriptorCount = 1;										// amount to update
-			setWrite.pBufferInfo = &descriptorInfo;								// Information about buffer data to bind
-
-			mWriteOperations.push_back(setWrite);
+			mDescriptorInfos[offset + descriptor.first].buffer = descriptor.second;
 		}
+
+		mBindingMask |= 1u << binding.first;
 	}
 }
@@ -1,12 +1,13 @@
 #pragma once
 #include "Common.h"
+#include "DescriptorSetLayout.h"
 
 class DescriptorPool;
-class DescriptorSetLayout;
 class Device;
 
 // This class manages a descriptor set once it is allocated by from a pool
 // This primarily involves updating descriptors with writes
+// Infos are held in a flat array laid out by the set layout so bindings are written with a single cached update template
 class DescriptorSet
 {
 public:
@@ -28,11 +29,12 @@ public:
 	// - Getters
 	Device& device() const;
 	VkDescriptorSet handle() const;
-	const BindingMap<VkDescriptorImageInfo>& imageInfos() const;
-	const BindingMap<VkDescriptorBufferInfo>& bufferInfos() const;
+	DescriptorPool& descriptorPool() const;
+	const std::vector<DescriptorInfo>& descriptorInfos() const;
 
 	// - Management
 	void update(const std::vector<uint32_t>& bindingsToUpdate = {});
+	void writeImage(uint32_t bindingIndex, uint32_t descriptorIndex, const VkDescriptorImageInfo& imageInfo);
 	void reset(const BindingMap<VkDescriptorImageInfo>& newImageInfos = {},
 		const BindingMap<VkDescriptorBufferInfo>& newBufferInfos = {});
 
@@ -44,16 +46,21 @@ private:
 
 	VkDescriptorSet mHandle{ VK_NULL_HANDLE };
 
-	BindingMap<VkDescriptorImageInfo>	mImageInfos;
-	BindingMap<VkDescriptorBufferInfo>	mBufferInfos;
-
-	std::vector<VkWriteDescriptorSet> mWriteOperations;
-	std::vector<uint32_t> mUpdatedBindings;
+	std::vector<DescriptorInfo> mDescriptorInfos;	// Indexed by the layout's descriptor offsets
+	uint32_t mBindingMask{ 0 };						// Bindings which have infos to write
+	uint32_t mUpdatedBindings{ 0 };					// Bindings which have been written
 
 	// - Write operation support
-	void prepareWriteOperations();
-	void prepareImageWriteOperations();
-	void prepareBufferWriteOperations();
+	void setDescriptorInfos(const BindingMap<VkDescriptorImageInfo>& imageInfos, const BindingMap<VkDescriptorBufferInfo>& bufferInfos);
+
+	// Update templates write every descriptor of a binding so an info must be given for each, sparse arrays are written with writeImage
+	template<typename T>
+	void assertCompleteBinding(uint32_t bindingIndex, const std::map<uint32_t, T>& descriptors) const
+	{
+		assert(descriptors.size() == mDescriptorSetLayout.bindingDescriptorCount(bindingIndex) &&
+			descriptors.rbegin()->first < descriptors.size() &&
+			"Every descriptor of an updated binding must have an info!");
+	}
 
 };
 
@@ -0,0 +1,76 @@
+#include "DescriptorSetCache.h"
+
+#include "Buffer.h"
+#include "DescriptorPool.h"
+#include "DescriptorSet.h"
+#include "DescriptorSetLayout.h"
+#include "Device.h"
+#include "ImageView.h"
+#include "Sampler.h"
+
+DescriptorSetCache::DescriptorSetCache(Device& device, DescriptorSetLayout& descriptorSetLayout, uint32_t initialSets) :
+	mDevice(device),
+	mDescriptorSetLayout(descriptorSetLayout),
+	mDescriptorAllocator(device, descriptorSetLayout, initialSets)
+{
+}
+
+// Defined here so DescriptorSet is a complete type when cached sets are destroyed
+// The sets themselves are destroyed with the pools
+DescriptorSetCache::~DescriptorSetCache()
+{
+}
+
+// Return the set which binds these resources, allocating and writing it if no such set exists
+DescriptorSet& DescriptorSetCache::request(const DescriptorResourceReference& resourceReference)
+{
+	size_t key = hash(resourceReference);
+
+	auto range = mCachedSets.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second.resourceBindings == resourceReference.resourceBindings())
+		{
+			return *it->second.descriptorSet;
+		}
+	}
+
+	// Create a new set
+	BindingMap<VkDescriptorImageInfo> imageInfos;
+	BindingMap<VkDescriptorBufferInfo> bufferInfos;
+	resourceReference.generateDescriptorInfos(imageInfos, bufferInfos);
+
+	CachedSet cachedSet;
+	cachedSet.descriptorSet = std::make_unique<DescriptorSet>(mDevice, mDescriptorSetLayout, mDescriptorAllocator.requestPool(), imageInfos, bufferInfos);
+	cachedSet.descriptorSet->update();
+	cachedSet.resourceBindings = resourceReference.resourceBindings();
+
+	auto it = mCachedSets.emplace(key, std::move(cachedSet));
+	return *it->second.descriptorSet;
+}
+
+// Hash the layout together with the handles of every bound resource
+// Handles rather than wrapper addresses so identical contents always share a set
+size_t DescriptorSetCache::hash(const DescriptorResourceReference& resourceReference) const
+{
+	size_t seed = 0;
+	hashCombine(seed, mDescriptorSetLayout.handle());
+
+	for (auto& binding : resourceReference.resourceBindings())
+	{
+		for (auto& descriptor : binding.second)
+		{
+			auto& resource = descriptor.second;
+
+			hashCombine(seed, binding.first);
+			hashCombine(seed, descriptor.first);
+			hashCombine(seed, resource.buffer ? resource.buffer->handle() : VK_NULL_HANDLE);
+			hashCombine(seed, resource.offset);
+			hashCombine(seed, resource.range);
+			hashCombine(seed, resource.imageView ? resource.imageView->handle() : VK_NULL_HANDLE);
+			hashCombine(seed, resource.sampler ? resource.sampler->handle() : VK_NULL_HANDLE);
+		}
+	}
+
+	return seed;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "Common.h"
+
+#include "DescriptorAllocator.h"
+#include "DescriptorResourceReference.h"
+
+class DescriptorSet;
+class DescriptorSetLayout;
+class Device;
+
+// Shares descriptor sets between requests which bind identical resources with the same layout
+// Sets are keyed by a hash of the layout and the handles of the bound resources
+// Sets live until the cache is destroyed, not thread safe so sets should be requested on the loading thread
+class DescriptorSetCache
+{
+public:
+	DescriptorSetCache(Device& device, DescriptorSetLayout& descriptorSetLayout, uint32_t initialSets);
+	~DescriptorSetCache();
+
+	DescriptorSetCache(const DescriptorSetCache&) = delete;
+
+	// - Cache Management
+	DescriptorSet& request(const DescriptorResourceReference& resourceReference);
+
+private:
+	Device& mDevice;
+	DescriptorSetLayout& mDescriptorSetLayout;
+
+	DescriptorAllocator mDescriptorAllocator;
+
+	struct CachedSet {
+		std::unique_ptr<DescriptorSet> descriptorSet;
+		BindingMap<ResourceBinding> resourceBindings;		// Compared on lookup in case of hash collisions
+	};
+
+	std::unordered_multimap<size_t, CachedSet> mCachedSets;
+
+	// - Support
+	size_t hash(const DescriptorResourceReference& resourceReference) const;
+};
+
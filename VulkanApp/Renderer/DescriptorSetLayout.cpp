@@ -2,7 +2,7 @@
 
 #include "Device.h"
 
-DescriptorSetLayout::DescriptorSetLayout(Device& device, uint32_t setIndex, std::vector<ShaderResource>& shaderResources) :
+DescriptorSetLayout::DescriptorSetLayout(Device& device, uint32_t setIndex, std::vector<ShaderResource>& shaderResources, VkDescriptorSetLayoutCreateFlags flags) :
 	mDevice(device), mSetIndex(setIndex)
 {
 	// Create bindings
@@ -11,11 +11,16 @@ DescriptorSetLayout::DescriptorSetLayout(Device& device, uint32_t setIndex, std:
 		createDescriptorSetLayoutBinding(resource);
 	}
 
-	createDescriptorSetLayout();;
+	createDescriptorSetLayout(flags);
 }
 
 DescriptorSetLayout::~DescriptorSetLayout()
 {
+	for (auto& updateTemplate : mUpdateTemplates)
+	{
+		vkDestroyDescriptorUpdateTemplate(mDevice.logicalDevice(), updateTemplate.second, nullptr);
+	}
+
 	if (mHandle != VK_NULL_HANDLE)
 	{
 		vkDestroyDescriptorSetLayout(mDevice.logicalDevice(), mHandle, nullptr);
@@ -37,13 +42,57 @@ const std::vector<VkDescriptorSetLayoutBinding>& DescriptorSetLayout::layoutBind
 	return mLayoutBindings;
 }
 
+// Bindings are looked up by binding number as the shader may leave gaps between them
 const VkDescriptorSetLayoutBinding& DescriptorSetLayout::layoutBinding(uint32_t bindingIndex) const
 {
-	return mLayoutBindings.at(bindingIndex);
+	auto layoutBinding = std::find_if(mLayoutBindings.begin(), mLayoutBindings.end(),
+		[bindingIndex](const VkDescriptorSetLayoutBinding& binding) { return binding.binding == bindingIndex; });
+
+	if (layoutBinding == mLayoutBindings.end())
+	{
+		throw std::runtime_error("Failed to find a Descriptor Set Layout Binding!");
+	}
+
+	return *layoutBinding;
+}
+
+uint32_t DescriptorSetLayout::descriptorCount() const
+{
+	return mDescriptorCount;
+}
+
+uint32_t DescriptorSetLayout::descriptorOffset(uint32_t bindingIndex) const
+{
+	return mDescriptorOffsets.at(bindingIndex);
+}
+
+uint32_t DescriptorSetLayout::bindingDescriptorCount(uint32_t bindingIndex) const
+{
+	return layoutBinding(bindingIndex).descriptorCount;
+}
+
+// Return the cached template for this combination of bindings, creating it if needed
+VkDescriptorUpdateTemplate DescriptorSetLayout::updateTemplate(uint32_t bindingMask)
+{
+	std::lock_guard<std::mutex> lock(mUpdateTemplateMutex);
+
+	auto& updateTemplate = mUpdateTemplates[bindingMask];
+	if (updateTemplate == VK_NULL_HANDLE)
+	{
+		updateTemplate = createUpdateTemplate(bindingMask);
+	}
+
+	return updateTemplate;
 }
 
 void DescriptorSetLayout::createDescriptorSetLayoutBinding(ShaderResource& shaderResource)
 {
+	// Bindings are tracked in 32 bit masks
+	if (shaderResource.binding >= 32)
+	{
+		throw std::runtime_error("Failed to create a Descriptor Set Layout Binding, binding index must be less than 32!");
+	}
+
 	VkDescriptorSetLayoutBinding layoutBinding = {};
 	layoutBinding.binding = shaderResource.binding;						// Binding point in shader ( designated by binding number in shader)
 	layoutBinding.descriptorType = shaderResource.descriptorType;		// Type of descriptor (uniform, dynamic uniform, image sampler, etc)
@@ -52,16 +101,37 @@ void DescriptorSetLayout::createDescriptorSetLayoutBinding(ShaderResource& shade
 	layoutBinding.pImmutableSamplers = nullptr;
 
 	mLayoutBindings.push_back(layoutBinding);
+	mBindingFlags.push_back(shaderResource.bindingFlags);
+
+	// Reserve this binding's descriptors in the flat info array
+	if (mDescriptorOffsets.size() <= shaderResource.binding)
+	{
+		mDescriptorOffsets.resize(shaderResource.binding + 1, 0);
+	}
+	mDescriptorOffsets[shaderResource.binding] = mDescriptorCount;
+	mDescriptorCount += shaderResource.descriptorCount;
 }
 
 //void DescriptorSetLayout::createDescriptorSetLayout(std::vector<VkDescriptorSetLayoutBinding>& bindings)
-void DescriptorSetLayout::createDescriptorSetLayout()
+void DescriptorSetLayout::createDescriptorSetLayout(VkDescriptorSetLayoutCreateFlags flags)
 {
 	VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
 	layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutCreateInfo.flags = flags;
 	layoutCreateInfo.bindingCount = static_cast<uint32_t>(mLayoutBindings.size());					// Number of binding infos
 	layoutCreateInfo.pBindings = mLayoutBindings.data();											// Array of binding infos
 
+	// Binding flags are only chained if a binding uses descriptor indexing
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo = {};
+	bindingFlagsCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	bindingFlagsCreateInfo.bindingCount = static_cast<uint32_t>(mBindingFlags.size());
+	bindingFlagsCreateInfo.pBindingFlags = mBindingFlags.data();
+
+	if (std::any_of(mBindingFlags.begin(), mBindingFlags.end(), [](VkDescriptorBindingFlags bindingFlags) { return bindingFlags != 0; }))
+	{
+		layoutCreateInfo.pNext = &bindingFlagsCreateInfo;
+	}
+
 	// Create descriptor set layout
 	VkResult result = vkCreateDescriptorSetLayout(mDevice.logicalDevice(), &layoutCreateInfo, nullptr, &mHandle);
 	if (result != VK_SUCCESS)
@@ -70,7 +140,48 @@ void DescriptorSetLayout::createDescriptorSetLayout()
 	}
 }
 
-ShaderResource::ShaderResource(uint32_t binding, VkDescriptorType descriptorType, uint32_t descriptorCount, VkShaderStageFlags stageFlags) :
-	binding(binding), descriptorType(descriptorType), descriptorCount(descriptorCount), stageFlags(stageFlags)
+// Each entry writes every descriptor of one binding, reading infos from the binding's range of a flat DescriptorInfo array
+VkDescriptorUpdateTemplate DescriptorSetLayout::createUpdateTemplate(uint32_t bindingMask)
+{
+	std::vector<VkDescriptorUpdateTemplateEntry> entries;
+
+	for (auto& layoutBinding : mLayoutBindings)
+	{
+		if ((bindingMask & (1u << layoutBinding.binding)) == 0)
+		{
+			continue;
+		}
+
+		VkDescriptorUpdateTemplateEntry entry = {};
+		entry.dstBinding = layoutBinding.binding;
+		entry.dstArrayElement = 0;
+		entry.descriptorCount = layoutBinding.descriptorCount;
+		entry.descriptorType = layoutBinding.descriptorType;
+		entry.offset = mDescriptorOffsets[layoutBinding.binding] * sizeof(DescriptorInfo);
+		entry.stride = sizeof(DescriptorInfo);
+
+		entries.push_back(entry);
+	}
+
+	VkDescriptorUpdateTemplateCreateInfo templateCreateInfo = {};
+	templateCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+	templateCreateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+	templateCreateInfo.pDescriptorUpdateEntries = entries.data();
+	templateCreateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+	templateCreateInfo.descriptorSetLayout = mHandle;
+
+	VkDescriptorUpdateTemplate updateTemplate;
+	VkResult result = vkCreateDescriptorUpdateTemplate(mDevice.logicalDevice(), &templateCreateInfo, nullptr, &updateTemplate);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Descriptor Update Template!");
+	}
+
+	return updateTemplate;
+}
+
+ShaderResource::ShaderResource(uint32_t binding, VkDescriptorType descriptorType, uint32_t descriptorCount, VkShaderStageFlags stageFlags,
+	VkDescriptorBindingFlags bindingFlags) :
+	binding(binding), descriptorType(descriptorType), descriptorCount(descriptorCount), stageFlags(stageFlags), bindingFlags(bindingFlags)
 {
 }
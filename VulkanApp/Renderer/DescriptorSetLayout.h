@@ -3,20 +3,28 @@
 
 class Device;
 
+// One descriptor's info in the flat array read by an update template
+union DescriptorInfo {
+	VkDescriptorImageInfo image;
+	VkDescriptorBufferInfo buffer;
+};
+
 struct ShaderResource {
 	uint32_t				binding;
 	VkDescriptorType		descriptorType;
 	uint32_t				descriptorCount;
 	VkShaderStageFlags		stageFlags;
+	VkDescriptorBindingFlags bindingFlags{ 0 };		// Descriptor indexing flags e.g. partially bound, update after bind
 
 	ShaderResource() = default;
-	ShaderResource(uint32_t binding, VkDescriptorType descriptorType, uint32_t descriptorCount, VkShaderStageFlags stageFlags);
+	ShaderResource(uint32_t binding, VkDescriptorType descriptorType, uint32_t descriptorCount, VkShaderStageFlags stageFlags,
+		VkDescriptorBindingFlags bindingFlags = 0);
 };
 
 class DescriptorSetLayout
 {
 public:
-	DescriptorSetLayout(Device& device, uint32_t setIndex, std::vector<ShaderResource>& shaderResources);
+	DescriptorSetLayout(Device& device, uint32_t setIndex, std::vector<ShaderResource>& shaderResources, VkDescriptorSetLayoutCreateFlags flags = 0);
 	~DescriptorSetLayout();
 
 	// - Getters
@@ -26,6 +34,12 @@ public:
 	const std::vector<VkDescriptorSetLayoutBinding>& layoutBindings() const;
 	const VkDescriptorSetLayoutBinding& layoutBinding(uint32_t bindingIndex) const;
 
+	// - Update templates
+	uint32_t descriptorCount() const;							// Total descriptors across every binding
+	uint32_t descriptorOffset(uint32_t bindingIndex) const;		// Index of the binding's first descriptor in a flat DescriptorInfo array
+	uint32_t bindingDescriptorCount(uint32_t bindingIndex) const;	// Descriptors in one binding (array size)
+	VkDescriptorUpdateTemplate updateTemplate(uint32_t bindingMask);	// Template writing every descriptor of the bindings in the mask
+
 private:
 	Device& mDevice;
 
@@ -34,10 +48,21 @@ private:
 	const uint32_t mSetIndex;
 
 	std::vector<VkDescriptorSetLayoutBinding> mLayoutBindings;
+	std::vector<VkDescriptorBindingFlags> mBindingFlags;		// Index matches mLayoutBindings
+
+	// Flat descriptor info layout
+	std::vector<uint32_t> mDescriptorOffsets;					// Index matches binding
+	uint32_t mDescriptorCount{ 0 };
+
+	// Templates are created on first use for each combination of bindings
+	// Sets may be created on any recording thread so access is locked
+	std::unordered_map<uint32_t, VkDescriptorUpdateTemplate> mUpdateTemplates;
+	std::mutex mUpdateTemplateMutex;
 
 	// - Support
 	void createDescriptorSetLayoutBinding(ShaderResource& shaderResource);
-	void createDescriptorSetLayout();
+	void createDescriptorSetLayout(VkDescriptorSetLayoutCreateFlags flags);
+	VkDescriptorUpdateTemplate createUpdateTemplate(uint32_t bindingMask);
 
 
 };
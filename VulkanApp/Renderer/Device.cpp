@@ -1,17 +1,34 @@
 #include "Device.h"
 
+#include <cstddef>
+
 #include "CommandBuffer.h"
 #include "CommandPool.h"
 #include "Instance.h"
 #include "PhysicalDevice.h"
+#include "PipelineCache.h"
 #include "Queue.h"
 
-Device::Device(Instance& instance, VkSurfaceKHR surface, const std::vector<const char*>& requiredExtensions, VkPhysicalDeviceFeatures& requiredFeatures)
+// Timeline semaphores are always enabled as all queue synchronisation is built on them
+Device::Device(Instance& instance, VkSurfaceKHR surface, const std::vector<const char*>& requiredExtensions, VkPhysicalDeviceFeatures& requiredFeatures,
+	VkPhysicalDeviceVulkan12Features requiredFeatures12,
+	const VkPhysicalDeviceFeatures& optionalFeatures,
+	const VkPhysicalDeviceVulkan12Features& optionalFeatures12)
 	:mSurface(surface)
 {
-	getPhysicalDevice(instance.handle(), requiredExtensions, requiredFeatures);
-	createLogicalDevice(requiredExtensions, requiredFeatures);
+	requiredFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	requiredFeatures12.pNext = nullptr;
+	requiredFeatures12.timelineSemaphore = VK_TRUE;
+
+	getPhysicalDevice(instance.handle(), requiredExtensions, requiredFeatures, requiredFeatures12);
+
+	mEnabledFeatures = requiredFeatures;
+	mEnabledFeatures12 = requiredFeatures12;
+	enableOptionalFeatures(optionalFeatures, optionalFeatures12);
+
+	createLogicalDevice(requiredExtensions);
 	createCommandPool();
+	createPipelineCache();
 }
 
 Device::~Device()
@@ -19,6 +36,13 @@ Device::~Device()
 	mPrimaryCommandPool.reset();
 
 	waitIdle();
+
+	// Written to disk on destruction
+	mPipelineCache.reset();
+
+	// Queues own timeline semaphores so must be destroyed before the device
+	mQueues.clear();
+
 	vkDestroyDevice(mLogicalDevice, nullptr);
 }
 
@@ -38,11 +62,36 @@ CommandPool& Device::primaryCommandPool()
 	return *mPrimaryCommandPool;
 }
 
+PipelineCache& Device::pipelineCache()
+{
+	return *mPipelineCache;
+}
+
 const Queue& Device::queue(uint32_t familyIndex, uint32_t index) const
 {
 	return mQueues[familyIndex][index];
 }
 
+bool Device::synchronization2Enabled() const
+{
+	return mCmdPipelineBarrier2 != nullptr;
+}
+
+void Device::cmdPipelineBarrier2(VkCommandBuffer commandBuffer, const VkDependencyInfoKHR& dependencyInfo) const
+{
+	mCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+}
+
+const VkPhysicalDeviceFeatures& Device::enabledFeatures() const
+{
+	return mEnabledFeatures;
+}
+
+const VkPhysicalDeviceVulkan12Features& Device::enabledFeatures12() const
+{
+	return mEnabledFeatures12;
+}
+
 // TODO : abstract to physicald evice class
 const VkPhysicalDeviceProperties& Device::physicalDeviceProperties()
 {
@@ -103,8 +152,14 @@ void Device::endAndSubmitTemporaryCommandBuffer(CommandBuffer& commandBuffer)
 	// SUBMIT TO QUEUE
 	auto& queue = mQueues[commandBuffer.queueFamilyIndex()][0];		// get first queue with appropriate family index
 
-	queue.submit(commandBuffer);
-	vkQueueWaitIdle(queue.handle()); // TODO : need to abstract this out by requesting fences on submit
+	// Wait on the submission's timeline value rather than idling the whole queue
+	uint64_t signalValue = queue.submit(commandBuffer);
+
+	VkResult result = queue.wait(signalValue);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to wait for Temporary Command Buffer to complete!");
+	}
 
 	// CHECK : command buffer should now leave scope and be automatically freed
 	// FREE COMMAND BUFFER
@@ -124,7 +179,8 @@ uint32_t Device::getQueueFamilyIndex(VkQueueFlagBits queueFlag)
 	return mPhysicalDevice->getQueueFamilyIndex(queueFlag);
 }
 
-void Device::getPhysicalDevice(VkInstance instance, const std::vector<const char*>& requiredExtensions, VkPhysicalDeviceFeatures& requiredFeatures)
+void Device::getPhysicalDevice(VkInstance instance, const std::vector<const char*>& requiredExtensions, VkPhysicalDeviceFeatures& requiredFeatures,
+	const VkPhysicalDeviceVulkan12Features& requiredFeatures12)
 {
 	// Enumerate Physical devices the vkInstance can access
 	uint32_t deviceCount = 0;
@@ -146,7 +202,7 @@ void Device::getPhysicalDevice(VkInstance instance, const std::vector<const char
 	{
 		PhysicalDevice physicalDevice(deviceHandle);
 
-		if (physicalDevice.checkDeviceSuitable(requiredExtensions, requiredFeatures, mSurface))
+		if (physicalDevice.checkDeviceSuitable(requiredExtensions, requiredFeatures, requiredFeatures12, mSurface))
 		{
 			mPhysicalDevice = std::make_unique<PhysicalDevice>(std::move(physicalDevice));
 			return;
@@ -157,8 +213,34 @@ void Device::getPhysicalDevice(VkInstance instance, const std::vector<const char
 
 }
 
+// Add each optional feature which the physical device supports to the enabled features
+// Feature structs are arrays of VkBool32 (after sType + pNext for the 1.2 struct) so they are compared member by member
+void Device::enableOptionalFeatures(const VkPhysicalDeviceFeatures& optionalFeatures, const VkPhysicalDeviceVulkan12Features& optionalFeatures12)
+{
+	const VkBool32* optional = reinterpret_cast<const VkBool32*>(&optionalFeatures);
+	const VkBool32* supported = reinterpret_cast<const VkBool32*>(&mPhysicalDevice->features());
+	VkBool32* enabled = reinterpret_cast<VkBool32*>(&mEnabledFeatures);
+
+	for (size_t i = 0; i < sizeof(VkPhysicalDeviceFeatures) / sizeof(VkBool32); ++i)
+	{
+		enabled[i] = enabled[i] || (optional[i] && supported[i]);
+	}
+
+	const size_t offset12 = offsetof(VkPhysicalDeviceVulkan12Features, samplerMirrorClampToEdge);
+	const size_t count12 = (sizeof(VkPhysicalDeviceVulkan12Features) - offset12) / sizeof(VkBool32);
+
+	optional = reinterpret_cast<const VkBool32*>(reinterpret_cast<const char*>(&optionalFeatures12) + offset12);
+	supported = reinterpret_cast<const VkBool32*>(reinterpret_cast<const char*>(&mPhysicalDevice->features12()) + offset12);
+	enabled = reinterpret_cast<VkBool32*>(reinterpret_cast<char*>(&mEnabledFeatures12) + offset12);
+
+	for (size_t i = 0; i < count12; ++i)
+	{
+		enabled[i] = enabled[i] || (optional[i] && supported[i]);
+	}
+}
+
 // Create logical device and associated queues
-void Device::createLogicalDevice(const std::vector<const char*>& requiredExtensions, VkPhysicalDeviceFeatures& requiredFeatures)
+void Device::createLogicalDevice(const std::vector<const char*>& requiredExtensions)
 {
 	// Get number of queue families
 	uint32_t queueFamilyCount = 0;
@@ -190,14 +272,34 @@ void Device::createLogicalDevice(const std::vector<const char*>& requiredExtensi
 	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());				// Number of Queue Create Infos
 	deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();										// List of queue create infos so device can create required queues
-	deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(requiredExtensions.size());			// Number of enabled logical device extensions
-	deviceCreateInfo.ppEnabledExtensionNames = requiredExtensions.data();									// List of enabled logical device extensions
+	// Synchronization2 is optional so is enabled here rather than being a required extension
+	std::vector<const char*> extensions = requiredExtensions;
+	bool synchronization2 = mPhysicalDevice->synchronization2Supported();
+	if (synchronization2)
+	{
+		extensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+	}
+
+	deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());					// Number of enabled logical device extensions
+	deviceCreateInfo.ppEnabledExtensionNames = extensions.data();											// List of enabled logical device extensions
 
 	//// Physical Device Features the Logical Device will be using
 	//VkPhysicalDeviceFeatures deviceFeatures = {};
 	//deviceFeatures.samplerAnisotropy = VK_TRUE;		// Enable Anisotropy
 
-	deviceCreateInfo.pEnabledFeatures = &requiredFeatures;					// Physical Device features Logical Device will use
+	deviceCreateInfo.pEnabledFeatures = &mEnabledFeatures;					// Physical Device features Logical Device will use
+	deviceCreateInfo.pNext = &mEnabledFeatures12;							// Vulkan 1.2 features (e.g. timeline semaphores)
+
+	VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features = {};
+	synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+	synchronization2Features.synchronization2 = VK_TRUE;
+
+	VkPhysicalDeviceVulkan12Features features12 = mEnabledFeatures12;
+	if (synchronization2)
+	{
+		features12.pNext = &synchronization2Features;
+		deviceCreateInfo.pNext = &features12;
+	}
 
 
 	// Create the logical device for the given physical device
@@ -207,6 +309,11 @@ void Device::createLogicalDevice(const std::vector<const char*>& requiredExtensi
 		throw std::runtime_error("Failed to create a Logical Device!");
 	}
 
+	if (synchronization2)
+	{
+		mCmdPipelineBarrier2 = reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(vkGetDeviceProcAddr(mLogicalDevice, "vkCmdPipelineBarrier2KHR"));
+	}
+
 	// Create queue objects
 	mQueues.resize(queueFamilyCount);
 
@@ -227,3 +334,8 @@ void Device::createCommandPool()
 {
 	mPrimaryCommandPool = std::make_unique<CommandPool>(*this, getQueueFamilyIndex(VK_QUEUE_GRAPHICS_BIT));
 }
+
+void Device::createPipelineCache()
+{
+	mPipelineCache = std::make_unique<PipelineCache>(*this);
+}
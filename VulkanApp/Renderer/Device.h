@@ -6,6 +6,7 @@ class CommandBuffer;
 class CommandPool;
 class Instance;
 class PhysicalDevice;
+class PipelineCache;
 class Queue;
 
 // Container for logical and physical device
@@ -13,19 +14,30 @@ class Device
 {
 public:
 	// Create logical device based on list of requested extensions
-	Device(Instance& instance, VkSurfaceKHR surface, const std::vector<const char*>& requiredExtensions, VkPhysicalDeviceFeatures& requiredFeatures);
+	// Optional features are enabled if the chosen physical device supports them, check enabledFeatures() after creation
+	Device(Instance& instance, VkSurfaceKHR surface, const std::vector<const char*>& requiredExtensions, VkPhysicalDeviceFeatures& requiredFeatures,
+		VkPhysicalDeviceVulkan12Features requiredFeatures12 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES },
+		const VkPhysicalDeviceFeatures& optionalFeatures = {},
+		const VkPhysicalDeviceVulkan12Features& optionalFeatures12 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES });
 	~Device();
 
 	// - Getters
 	PhysicalDevice& physicalDevice() const;
 	VkDevice logicalDevice() const;
 	CommandPool& primaryCommandPool();
+	PipelineCache& pipelineCache();
 	const Queue& queue(uint32_t familyIndex, uint32_t index) const;
 	const VkPhysicalDeviceProperties& physicalDeviceProperties();
+	const VkPhysicalDeviceFeatures& enabledFeatures() const;
+	const VkPhysicalDeviceVulkan12Features& enabledFeatures12() const;
+	bool synchronization2Enabled() const;
 
 	const Queue& getQueueByFlag(VkQueueFlagBits queueFlag, uint32_t index);
 	uint32_t getQueueFamilyIndex(VkQueueFlagBits queueFlag);
 
+	// Only valid if synchronization2Enabled()
+	void cmdPipelineBarrier2(VkCommandBuffer commandBuffer, const VkDependencyInfoKHR& dependencyInfo) const;
+
 	CommandBuffer& requestCommandBuffer(VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 
 	// - Management
@@ -40,17 +52,29 @@ private:
 	VkDevice mLogicalDevice;
 	VkSurfaceKHR mSurface;
 
+	VkPhysicalDeviceFeatures mEnabledFeatures{};
+	VkPhysicalDeviceVulkan12Features mEnabledFeatures12{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+
+	// Enabled whenever supported, barriers fall back to vkCmdPipelineBarrier otherwise
+	PFN_vkCmdPipelineBarrier2KHR mCmdPipelineBarrier2{ nullptr };
+
 	std::vector<std::vector<Queue>> mQueues;
 
 	// Command pool associated with the primary queue
 	std::unique_ptr<CommandPool> mPrimaryCommandPool;
 
+	// Pipeline cache shared by all pipeline creation, persisted to disk
+	std::unique_ptr<PipelineCache> mPipelineCache;
+
 	// Functions
 	// - Get Physical Device referece
-	void getPhysicalDevice(VkInstance instance, const std::vector<const char*>& requiredExtensions, VkPhysicalDeviceFeatures& requiredFeatures);
+	void getPhysicalDevice(VkInstance instance, const std::vector<const char*>& requiredExtensions, VkPhysicalDeviceFeatures& requiredFeatures,
+		const VkPhysicalDeviceVulkan12Features& requiredFeatures12);
 	
 	// - Object creation
-	void createLogicalDevice(const std::vector<const char*>& requiredExtensions, VkPhysicalDeviceFeatures& requiredFeatures);
+	void enableOptionalFeatures(const VkPhysicalDeviceFeatures& optionalFeatures, const VkPhysicalDeviceVulkan12Features& optionalFeatures12);
+	void createLogicalDevice(const std::vector<const char*>& requiredExtensions);
 	void createCommandPool();
+	void createPipelineCache();
 	
 };
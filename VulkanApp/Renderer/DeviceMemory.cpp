@@ -43,6 +43,22 @@ VkDeviceMemory DeviceMemory::handle() const
     return mHandle;
 }
 
+bool DeviceMemory::hasMemoryType(Device& device, uint32_t allowedTypes, VkMemoryPropertyFlags properties)
+{
+	auto& memoryProperties = device.physicalDevice().memoryProperties();
+
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+	{
+		if ((allowedTypes & (1 << i))
+			&& (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 uint32_t DeviceMemory::findMemoryTypeIndex(VkPhysicalDevice physicalDevice, uint32_t allowedTypes, VkMemoryPropertyFlags properties)
 {
 	// Get properties of physical device memory
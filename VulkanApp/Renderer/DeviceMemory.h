@@ -12,6 +12,9 @@ public:
 	// - Getters
 	Device& device() const;
 	VkDeviceMemory handle() const;
+
+	// Check for a memory type with the properties among the allowed types (e.g. VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+	static bool hasMemoryType(Device& device, uint32_t allowedTypes, VkMemoryPropertyFlags properties);
 private:
 	Device& mDevice;
 
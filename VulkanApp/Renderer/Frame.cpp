@@ -2,6 +2,7 @@
 
 #include "Buffer.h"
 #include "CommandBuffer.h"
+#include "DescriptorAllocator.h"
 #include "DescriptorPool.h"
 #include "DescriptorResourceReference.h"
 #include "DescriptorSet.h"
@@ -11,10 +12,10 @@
 #include "Queue.h"
 #include "RenderTarget.h"
 
-Frame::Frame(Device& device, std::unique_ptr<RenderTarget>&& renderTarget, size_t threadCount) :
-	mDevice(device), mRenderTarget(std::move(renderTarget)),
-	mFencePool(device), mSemaphorePool(device),
-	mThreadCount(threadCount)
+Frame::Frame(Device& device, size_t threadCount, size_t renderTargetCount) :
+	mDevice(device),
+	mSemaphorePool(device),
+	mThreadCount(threadCount), mThreadData(threadCount), mRenderTargetCount(renderTargetCount)
 {
 
 }
@@ -24,31 +25,35 @@ Device& Frame::device() const
 	return mDevice;
 }
 
-const RenderTarget& Frame::renderTarget() const
-{
-	return *mRenderTarget;
-}
-
 const DescriptorSetLayout& Frame::descriptorSetLayout(uint32_t pipelineIndex)
 {
 	return *mDescriptorSetLayouts[pipelineIndex];
 }
 
-const DescriptorSet& Frame::descriptorSet(uint32_t pipelineIndex, size_t threadIndex)
+// targetIndex selects the set created for a given render target
+// Sets which do not reference any attachments are only created for target 0
+// The returned set is shared between threads and must not be updated while recording
+const DescriptorSet& Frame::descriptorSet(uint32_t pipelineIndex, uint32_t targetIndex)
 {
-	return *mThreadData[threadIndex].descriptorSets[pipelineIndex];
+	auto& descriptorSets = mDescriptorSets.at(pipelineIndex);
+
+	if (!descriptorSets[targetIndex])
+	{
+		return *descriptorSets[0];
+	}
+
+	return *descriptorSets[targetIndex];
 }
 
 void Frame::reset()
 {
-	// Reset synchronisation pools
-	mFencePool.reset();
+	// Reset synchronisation objects
+	mSubmissionValues.clear();
 	mSemaphorePool.reset();
 
 	// Reset thread data
-	for (size_t i = 0; i < mThreadCount; ++i)
+	for (auto& thread : mThreadData)
 	{
-		auto& thread = mThreadData[i];
 		for (auto& pool : thread.commandPools)
 		{
 			pool->reset();
@@ -70,24 +75,42 @@ void Frame::createDescriptorSetLayout(std::vector<ShaderResource>& shaderResourc
 	// Create descriptor set layout
 	mDescriptorSetLayouts[pipelineIndex] = std::make_unique<DescriptorSetLayout>(mDevice, setIndex, shaderResources);
 
-	// Create associted descriptor pool per thread
-	for (size_t i = 0; i < mThreadCount; ++i)
+	// Create associated descriptor allocator
+	// The first pool is sized to hold a set for every render target
+	uint32_t initialSets = static_cast<uint32_t>(mRenderTargetCount);
+	mDescriptorAllocators[pipelineIndex] = std::make_unique<DescriptorAllocator>(mDevice, *mDescriptorSetLayouts[pipelineIndex], initialSets);
+	mDescriptorSets[pipelineIndex].resize(mRenderTargetCount);
+}
+
+// Destroy all descriptor sets and reset the pools to hold sets for a new number of render targets
+// Layouts are kept, so descriptor sets can be recreated straight away (e.g. after the swapchain is recreated)
+// The frame must not be in use by the device when this is called
+void Frame::resetDescriptorSets(size_t renderTargetCount)
+{
+	mRenderTargetCount = renderTargetCount;
+
+	mDescriptorSets.clear();
+
+	// The allocators grow if the new number of render targets does not fit in their existing pools
+	for (auto& allocator : mDescriptorAllocators)
 	{
-		mThreadData[i].descriptorPools[pipelineIndex] = std::make_unique<DescriptorPool>(mDevice, *mDescriptorSetLayouts[pipelineIndex], 1);
+		uint32_t pipelineIndex = allocator.first;
+
+		allocator.second->reset();
+		mDescriptorSets[pipelineIndex].resize(mRenderTargetCount);
 	}
 }
 
 // Create resource references based on the provided indices to create image and buffer infos
-// These can then be used to create the "Per Frame" descriptor set for the provided 
+// These can then be used to create the "Per Frame" descriptor set for the provided render target
 // This method does not support creating a descriptor set with images which require sampling
-void Frame::createDescriptorSet(uint32_t pipelineIndex, const BindingMap<uint32_t>& imageIndices, const BindingMap<uint32_t>& bufferIndices)
+void Frame::createDescriptorSet(uint32_t pipelineIndex, const RenderTarget& renderTarget, const BindingMap<uint32_t>& imageIndices, const BindingMap<uint32_t>& bufferIndices, uint32_t targetIndex)
 {
 	// Bind image and buffers to resource reference
 	DescriptorResourceReference descriptorSetResourceReference;
 	std::vector<uint32_t> bindingsToUpdate{};
 
 	// Bind images
-	auto& targetImages = mRenderTarget->imageViews();
 	for (auto& binding : imageIndices)
 	{
 		uint32_t bindingIndex = binding.first;
@@ -101,7 +124,7 @@ void Frame::createDescriptorSet(uint32_t pipelineIndex, const BindingMap<uint32_
 			uint32_t imageIndex = descriptor.second;
 
 			// Create descriptor resource reference and genereate an image info
-			auto& imageView = (*mRenderTarget).mImageViews[imageIndex];
+			auto& imageView = renderTarget.mImageViews[imageIndex];
 			descriptorSetResourceReference.bindInputImage(imageView, bindingIndex, descriptorIndex);
 		}
 	}
@@ -135,19 +158,14 @@ void Frame::createDescriptorSet(uint32_t pipelineIndex, const BindingMap<uint32_
 
 	descriptorSetResourceReference.generateDescriptorInfos(imageInfos, bufferInfos);
 
-	// Create descriptor set per thread
-	for (size_t i = 0; i < mThreadCount; ++i)
-	{
-		auto& descriptorPool = *mThreadData[i].descriptorPools[pipelineIndex];
-		mThreadData[i].descriptorSets[pipelineIndex] = std::make_unique<DescriptorSet>(mDevice, *mDescriptorSetLayouts[pipelineIndex], descriptorPool, imageInfos, bufferInfos);
-		mThreadData[i].descriptorSets[pipelineIndex]->update(bindingsToUpdate);
-	}
+	// Create descriptor set shared by all threads
+	createSharedDescriptorSet(pipelineIndex, targetIndex, bindingsToUpdate, imageInfos, bufferInfos);
 }
 
 
 // Create descriptor sets created with descriptor set reference which can be used to generate image and buffer infos
 // Use this method if creating descriptor sets with external samplers or buffers
-void Frame::createDescriptorSet(uint32_t pipelineIndex, DescriptorResourceReference& resourceReference, const BindingMap<uint32_t>& bufferIndices)
+void Frame::createDescriptorSet(uint32_t pipelineIndex, DescriptorResourceReference& resourceReference, const BindingMap<uint32_t>& bufferIndices, uint32_t targetIndex)
 {
 	// Get bindings which will need updated
 	std::vector<uint32_t> bindingsToUpdate{};
@@ -188,13 +206,8 @@ void Frame::createDescriptorSet(uint32_t pipelineIndex, DescriptorResourceRefere
 
 	resourceReference.generateDescriptorInfos(imageInfos, bufferInfos);
 
-	// Create descriptor set per thread
-	for (size_t i = 0; i < mThreadCount; ++i)
-	{
-		auto& descriptorPool = *mThreadData[i].descriptorPools[pipelineIndex];
-		mThreadData[i].descriptorSets[pipelineIndex] = std::make_unique<DescriptorSet>(mDevice, *mDescriptorSetLayouts[pipelineIndex], descriptorPool, imageInfos, bufferInfos);
-		mThreadData[i].descriptorSets[pipelineIndex]->update(bindingsToUpdate);
-	}
+	// Create descriptor set shared by all threads
+	createSharedDescriptorSet(pipelineIndex, targetIndex, bindingsToUpdate, imageInfos, bufferInfos);
 }
 
 uint32_t Frame::createBuffer(VkDeviceSize bufferSize, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
@@ -204,9 +217,10 @@ uint32_t Frame::createBuffer(VkDeviceSize bufferSize, VkBufferUsageFlags usage,
 	return static_cast<uint32_t>(mBuffers.size() - 1);
 }
 
-VkFence Frame::requestFence()
+void Frame::addSubmission(const Queue& queue, uint64_t signalValue)
 {
-	return mFencePool.requestFence();
+	auto& value = mSubmissionValues[&queue];
+	value = std::max(value, signalValue);
 }
 
 VkSemaphore Frame::requestSemaphore()
@@ -214,12 +228,16 @@ VkSemaphore Frame::requestSemaphore()
 	return mSemaphorePool.requestSemaphore();
 }
 
+// Wait for the timeline value of each queue this frame submitted to
 void Frame::wait()
 {
-	VkResult result = mFencePool.wait();
-	if (result != VK_SUCCESS)
+	for (auto& submission : mSubmissionValues)
 	{
-		throw std::runtime_error("Failed to wait for Fence(s) to signal!");
+		VkResult result = submission.first->wait(submission.second);
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to wait for Timeline Semaphore to signal!");
+		}
 	}
 }
 
@@ -245,3 +263,14 @@ std::unique_ptr<CommandPool>& Frame::requestCommandPool(const Queue& queue, size
 
 	return commandPools.back();
 }
+
+// Create the descriptor set for the given pipeline and render target which is read by every recording thread
+void Frame::createSharedDescriptorSet(uint32_t pipelineIndex, uint32_t targetIndex, const std::vector<uint32_t>& bindingsToUpdate,
+	const BindingMap<VkDescriptorImageInfo>& imageInfos, const BindingMap<VkDescriptorBufferInfo>& bufferInfos)
+{
+	auto& descriptorPool = mDescriptorAllocators[pipelineIndex]->requestPool();
+	auto& descriptorSet = mDescriptorSets[pipelineIndex][targetIndex];
+
+	descriptorSet = std::make_unique<DescriptorSet>(mDevice, *mDescriptorSetLayouts[pipelineIndex], descriptorPool, imageInfos, bufferInfos);
+	descriptorSet->update(bindingsToUpdate);
+}
\ No newline at end of file
@@ -1,16 +1,13 @@
 #pragma once
-#include <ctpl_stl.h>
-
 #include "Common.h"
 
 #include "CommandPool.h"
-#include "FencePool.h"
 #include "SemaphorePool.h"
 
 class Buffer;
 class CommandBuffer;
 class Device;
-class DescriptorPool;
+class DescriptorAllocator;
 class DescriptorResourceReference;
 class DescriptorSet;
 class DescriptorSetLayout;
@@ -19,19 +16,20 @@ class RenderTarget;
 struct ShaderResource;
 
 
-// This is a container for data which must be held by every frame
+// This is a container for the CPU side resources which must be held by every frame in flight
 // All operation regarding command buffers and descriptor sets are handled in this class and multithreaded where possible
+// Render targets are owned per swapchain image by the renderer, so descriptor sets which reference attachments are created once per render target
+// Per frame descriptor sets are only read while recording so a single copy is shared by every thread
 class Frame
 {
 public:
-	Frame(Device& device, std::unique_ptr<RenderTarget>&& renderTarget, size_t threadCount = 1);
+	Frame(Device& device, size_t threadCount = 1, size_t renderTargetCount = 1);
 	~Frame() = default;
 
 	// - Getters
 	Device& device() const;
-	const RenderTarget& renderTarget() const;
 	const DescriptorSetLayout& descriptorSetLayout(uint32_t pipelineIndex = 0);
-	const DescriptorSet& descriptorSet(uint32_t pipelineIndex = 0, size_t threadIndex = 0);
+	const DescriptorSet& descriptorSet(uint32_t pipelineIndex = 0, uint32_t targetIndex = 0);
 
 	// - Frame management
 	void reset();
@@ -41,8 +39,9 @@ public:
 
 	// - Descriptor Sets
 	void createDescriptorSetLayout(std::vector<ShaderResource>& shaderResources, uint32_t pipelineIndex, uint32_t setIndex = 0);
-	void createDescriptorSet(uint32_t pipelineIndex, const BindingMap<uint32_t>& imageIndices = {}, const BindingMap<uint32_t>& bufferIndices = {});
-	void createDescriptorSet(uint32_t pipelineIndex, DescriptorResourceReference& resourceReference, const BindingMap<uint32_t>& bufferIndices = {});
+	void createDescriptorSet(uint32_t pipelineIndex, const RenderTarget& renderTarget, const BindingMap<uint32_t>& imageIndices = {}, const BindingMap<uint32_t>& bufferIndices = {}, uint32_t targetIndex = 0);
+	void createDescriptorSet(uint32_t pipelineIndex, DescriptorResourceReference& resourceReference, const BindingMap<uint32_t>& bufferIndices = {}, uint32_t targetIndex = 0);
+	void resetDescriptorSets(size_t renderTargetCount);
 
 	// - Buffers
 	uint32_t createBuffer(VkDeviceSize bufferSize,
@@ -60,7 +59,8 @@ public:
 	}
 
 	// -- Synchronisation
-	VkFence requestFence();
+	// Submissions are tracked by the timeline value they signal on their queue
+	void addSubmission(const Queue& queue, uint64_t signalValue);
 	VkSemaphore requestSemaphore();
 	void wait();
 
@@ -71,30 +71,35 @@ private:
 	struct ThreadData {
 		// Command Pools
 		std::vector<std::unique_ptr<CommandPool>> commandPools;			// per thread vector of command pools: Each index holds a pool for a different queue type
-		
-		// Descriptors - each index maps to a pipeline	
-		std::unordered_map<uint32_t, std::unique_ptr<DescriptorPool>> descriptorPools;
-		std::unordered_map<uint32_t, std::unique_ptr<DescriptorSet>> descriptorSets;
 	};
 
 	size_t mThreadCount{ 1 };
-	std::unordered_map<size_t, ThreadData> mThreadData;
+	std::vector<ThreadData> mThreadData;		// Index maps to a thread index
 
-	// - Render target
-	std::unique_ptr<RenderTarget> mRenderTarget;
+	// - Number of render targets (swapchain images) descriptor sets may be created for
+	size_t mRenderTargetCount{ 1 };
 
 	// - Descriptor Set Layouts - Index maps to a pipeline
 	std::unordered_map<uint32_t, std::unique_ptr<DescriptorSetLayout>> mDescriptorSetLayouts;
 
+	// - Shared descriptors - Index maps to a pipeline
+	// Descriptor sets hold one set per render target
+	std::unordered_map<uint32_t, std::unique_ptr<DescriptorAllocator>> mDescriptorAllocators;
+	std::unordered_map<uint32_t, std::vector<std::unique_ptr<DescriptorSet>>> mDescriptorSets;
+
 	// - Buffers
 	// TODO : update this to support dynamic buffers
 	std::vector<std::unique_ptr<Buffer>> mBuffers;
 
 	// - Synchronisation
-	FencePool mFencePool;
+	std::unordered_map<const Queue*, uint64_t> mSubmissionValues;		// Last timeline value signalled by this frame on each queue
 	SemaphorePool mSemaphorePool;
 
 	// - Support
 	// -- Command Pools
 	std::unique_ptr<CommandPool>& requestCommandPool(const Queue& queue, size_t threadIndex = 0);
+
+	// -- Descriptor Sets
+	void createSharedDescriptorSet(uint32_t pipelineIndex, uint32_t targetIndex, const std::vector<uint32_t>& bindingsToUpdate,
+		const BindingMap<VkDescriptorImageInfo>& imageInfos, const BindingMap<VkDescriptorBufferInfo>& bufferInfos);
 };
\ No newline at end of file
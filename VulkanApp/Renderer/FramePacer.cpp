@@ -0,0 +1,110 @@
+#include "FramePacer.h"
+
+#include <thread>
+
+// Statistics are averaged over this interval
+const std::chrono::milliseconds REPORT_INTERVAL(500);
+
+// Sleep granularity can be poor (~1ms or worse on some platforms) so the final part of the wait is spent spinning
+const std::chrono::milliseconds SPIN_THRESHOLD(2);
+
+FramePacer::FramePacer(float targetFrameRate, bool sleepBeforeInput) :
+	mTargetFrameRate(targetFrameRate), mSleepBeforeInput(sleepBeforeInput),
+	mNextFrameTime(Clock::now()), mPresentTime(Clock::now()), mLastReportTime(Clock::now())
+{
+}
+
+float FramePacer::targetFrameRate() const
+{
+	return mTargetFrameRate;
+}
+
+bool FramePacer::sleepBeforeInput() const
+{
+	return mSleepBeforeInput;
+}
+
+const LatencyStats& FramePacer::latencyStats() const
+{
+	return mLatencyStats;
+}
+
+void FramePacer::setTargetFrameRate(float targetFrameRate)
+{
+	mTargetFrameRate = std::max(targetFrameRate, 0.0f);
+	mNextFrameTime = Clock::now();
+}
+
+void FramePacer::setSleepBeforeInput(bool sleepBeforeInput)
+{
+	mSleepBeforeInput = sleepBeforeInput;
+}
+
+// Block the CPU until the next frame is due
+void FramePacer::limit()
+{
+	if (mTargetFrameRate <= 0.0f)
+	{
+		mNextFrameTime = Clock::now();
+		return;
+	}
+
+	auto frameDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / mTargetFrameRate));
+	mNextFrameTime += frameDuration;
+
+	// If the frame is already late then start a new schedule rather than trying to catch up
+	auto now = Clock::now();
+	if (mNextFrameTime <= now)
+	{
+		mNextFrameTime = now;
+		return;
+	}
+
+	if (mNextFrameTime - now > SPIN_THRESHOLD)
+	{
+		std::this_thread::sleep_until(mNextFrameTime - SPIN_THRESHOLD);
+	}
+
+	while (Clock::now() < mNextFrameTime)
+	{
+		std::this_thread::yield();
+	}
+}
+
+void FramePacer::markInputSampled(Clock::time_point sampleTime)
+{
+	mInputSampleTime = sampleTime;
+}
+
+void FramePacer::markSubmitted()
+{
+	mSubmitTime = Clock::now();
+}
+
+// Accumulate the timings for this frame and update the averages once the report interval has passed
+void FramePacer::markPresented()
+{
+	Clock::time_point now = Clock::now();
+
+	mInputToSubmitSum += mSubmitTime - mInputSampleTime;
+	mInputToPresentSum += now - mInputSampleTime;
+	mFrameTimeSum += now - mPresentTime;
+	++mSampleCount;
+
+	mPresentTime = now;
+
+	if (now - mLastReportTime < REPORT_INTERVAL)
+	{
+		return;
+	}
+
+	mLatencyStats.inputToSubmit = static_cast<float>(mInputToSubmitSum.count() / mSampleCount);
+	mLatencyStats.inputToPresent = static_cast<float>(mInputToPresentSum.count() / mSampleCount);
+	mLatencyStats.frameTime = static_cast<float>(mFrameTimeSum.count() / mSampleCount);
+
+	mInputToSubmitSum = Milliseconds(0.0);
+	mInputToPresentSum = Milliseconds(0.0);
+	mFrameTimeSum = Milliseconds(0.0);
+	mSampleCount = 0;
+	mLastReportTime = now;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <chrono>
+
+#include "Common.h"
+
+// Latency statistics averaged over the last reporting interval (milliseconds)
+struct LatencyStats {
+	float inputToSubmit{ 0.0f };		// Input sampled -> command buffer submitted
+	float inputToPresent{ 0.0f };		// Input sampled -> present call returned
+	float frameTime{ 0.0f };			// Present -> present
+};
+
+// CPU frame limiter and input latency instrumentation
+// limit() sleeps until the next frame is due based on the target frame rate (a rate of 0 is unlimited)
+// If sleepBeforeInput is set the renderer also blocks on the GPU before input is sampled rather than after
+// Timestamps from input sampling, submission and presentation are recorded to measure latency
+class FramePacer
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	FramePacer(float targetFrameRate = 0.0f, bool sleepBeforeInput = false);
+	~FramePacer() = default;
+
+	// - Getters
+	float targetFrameRate() const;
+	bool sleepBeforeInput() const;
+	const LatencyStats& latencyStats() const;
+
+	// - Setters
+	void setTargetFrameRate(float targetFrameRate);
+	void setSleepBeforeInput(bool sleepBeforeInput);
+
+	// - Pacing
+	void limit();
+
+	// - Instrumentation
+	void markInputSampled(Clock::time_point sampleTime);
+	void markSubmitted();
+	void markPresented();
+
+private:
+	using Milliseconds = std::chrono::duration<double, std::milli>;
+
+	float mTargetFrameRate{ 0.0f };
+	bool mSleepBeforeInput{ false };
+
+	Clock::time_point mNextFrameTime;
+
+	// - Timestamps for the current frame
+	Clock::time_point mInputSampleTime;
+	Clock::time_point mSubmitTime;
+	Clock::time_point mPresentTime;
+
+	// - Accumulated values since the last report
+	Milliseconds mInputToSubmitSum{ 0.0 };
+	Milliseconds mInputToPresentSum{ 0.0 };
+	Milliseconds mFrameTimeSum{ 0.0 };
+	uint32_t mSampleCount{ 0 };
+	Clock::time_point mLastReportTime;
+
+	LatencyStats mLatencyStats;
+};
+
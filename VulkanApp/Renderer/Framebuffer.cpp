@@ -8,27 +8,25 @@
 Framebuffer::Framebuffer(Device& device, const RenderPass& renderPass, const RenderTarget& renderTarget) :
 	mDevice(device)
 {
-	auto& extent = renderTarget.extent();
 	auto& imageViews = renderTarget.imageViews();
 	std::vector<VkImageView> framebufferAttachments(imageViews.size(), VK_NULL_HANDLE);
 
 	std::transform(imageViews.begin(), imageViews.end(), framebufferAttachments.begin(),
 		[](const ImageView& object) { return object.handle(); });
 
-	VkFramebufferCreateInfo framebufferCreateInfo = {};
-	framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-	framebufferCreateInfo.renderPass = renderPass.handle();											// Render pass layout the framebuffer will be used with
-	framebufferCreateInfo.attachmentCount = static_cast<uint32_t>(framebufferAttachments.size());
-	framebufferCreateInfo.pAttachments = framebufferAttachments.data();								// List of attachments (1:1 with Render Pass)
-	framebufferCreateInfo.width = extent.width;												// Framebuffer width
-	framebufferCreateInfo.height = extent.height;											// Framebuffer height
-	framebufferCreateInfo.layers = 1;														// Framebuffer layers
+	createFramebuffer(renderPass, renderTarget.extent(), framebufferAttachments);
+}
 
-	VkResult result = vkCreateFramebuffer(device.logicalDevice(), &framebufferCreateInfo, nullptr, &mHandle);
-	if (result != VK_SUCCESS)
-	{
-		throw std::runtime_error("Failed to create a Framebuffer");
-	}
+Framebuffer::Framebuffer(Device& device, const RenderPass& renderPass, const RenderTarget& renderTarget, const std::vector<uint32_t>& attachmentIndices) :
+	mDevice(device)
+{
+	auto& imageViews = renderTarget.imageViews();
+	std::vector<VkImageView> framebufferAttachments(attachmentIndices.size(), VK_NULL_HANDLE);
+
+	std::transform(attachmentIndices.begin(), attachmentIndices.end(), framebufferAttachments.begin(),
+		[&imageViews](uint32_t attachmentIndex) { return imageViews[attachmentIndex].handle(); });
+
+	createFramebuffer(renderPass, renderTarget.extent(), framebufferAttachments);
 }
 
 Framebuffer::~Framebuffer()
@@ -44,3 +42,21 @@ VkFramebuffer Framebuffer::handle() const
 {
 	return mHandle;
 }
+
+void Framebuffer::createFramebuffer(const RenderPass& renderPass, const VkExtent2D& extent, const std::vector<VkImageView>& framebufferAttachments)
+{
+	VkFramebufferCreateInfo framebufferCreateInfo = {};
+	framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferCreateInfo.renderPass = renderPass.handle();											// Render pass layout the framebuffer will be used with
+	framebufferCreateInfo.attachmentCount = static_cast<uint32_t>(framebufferAttachments.size());
+	framebufferCreateInfo.pAttachments = framebufferAttachments.data();								// List of attachments (1:1 with Render Pass)
+	framebufferCreateInfo.width = extent.width;												// Framebuffer width
+	framebufferCreateInfo.height = extent.height;											// Framebuffer height
+	framebufferCreateInfo.layers = 1;														// Framebuffer layers
+
+	VkResult result = vkCreateFramebuffer(mDevice.logicalDevice(), &framebufferCreateInfo, nullptr, &mHandle);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Framebuffer");
+	}
+}
@@ -11,6 +11,9 @@ class Framebuffer
 public:
 	//Framebuffer(Device& device, const VkExtent2D& extent, const std::vector<VkImageView>& imageViews, VkRenderPass renderPass);
 	Framebuffer(Device& device, const RenderPass& renderPass, const RenderTarget& renderTarget);
+	// Only the given attachments of the render target are used, in the order given
+	// e.g. for a render pass which writes part of another render pass's target before it begins
+	Framebuffer(Device& device, const RenderPass& renderPass, const RenderTarget& renderTarget, const std::vector<uint32_t>& attachmentIndices);
 	~Framebuffer();
 
 	// - Getters
@@ -21,5 +24,8 @@ private:
 
 	VkFramebuffer mHandle;
 
+	// - Support
+	void createFramebuffer(const RenderPass& renderPass, const VkExtent2D& extent, const std::vector<VkImageView>& framebufferAttachments);
+
 };
 
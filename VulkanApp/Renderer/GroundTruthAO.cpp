@@ -0,0 +1,220 @@
+#include "GroundTruthAO.h"
+
+#include "BarrierBatch.h"
+#include "CommandBuffer.h"
+#include "DescriptorPool.h"
+#include "DescriptorSet.h"
+#include "DescriptorSetLayout.h"
+#include "Device.h"
+#include "Framebuffer.h"
+#include "Image.h"
+#include "ImageView.h"
+#include "Pipeline.h"
+#include "PipelineLayout.h"
+#include "RenderPass.h"
+#include "RenderTarget.h"
+#include "Sampler.h"
+#include "ShaderModule.h"
+#include "Utilities.h"
+
+namespace {
+	const uint32_t GTAO_TILE_SIZE = 16;		// Must match TILE_SIZE in gtao.comp
+	const int32_t GTAO_SLICE_COUNT = 4;
+	const int32_t GTAO_STEP_COUNT = 4;
+	const VkFormat GTAO_OCCLUSION_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;	// Storage support is required for this format
+}
+
+GroundTruthAO::GroundTruthAO(Device& device, VkFormat depthFormat, float zNear, float zFar) :
+	mDevice(device), mDepthFormat(depthFormat), mNearPlane(zNear), mFarPlane(zFar)
+{
+	createRenderPass();
+
+	// Depth is read texel for texel
+	mDepthSampler = std::make_unique<Sampler>(
+		mDevice,
+		VK_FALSE,
+		0.0f,
+		0.0f,
+		0.0f,
+		0.0f,
+		VK_FILTER_NEAREST,
+		VK_FILTER_NEAREST,
+		VK_SAMPLER_MIPMAP_MODE_NEAREST,
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+
+	// Binding 0 : prepass depth, Binding 1 : occlusion
+	std::vector<ShaderResource> shaderResources;
+	shaderResources.emplace_back(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+	shaderResources.emplace_back(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+
+	// The pool is sized by the render target count when the images are created
+	mDescriptorSetLayout = std::make_unique<DescriptorSetLayout>(mDevice, 0, shaderResources);
+
+	// Projection and radius are pushed for each dispatch
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(GTAOPushConstant);
+
+	std::vector<std::reference_wrapper<const DescriptorSetLayout>> descriptorSetLayouts = { *mDescriptorSetLayout };
+	mPipelineLayout = std::make_unique<PipelineLayout>(mDevice, descriptorSetLayouts, pushConstantRange);
+}
+
+GroundTruthAO::~GroundTruthAO() = default;
+
+const RenderPass& GroundTruthAO::depthRenderPass() const
+{
+	return *mRenderPass;
+}
+
+const ImageView& GroundTruthAO::occlusionImageView(uint32_t targetIndex) const
+{
+	return *mOcclusionImageViews[targetIndex];
+}
+
+void GroundTruthAO::createPipeline()
+{
+	ShaderModule shaderModule(mDevice, readFile("Shaders/SSAOApp/gtao_comp.spv"), VK_SHADER_STAGE_COMPUTE_BIT);
+
+	// Clip planes are used to linearise depth as the tile is loaded
+	SpecializationConstants specializationConstants;
+	specializationConstants.set(SPECIALIZATION_Z_NEAR, mNearPlane);
+	specializationConstants.set(SPECIALIZATION_Z_FAR, mFarPlane);
+	specializationConstants.set(SPECIALIZATION_GTAO_SLICE_COUNT, GTAO_SLICE_COUNT);
+	specializationConstants.set(SPECIALIZATION_GTAO_STEP_COUNT, GTAO_STEP_COUNT);
+
+	mPipeline = std::make_unique<ComputePipeline>(mDevice, shaderModule, *mPipelineLayout, specializationConstants);
+}
+
+void GroundTruthAO::createImages(std::vector<std::unique_ptr<RenderTarget>>& renderTargets, uint32_t depthAttachmentIndex)
+{
+	mDepthTargets.clear();
+	mFramebuffers.clear();
+	mOcclusionImageViews.clear();
+	mOcclusionImages.clear();
+
+	mDepthAttachmentIndex = depthAttachmentIndex;
+
+	// Sets are freed with their pool, which is only recreated if the render target count changes
+	if (mDescriptorSets.size() != renderTargets.size())
+	{
+		mDescriptorSets.clear();
+		mDescriptorPool = std::make_unique<DescriptorPool>(mDevice, *mDescriptorSetLayout, static_cast<uint32_t>(renderTargets.size()));
+	}
+
+	for (auto& renderTarget : renderTargets)
+	{
+		// Only the depth attachment is written by the prepass
+		mDepthTargets.push_back(renderTarget.get());
+		mFramebuffers.push_back(std::make_unique<Framebuffer>(mDevice, *mRenderPass, *renderTarget, std::vector<uint32_t>{ mDepthAttachmentIndex }));
+
+		mOcclusionImages.push_back(std::make_unique<Image>(mDevice,
+			renderTarget->extent(),
+			GTAO_OCCLUSION_FORMAT,
+			VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+
+		mOcclusionImageViews.push_back(std::make_unique<ImageView>(*mOcclusionImages.back(), VK_IMAGE_VIEW_TYPE_2D));
+	}
+
+	createDescriptorSets();
+}
+
+void GroundTruthAO::beginDepthPrepass(CommandBuffer& commandBuffer, uint32_t targetIndex)
+{
+	VkClearValue depthClear = {};
+	depthClear.depthStencil.depth = 1.0f;
+
+	commandBuffer.beginRenderPass(*mDepthTargets[targetIndex],
+		*mRenderPass,
+		*mFramebuffers[targetIndex],
+		{ depthClear },
+		VK_SUBPASS_CONTENTS_INLINE);
+}
+
+void GroundTruthAO::recordOcclusion(CommandBuffer& commandBuffer, uint32_t targetIndex, const glm::mat4& projection, float radius)
+{
+	Image& depthImage = mDepthTargets[targetIndex]->image(mDepthAttachmentIndex);
+	Image& occlusionImage = *mOcclusionImages[targetIndex];
+
+	// The render pass leaves depth as an attachment, the barriers below make its writes visible to compute
+	ImageSubresourceState depthState;
+	depthState.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthState.writeStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR;
+	depthState.writeAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR;
+	depthImage.setSubresourceState(0, 0, depthState);
+
+	BarrierBatch barriers(mDevice);
+	barriers.transitionImage(depthImage,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
+		VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR);
+	barriers.transitionImage(occlusionImage,
+		VK_IMAGE_LAYOUT_GENERAL,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
+		VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR);
+	barriers.flush(commandBuffer);
+
+	commandBuffer.bindPipeline(VK_PIPELINE_BIND_POINT_COMPUTE, *mPipeline);
+
+	std::vector<std::reference_wrapper<const DescriptorSet>> descriptorGroup{ *mDescriptorSets[targetIndex] };
+	commandBuffer.bindDescriptorSets(VK_PIPELINE_BIND_POINT_COMPUTE, *mPipelineLayout, 0, descriptorGroup);
+
+	GTAOPushConstant pushConstant{ projection, radius };
+	commandBuffer.pushConstant(*mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, pushConstant);
+
+	// One invocation per pixel
+	const VkExtent2D& extent = mDepthTargets[targetIndex]->extent();
+	commandBuffer.dispatch((extent.width + GTAO_TILE_SIZE - 1) / GTAO_TILE_SIZE, (extent.height + GTAO_TILE_SIZE - 1) / GTAO_TILE_SIZE);
+
+	barriers.transitionImage(occlusionImage,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR,
+		VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR);
+	barriers.flush(commandBuffer);
+}
+
+// Depth is only written by the prepass so it is never loaded, it is kept for the compute pass and the main render pass to read
+void GroundTruthAO::createRenderPass()
+{
+	std::vector<Attachment> attachments;
+	attachments.emplace_back(mDepthFormat, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+
+	std::vector<SubpassInfo> subpassInfos = { { {}, { 0 } } };
+	std::vector<LoadStoreInfo> loadStoreInfos = { { VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE } };
+
+	// The previous frame's main render pass tests against and reads depth in memory shared by every render target
+	VkSubpassDependency dependency = {};
+	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependency.srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependency.dstSubpass = 0;
+	dependency.dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependency.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	mRenderPass = std::make_unique<RenderPass>(mDevice, attachments, subpassInfos, loadStoreInfos, std::vector<VkSubpassDependency>{ dependency });
+}
+
+// Sets are allocated once and rewritten when the images are recreated
+void GroundTruthAO::createDescriptorSets()
+{
+	for (uint32_t i = 0; i < mDepthTargets.size(); ++i)
+	{
+		BindingMap<VkDescriptorImageInfo> imageInfos;
+		imageInfos[0][0] = { mDepthSampler->handle(), mDepthTargets[i]->imageViews()[mDepthAttachmentIndex].handle(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		imageInfos[1][0] = { VK_NULL_HANDLE, mOcclusionImageViews[i]->handle(), VK_IMAGE_LAYOUT_GENERAL };
+
+		if (mDescriptorSets.size() <= i)
+		{
+			mDescriptorSets.push_back(std::make_unique<DescriptorSet>(mDevice, *mDescriptorSetLayout, *mDescriptorPool, imageInfos));
+		}
+		else
+		{
+			mDescriptorSets[i]->reset(imageInfos);
+		}
+
+		mDescriptorSets[i]->update();
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "Common.h"
+
+class CommandBuffer;
+class ComputePipeline;
+class DescriptorPool;
+class DescriptorSet;
+class DescriptorSetLayout;
+class Device;
+class Framebuffer;
+class Image;
+class ImageView;
+class PipelineLayout;
+class RenderPass;
+class RenderTarget;
+class Sampler;
+
+// Horizon based ambient occlusion (GTAO) evaluated by a compute pass on screen tiles
+// Each work group loads its tile plus an apron of linearised depth into shared memory once and searches for horizons in shared memory only
+// Compute cannot run inside a render pass so depth is rendered by a separate depth only render pass before the main render pass
+// Depth is rendered into the render targets' own depth attachment so the main render pass can load it instead of drawing depth again
+// Occlusion images are held for each render target and left readable by fragment shaders as a sampled image
+class GroundTruthAO
+{
+public:
+	GroundTruthAO(Device& device, VkFormat depthFormat, float zNear, float zFar);
+	~GroundTruthAO();
+
+	GroundTruthAO(const GroundTruthAO&) = delete;
+
+	// - Getters
+	const RenderPass& depthRenderPass() const;		// Depth prepass pipelines are created for subpass 0 of this render pass
+	const ImageView& occlusionImageView(uint32_t targetIndex) const;
+
+	// - Pipeline
+	void createPipeline();	// Can be called from a job, must be called before recording
+
+	// - Images
+	// (Re)create the occlusion images and depth framebuffers for the render targets, previous images must no longer be in use
+	// Depth is written to the depth attachment of each render target, the render targets must outlive their use here
+	void createImages(std::vector<std::unique_ptr<RenderTarget>>& renderTargets, uint32_t depthAttachmentIndex);
+
+	// - Record Functions
+	// Begin the depth only render pass, depth prepass draws are recorded inline by the caller who then ends the render pass
+	void beginDepthPrepass(CommandBuffer& commandBuffer, uint32_t targetIndex);
+	// Evaluate occlusion from the render target's prepass depth, must be recorded after the depth prepass and outside of a render pass
+	// Depth is left in the shader read only layout, radius is the view space sampling radius
+	void recordOcclusion(CommandBuffer& commandBuffer, uint32_t targetIndex, const glm::mat4& projection, float radius);
+
+private:
+	Device& mDevice;
+
+	VkFormat mDepthFormat{ VK_FORMAT_UNDEFINED };
+	float mNearPlane{ 0.0f };
+	float mFarPlane{ 0.0f };
+
+	// Depth prepass
+	std::unique_ptr<RenderPass> mRenderPass;
+
+	// Index maps to a render target
+	std::vector<RenderTarget*> mDepthTargets;		// Not owned
+	uint32_t mDepthAttachmentIndex{ 0 };
+	std::vector<std::unique_ptr<Framebuffer>> mFramebuffers;
+	std::vector<std::unique_ptr<Image>> mOcclusionImages;
+	std::vector<std::unique_ptr<ImageView>> mOcclusionImageViews;
+
+	// Occlusion pipeline
+	struct GTAOPushConstant {
+		glm::mat4 projection;
+		float radius;
+	};
+
+	std::unique_ptr<Sampler> mDepthSampler;
+	std::unique_ptr<DescriptorSetLayout> mDescriptorSetLayout;
+	std::unique_ptr<DescriptorPool> mDescriptorPool;
+	std::vector<std::unique_ptr<DescriptorSet>> mDescriptorSets;	// Index maps to a render target
+	std::unique_ptr<PipelineLayout> mPipelineLayout;
+	std::unique_ptr<ComputePipeline> mPipeline;
+
+	// - Support
+	void createRenderPass();
+	void createDescriptorSets();
+};
@@ -16,12 +16,15 @@ Image::Image(Device& device,
 	mExtent({ extent.width, extent.height, 1 }),
 	mFormat(format),
 	mSampleCount(sampleCount),
-	mUsage(usage)
+	mUsage(usage),
+	mExternal(true)
 {
 	mSubresource.arrayLayer = 1;
 	mSubresource.mipLevel = 1;
 	//mSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 
+	mSubresourceStates.resize(1);
+
 	//createImageView();
 }
 
@@ -46,17 +49,23 @@ Image::Image(Device& device,
 	mSampleCount(sampleCount), 
 	mUsage(usage), 
 	//mPropFlags(propFlags),
-	mSharingMode(VK_SHARING_MODE_EXCLUSIVE),
-	mLayout(initialLayout)
+	mSharingMode(VK_SHARING_MODE_EXCLUSIVE)
 {
 	mSubresource.mipLevel = mipLevels;
 	mSubresource.arrayLayer = arrayLayerCount;
 
+	ImageSubresourceState initialState;
+	initialState.layout = initialLayout;
+	mSubresourceStates.resize(mipLevels * arrayLayerCount, initialState);
+
 	// CREATE IMAGE
 	createImage();
 
 	// CREATE DEVICE MEMORY
-	createMemory(propFlags);
+	if (propFlags != 0)
+	{
+		createMemory(propFlags);
+	}
 
 	// CREATE VIEW
 	//createImageView();
@@ -106,8 +115,9 @@ Image::Image(Image&& other) :
 	mUsage(other.mUsage),
 	//mPropFlags(propFlags),
 	mSharingMode(other.mSharingMode),
-	mLayout(other.mLayout),
+	mSubresourceStates(std::move(other.mSubresourceStates)),
 	mHandle(other.mHandle),
+	mExternal(other.mExternal),
 	mMemory(std::move(other.mMemory))
 	//mImageView(other.mImageView)
 {
@@ -118,9 +128,9 @@ Image::~Image()
 {
 	
 
-	// If memory nullptr then object was created from an external VkImage (from swapchain)
-	// Therefore, only destroy image if it is not from swapchain
-	if (mHandle != VK_NULL_HANDLE && mMemory)
+	// Only destroy image if it is not from an external VkImage (from swapchain)
+	// Memory is freed once no image references it
+	if (mHandle != VK_NULL_HANDLE && !mExternal)
 	{
 		vkDestroyImage(mDevice.logicalDevice(), mHandle, nullptr);
 		
@@ -173,9 +183,65 @@ VkDeviceMemory Image::memory() const
 	return mMemory->handle();
 }
 
+// Layout of the first subresource, other subresources may differ (see subresourceState)
 VkImageLayout Image::layout() const
 {
-	return mLayout;
+	return mSubresourceStates[0].layout;
+}
+
+VkMemoryRequirements Image::memoryRequirements() const
+{
+	VkMemoryRequirements memoryRequirements;
+	vkGetImageMemoryRequirements(mDevice.logicalDevice(), mHandle, &memoryRequirements);
+
+	return memoryRequirements;
+}
+
+uint32_t Image::mipLevelCount() const
+{
+	return mSubresource.mipLevel;
+}
+
+uint32_t Image::arrayLayerCount() const
+{
+	return mSubresource.arrayLayer;
+}
+
+VkImageAspectFlags Image::aspectMask() const
+{
+	if (!isDepthStencilFormat(mFormat))
+	{
+		return VK_IMAGE_ASPECT_COLOR_BIT;
+	}
+
+	return isDepthOnlyFormat(mFormat) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+}
+
+const ImageSubresourceState& Image::subresourceState(uint32_t mipLevel, uint32_t arrayLayer) const
+{
+	return mSubresourceStates[arrayLayer * mSubresource.mipLevel + mipLevel];
+}
+
+void Image::setSubresourceState(uint32_t mipLevel, uint32_t arrayLayer, const ImageSubresourceState& state)
+{
+	mSubresourceStates[arrayLayer * mSubresource.mipLevel + mipLevel] = state;
+}
+
+// Bind memory allocated elsewhere, the memory must satisfy this image's memory requirements at the given offset
+void Image::bindMemory(std::shared_ptr<DeviceMemory> memory, VkDeviceSize offset)
+{
+	if (mMemory)
+	{
+		throw std::runtime_error("Image memory has already been bound!");
+	}
+
+	mMemory = std::move(memory);
+
+	VkResult result = vkBindImageMemory(mDevice.logicalDevice(), mHandle, mMemory->handle(), offset);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to bind Image memory!");
+	}
 }
 
 void Image::createMemory(VkMemoryPropertyFlags propFlags)
@@ -184,6 +250,14 @@ void Image::createMemory(VkMemoryPropertyFlags propFlags)
 	VkMemoryRequirements memoryRequirements;
 	vkGetImageMemoryRequirements(mDevice.logicalDevice(), mHandle, &memoryRequirements);
 
+	// Transient attachments are never stored so prefer memory which is only backed if the GPU needs it (e.g. not on tile based GPUs)
+	VkMemoryPropertyFlags lazyPropFlags = propFlags | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+	if ((mUsage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) && !(propFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) &&
+		DeviceMemory::hasMemoryType(mDevice, memoryRequirements.memoryTypeBits, lazyPropFlags))
+	{
+		propFlags = lazyPropFlags;
+	}
+
 	mMemory = std::make_unique<DeviceMemory>(mDevice, propFlags, memoryRequirements);
 
 	// Connect memory to image
@@ -204,7 +278,7 @@ void Image::createImage()
 	imageCreateInfo.arrayLayers = mSubresource.arrayLayer;			// Number of levels in image array
 	imageCreateInfo.format = mFormat;								// Format type of image
 	imageCreateInfo.tiling = mTiling;								// How image data should be "tiled" (arranged for optimal reading)
-	imageCreateInfo.initialLayout = mLayout;						// Layout of image data on creation
+	imageCreateInfo.initialLayout = mSubresourceStates[0].layout;		// Layout of image data on creation
 	imageCreateInfo.usage = mUsage;									// Bit flags defining what image will be used for
 	imageCreateInfo.samples = mSampleCount;							// Number of samples for multi-sampling
 	imageCreateInfo.sharingMode = mSharingMode;						// Whether image can be shared between queues
@@ -5,6 +5,17 @@
 class Device;
 class DeviceMemory;
 
+// Layout and access history of an image subresource (one mip level of one array layer)
+// Used to derive the source half of the next barrier so callers only give the new layout and access
+// The last write (or layout transition) is kept alongside the reads which have been synchronised with it since
+struct ImageSubresourceState {
+	VkImageLayout layout{ VK_IMAGE_LAYOUT_UNDEFINED };
+	VkPipelineStageFlags2KHR writeStageMask{ 0 };
+	VkAccessFlags2KHR writeAccessMask{ 0 };
+	VkPipelineStageFlags2KHR readStageMask{ 0 };
+	VkAccessFlags2KHR readAccessMask{ 0 };
+};
+
 // TODO: add functionality to change image properties based on member variables
 // TODO: support for 3D images
 // Container for an image and the image view referring to this image
@@ -21,6 +32,7 @@ public:
 	);
 
 	// Create an image object from input parameters
+	// If propFlags is 0 no memory is allocated and memory must be bound with bindMemory (e.g. memory shared by aliased images)
 	Image(Device& device,
 		const VkExtent2D& extent,
 		VkFormat format,
@@ -51,9 +63,18 @@ public:
 	VkImageUsageFlags usage() const;
 	VkDeviceMemory memory() const;
 	VkImageLayout layout() const;
+	VkMemoryRequirements memoryRequirements() const;
+	uint32_t mipLevelCount() const;
+	uint32_t arrayLayerCount() const;
+	VkImageAspectFlags aspectMask() const;
+	const ImageSubresourceState& subresourceState(uint32_t mipLevel, uint32_t arrayLayer = 0) const;
+
+	// - Setters
+	// Record the state a subresource is left in by a barrier or render pass
+	void setSubresourceState(uint32_t mipLevel, uint32_t arrayLayer, const ImageSubresourceState& state);
 
 	// - Image Management
-	////
+	void bindMemory(std::shared_ptr<DeviceMemory> memory, VkDeviceSize offset = 0);
 
 private:
 	Device& mDevice;
@@ -67,11 +88,15 @@ private:
 	VkImageTiling			mTiling{};
 	VkSampleCountFlagBits	mSampleCount{};
 	VkImageUsageFlags		mUsage{};
-	VkImageLayout			mLayout{};
 	VkSharingMode			mSharingMode{};
 
+	// Tracked state of each subresource, indexed by arrayLayer * mipLevelCount + mipLevel
+	std::vector<ImageSubresourceState> mSubresourceStates;
+
+	bool mExternal{ false };	// Handle is owned elsewhere (e.g. swapchain image) so is not destroyed
+
 	// - Associated with image
-	std::unique_ptr<DeviceMemory> mMemory{ nullptr };
+	std::shared_ptr<DeviceMemory> mMemory{ nullptr };	// May be shared with other images which alias the same memory
 	//VkImageView mImageView{ VK_NULL_HANDLE };
 
 	// - Image view management
@@ -0,0 +1,186 @@
+#include "JobSystem.h"
+
+// Index of the current thread in the job system. Threads not created by the job system are treated as thread 0
+static thread_local size_t tThreadIndex = 0;
+
+JobSystem::JobSystem(size_t threadCount) :
+	mThreadCount(std::max<size_t>(threadCount, 1))
+{
+	for (size_t i = 0; i < mThreadCount; ++i)
+	{
+		mWorkQueues.push_back(std::make_unique<WorkQueue>());
+	}
+
+	// Thread 0 is the calling thread so only create the remaining workers
+	for (size_t i = 1; i < mThreadCount; ++i)
+	{
+		mWorkers.emplace_back(&JobSystem::workerLoop, this, i);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mRunning = false;
+	}
+	mWakeCondition.notify_all();
+
+	for (auto& worker : mWorkers)
+	{
+		worker.join();
+	}
+}
+
+size_t JobSystem::threadCount() const
+{
+	return mThreadCount;
+}
+
+size_t JobSystem::threadIndex() const
+{
+	return tThreadIndex;
+}
+
+// Push a job to the back of the calling thread's deque
+void JobSystem::submit(Job job, JobCounter& counter)
+{
+	counter.pending.fetch_add(1);
+
+	WorkQueue& queue = *mWorkQueues[tThreadIndex];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back({ std::move(job), &counter });
+	}
+
+	mQueuedTasks.fetch_add(1);
+
+	// Lock before notifying so a worker about to sleep cannot miss the wake up
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+	}
+	mWakeCondition.notify_one();
+}
+
+// Execute queued jobs until every job in the counter has completed
+// Helping rather than blocking means jobs may safely wait on jobs they have submitted
+void JobSystem::wait(JobCounter& counter)
+{
+	size_t threadIndex = tThreadIndex;
+
+	while (counter.pending.load() > 0)
+	{
+		Task task;
+		if (findTask(threadIndex, task))
+		{
+			execute(task, threadIndex);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	if (counter.exception)
+	{
+		std::exception_ptr exception = counter.exception;
+		counter.exception = nullptr;
+		std::rethrow_exception(exception);
+	}
+}
+
+void JobSystem::parallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t, uint32_t, size_t)>& function)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	batchSize = std::max<uint32_t>(batchSize, 1);
+
+	JobCounter counter;
+
+	for (uint32_t start = 0; start < count; start += batchSize)
+	{
+		uint32_t end = std::min(count, start + batchSize);
+
+		submit([&function, start, end](size_t threadIndex) {
+			function(start, end, threadIndex);
+			}, counter);
+	}
+
+	wait(counter);
+}
+
+void JobSystem::workerLoop(size_t threadIndex)
+{
+	tThreadIndex = threadIndex;
+
+	while (true)
+	{
+		Task task;
+		if (findTask(threadIndex, task))
+		{
+			execute(task, threadIndex);
+			continue;
+		}
+
+		// Sleep until work is submitted or the job system is destroyed
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		mWakeCondition.wait(lock, [this]() { return !mRunning || mQueuedTasks.load() > 0; });
+
+		if (!mRunning)
+		{
+			return;
+		}
+	}
+}
+
+// Pop from the back of this thread's deque, otherwise steal from the front of another thread's deque
+bool JobSystem::findTask(size_t threadIndex, Task& task)
+{
+	{
+		WorkQueue& queue = *mWorkQueues[threadIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty())
+		{
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			mQueuedTasks.fetch_sub(1);
+			return true;
+		}
+	}
+
+	for (size_t i = 1; i < mThreadCount; ++i)
+	{
+		WorkQueue& victim = *mWorkQueues[(threadIndex + i) % mThreadCount];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			mQueuedTasks.fetch_sub(1);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void JobSystem::execute(Task& task, size_t threadIndex)
+{
+	try
+	{
+		task.job(threadIndex);
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock(task.counter->exceptionMutex);
+		if (!task.counter->exception)
+		{
+			task.counter->exception = std::current_exception();
+		}
+	}
+
+	task.counter->pending.fetch_sub(1);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <thread>
+
+#include "Common.h"
+
+// A job receives the index of the thread executing it so per thread resources (e.g. command pools) can be selected
+using Job = std::function<void(size_t threadIndex)>;
+
+// Tracks a group of submitted jobs so they can be waited on
+// The first exception thrown by a job in the group is rethrown by JobSystem::wait
+struct JobCounter {
+	std::atomic<uint32_t> pending{ 0 };
+
+	std::mutex exceptionMutex;
+	std::exception_ptr exception{ nullptr };
+};
+
+// Work stealing job system
+// Each thread owns a deque: jobs are pushed to and popped from the back of the submitting thread's deque,
+// idle threads steal from the front of other threads' deques
+// Thread index 0 is the thread which created the job system. It does not run a worker loop but executes jobs while waiting,
+// so threadCount() threads take part in total and thread indices are in the range [0, threadCount())
+class JobSystem
+{
+public:
+	JobSystem(size_t threadCount);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// - Getters
+	size_t threadCount() const;
+	size_t threadIndex() const;		// Index of the calling thread
+
+	// - Jobs
+	void submit(Job job, JobCounter& counter);
+	void wait(JobCounter& counter);
+
+	// Split [0, count) into batches of batchSize and run function(start, end, threadIndex) for each batch
+	// Blocks until all batches have completed
+	void parallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t, uint32_t, size_t)>& function);
+
+private:
+	struct Task {
+		Job job;
+		JobCounter* counter{ nullptr };
+	};
+
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	size_t mThreadCount{ 1 };
+	std::vector<std::unique_ptr<WorkQueue>> mWorkQueues;	// One per thread index
+	std::vector<std::thread> mWorkers;
+
+	// - Worker sleeping
+	std::atomic<bool> mRunning{ true };
+	std::atomic<uint32_t> mQueuedTasks{ 0 };
+	std::mutex mSleepMutex;
+	std::condition_variable mWakeCondition;
+
+	// - Support
+	void workerLoop(size_t threadIndex);
+	bool findTask(size_t threadIndex, Task& task);
+	void execute(Task& task, size_t threadIndex);
+};
+
@@ -0,0 +1,157 @@
+#include "LightClusters.h"
+
+#include "BarrierBatch.h"
+#include "Buffer.h"
+#include "CommandBuffer.h"
+#include "DescriptorPool.h"
+#include "DescriptorSet.h"
+#include "DescriptorSetLayout.h"
+#include "Device.h"
+#include "Pipeline.h"
+#include "PipelineLayout.h"
+#include "Utilities.h"
+
+namespace {
+	const uint32_t CLUSTER_WORK_GROUP_SIZE = 128;	// Must match WORK_GROUP_SIZE in cluster_lights.comp
+	const uint32_t CLUSTER_COUNT = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+}
+
+LightClusters::LightClusters(Device& device, uint32_t frameCount, uint32_t maxPointLights, float zNear, float zFar) :
+	mDevice(device), mMaxPointLights(maxPointLights), mNearPlane(zNear), mFarPlane(zFar)
+{
+	createBuffers(frameCount);
+	createDescriptorSets(frameCount);
+
+	// Inverse projection and the light transform are pushed for each dispatch
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(ClusterPushConstant);
+
+	std::vector<std::reference_wrapper<const DescriptorSetLayout>> descriptorSetLayouts = { *mDescriptorSetLayout };
+	mPipelineLayout = std::make_unique<PipelineLayout>(mDevice, descriptorSetLayouts, pushConstantRange);
+}
+
+LightClusters::~LightClusters() = default;
+
+uint32_t LightClusters::maxPointLights() const
+{
+	return mMaxPointLights;
+}
+
+const Buffer& LightClusters::lightBuffer(uint32_t frameIndex) const
+{
+	return *mLightBuffers[frameIndex];
+}
+
+const Buffer& LightClusters::clusterBuffer(uint32_t frameIndex) const
+{
+	return *mClusterBuffers[frameIndex];
+}
+
+void LightClusters::setSpecializationConstants(SpecializationConstants& specializationConstants)
+{
+	specializationConstants.set(SPECIALIZATION_CLUSTER_GRID_X, CLUSTER_GRID_X);
+	specializationConstants.set(SPECIALIZATION_CLUSTER_GRID_Y, CLUSTER_GRID_Y);
+	specializationConstants.set(SPECIALIZATION_CLUSTER_GRID_Z, CLUSTER_GRID_Z);
+	specializationConstants.set(SPECIALIZATION_MAX_LIGHTS_PER_CLUSTER, MAX_LIGHTS_PER_CLUSTER);
+}
+
+void LightClusters::createPipeline()
+{
+	ShaderModule shaderModule(mDevice, readFile("Shaders/Common/cluster_lights_comp.spv"), VK_SHADER_STAGE_COMPUTE_BIT);
+
+	// Slice depths are derived from the clip planes
+	SpecializationConstants specializationConstants;
+	specializationConstants.set(SPECIALIZATION_Z_NEAR, mNearPlane);
+	specializationConstants.set(SPECIALIZATION_Z_FAR, mFarPlane);
+	setSpecializationConstants(specializationConstants);
+
+	mPipeline = std::make_unique<ComputePipeline>(mDevice, shaderModule, *mPipelineLayout, specializationConstants);
+}
+
+void LightClusters::updateLights(uint32_t frameIndex, const SpotLight& flashLight, const std::vector<PointLight>& pointLights, const glm::mat4& transform)
+{
+	uint32_t pointLightCount = std::min(static_cast<uint32_t>(pointLights.size()), mMaxPointLights);
+
+	LightBufferHeader header;
+	header.lightCount.x = pointLightCount;
+	header.flashLight = flashLight;
+
+	uint8_t* data = static_cast<uint8_t*>(mLightBuffers[frameIndex]->map());
+
+	memcpy(data, &header, sizeof(LightBufferHeader));
+
+	PointLight* dstLights = reinterpret_cast<PointLight*>(data + sizeof(LightBufferHeader));
+	for (uint32_t i = 0; i < pointLightCount; ++i)
+	{
+		dstLights[i] = pointLights[i];
+		dstLights[i].position = transform * pointLights[i].position;
+	}
+
+	mLightBuffers[frameIndex]->unmap();
+}
+
+void LightClusters::recordCulling(CommandBuffer& commandBuffer, uint32_t frameIndex, const glm::mat4& projection, const glm::mat4& lightToView)
+{
+	commandBuffer.bindPipeline(VK_PIPELINE_BIND_POINT_COMPUTE, *mPipeline);
+
+	std::vector<std::reference_wrapper<const DescriptorSet>> descriptorGroup{ *mDescriptorSets[frameIndex] };
+	commandBuffer.bindDescriptorSets(VK_PIPELINE_BIND_POINT_COMPUTE, *mPipelineLayout, 0, descriptorGroup);
+
+	ClusterPushConstant pushConstant{ glm::inverse(projection), lightToView };
+	commandBuffer.pushConstant(*mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, pushConstant);
+
+	// One invocation per cluster
+	commandBuffer.dispatch((CLUSTER_COUNT + CLUSTER_WORK_GROUP_SIZE - 1) / CLUSTER_WORK_GROUP_SIZE);
+
+	// The previous read of this frame's clusters completed before the frame was waited on so only the write needs a barrier
+	BarrierBatch barriers(mDevice);
+	barriers.bufferBarrier(*mClusterBuffers[frameIndex],
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
+		VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR,
+		VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR,
+		VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR);
+	barriers.flush(commandBuffer);
+}
+
+// Lights are written by the host every frame, clusters are only accessed by the device
+void LightClusters::createBuffers(uint32_t frameCount)
+{
+	VkDeviceSize lightBufferSize = sizeof(LightBufferHeader) + sizeof(PointLight) * std::max(mMaxPointLights, 1u);
+	VkDeviceSize clusterBufferSize = sizeof(uint32_t) * CLUSTER_COUNT * (MAX_LIGHTS_PER_CLUSTER + 1);
+
+	for (uint32_t i = 0; i < frameCount; ++i)
+	{
+		mLightBuffers.push_back(std::make_unique<Buffer>(mDevice,
+			lightBufferSize,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+
+		mClusterBuffers.push_back(std::make_unique<Buffer>(mDevice,
+			clusterBufferSize,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+	}
+}
+
+void LightClusters::createDescriptorSets(uint32_t frameCount)
+{
+	// Binding 0 : lights, Binding 1 : clusters
+	std::vector<ShaderResource> shaderResources;
+	shaderResources.emplace_back(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+	shaderResources.emplace_back(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+
+	mDescriptorSetLayout = std::make_unique<DescriptorSetLayout>(mDevice, 0, shaderResources);
+	mDescriptorPool = std::make_unique<DescriptorPool>(mDevice, *mDescriptorSetLayout, frameCount);
+
+	for (uint32_t i = 0; i < frameCount; ++i)
+	{
+		BindingMap<VkDescriptorBufferInfo> bufferInfos;
+		bufferInfos[0][0] = { mLightBuffers[i]->handle(), 0, mLightBuffers[i]->size() };
+		bufferInfos[1][0] = { mClusterBuffers[i]->handle(), 0, mClusterBuffers[i]->size() };
+
+		mDescriptorSets.push_back(std::make_unique<DescriptorSet>(mDevice, *mDescriptorSetLayout, *mDescriptorPool, bufferInfos));
+		mDescriptorSets.back()->update();
+	}
+}
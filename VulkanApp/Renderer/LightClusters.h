@@ -0,0 +1,83 @@
+#pragma once
+#include "Common.h"
+
+#include "Light.h"
+#include "ShaderModule.h"
+
+class Buffer;
+class CommandBuffer;
+class ComputePipeline;
+class DescriptorPool;
+class DescriptorSet;
+class DescriptorSetLayout;
+class Device;
+class PipelineLayout;
+
+// Start of the light storage buffer, the point light array follows
+struct LightBufferHeader
+{
+	alignas(16) glm::uvec4 lightCount{ 0 };	// x : point light count
+	SpotLight flashLight;
+};
+
+// Assigns point lights to view space clusters with a compute pass so lighting only evaluates the lights in a fragment's cluster
+// The screen is split into CLUSTER_GRID_X * CLUSTER_GRID_Y tiles and view depth into CLUSTER_GRID_Z exponentially spaced slices
+// Each cluster holds a light count followed by up to MAX_LIGHTS_PER_CLUSTER light indices
+// A light buffer and a cluster buffer are held for each frame in flight, lighting passes bind both as storage buffers
+class LightClusters
+{
+public:
+	LightClusters(Device& device, uint32_t frameCount, uint32_t maxPointLights, float zNear, float zFar);
+	~LightClusters();
+
+	LightClusters(const LightClusters&) = delete;
+
+	// - Getters
+	uint32_t maxPointLights() const;
+	const Buffer& lightBuffer(uint32_t frameIndex) const;
+	const Buffer& clusterBuffer(uint32_t frameIndex) const;
+
+	// - Setters
+	// Add the cluster grid constants read by both the culling and lighting shaders
+	static void setSpecializationConstants(SpecializationConstants& specializationConstants);
+
+	// - Pipeline
+	void createPipeline();	// Can be called from a job, must be called before recording
+
+	// - Lights
+	// Light positions are multiplied by the transform as they are written, point lights beyond the capacity are dropped
+	void updateLights(uint32_t frameIndex, const SpotLight& flashLight, const std::vector<PointLight>& pointLights,
+		const glm::mat4& transform = glm::mat4(1.0f));
+
+	// - Record Functions
+	// Assign lights to the frame's clusters then make the clusters visible to fragment shaders
+	// Must be recorded outside of a render pass, lightToView transforms the uploaded light positions to view space
+	void recordCulling(CommandBuffer& commandBuffer, uint32_t frameIndex, const glm::mat4& projection, const glm::mat4& lightToView);
+
+private:
+	Device& mDevice;
+
+	uint32_t mMaxPointLights{ 0 };
+	float mNearPlane{ 0.0f };
+	float mFarPlane{ 0.0f };
+
+	// Index maps to a frame in flight
+	std::vector<std::unique_ptr<Buffer>> mLightBuffers;
+	std::vector<std::unique_ptr<Buffer>> mClusterBuffers;
+
+	// Culling pipeline
+	struct ClusterPushConstant {
+		glm::mat4 inverseProjection;
+		glm::mat4 lightToView;
+	};
+
+	std::unique_ptr<DescriptorSetLayout> mDescriptorSetLayout;
+	std::unique_ptr<DescriptorPool> mDescriptorPool;
+	std::vector<std::unique_ptr<DescriptorSet>> mDescriptorSets;	// Index maps to a frame in flight
+	std::unique_ptr<PipelineLayout> mPipelineLayout;
+	std::unique_ptr<ComputePipeline> mPipeline;
+
+	// - Support
+	void createBuffers(uint32_t frameCount);
+	void createDescriptorSets(uint32_t frameCount);
+};
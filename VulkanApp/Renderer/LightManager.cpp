@@ -0,0 +1,255 @@
+#include "LightManager.h"
+
+#include <cfloat>
+#include <xmmintrin.h>
+
+namespace {
+	const uint32_t LANE_COUNT = 4;			// Lights processed by each SSE instruction
+	const float LIGHT_CUTOFF = 0.01f;		// Must match LIGHT_CUTOFF in cluster_lights.comp and the lighting shaders
+
+	uint32_t paddedCount(uint32_t count)
+	{
+		return (count + LANE_COUNT - 1) / LANE_COUNT * LANE_COUNT;
+	}
+}
+
+uint32_t LightManager::pointLightCount() const
+{
+	return mLightCount;
+}
+
+uint32_t LightManager::visibleLightCount() const
+{
+	return static_cast<uint32_t>(mVisibleLights.size());
+}
+
+glm::vec3 LightManager::position(uint32_t lightIndex) const
+{
+	return glm::vec3(mPositionX[lightIndex], mPositionY[lightIndex], mPositionZ[lightIndex]);
+}
+
+const std::vector<PointLight>& LightManager::visibleLights() const
+{
+	return mVisibleLights;
+}
+
+void LightManager::setPosition(uint32_t lightIndex, const glm::vec3& position)
+{
+	mPositionX[lightIndex] = position.x;
+	mPositionY[lightIndex] = position.y;
+	mPositionZ[lightIndex] = position.z;
+}
+
+void LightManager::setColour(uint32_t lightIndex, const glm::vec4& colour)
+{
+	mColours[lightIndex] = colour;
+	mEnabled[lightIndex] = colour.w > 0.0f ? 1.0f : 0.0f;
+}
+
+void LightManager::setIntensityAndAttenuation(uint32_t lightIndex, const glm::vec4& intensityAndAttenuation)
+{
+	mIntensity[lightIndex] = intensityAndAttenuation.x;
+	mKq[lightIndex] = intensityAndAttenuation.y;
+	mKl[lightIndex] = intensityAndAttenuation.z;
+	mKc[lightIndex] = intensityAndAttenuation.w;
+}
+
+void LightManager::reserve(uint32_t lightCount)
+{
+	uint32_t storageCount = paddedCount(lightCount);
+
+	for (auto* values : { &mPositionX, &mPositionY, &mPositionZ, &mIntensity, &mKq, &mKl, &mKc, &mEnabled, &mRadius })
+	{
+		values->reserve(storageCount);
+	}
+	mColours.reserve(storageCount);
+}
+
+uint32_t LightManager::addPointLight(const PointLight& light)
+{
+	uint32_t lightIndex = mLightCount++;
+	uint32_t storageCount = paddedCount(mLightCount);
+
+	// New padding lanes are zeroed, which leaves them off
+	for (auto* values : { &mPositionX, &mPositionY, &mPositionZ, &mIntensity, &mKq, &mKl, &mKc, &mEnabled, &mRadius })
+	{
+		values->resize(storageCount, 0.0f);
+	}
+	mColours.resize(storageCount, glm::vec4(0.0f));
+
+	setPosition(lightIndex, glm::vec3(light.position));
+	setColour(lightIndex, light.colour);
+	setIntensityAndAttenuation(lightIndex, light.intensityAndAttenuation);
+
+	return lightIndex;
+}
+
+void LightManager::clear()
+{
+	mLightCount = 0;
+
+	for (auto* values : { &mPositionX, &mPositionY, &mPositionZ, &mIntensity, &mKq, &mKl, &mKc, &mEnabled, &mRadius })
+	{
+		values->clear();
+	}
+	mColours.clear();
+
+	mVisibleIndices.clear();
+	mVisibleLights.clear();
+}
+
+void LightManager::update(const glm::mat4& view, const glm::mat4& projection)
+{
+	calculateRadii();
+	cullLights(frustumPlanes(projection * view));
+	transformVisibleLights(view);
+}
+
+// Distance at which each light's attenuated intensity falls to LIGHT_CUTOFF (as calcLightRadius in cluster_lights.comp)
+// Solves Kq * d^2 + Kl * d + Kc = intensity / LIGHT_CUTOFF, lights which are off are given a radius no sphere test can pass
+void LightManager::calculateRadii()
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 four = _mm_set1_ps(4.0f);
+	const __m128 inverseCutoff = _mm_set1_ps(1.0f / LIGHT_CUTOFF);
+	const __m128 offRadius = _mm_set1_ps(-FLT_MAX);
+
+	for (uint32_t i = 0; i < mLightCount; i += LANE_COUNT)
+	{
+		__m128 intensity = _mm_loadu_ps(&mIntensity[i]);
+		__m128 Kq = _mm_loadu_ps(&mKq[i]);
+		__m128 Kl = _mm_loadu_ps(&mKl[i]);
+		__m128 Kc = _mm_sub_ps(_mm_loadu_ps(&mKc[i]), _mm_mul_ps(intensity, inverseCutoff));
+
+		// (-Kl + sqrt(Kl^2 - 4 * Kq * Kc)) / (2 * Kq)
+		__m128 discriminant = _mm_max_ps(_mm_sub_ps(_mm_mul_ps(Kl, Kl), _mm_mul_ps(four, _mm_mul_ps(Kq, Kc))), zero);
+		__m128 radius = _mm_div_ps(_mm_sub_ps(_mm_sqrt_ps(discriminant), Kl), _mm_mul_ps(two, Kq));
+
+		__m128 enabled = _mm_cmpgt_ps(_mm_loadu_ps(&mEnabled[i]), zero);
+		radius = _mm_or_ps(_mm_and_ps(enabled, radius), _mm_andnot_ps(enabled, offRadius));
+
+		_mm_storeu_ps(&mRadius[i], radius);
+
+		// Lights without a quadratic term are rare so they are solved one at a time
+		int linearMask = _mm_movemask_ps(_mm_and_ps(enabled, _mm_cmple_ps(Kq, zero)));
+		for (uint32_t lane = 0; linearMask != 0 && lane < LANE_COUNT; ++lane)
+		{
+			if (linearMask & (1 << lane))
+			{
+				uint32_t lightIndex = i + lane;
+				float constant = mKc[lightIndex] - mIntensity[lightIndex] / LIGHT_CUTOFF;
+
+				mRadius[lightIndex] = mKl[lightIndex] > 0.0f ? -constant / mKl[lightIndex] : FLT_MAX;
+			}
+		}
+	}
+}
+
+// Test the light spheres against every plane four lights at a time
+// Visible lights are appended to the visible list along with their positions so they can be transformed in batches
+void LightManager::cullLights(const std::array<glm::vec4, 6>& planes)
+{
+	mVisibleIndices.clear();
+	mVisibleX.clear();
+	mVisibleY.clear();
+	mVisibleZ.clear();
+
+	// Broadcast each plane component to every lane
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+	for (size_t p = 0; p < planes.size(); ++p)
+	{
+		planeX[p] = _mm_set1_ps(planes[p].x);
+		planeY[p] = _mm_set1_ps(planes[p].y);
+		planeZ[p] = _mm_set1_ps(planes[p].z);
+		planeW[p] = _mm_set1_ps(planes[p].w);
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+
+	for (uint32_t i = 0; i < mLightCount; i += LANE_COUNT)
+	{
+		__m128 x = _mm_loadu_ps(&mPositionX[i]);
+		__m128 y = _mm_loadu_ps(&mPositionY[i]);
+		__m128 z = _mm_loadu_ps(&mPositionZ[i]);
+		__m128 negativeRadius = _mm_sub_ps(zero, _mm_loadu_ps(&mRadius[i]));
+
+		// A sphere is outside if it is entirely behind any plane
+		__m128 inside = _mm_cmpeq_ps(zero, zero);
+		for (size_t p = 0; p < planes.size(); ++p)
+		{
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(x, planeX[p]), _mm_mul_ps(y, planeY[p])),
+				_mm_add_ps(_mm_mul_ps(z, planeZ[p]), planeW[p]));
+
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+		}
+
+		int visibleMask = _mm_movemask_ps(inside);
+
+		// Lanes past the last light are padding
+		uint32_t laneCount = std::min(LANE_COUNT, mLightCount - i);
+		for (uint32_t lane = 0; visibleMask != 0 && lane < laneCount; ++lane)
+		{
+			if (visibleMask & (1 << lane))
+			{
+				uint32_t lightIndex = i + lane;
+
+				mVisibleIndices.push_back(lightIndex);
+				mVisibleX.push_back(mPositionX[lightIndex]);
+				mVisibleY.push_back(mPositionY[lightIndex]);
+				mVisibleZ.push_back(mPositionZ[lightIndex]);
+			}
+		}
+	}
+}
+
+void LightManager::transformVisibleLights(const glm::mat4& view)
+{
+	uint32_t visibleCount = static_cast<uint32_t>(mVisibleIndices.size());
+	uint32_t storageCount = paddedCount(visibleCount);
+
+	mVisibleX.resize(storageCount, 0.0f);
+	mVisibleY.resize(storageCount, 0.0f);
+	mVisibleZ.resize(storageCount, 0.0f);
+
+	mVisibleLights.resize(visibleCount);
+
+	// View matrix elements broadcast to every lane (glm matrices are indexed [column][row])
+	__m128 rows[3][4];
+	for (int row = 0; row < 3; ++row)
+	{
+		for (int column = 0; column < 4; ++column)
+		{
+			rows[row][column] = _mm_set1_ps(view[column][row]);
+		}
+	}
+
+	for (uint32_t i = 0; i < visibleCount; i += LANE_COUNT)
+	{
+		__m128 x = _mm_loadu_ps(&mVisibleX[i]);
+		__m128 y = _mm_loadu_ps(&mVisibleY[i]);
+		__m128 z = _mm_loadu_ps(&mVisibleZ[i]);
+
+		alignas(16) float viewPosition[3][LANE_COUNT];
+		for (int row = 0; row < 3; ++row)
+		{
+			__m128 value = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(x, rows[row][0]), _mm_mul_ps(y, rows[row][1])),
+				_mm_add_ps(_mm_mul_ps(z, rows[row][2]), rows[row][3]));
+
+			_mm_store_ps(viewPosition[row], value);
+		}
+
+		uint32_t laneCount = std::min(LANE_COUNT, visibleCount - i);
+		for (uint32_t lane = 0; lane < laneCount; ++lane)
+		{
+			uint32_t lightIndex = mVisibleIndices[i + lane];
+
+			PointLight& light = mVisibleLights[i + lane];
+			light.colour = mColours[lightIndex];
+			light.position = glm::vec4(viewPosition[0][lane], viewPosition[1][lane], viewPosition[2][lane], 1.0f);
+			light.intensityAndAttenuation = glm::vec4(mIntensity[lightIndex], mKq[lightIndex], mKl[lightIndex], mKc[lightIndex]);
+		}
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "Common.h"
+
+#include "Light.h"
+
+// Holds point lights in structure of arrays form so they can be processed four at a time with SSE
+// Each update computes the distance at which every light's attenuated intensity falls to the cutoff, culls the
+// resulting spheres against the view frustum and transforms the survivors to view space in batches
+// The visible lights are written to a compacted list so off-screen lights are never uploaded
+// Lights are referenced by the index returned when they are added
+class LightManager
+{
+public:
+	LightManager() = default;
+	~LightManager() = default;
+
+	LightManager(const LightManager&) = delete;
+
+	// - Getters
+	uint32_t pointLightCount() const;
+	uint32_t visibleLightCount() const;
+	glm::vec3 position(uint32_t lightIndex) const;
+	// Lights which intersected the frustum in the last update, positions are in view space
+	const std::vector<PointLight>& visibleLights() const;
+
+	// - Setters
+	void setPosition(uint32_t lightIndex, const glm::vec3& position);
+	void setColour(uint32_t lightIndex, const glm::vec4& colour);	// Lights with a colour w of 0 are off
+	void setIntensityAndAttenuation(uint32_t lightIndex, const glm::vec4& intensityAndAttenuation);
+
+	// - Light Management
+	void reserve(uint32_t lightCount);
+	uint32_t addPointLight(const PointLight& light);	// Position is in world space
+	void clear();
+
+	// - Update
+	// Cull the lights against the camera frustum and rebuild the visible light list
+	void update(const glm::mat4& view, const glm::mat4& projection);
+
+private:
+	uint32_t mLightCount{ 0 };
+
+	// Arrays are padded to a multiple of the SSE width, padding lights are off
+	std::vector<float> mPositionX;
+	std::vector<float> mPositionY;
+	std::vector<float> mPositionZ;
+	std::vector<float> mIntensity;
+	std::vector<float> mKq;
+	std::vector<float> mKl;
+	std::vector<float> mKc;
+	std::vector<float> mEnabled;		// 1 if the colour's w is above 0
+	std::vector<float> mRadius;			// Recalculated each update
+	std::vector<glm::vec4> mColours;	// Only read for visible lights
+
+	// Visible lights
+	std::vector<uint32_t> mVisibleIndices;
+	std::vector<float> mVisibleX;		// World space positions of the visible lights, compacted while culling
+	std::vector<float> mVisibleY;
+	std::vector<float> mVisibleZ;
+	std::vector<PointLight> mVisibleLights;
+
+	// - Support
+	void calculateRadii();
+	void cullLights(const std::array<glm::vec4, 6>& planes);
+	void transformVisibleLights(const glm::mat4& view);
+};
@@ -12,6 +12,7 @@ Mesh::Mesh(Device& device,
 	mModel(glm::mat4(1.0f)),
 	mOpaque(opaque)
 {
+	calculateBounds(vertices);
 	createVertexBuffer(device, vertices);
 	createIndexBuffer(device, indices);
 }
@@ -32,6 +33,16 @@ uint32_t Mesh::materialID() const
 }
 
 
+const glm::vec3& Mesh::boundsCentre() const
+{
+	return mBoundsCentre;
+}
+
+float Mesh::boundsRadius() const
+{
+	return mBoundsRadius;
+}
+
 uint32_t Mesh::vertexCount() const
 {
 	return mVertexCount;
@@ -123,3 +134,32 @@ void Mesh::copyBuffer(Device& device, Buffer& srcBuffer, Buffer& dstBuffer)
 
 	device.endAndSubmitTemporaryCommandBuffer(*commandBuffer);
 }
+
+// Sphere centred on the axis aligned bounding box which encloses every vertex
+void Mesh::calculateBounds(std::vector<Vertex>* vertices)
+{
+	if (vertices->empty())
+	{
+		return;
+	}
+
+	glm::vec3 minimum = (*vertices)[0].position;
+	glm::vec3 maximum = (*vertices)[0].position;
+
+	for (const auto& vertex : *vertices)
+	{
+		minimum = glm::min(minimum, vertex.position);
+		maximum = glm::max(maximum, vertex.position);
+	}
+
+	mBoundsCentre = (minimum + maximum) * 0.5f;
+
+	float radiusSquared = 0.0f;
+	for (const auto& vertex : *vertices)
+	{
+		glm::vec3 offset = vertex.position - mBoundsCentre;
+		radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+	}
+
+	mBoundsRadius = std::sqrt(radiusSquared);
+}
@@ -36,6 +36,10 @@ public:
 
 	bool opaque() const;	// Indicates whether the associated materials are opaque
 
+	// Bounding sphere in model space
+	const glm::vec3& boundsCentre() const;
+	float boundsRadius() const;
+
 private:
 	glm::mat4 mModel;
 
@@ -45,6 +49,10 @@ private:
 	// Material info
 	bool mOpaque;
 
+	// Bounds
+	glm::vec3 mBoundsCentre{ 0.0f };
+	float mBoundsRadius{ 0.0f };
+
 	// Vertex and index buffers
 	uint32_t mVertexCount;
 	std::unique_ptr<Buffer> mVertexBuffer;
@@ -52,6 +60,7 @@ private:
 	uint32_t mIndexCount;
 	std::unique_ptr<Buffer> mIndexBuffer;
 
+	void calculateBounds(std::vector<Vertex>* vertices);
 	void createVertexBuffer(Device& device, std::vector<Vertex>* vertices);
 	void createIndexBuffer(Device& device, std::vector<uint32_t>* indices);
 	void copyBuffer(Device& device, Buffer& srcBuffer, Buffer& dstBuffer);
@@ -6,13 +6,43 @@ PhysicalDevice::PhysicalDevice(VkPhysicalDevice handle) :
 	vkGetPhysicalDeviceFeatures(mHandle, &mFeatures);
 	vkGetPhysicalDeviceProperties(mHandle, &mProperties);
 	vkGetPhysicalDeviceMemoryProperties(mHandle, &mMemoryProperties);
+
+	// Vulkan 1.2 features can only be queried on devices which support 1.2
+	if (mProperties.apiVersion >= VK_API_VERSION_1_2)
+	{
+		// Extension feature structs may only be chained if the extension is present
+		VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features = {};
+		synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+		bool synchronization2Extension = checkDeviceExtensionSupport({ VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME });
+		mFeatures12.pNext = synchronization2Extension ? &synchronization2Features : nullptr;
+
+		VkPhysicalDeviceFeatures2 features2 = {};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features2.pNext = &mFeatures12;
+
+		vkGetPhysicalDeviceFeatures2(mHandle, &features2);
+
+		mSynchronization2Supported = synchronization2Extension && synchronization2Features.synchronization2;
+
+		VkPhysicalDeviceProperties2 properties2 = {};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &mProperties12;
+
+		vkGetPhysicalDeviceProperties2(mHandle, &properties2);
+	}
+
+	mFeatures12.pNext = nullptr;
+	mProperties12.pNext = nullptr;
 }
 
 PhysicalDevice::PhysicalDevice(PhysicalDevice&& other) :
 	mHandle(other.mHandle),
 	mFeatures(other.mFeatures),
+	mFeatures12(other.mFeatures12),
 	mProperties(other.mProperties),
-	mMemoryProperties(other.mMemoryProperties)
+	mProperties12(other.mProperties12),
+	mMemoryProperties(other.mMemoryProperties),
+	mSynchronization2Supported(other.mSynchronization2Supported)
 {
 	other.mHandle = VK_NULL_HANDLE;
 }
@@ -27,25 +57,42 @@ const VkPhysicalDeviceFeatures& PhysicalDevice::features() const
 	return mFeatures;
 }
 
+const VkPhysicalDeviceVulkan12Features& PhysicalDevice::features12() const
+{
+	return mFeatures12;
+}
+
 const VkPhysicalDeviceProperties& PhysicalDevice::properties() const
 {
 	return mProperties;
 }
 
+const VkPhysicalDeviceVulkan12Properties& PhysicalDevice::properties12() const
+{
+	return mProperties12;
+}
+
 const VkPhysicalDeviceMemoryProperties& PhysicalDevice::memoryProperties() const
 {
 	return mMemoryProperties;
 }
 
-VkBool32 PhysicalDevice::checkDeviceSuitable(const std::vector<const char*>& requiredExtensions, VkPhysicalDeviceFeatures& requiredFeatures, VkSurfaceKHR presentationSurface)
+bool PhysicalDevice::synchronization2Supported() const
+{
+	return mSynchronization2Supported;
+}
+
+VkBool32 PhysicalDevice::checkDeviceSuitable(const std::vector<const char*>& requiredExtensions, VkPhysicalDeviceFeatures& requiredFeatures,
+	const VkPhysicalDeviceVulkan12Features& requiredFeatures12, VkSurfaceKHR presentationSurface)
 {
 	uint32_t graphicsIndex = getQueueFamilyIndex(VK_QUEUE_GRAPHICS_BIT);
 
 	VkBool32 presentationSupported = checkQueueFamilyPresentationSupport(graphicsIndex, presentationSurface);
 	VkBool32 extensionsSupported = checkDeviceExtensionSupport(requiredExtensions);
 	VkBool32 featuresSupported = checkDeviceFeatureSupport(requiredFeatures);
+	VkBool32 features12Supported = checkDeviceFeature12Support(requiredFeatures12);
 
-	return presentationSupported && extensionsSupported && featuresSupported;
+	return presentationSupported && extensionsSupported && featuresSupported && features12Supported;
 }
 
 VkBool32 PhysicalDevice::checkQueueFamilyPresentationSupport(uint32_t queueFamilyIndex, VkSurfaceKHR surface)
@@ -155,3 +202,14 @@ VkBool32 PhysicalDevice::checkDeviceFeatureSupport(VkPhysicalDeviceFeatures& req
 
 	return VK_FALSE;
 }
+
+// Only features used by the renderer are compared
+VkBool32 PhysicalDevice::checkDeviceFeature12Support(const VkPhysicalDeviceVulkan12Features& requiredFeatures12)
+{
+	if (requiredFeatures12.timelineSemaphore && !mFeatures12.timelineSemaphore)
+	{
+		return VK_FALSE;
+	}
+
+	return VK_TRUE;
+}
\ No newline at end of file
@@ -12,11 +12,15 @@ public:
 	// - Getters
 	VkPhysicalDevice handle() const;
 	const VkPhysicalDeviceFeatures& features() const;
+	const VkPhysicalDeviceVulkan12Features& features12() const;
 	const VkPhysicalDeviceProperties& properties() const;
+	const VkPhysicalDeviceVulkan12Properties& properties12() const;
 	const VkPhysicalDeviceMemoryProperties& memoryProperties() const;
+	bool synchronization2Supported() const;		// VK_KHR_synchronization2 extension and feature
 
 	// - Query device
-	VkBool32 checkDeviceSuitable(const std::vector<const char*>& requiredExtensions, VkPhysicalDeviceFeatures& requiredFeatures, VkSurfaceKHR presentationSurface);
+	VkBool32 checkDeviceSuitable(const std::vector<const char*>& requiredExtensions, VkPhysicalDeviceFeatures& requiredFeatures,
+		const VkPhysicalDeviceVulkan12Features& requiredFeatures12, VkSurfaceKHR presentationSurface);
 	VkBool32 checkQueueFamilyPresentationSupport(uint32_t queueFamilyIndex, VkSurfaceKHR surface);
 	uint32_t getQueueFamilyIndex(VkQueueFlagBits queueFlag);
 	void getFormatProperties(VkFormat format, VkFormatProperties& formatProperties);
@@ -27,13 +31,20 @@ private:
 
 	VkPhysicalDeviceFeatures mFeatures;
 
+	VkPhysicalDeviceVulkan12Features mFeatures12{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+
 	VkPhysicalDeviceProperties mProperties;
 
+	VkPhysicalDeviceVulkan12Properties mProperties12{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES };
+
 	VkPhysicalDeviceMemoryProperties mMemoryProperties;
 
+	bool mSynchronization2Supported{ false };
+
 	//std::vector<VkQueueFamilyProperties> mQueueFamilyProperties;
 
 	VkBool32 checkDeviceExtensionSupport(const std::vector<const char*>& requiredExtensions);
 	VkBool32 checkDeviceFeatureSupport(VkPhysicalDeviceFeatures& requiredFeatures);
+	VkBool32 checkDeviceFeature12Support(const VkPhysicalDeviceVulkan12Features& requiredFeatures12);
 };
 
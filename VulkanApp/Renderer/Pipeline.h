@@ -3,9 +3,10 @@
 
 class Device;
 class PipelineLayout;
+class PipelineState;
 class RenderPass;
 class ShaderModule;
-class Swapchain;
+class SpecializationConstants;
 
 class Pipeline
 {
@@ -28,13 +29,24 @@ class GraphicsPipeline : public Pipeline
 public:
 	GraphicsPipeline(Device& device,
 		const std::vector<ShaderModule>& shaderModules,
-		const Swapchain& swapchain,
 		const PipelineLayout& pipelineLayout,
 		const RenderPass& renderPass,
 		uint32_t subpassIndex,
-		VkBool32 vertexInput,
-		VkBool32 depthWriteEnable);
+		const PipelineState& pipelineState,
+		const std::map<VkShaderStageFlagBits, SpecializationConstants>& specializationConstants = {});
 
 	virtual ~GraphicsPipeline() = default;
 
+};
+
+class ComputePipeline : public Pipeline
+{
+public:
+	ComputePipeline(Device& device,
+		const ShaderModule& shaderModule,
+		const PipelineLayout& pipelineLayout,
+		const SpecializationConstants& specializationConstants = {});
+
+	virtual ~ComputePipeline() = default;
+
 };
\ No newline at end of file
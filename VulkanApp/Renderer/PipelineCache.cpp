@@ -0,0 +1,124 @@
+#include "PipelineCache.h"
+
+#include <fstream>
+
+#include "Device.h"
+#include "PhysicalDevice.h"
+
+PipelineCache::PipelineCache(Device& device) :
+	mDevice(device)
+{
+	const VkPhysicalDeviceProperties& properties = mDevice.physicalDevice().properties();
+
+	mFileName = "pipeline_cache_" + std::to_string(properties.vendorID) + "_" + std::to_string(properties.deviceID) +
+		"_" + std::to_string(properties.driverVersion) + ".bin";
+
+	// Start with an empty cache if there is no valid data from a previous run
+	std::vector<char> cacheData = loadCacheData();
+	if (!validateHeader(cacheData))
+	{
+		cacheData.clear();
+	}
+
+	VkPipelineCacheCreateInfo cacheCreateInfo = {};
+	cacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	cacheCreateInfo.initialDataSize = cacheData.size();
+	cacheCreateInfo.pInitialData = cacheData.empty() ? nullptr : cacheData.data();
+
+	VkResult result = vkCreatePipelineCache(mDevice.logicalDevice(), &cacheCreateInfo, nullptr, &mHandle);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Pipeline Cache!");
+	}
+}
+
+PipelineCache::~PipelineCache()
+{
+	if (mHandle != VK_NULL_HANDLE)
+	{
+		save();
+
+		vkDestroyPipelineCache(mDevice.logicalDevice(), mHandle, nullptr);
+	}
+}
+
+VkPipelineCache PipelineCache::handle() const
+{
+	return mHandle;
+}
+
+const std::string& PipelineCache::fileName() const
+{
+	return mFileName;
+}
+
+// Write the cache contents to disk, returns false if the data could not be retrieved or written
+bool PipelineCache::save()
+{
+	size_t dataSize = 0;
+	if (vkGetPipelineCacheData(mDevice.logicalDevice(), mHandle, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0)
+	{
+		return false;
+	}
+
+	std::vector<char> cacheData(dataSize);
+	if (vkGetPipelineCacheData(mDevice.logicalDevice(), mHandle, &dataSize, cacheData.data()) != VK_SUCCESS)
+	{
+		return false;
+	}
+
+	std::ofstream file(mFileName, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	file.write(cacheData.data(), dataSize);
+
+	return file.good();
+}
+
+// Returns an empty vector if there is no cache file
+std::vector<char> PipelineCache::loadCacheData()
+{
+	std::ifstream file(mFileName, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+	{
+		return {};
+	}
+
+	size_t fileSize = static_cast<size_t>(file.tellg());
+	std::vector<char> cacheData(fileSize);
+
+	file.seekg(0);
+	file.read(cacheData.data(), fileSize);
+
+	if (!file)
+	{
+		return {};
+	}
+
+	return cacheData;
+}
+
+// Check the cache header matches this device and driver
+// See "Pipeline Cache Header" : https://www.khronos.org/registry/vulkan/specs/1.2-extensions/html/vkspec.html#pipelines-cache-header
+bool PipelineCache::validateHeader(const std::vector<char>& cacheData) const
+{
+	if (cacheData.size() < sizeof(VkPipelineCacheHeaderVersionOne))
+	{
+		return false;
+	}
+
+	VkPipelineCacheHeaderVersionOne header;
+	memcpy(&header, cacheData.data(), sizeof(VkPipelineCacheHeaderVersionOne));
+
+	const VkPhysicalDeviceProperties& properties = mDevice.physicalDevice().properties();
+
+	return header.headerSize >= sizeof(VkPipelineCacheHeaderVersionOne) &&
+		header.headerSize <= cacheData.size() &&
+		header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		header.vendorID == properties.vendorID &&
+		header.deviceID == properties.deviceID &&
+		memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
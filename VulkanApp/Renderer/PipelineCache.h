@@ -0,0 +1,37 @@
+#pragma once
+#include "Common.h"
+
+class Device;
+
+// Wraps a VkPipelineCache which persists between runs
+// The cache file is named by vendor ID, device ID and driver version and its header is validated against the device
+// (including the pipeline cache UUID) before use, so stale or foreign data is discarded rather than passed to the driver
+// The cache is written back when destroyed
+// VkPipelineCache is internally synchronised so a single cache can be used to create pipelines on multiple threads
+class PipelineCache
+{
+public:
+	PipelineCache(Device& device);
+	~PipelineCache();
+
+	PipelineCache(const PipelineCache&) = delete;
+
+	// - Getters
+	VkPipelineCache handle() const;
+	const std::string& fileName() const;
+
+	// - Management
+	bool save();
+
+private:
+	Device& mDevice;
+
+	VkPipelineCache mHandle{ VK_NULL_HANDLE };
+
+	std::string mFileName;
+
+	// - Support
+	std::vector<char> loadCacheData();
+	bool validateHeader(const std::vector<char>& cacheData) const;
+};
+
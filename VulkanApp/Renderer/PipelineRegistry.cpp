@@ -0,0 +1,133 @@
+#include "PipelineRegistry.h"
+
+#include "Device.h"
+#include "Pipeline.h"
+#include "PipelineLayout.h"
+#include "RenderPass.h"
+#include "Subpass.h"
+#include "Utilities.h"
+
+PipelineRegistry::PipelineRegistry(Device& device) :
+	mDevice(device)
+{
+}
+
+PipelineRegistry::~PipelineRegistry()
+{
+	mPipelines.clear();
+}
+
+uint32_t PipelineRegistry::pipelineCount() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	return static_cast<uint32_t>(mPipelines.size());
+}
+
+// Return the pipeline matching the request, creating it if no identical pipeline exists
+GraphicsPipeline& PipelineRegistry::request(const Subpass& subpass,
+	const PipelineLayout& pipelineLayout,
+	const RenderPass& renderPass,
+	uint32_t subpassIndex,
+	const PipelineState& pipelineState)
+{
+	PipelineKey key = {
+		subpass.vertexShaderSource(),
+		subpass.fragmentShaderSource(),
+		subpass.vertexSpecializationConstants(),
+		subpass.fragmentSpecializationConstants(),
+		pipelineLayout.handle(),
+		renderPass.handle(),
+		subpassIndex,
+		pipelineState };
+
+	size_t keyHash = hash(key);
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (GraphicsPipeline* pipeline = find(keyHash, key))
+		{
+			return *pipeline;
+		}
+	}
+
+	// Compile without holding the lock so unrelated pipelines are created in parallel
+	std::vector<ShaderModule> shaderModules;
+	shaderModules.reserve(2);
+	shaderModules.emplace_back(mDevice,
+		readFile(key.vertexShaderSource),
+		VK_SHADER_STAGE_VERTEX_BIT);
+
+	// Depth only subpasses have no fragment shader
+	if (!key.fragmentShaderSource.empty())
+	{
+		shaderModules.emplace_back(mDevice,
+			readFile(key.fragmentShaderSource),
+			VK_SHADER_STAGE_FRAGMENT_BIT);
+	}
+
+	auto pipeline = std::make_unique<GraphicsPipeline>(mDevice,
+		shaderModules,
+		pipelineLayout,
+		renderPass,
+		subpassIndex,
+		pipelineState,
+		std::map<VkShaderStageFlagBits, SpecializationConstants>{
+			{ VK_SHADER_STAGE_VERTEX_BIT, key.vertexSpecializationConstants },
+			{ VK_SHADER_STAGE_FRAGMENT_BIT, key.fragmentSpecializationConstants } });
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	// Another thread may have created the same pipeline in the meantime, keep the first one
+	if (GraphicsPipeline* existingPipeline = find(keyHash, key))
+	{
+		return *existingPipeline;
+	}
+
+	auto& registeredPipeline = mPipelines.emplace(keyHash, RegisteredPipeline{ std::move(key), std::move(pipeline) })->second;
+
+	return *registeredPipeline.pipeline;
+}
+
+size_t PipelineRegistry::hash(const PipelineKey& key) const
+{
+	size_t seed = 0;
+
+	hashCombine(seed, key.vertexShaderSource);
+	hashCombine(seed, key.fragmentShaderSource);
+	hashCombine(seed, key.vertexSpecializationConstants.hash());
+	hashCombine(seed, key.fragmentSpecializationConstants.hash());
+	hashCombine(seed, key.pipelineLayout);
+	hashCombine(seed, key.renderPass);
+	hashCombine(seed, key.subpassIndex);
+	hashCombine(seed, key.pipelineState.hash());
+
+	return seed;
+}
+
+// Must be called with the mutex held
+GraphicsPipeline* PipelineRegistry::find(size_t hash, const PipelineKey& key)
+{
+	auto range = mPipelines.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second.key == key)
+		{
+			return it->second.pipeline.get();
+		}
+	}
+
+	return nullptr;
+}
+
+bool PipelineRegistry::PipelineKey::operator==(const PipelineKey& other) const
+{
+	return vertexShaderSource == other.vertexShaderSource &&
+		fragmentShaderSource == other.fragmentShaderSource &&
+		vertexSpecializationConstants == other.vertexSpecializationConstants &&
+		fragmentSpecializationConstants == other.fragmentSpecializationConstants &&
+		pipelineLayout == other.pipelineLayout &&
+		renderPass == other.renderPass &&
+		subpassIndex == other.subpassIndex &&
+		pipelineState == other.pipelineState;
+}
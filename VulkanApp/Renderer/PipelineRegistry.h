@@ -0,0 +1,62 @@
+#pragma once
+#include "Common.h"
+
+#include "PipelineState.h"
+#include "ShaderModule.h"
+
+class Device;
+class GraphicsPipeline;
+class PipelineLayout;
+class RenderPass;
+class Subpass;
+
+// Owns graphics pipelines and returns the existing pipeline when an identical one is requested
+// Pipelines are keyed by their shaders, specialization constants, layout, render pass/subpass and pipeline state
+// Viewport and scissor are dynamic so pipelines are independent of the swapchain extent
+// Thread safe so pipelines can be requested from jobs, compilation happens outside the lock
+class PipelineRegistry
+{
+public:
+	PipelineRegistry(Device& device);
+	~PipelineRegistry();
+
+	PipelineRegistry(const PipelineRegistry&) = delete;
+
+	// - Getters
+	uint32_t pipelineCount() const;
+
+	// - Registry Management
+	GraphicsPipeline& request(const Subpass& subpass,
+		const PipelineLayout& pipelineLayout,
+		const RenderPass& renderPass,
+		uint32_t subpassIndex,
+		const PipelineState& pipelineState);
+
+private:
+	Device& mDevice;
+
+	struct PipelineKey {
+		std::string vertexShaderSource;
+		std::string fragmentShaderSource;
+		SpecializationConstants vertexSpecializationConstants;
+		SpecializationConstants fragmentSpecializationConstants;
+		VkPipelineLayout pipelineLayout;
+		VkRenderPass renderPass;
+		uint32_t subpassIndex;
+		PipelineState pipelineState;
+
+		bool operator==(const PipelineKey& other) const;
+	};
+
+	struct RegisteredPipeline {
+		PipelineKey key;					// Compared on lookup in case of hash collisions
+		std::unique_ptr<GraphicsPipeline> pipeline;
+	};
+
+	std::unordered_multimap<size_t, RegisteredPipeline> mPipelines;
+	mutable std::mutex mMutex;
+
+	// - Support
+	size_t hash(const PipelineKey& key) const;
+	GraphicsPipeline* find(size_t hash, const PipelineKey& key);
+};
@@ -0,0 +1,292 @@
+#include "PipelineState.h"
+
+#include "Mesh.h"
+
+ColourBlendAttachmentState ColourBlendAttachmentState::alphaBlend()
+{
+	ColourBlendAttachmentState state;
+	state.blendEnable = VK_TRUE;
+	state.srcColourBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	state.dstColourBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+	return state;
+}
+
+const VertexInputState& PipelineState::vertexInputState() const
+{
+	return mVertexInputState;
+}
+
+const InputAssemblyState& PipelineState::inputAssemblyState() const
+{
+	return mInputAssemblyState;
+}
+
+const RasterizationState& PipelineState::rasterizationState() const
+{
+	return mRasterizationState;
+}
+
+const DepthStencilState& PipelineState::depthStencilState() const
+{
+	return mDepthStencilState;
+}
+
+const std::vector<ColourBlendAttachmentState>& PipelineState::colourBlendAttachmentStates() const
+{
+	return mColourBlendAttachmentStates;
+}
+
+const std::vector<VkDynamicState>& PipelineState::dynamicStates() const
+{
+	return mDynamicStates;
+}
+
+void PipelineState::setVertexInputState(const VertexInputState& vertexInputState)
+{
+	mVertexInputState = vertexInputState;
+}
+
+void PipelineState::setInputAssemblyState(const InputAssemblyState& inputAssemblyState)
+{
+	mInputAssemblyState = inputAssemblyState;
+}
+
+void PipelineState::setRasterizationState(const RasterizationState& rasterizationState)
+{
+	mRasterizationState = rasterizationState;
+}
+
+void PipelineState::setDepthStencilState(const DepthStencilState& depthStencilState)
+{
+	mDepthStencilState = depthStencilState;
+}
+
+void PipelineState::setColourBlendAttachmentStates(const std::vector<ColourBlendAttachmentState>& colourBlendAttachmentStates)
+{
+	mColourBlendAttachmentStates = colourBlendAttachmentStates;
+}
+
+void PipelineState::setColourBlendAttachmentState(uint32_t attachment, const ColourBlendAttachmentState& colourBlendAttachmentState)
+{
+	if (attachment >= mColourBlendAttachmentStates.size())
+	{
+		mColourBlendAttachmentStates.resize(attachment + 1);
+	}
+
+	mColourBlendAttachmentStates[attachment] = colourBlendAttachmentState;
+}
+
+void PipelineState::setDynamicStates(const std::vector<VkDynamicState>& dynamicStates)
+{
+	mDynamicStates = dynamicStates;
+}
+
+VertexInputState PipelineState::meshVertexInputState()
+{
+	VertexInputState vertexInputState;
+
+	// How the data for a single vertex is laid out as a whole
+	VkVertexInputBindingDescription bindingDescription = {};
+	bindingDescription.binding = 0;								// Can bind multiple streams of data, this defines which one
+	bindingDescription.stride = sizeof(Vertex);					// Size of a single vertex object
+	bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;	// How to move between data after each vertex
+
+	vertexInputState.bindings = { bindingDescription };
+
+	// How the data for an attribute is defined within a vertex { location, binding, format, offset }
+	vertexInputState.attributes = {
+		{ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position) },
+		{ 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal) },
+		{ 2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, tangent) },
+		{ 3, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, bitangent) },
+		{ 4, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv) } };
+
+	return vertexInputState;
+}
+
+PipelineState PipelineState::fullscreen()
+{
+	PipelineState pipelineState;
+
+	// Vertices are generated in clockwise order in the vertex shader
+	RasterizationState rasterizationState;
+	rasterizationState.frontFace = VK_FRONT_FACE_CLOCKWISE;
+	pipelineState.setRasterizationState(rasterizationState);
+
+	// Every pixel is written once so depth is neither tested nor written
+	DepthStencilState depthStencilState;
+	depthStencilState.depthTestEnable = VK_FALSE;
+	depthStencilState.depthWriteEnable = VK_FALSE;
+	pipelineState.setDepthStencilState(depthStencilState);
+
+	return pipelineState;
+}
+
+namespace {
+	void hashStencilOpState(size_t& seed, const VkStencilOpState& state)
+	{
+		hashCombine(seed, state.failOp);
+		hashCombine(seed, state.passOp);
+		hashCombine(seed, state.depthFailOp);
+		hashCombine(seed, state.compareOp);
+		hashCombine(seed, state.compareMask);
+		hashCombine(seed, state.writeMask);
+		hashCombine(seed, state.reference);
+	}
+
+	bool equalStencilOpState(const VkStencilOpState& a, const VkStencilOpState& b)
+	{
+		return a.failOp == b.failOp &&
+			a.passOp == b.passOp &&
+			a.depthFailOp == b.depthFailOp &&
+			a.compareOp == b.compareOp &&
+			a.compareMask == b.compareMask &&
+			a.writeMask == b.writeMask &&
+			a.reference == b.reference;
+	}
+
+	bool equalColourBlendAttachmentState(const ColourBlendAttachmentState& a, const ColourBlendAttachmentState& b)
+	{
+		return a.blendEnable == b.blendEnable &&
+			a.srcColourBlendFactor == b.srcColourBlendFactor &&
+			a.dstColourBlendFactor == b.dstColourBlendFactor &&
+			a.colourBlendOp == b.colourBlendOp &&
+			a.srcAlphaBlendFactor == b.srcAlphaBlendFactor &&
+			a.dstAlphaBlendFactor == b.dstAlphaBlendFactor &&
+			a.alphaBlendOp == b.alphaBlendOp &&
+			a.colourWriteMask == b.colourWriteMask;
+	}
+}
+
+size_t PipelineState::hash() const
+{
+	size_t seed = 0;
+
+	// Vertex input
+	for (auto& binding : mVertexInputState.bindings)
+	{
+		hashCombine(seed, binding.binding);
+		hashCombine(seed, binding.stride);
+		hashCombine(seed, binding.inputRate);
+	}
+	for (auto& attribute : mVertexInputState.attributes)
+	{
+		hashCombine(seed, attribute.location);
+		hashCombine(seed, attribute.binding);
+		hashCombine(seed, attribute.format);
+		hashCombine(seed, attribute.offset);
+	}
+
+	// Input assembly
+	hashCombine(seed, mInputAssemblyState.topology);
+	hashCombine(seed, mInputAssemblyState.primitiveRestartEnable);
+
+	// Rasterization
+	hashCombine(seed, mRasterizationState.polygonMode);
+	hashCombine(seed, mRasterizationState.cullMode);
+	hashCombine(seed, mRasterizationState.frontFace);
+	hashCombine(seed, mRasterizationState.depthBiasEnable);
+
+	// Depth stencil
+	hashCombine(seed, mDepthStencilState.depthTestEnable);
+	hashCombine(seed, mDepthStencilState.depthWriteEnable);
+	hashCombine(seed, mDepthStencilState.depthCompareOp);
+	hashCombine(seed, mDepthStencilState.stencilTestEnable);
+	hashStencilOpState(seed, mDepthStencilState.front);
+	hashStencilOpState(seed, mDepthStencilState.back);
+
+	// Blending
+	for (auto& attachment : mColourBlendAttachmentStates)
+	{
+		hashCombine(seed, attachment.blendEnable);
+		hashCombine(seed, attachment.srcColourBlendFactor);
+		hashCombine(seed, attachment.dstColourBlendFactor);
+		hashCombine(seed, attachment.colourBlendOp);
+		hashCombine(seed, attachment.srcAlphaBlendFactor);
+		hashCombine(seed, attachment.dstAlphaBlendFactor);
+		hashCombine(seed, attachment.alphaBlendOp);
+		hashCombine(seed, attachment.colourWriteMask);
+	}
+
+	// Dynamic states
+	for (auto& dynamicState : mDynamicStates)
+	{
+		hashCombine(seed, dynamicState);
+	}
+
+	return seed;
+}
+
+bool PipelineState::operator==(const PipelineState& other) const
+{
+	// Vertex input
+	if (mVertexInputState.bindings.size() != other.mVertexInputState.bindings.size() ||
+		mVertexInputState.attributes.size() != other.mVertexInputState.attributes.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < mVertexInputState.bindings.size(); ++i)
+	{
+		auto& a = mVertexInputState.bindings[i];
+		auto& b = other.mVertexInputState.bindings[i];
+		if (a.binding != b.binding || a.stride != b.stride || a.inputRate != b.inputRate)
+		{
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < mVertexInputState.attributes.size(); ++i)
+	{
+		auto& a = mVertexInputState.attributes[i];
+		auto& b = other.mVertexInputState.attributes[i];
+		if (a.location != b.location || a.binding != b.binding || a.format != b.format || a.offset != b.offset)
+		{
+			return false;
+		}
+	}
+
+	// Input assembly and rasterization
+	if (mInputAssemblyState.topology != other.mInputAssemblyState.topology ||
+		mInputAssemblyState.primitiveRestartEnable != other.mInputAssemblyState.primitiveRestartEnable ||
+		mRasterizationState.polygonMode != other.mRasterizationState.polygonMode ||
+		mRasterizationState.cullMode != other.mRasterizationState.cullMode ||
+		mRasterizationState.frontFace != other.mRasterizationState.frontFace ||
+		mRasterizationState.depthBiasEnable != other.mRasterizationState.depthBiasEnable)
+	{
+		return false;
+	}
+
+	// Depth stencil
+	if (mDepthStencilState.depthTestEnable != other.mDepthStencilState.depthTestEnable ||
+		mDepthStencilState.depthWriteEnable != other.mDepthStencilState.depthWriteEnable ||
+		mDepthStencilState.depthCompareOp != other.mDepthStencilState.depthCompareOp ||
+		mDepthStencilState.stencilTestEnable != other.mDepthStencilState.stencilTestEnable ||
+		!equalStencilOpState(mDepthStencilState.front, other.mDepthStencilState.front) ||
+		!equalStencilOpState(mDepthStencilState.back, other.mDepthStencilState.back))
+	{
+		return false;
+	}
+
+	// Blending
+	if (mColourBlendAttachmentStates.size() != other.mColourBlendAttachmentStates.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < mColourBlendAttachmentStates.size(); ++i)
+	{
+		if (!equalColourBlendAttachmentState(mColourBlendAttachmentStates[i], other.mColourBlendAttachmentStates[i]))
+		{
+			return false;
+		}
+	}
+
+	return mDynamicStates == other.mDynamicStates;
+}
+
+bool PipelineState::operator!=(const PipelineState& other) const
+{
+	return !(*this == other);
+}
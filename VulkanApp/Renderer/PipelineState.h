@@ -0,0 +1,92 @@
+#pragma once
+#include "Common.h"
+
+// Fixed function state used to create a graphics pipeline
+// Defaults describe an opaque, back face culled, depth tested draw with no vertex input
+
+struct VertexInputState {
+	std::vector<VkVertexInputBindingDescription> bindings;
+	std::vector<VkVertexInputAttributeDescription> attributes;
+};
+
+struct InputAssemblyState {
+	VkPrimitiveTopology topology{ VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST };
+	VkBool32 primitiveRestartEnable{ VK_FALSE };
+};
+
+struct RasterizationState {
+	VkPolygonMode polygonMode{ VK_POLYGON_MODE_FILL };
+	VkCullModeFlags cullMode{ VK_CULL_MODE_BACK_BIT };
+	VkFrontFace frontFace{ VK_FRONT_FACE_COUNTER_CLOCKWISE };
+	VkBool32 depthBiasEnable{ VK_FALSE };
+};
+
+struct ColourBlendAttachmentState {
+	VkBool32 blendEnable{ VK_FALSE };
+	VkBlendFactor srcColourBlendFactor{ VK_BLEND_FACTOR_ONE };
+	VkBlendFactor dstColourBlendFactor{ VK_BLEND_FACTOR_ZERO };
+	VkBlendOp colourBlendOp{ VK_BLEND_OP_ADD };
+	VkBlendFactor srcAlphaBlendFactor{ VK_BLEND_FACTOR_ONE };
+	VkBlendFactor dstAlphaBlendFactor{ VK_BLEND_FACTOR_ZERO };
+	VkBlendOp alphaBlendOp{ VK_BLEND_OP_ADD };
+	VkColorComponentFlags colourWriteMask{ VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT };
+
+	// (src alpha * new colour) + ((1 - src alpha) * old colour)
+	static ColourBlendAttachmentState alphaBlend();
+};
+
+struct DepthStencilState {
+	VkBool32 depthTestEnable{ VK_TRUE };
+	VkBool32 depthWriteEnable{ VK_TRUE };
+	VkCompareOp depthCompareOp{ VK_COMPARE_OP_LESS };
+	VkBool32 stencilTestEnable{ VK_FALSE };
+	VkStencilOpState front{};
+	VkStencilOpState back{};
+};
+
+// Full description of a pipeline's fixed function state
+// Hashable and comparable so identical states can share a pipeline (see PipelineRegistry)
+class PipelineState
+{
+public:
+	PipelineState() = default;
+	~PipelineState() = default;
+
+	// - Getters
+	const VertexInputState& vertexInputState() const;
+	const InputAssemblyState& inputAssemblyState() const;
+	const RasterizationState& rasterizationState() const;
+	const DepthStencilState& depthStencilState() const;
+	const std::vector<ColourBlendAttachmentState>& colourBlendAttachmentStates() const;
+	const std::vector<VkDynamicState>& dynamicStates() const;
+
+	// - Setters
+	void setVertexInputState(const VertexInputState& vertexInputState);
+	void setInputAssemblyState(const InputAssemblyState& inputAssemblyState);
+	void setRasterizationState(const RasterizationState& rasterizationState);
+	void setDepthStencilState(const DepthStencilState& depthStencilState);
+	// Colour attachments without a state use the default (blending off, all components written)
+	void setColourBlendAttachmentStates(const std::vector<ColourBlendAttachmentState>& colourBlendAttachmentStates);
+	void setColourBlendAttachmentState(uint32_t attachment, const ColourBlendAttachmentState& colourBlendAttachmentState);
+	// Viewport and scissor are always dynamic, only additional states need to be given
+	void setDynamicStates(const std::vector<VkDynamicState>& dynamicStates);
+
+	// - Presets
+	// Vertex layout of Mesh vertices (position, normal, tangent, bitangent, uv)
+	static VertexInputState meshVertexInputState();
+	// Fullscreen triangle generated from vertex indices: no vertex input, clockwise winding and no depth testing
+	static PipelineState fullscreen();
+
+	size_t hash() const;
+
+	bool operator==(const PipelineState& other) const;
+	bool operator!=(const PipelineState& other) const;
+
+private:
+	VertexInputState mVertexInputState;
+	InputAssemblyState mInputAssemblyState;
+	RasterizationState mRasterizationState;
+	DepthStencilState mDepthStencilState;
+	std::vector<ColourBlendAttachmentState> mColourBlendAttachmentStates;
+	std::vector<VkDynamicState> mDynamicStates;
+};
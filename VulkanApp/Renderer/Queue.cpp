@@ -3,11 +3,20 @@
 #include "CommandBuffer.h"
 #include "Device.h"
 #include "Swapchain.h"
+#include "TimelineSemaphore.h"
 
 Queue::Queue(Device& device, uint32_t familyIndex, uint32_t index, VkQueueFamilyProperties properties, VkBool32 presentationSupport) :
     mDevice(device), mFamilyIndex(familyIndex), mIndex(index), mProperties(properties), mPresentationSupport(presentationSupport)
 {
     vkGetDeviceQueue(device.logicalDevice(), familyIndex, index, &mHandle);
+
+    mTimeline = std::make_unique<TimelineSemaphore>(device);
+}
+
+Queue::Queue(Queue&&) = default;
+
+Queue::~Queue()
+{
 }
 
 const Device& Queue::device() const
@@ -40,46 +49,91 @@ const VkQueueFamilyProperties& Queue::properties() const
     return mProperties;
 }
 
-// Submit a command buffer (no semaphores)
-void Queue::submit(const CommandBuffer& commandBuffer, VkFence fence) const 
+TimelineSemaphore& Queue::timeline() const
 {
+    return *mTimeline;
+}
+
+// Submit a command buffer (no binary semaphores)
+// Returns the timeline value which will be signalled once the command buffer completes
+uint64_t Queue::submit(const CommandBuffer& commandBuffer) const 
+{
+	VkSemaphore timelineSemaphore = mTimeline->handle();
+	uint64_t signalValue = mTimeline->nextSignalValue();
+
+	VkTimelineSemaphoreSubmitInfo timelineSubmitInfo = {};
+	timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineSubmitInfo.signalSemaphoreValueCount = 1;
+	timelineSubmitInfo.pSignalSemaphoreValues = &signalValue;
+
 	// Queue submission information
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.pNext = &timelineSubmitInfo;
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &commandBuffer.handle();
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &timelineSemaphore;
 
 	// submit command buffer to queue
-    VkResult result = vkQueueSubmit(mHandle, 1, &submitInfo, fence);
+    VkResult result = vkQueueSubmit(mHandle, 1, &submitInfo, VK_NULL_HANDLE);
 	if (result != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to submit Command Buffer to Queue!");
 	}
+
+	return signalValue;
 }
 
-// Submit a command buffer (with semaphores)
-void Queue::submit(VkSemaphore waitSemaphore, VkPipelineStageFlags waitStage, VkSemaphore signalSemaphore,const CommandBuffer& commandBuffer, VkFence fence) const
+// Submit a command buffer (with binary semaphores for swapchain acquire/present)
+// Returns the timeline value which will be signalled once the command buffer completes
+uint64_t Queue::submit(VkSemaphore waitSemaphore, VkPipelineStageFlags waitStage, VkSemaphore signalSemaphore, const CommandBuffer& commandBuffer) const
 {
+	// Binary semaphore is signalled alongside the queue's timeline semaphore
+	std::array<VkSemaphore, 2> signalSemaphores = { signalSemaphore, mTimeline->handle() };
+	uint64_t signalValue = mTimeline->nextSignalValue();
+
+	// Values for binary semaphores are ignored
+	uint64_t waitValue = 0;
+	std::array<uint64_t, 2> signalValues = { 0, signalValue };
+
+	VkTimelineSemaphoreSubmitInfo timelineSubmitInfo = {};
+	timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineSubmitInfo.waitSemaphoreValueCount = 1;
+	timelineSubmitInfo.pWaitSemaphoreValues = &waitValue;
+	timelineSubmitInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+	timelineSubmitInfo.pSignalSemaphoreValues = signalValues.data();
+
 	// Queue submission information
 	VkSubmitInfo submitInfo = {};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.pNext = &timelineSubmitInfo;
 	submitInfo.waitSemaphoreCount = 1;												// Number of semaphores to wait on
 	submitInfo.pWaitSemaphores = &waitSemaphore;									// Stages to check semaphores at
 	submitInfo.pWaitDstStageMask = &waitStage;
 	submitInfo.commandBufferCount = 1;												// Number of command buffers to submit
 	submitInfo.pCommandBuffers = &commandBuffer.handle();							// Command buffer to submit
-	submitInfo.signalSemaphoreCount = 1;											// Number of semaphores to signal
-	submitInfo.pSignalSemaphores = &signalSemaphore;								// Semaphore to signal when the command buffer finishes
+	submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());	// Number of semaphores to signal
+	submitInfo.pSignalSemaphores = signalSemaphores.data();							// Semaphores to signal when the command buffer finishes
 
 	// submit command buffer to queue
-	VkResult result = vkQueueSubmit(mHandle, 1, &submitInfo, fence);
+	VkResult result = vkQueueSubmit(mHandle, 1, &submitInfo, VK_NULL_HANDLE);
 	if (result != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to submit Command Buffer to Queue!");
 	}
+
+	return signalValue;
 }
 
-void Queue::present(VkSemaphore waitSemaphore, const Swapchain& swapchain, uint32_t imageIndex) const
+// Wait on the host for a submission to this queue to complete
+VkResult Queue::wait(uint64_t value, uint64_t timeout) const
+{
+	return mTimeline->wait(value, timeout);
+}
+
+// Returns VK_SUBOPTIMAL_KHR or VK_ERROR_OUT_OF_DATE_KHR if the swapchain no longer matches the surface so it can be recreated
+VkResult Queue::present(VkSemaphore waitSemaphore, const Swapchain& swapchain, uint32_t imageIndex) const
 {
 	VkSwapchainKHR swapchainHandle = swapchain.handle();
 
@@ -94,9 +148,11 @@ void Queue::present(VkSemaphore waitSemaphore, const Swapchain& swapchain, uint3
 
 	// Present image
 	VkResult result = vkQueuePresentKHR(mHandle, &presentInfo);
-	if (result != VK_SUCCESS)
+	if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR && result != VK_ERROR_OUT_OF_DATE_KHR)
 	{
 		throw std::runtime_error("Failed to present Swapchain Image!");
 	}
+
+	return result;
 }
 
@@ -4,12 +4,18 @@
 class CommandBuffer;
 class Device;
 class Swapchain;
+class TimelineSemaphore;
 
+// Each queue owns a timeline semaphore which is signalled with an increasing value on every submission
+// Submissions return the value they will signal so that the host can wait on that specific submission
 class Queue
 {
 public:
 	Queue(Device& device, uint32_t familyIndex, uint32_t index, VkQueueFamilyProperties properties, VkBool32 presentationSupport);
-	~Queue() = default;
+	~Queue();
+
+	Queue(const Queue&) = delete;
+	Queue(Queue&&);
 
 	// - Getters
 	const Device& device() const;
@@ -18,13 +24,15 @@ public:
 	uint32_t index() const;
 	VkBool32 presentationSupport() const;
 	const VkQueueFamilyProperties& properties() const;
+	TimelineSemaphore& timeline() const;
 
 	// - Management
-	void submit(const CommandBuffer& commandBuffer, VkFence fence = VK_NULL_HANDLE) const;
-	void submit(VkSemaphore waitSemaphore, VkPipelineStageFlags waitStage, VkSemaphore signalSemaphore,
-		const CommandBuffer& commandBuffer, VkFence fence = VK_NULL_HANDLE) const;
+	uint64_t submit(const CommandBuffer& commandBuffer) const;
+	uint64_t submit(VkSemaphore waitSemaphore, VkPipelineStageFlags waitStage, VkSemaphore signalSemaphore,
+		const CommandBuffer& commandBuffer) const;
+	VkResult wait(uint64_t value, uint64_t timeout = std::numeric_limits<uint64_t>::max()) const;
 
-	void present(VkSemaphore waitSemaphore, const Swapchain& swapchain, uint32_t imageIndex) const;
+	VkResult present(VkSemaphore waitSemaphore, const Swapchain& swapchain, uint32_t imageIndex) const;
 private:
 	Device& mDevice;
 
@@ -37,5 +45,8 @@ private:
 	VkBool32 mPresentationSupport;
 
 	VkQueueFamilyProperties mProperties;
+
+	// - Synchronisation
+	std::unique_ptr<TimelineSemaphore> mTimeline;
 };
 
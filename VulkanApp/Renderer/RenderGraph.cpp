@@ -0,0 +1,599 @@
+#include "RenderGraph.h"
+
+#include "Device.h"
+#include "DeviceMemory.h"
+#include "Image.h"
+#include "Subpass.h"
+
+namespace {
+	// How a single subpass accesses an attachment
+	struct AttachmentAccess {
+		VkPipelineStageFlags stageMask{ 0 };
+		VkAccessFlags accessMask{ 0 };
+		bool sampled{ false };		// Read at other pixels so dependencies cannot be framebuffer local
+
+		bool used() const { return stageMask != 0; }
+	};
+
+	// Dependencies between the same pair of subpasses are merged into one
+	using DependencyMap = std::map<std::pair<uint32_t, uint32_t>, VkSubpassDependency>;
+
+	void addDependency(DependencyMap& dependencies,
+		uint32_t srcSubpass, VkPipelineStageFlags srcStageMask, VkAccessFlags srcAccessMask,
+		uint32_t dstSubpass, VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask,
+		bool byRegion)
+	{
+		auto it = dependencies.find({ srcSubpass, dstSubpass });
+		if (it == dependencies.end())
+		{
+			VkSubpassDependency dependency = {};
+			dependency.srcSubpass = srcSubpass;
+			dependency.dstSubpass = dstSubpass;
+			dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+			it = dependencies.emplace(std::make_pair(srcSubpass, dstSubpass), dependency).first;
+		}
+
+		auto& dependency = it->second;
+		dependency.srcStageMask |= srcStageMask;
+		dependency.srcAccessMask |= srcAccessMask;
+		dependency.dstStageMask |= dstStageMask;
+		dependency.dstAccessMask |= dstAccessMask;
+
+		// A single access that is not framebuffer local makes the whole dependency global
+		if (!byRegion)
+		{
+			dependency.dependencyFlags &= ~VK_DEPENDENCY_BY_REGION_BIT;
+		}
+	}
+}
+
+RenderGraph::RenderGraph(Device& device) :
+	mDevice(device)
+{
+	mLazilyAllocatedMemorySupported = DeviceMemory::hasMemoryType(mDevice, UINT32_MAX, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+}
+
+uint32_t RenderGraph::attachmentCount() const
+{
+	return static_cast<uint32_t>(mResources.size());
+}
+
+const std::vector<Attachment>& RenderGraph::attachments() const
+{
+	return mAttachments;
+}
+
+const std::vector<SubpassInfo>& RenderGraph::subpassInfos() const
+{
+	return mSubpassInfos;
+}
+
+const std::vector<LoadStoreInfo>& RenderGraph::loadStoreInfos() const
+{
+	return mLoadStoreInfos;
+}
+
+const std::vector<VkSubpassDependency>& RenderGraph::subpassDependencies() const
+{
+	return mSubpassDependencies;
+}
+
+const std::vector<VkClearValue>& RenderGraph::clearValues() const
+{
+	return mClearValues;
+}
+
+bool RenderGraph::transient(uint32_t attachmentIndex) const
+{
+	return mResources[attachmentIndex].transient;
+}
+
+uint32_t RenderGraph::aliasGroup(uint32_t attachmentIndex) const
+{
+	return mResources[attachmentIndex].aliasGroup;
+}
+
+void RenderGraph::setClearValue(uint32_t attachmentIndex, const VkClearValue& clearValue)
+{
+	mClearValues[attachmentIndex] = clearValue;
+}
+
+uint32_t RenderGraph::addSwapchainAttachment(VkFormat format)
+{
+	if (!mResources.empty())
+	{
+		throw std::runtime_error("Swapchain must be the first render graph attachment!");
+	}
+
+	return addResource(format, true);
+}
+
+uint32_t RenderGraph::addAttachment(VkFormat format)
+{
+	if (mResources.empty())
+	{
+		throw std::runtime_error("Swapchain must be added to the render graph before other attachments!");
+	}
+
+	return addResource(format, false);
+}
+
+uint32_t RenderGraph::addLoadedAttachment(VkFormat format, VkImageLayout layout, VkImageUsageFlags usage)
+{
+	uint32_t attachmentIndex = addAttachment(format);
+
+	auto& resource = mResources[attachmentIndex];
+	resource.loaded = true;
+	resource.loadedLayout = layout;
+	resource.loadedUsage = usage;
+
+	return attachmentIndex;
+}
+
+void RenderGraph::compile(const std::vector<std::unique_ptr<Subpass>>& subpasses, uint32_t firstSubpass)
+{
+	if (firstSubpass >= subpasses.size())
+	{
+		throw std::runtime_error("Render graph must contain at least one subpass!");
+	}
+
+	uint32_t subpassCount = static_cast<uint32_t>(subpasses.size()) - firstSubpass;
+	uint32_t attachmentCount = static_cast<uint32_t>(mResources.size());
+
+	// FIND HOW EACH SUBPASS ACCESSES EACH ATTACHMENT
+	// First index refers to the subpass, second index refers to the attachment
+	std::vector<std::vector<AttachmentAccess>> reads(subpassCount, std::vector<AttachmentAccess>(attachmentCount));
+	std::vector<std::vector<AttachmentAccess>> writes(subpassCount, std::vector<AttachmentAccess>(attachmentCount));
+
+	mSubpassInfos.clear();
+
+	for (auto& resource : mResources)
+	{
+		resource.usage = resource.loadedUsage;
+		resource.firstSubpass = UINT32_MAX;
+		resource.lastSubpass = 0;
+	}
+
+	for (uint32_t i = 0; i < subpassCount; ++i)
+	{
+		auto& subpass = *subpasses[firstSubpass + i];
+		auto inputAttachments = subpass.inputAttachments();
+		auto outputAttachments = subpass.outputAttachments();
+
+		for (uint32_t sampledAttachment : subpass.sampledAttachments())
+		{
+			if (std::find(inputAttachments.begin(), inputAttachments.end(), sampledAttachment) == inputAttachments.end())
+			{
+				throw std::runtime_error("Sampled attachments must also be subpass inputs!");
+			}
+		}
+
+		for (uint32_t inputAttachment : inputAttachments)
+		{
+			auto& sampled = subpass.sampledAttachments();
+			auto& read = reads[i][inputAttachment];
+
+			read.stageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			read.sampled = std::find(sampled.begin(), sampled.end(), inputAttachment) != sampled.end();
+			read.accessMask = read.sampled ? VK_ACCESS_SHADER_READ_BIT : VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+
+			// Every input is referenced as an input attachment by the render pass
+			mResources[inputAttachment].usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+			if (read.sampled)
+			{
+				mResources[inputAttachment].usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+			}
+		}
+
+		for (uint32_t outputAttachment : outputAttachments)
+		{
+			auto& write = writes[i][outputAttachment];
+
+			if (isDepthStencilFormat(mResources[outputAttachment].format))
+			{
+				write.stageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+				write.accessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+				mResources[outputAttachment].usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+			}
+			else
+			{
+				write.stageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+				write.accessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+				mResources[outputAttachment].usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+			}
+		}
+
+		for (uint32_t attachment = 0; attachment < attachmentCount; ++attachment)
+		{
+			if (reads[i][attachment].used() || writes[i][attachment].used())
+			{
+				auto& resource = mResources[attachment];
+				resource.firstSubpass = std::min(resource.firstSubpass, i);
+				resource.lastSubpass = std::max(resource.lastSubpass, i);
+			}
+		}
+
+		mSubpassInfos.push_back({ inputAttachments, outputAttachments });
+	}
+
+	// LOAD/STORE OPS + TRANSIENT ATTACHMENTS
+	mLoadStoreInfos.clear();
+
+	for (uint32_t attachment = 0; attachment < attachmentCount; ++attachment)
+	{
+		auto& resource = mResources[attachment];
+
+		if (resource.firstSubpass == UINT32_MAX)
+		{
+			throw std::runtime_error("Render graph attachment is not used by any subpass!");
+		}
+
+		if (!resource.loaded && !writes[resource.firstSubpass][attachment].used())
+		{
+			throw std::runtime_error("Render graph attachment is read before it is written!");
+		}
+
+		// Only loaded attachments are loaded, others are cleared unless the first writer overwrites every pixel
+		// Only external attachments are needed after the render pass
+		LoadStoreInfo loadStoreInfo;
+		if (resource.loaded)
+		{
+			loadStoreInfo.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		}
+		else
+		{
+			loadStoreInfo.loadOp = subpasses[firstSubpass + resource.firstSubpass]->coversFramebuffer() ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : VK_ATTACHMENT_LOAD_OP_CLEAR;
+		}
+		loadStoreInfo.storeOp = resource.external ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		mLoadStoreInfos.push_back(loadStoreInfo);
+
+		// Attachments which are only written and subpass loaded can stay in tile memory
+		resource.transient = !resource.external && !resource.loaded && !(resource.usage & VK_IMAGE_USAGE_SAMPLED_BIT);
+		if (resource.transient)
+		{
+			resource.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		}
+	}
+
+	// MEMORY ALIASING
+	// Attachments whose lifetimes (first to last subpass used) do not overlap can share memory
+	// Lazily allocated attachments take no memory so are not aliased, loaded attachments are in use before the render pass
+	std::vector<uint32_t> aliasOrder;
+	for (uint32_t attachment = 1; attachment < attachmentCount; ++attachment)
+	{
+		aliasOrder.push_back(attachment);
+	}
+
+	std::stable_sort(aliasOrder.begin(), aliasOrder.end(), [&](uint32_t a, uint32_t b) {
+		return mResources[a].firstSubpass < mResources[b].firstSubpass;
+		});
+
+	// Last attachment placed in each group that other attachments may alias
+	std::vector<uint32_t> groupTails;
+	std::vector<bool> groupAliasable;
+
+	DependencyMap dependencies;
+
+	mResources[0].aliasGroup = 0;
+	mAliasGroupCount = 1;
+	groupTails.push_back(0);
+	groupAliasable.push_back(false);	// Swapchain memory is not owned by the render graph
+
+	for (uint32_t attachment : aliasOrder)
+	{
+		auto& resource = mResources[attachment];
+		bool aliasable = !resource.loaded && !(resource.transient && mLazilyAllocatedMemorySupported);
+
+		uint32_t group = mAliasGroupCount;
+		if (aliasable)
+		{
+			for (uint32_t i = 0; i < mAliasGroupCount; ++i)
+			{
+				if (groupAliasable[i] && mResources[groupTails[i]].lastSubpass < resource.firstSubpass)
+				{
+					group = i;
+					break;
+				}
+			}
+		}
+
+		if (group == mAliasGroupCount)
+		{
+			groupTails.push_back(attachment);
+			groupAliasable.push_back(aliasable);
+			++mAliasGroupCount;
+		}
+		else
+		{
+			// The new attachment must not be written until the previous attachment in this memory is finished with
+			uint32_t previous = groupTails[group];
+			auto& previousResource = mResources[previous];
+			auto& previousRead = reads[previousResource.lastSubpass][previous];
+			auto& previousWrite = writes[previousResource.lastSubpass][previous];
+			auto& firstWrite = writes[resource.firstSubpass][attachment];
+
+			addDependency(dependencies,
+				previousResource.lastSubpass, previousRead.stageMask | previousWrite.stageMask, previousWrite.accessMask,
+				resource.firstSubpass, firstWrite.stageMask, firstWrite.accessMask,
+				false);
+
+			groupTails[group] = attachment;
+		}
+
+		resource.aliasGroup = group;
+	}
+
+	// Stages and writes of every attachment sharing each alias group's memory
+	std::vector<VkPipelineStageFlags> groupStageMasks(mAliasGroupCount, 0);
+	std::vector<VkAccessFlags> groupAccessMasks(mAliasGroupCount, 0);
+	for (uint32_t attachment = 0; attachment < attachmentCount; ++attachment)
+	{
+		uint32_t group = mResources[attachment].aliasGroup;
+		for (uint32_t i = 0; i < subpassCount; ++i)
+		{
+			groupStageMasks[group] |= reads[i][attachment].stageMask | writes[i][attachment].stageMask;
+			groupAccessMasks[group] |= writes[i][attachment].accessMask;
+		}
+	}
+
+	// SUBPASS DEPENDENCIES
+	for (uint32_t attachment = 0; attachment < attachmentCount; ++attachment)
+	{
+		auto& resource = mResources[attachment];
+
+		uint32_t lastWriter = UINT32_MAX;
+		std::vector<uint32_t> readersSinceWrite;
+
+		for (uint32_t i = 0; i < subpassCount; ++i)
+		{
+			auto& read = reads[i][attachment];
+			auto& write = writes[i][attachment];
+
+			// Read after write
+			if (read.used() && lastWriter != UINT32_MAX && lastWriter != i)
+			{
+				auto& lastWrite = writes[lastWriter][attachment];
+				addDependency(dependencies,
+					lastWriter, lastWrite.stageMask, lastWrite.accessMask,
+					i, read.stageMask, read.accessMask,
+					!read.sampled);
+			}
+
+			if (write.used())
+			{
+				// Write after read, only an execution dependency is required
+				for (uint32_t reader : readersSinceWrite)
+				{
+					if (reader != i)
+					{
+						auto& previousRead = reads[reader][attachment];
+						addDependency(dependencies,
+							reader, previousRead.stageMask, 0,
+							i, write.stageMask, write.accessMask,
+							!previousRead.sampled);
+					}
+				}
+
+				// Write after write
+				if (lastWriter != UINT32_MAX && lastWriter != i)
+				{
+					auto& lastWrite = writes[lastWriter][attachment];
+					addDependency(dependencies,
+						lastWriter, lastWrite.stageMask, lastWrite.accessMask,
+						i, write.stageMask, write.accessMask,
+						true);
+				}
+
+				lastWriter = i;
+				readersSinceWrite.clear();
+			}
+
+			if (read.used())
+			{
+				readersSinceWrite.push_back(i);
+			}
+		}
+
+		// External dependencies
+		auto& firstWrite = writes[resource.firstSubpass][attachment];
+		if (resource.loaded)
+		{
+			// Written as an attachment before the render pass and possibly read by shaders since, the first access here may be a read
+			auto& firstRead = reads[resource.firstSubpass][attachment];
+			addDependency(dependencies,
+				VK_SUBPASS_EXTERNAL,
+				VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+				resource.firstSubpass, firstRead.stageMask | firstWrite.stageMask, firstRead.accessMask | firstWrite.accessMask,
+				false);
+		}
+		else if (resource.external)
+		{
+			// Wait for the presentation engine to release the image, the acquire semaphore is waited on at colour output
+			addDependency(dependencies,
+				VK_SUBPASS_EXTERNAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0,
+				resource.firstSubpass, firstWrite.stageMask, firstWrite.accessMask,
+				false);
+
+			// Make the final write available for presentation
+			auto& lastWrite = writes[lastWriter][attachment];
+			addDependency(dependencies,
+				lastWriter, lastWrite.stageMask, lastWrite.accessMask,
+				VK_SUBPASS_EXTERNAL, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+				false);
+		}
+		else
+		{
+			// The same memory is used by earlier submissions of this render pass (see createRenderTarget)
+			addDependency(dependencies,
+				VK_SUBPASS_EXTERNAL, groupStageMasks[resource.aliasGroup], groupAccessMasks[resource.aliasGroup],
+				resource.firstSubpass, firstWrite.stageMask, firstWrite.accessMask,
+				false);
+		}
+	}
+
+	mSubpassDependencies.clear();
+	for (auto& dependency : dependencies)
+	{
+		mSubpassDependencies.push_back(dependency.second);
+	}
+
+	// RENDER PASS ATTACHMENTS
+	std::vector<uint32_t> groupSizes(mAliasGroupCount, 0);
+	for (auto& resource : mResources)
+	{
+		++groupSizes[resource.aliasGroup];
+	}
+
+	mAttachments.clear();
+	for (auto& resource : mResources)
+	{
+		Attachment attachment(resource.format, VK_SAMPLE_COUNT_1_BIT, resource.usage);
+		attachment.initialLayout = resource.loadedLayout;
+		if (groupSizes[resource.aliasGroup] > 1)
+		{
+			attachment.flags = VK_ATTACHMENT_DESCRIPTION_MAY_ALIAS_BIT;
+		}
+
+		mAttachments.push_back(attachment);
+	}
+
+	// Memory shared between render targets depends on the alias groups
+	mSharedMemory.clear();
+
+	mCompiled = true;
+}
+
+std::unique_ptr<RenderTarget> RenderGraph::createRenderTarget(Image&& swapchainImage)
+{
+	if (!mCompiled)
+	{
+		throw std::runtime_error("Render graph must be compiled before creating a render target!");
+	}
+
+	VkExtent2D extent = { swapchainImage.extent().width, swapchainImage.extent().height };
+
+	std::vector<Image> images;
+	images.reserve(mResources.size());
+	images.push_back(std::move(swapchainImage));
+
+	// Memory is bound below so none is allocated on creation
+	for (size_t i = 1; i < mResources.size(); ++i)
+	{
+		images.emplace_back(mDevice,
+			extent,
+			mResources[i].format,
+			mResources[i].usage,
+			0);
+	}
+
+	// ALLOCATE MEMORY
+	// One allocation per alias group large enough for every image in the group
+	// No attachment other than the swapchain outlives the render pass so every render target binds the same allocation,
+	// the external dependency into the render pass orders each submission's use of it
+	// Groups of transient attachments instead get their own lazily allocated memory where supported,
+	// this may have no physical backing on tile based GPUs
+	if (mSharedMemory.size() != mAliasGroupCount ||
+		mSharedMemoryExtent.width != extent.width || mSharedMemoryExtent.height != extent.height)
+	{
+		mSharedMemory.assign(mAliasGroupCount, nullptr);
+		mSharedMemoryExtent = extent;
+	}
+
+	for (uint32_t group = 1; group < mAliasGroupCount; ++group)
+	{
+		std::vector<uint32_t> members;
+		for (uint32_t i = 1; i < static_cast<uint32_t>(mResources.size()); ++i)
+		{
+			if (mResources[i].aliasGroup == group)
+			{
+				members.push_back(i);
+			}
+		}
+
+		VkMemoryRequirements memoryRequirements = {};
+		memoryRequirements.memoryTypeBits = UINT32_MAX;
+		bool transient = true;
+
+		for (uint32_t member : members)
+		{
+			VkMemoryRequirements imageMemoryRequirements = images[member].memoryRequirements();
+			memoryRequirements.size = std::max(memoryRequirements.size, imageMemoryRequirements.size);
+			memoryRequirements.alignment = std::max(memoryRequirements.alignment, imageMemoryRequirements.alignment);
+			memoryRequirements.memoryTypeBits &= imageMemoryRequirements.memoryTypeBits;
+			transient = transient && mResources[member].transient;
+		}
+
+		// Images which cannot share a memory type are given their own memory, MAY_ALIAS on their attachments is then harmless
+		if (memoryRequirements.memoryTypeBits == 0)
+		{
+			for (uint32_t member : members)
+			{
+				VkMemoryRequirements imageMemoryRequirements = images[member].memoryRequirements();
+				images[member].bindMemory(std::make_shared<DeviceMemory>(mDevice, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, imageMemoryRequirements));
+			}
+			continue;
+		}
+
+		std::shared_ptr<DeviceMemory> memory;
+		VkMemoryPropertyFlags lazyProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+		if (transient && DeviceMemory::hasMemoryType(mDevice, memoryRequirements.memoryTypeBits, lazyProperties))
+		{
+			memory = std::make_shared<DeviceMemory>(mDevice, lazyProperties, memoryRequirements);
+		}
+		else
+		{
+			if (!mSharedMemory[group])
+			{
+				mSharedMemory[group] = std::make_shared<DeviceMemory>(mDevice, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, memoryRequirements);
+			}
+			memory = mSharedMemory[group];
+		}
+
+		for (uint32_t member : members)
+		{
+			images[member].bindMemory(memory);
+		}
+	}
+
+	return std::make_unique<RenderTarget>(std::move(images));
+}
+
+std::unique_ptr<RenderPass> RenderGraph::createRenderPass() const
+{
+	if (!mCompiled)
+	{
+		throw std::runtime_error("Render graph must be compiled before creating a render pass!");
+	}
+
+	return std::make_unique<RenderPass>(mDevice,
+		mAttachments,
+		mSubpassInfos,
+		mLoadStoreInfos,
+		mSubpassDependencies);
+}
+
+uint32_t RenderGraph::addResource(VkFormat format, bool external)
+{
+	AttachmentResource resource;
+	resource.format = format;
+	resource.external = external;
+	mResources.push_back(resource);
+
+	VkClearValue clearValue = {};
+	if (isDepthStencilFormat(format))
+	{
+		clearValue.depthStencil = { 1.0f, 0 };
+	}
+	else
+	{
+		clearValue.color = { 0.0f, 0.0f, 0.0f, 1.0f };
+	}
+	mClearValues.push_back(clearValue);
+
+	mCompiled = false;
+
+	return static_cast<uint32_t>(mResources.size() - 1);
+}
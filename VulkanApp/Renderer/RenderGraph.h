@@ -0,0 +1,90 @@
+#pragma once
+#include "Common.h"
+
+#include "RenderPass.h"
+#include "RenderTarget.h"
+
+class Device;
+class DeviceMemory;
+class Image;
+class Subpass;
+
+// Describes the attachments of a render pass, the subpasses describe how each attachment is read and written
+// From this the image usage, load/store ops, subpass dependencies, transient attachments and memory aliasing are derived
+// Attachments are added in attachment index order, the swapchain must be attachment 0
+class RenderGraph
+{
+public:
+	RenderGraph(Device& device);
+	~RenderGraph() = default;
+
+	RenderGraph(const RenderGraph&) = delete;
+
+	// - Getters
+	uint32_t attachmentCount() const;
+	const std::vector<Attachment>& attachments() const;
+	const std::vector<SubpassInfo>& subpassInfos() const;
+	const std::vector<LoadStoreInfo>& loadStoreInfos() const;
+	const std::vector<VkSubpassDependency>& subpassDependencies() const;
+	const std::vector<VkClearValue>& clearValues() const;
+	bool transient(uint32_t attachmentIndex) const;			// Never leaves tile memory, lazily allocated if supported
+	uint32_t aliasGroup(uint32_t attachmentIndex) const;	// Attachments in the same group share memory
+
+	// - Setters
+	void setClearValue(uint32_t attachmentIndex, const VkClearValue& clearValue);
+
+	// - Graph Building
+	// Returns the attachment index, depth formats are cleared to 1.0 and colour formats to opaque black
+	uint32_t addSwapchainAttachment(VkFormat format);
+	uint32_t addAttachment(VkFormat format);
+	// An attachment written before the render pass (e.g. by an earlier render pass into this render target's image)
+	// Its contents are loaded in the given layout, usage is how the image is accessed outside of this render pass
+	uint32_t addLoadedAttachment(VkFormat format, VkImageLayout layout, VkImageUsageFlags usage);
+
+	// Subpasses must be given in execution order and have their input, sampled and output attachments set
+	// Subpasses before firstSubpass are recorded in other render passes so are not part of this graph
+	void compile(const std::vector<std::unique_ptr<Subpass>>& subpasses, uint32_t firstSubpass = 0);
+
+	// - Resource Creation
+	// Create the images for every attachment other than the swapchain and bind their memory
+	// Memory is shared by every render target created with the same extent
+	std::unique_ptr<RenderTarget> createRenderTarget(Image&& swapchainImage);
+	std::unique_ptr<RenderPass> createRenderPass() const;
+
+private:
+	Device& mDevice;
+
+	bool mLazilyAllocatedMemorySupported{ false };
+	bool mCompiled{ false };
+
+	// Attachment state derived on compile
+	struct AttachmentResource {
+		VkFormat format;
+		VkImageUsageFlags usage{ 0 };
+		bool external{ false };				// Contents are used after the render pass (e.g. presented)
+		bool loaded{ false };				// Contents are written before the render pass
+		VkImageLayout loadedLayout{ VK_IMAGE_LAYOUT_UNDEFINED };
+		VkImageUsageFlags loadedUsage{ 0 };
+		bool transient{ false };
+		uint32_t firstSubpass{ UINT32_MAX };
+		uint32_t lastSubpass{ 0 };
+		uint32_t aliasGroup{ 0 };
+	};
+
+	std::vector<AttachmentResource> mResources;
+	std::vector<VkClearValue> mClearValues;
+	uint32_t mAliasGroupCount{ 0 };
+
+	// Memory for each alias group bound by every render target, recreated if the extent changes
+	std::vector<std::shared_ptr<DeviceMemory>> mSharedMemory;
+	VkExtent2D mSharedMemoryExtent{ 0, 0 };
+
+	// Render pass parameters
+	std::vector<Attachment> mAttachments;
+	std::vector<SubpassInfo> mSubpassInfos;
+	std::vector<LoadStoreInfo> mLoadStoreInfos;
+	std::vector<VkSubpassDependency> mSubpassDependencies;
+
+	// - Support
+	uint32_t addResource(VkFormat format, bool external);
+};
@@ -6,7 +6,8 @@
 RenderPass::RenderPass(Device& device, 
 	const std::vector<Attachment>& attachments, 
 	const std::vector<SubpassInfo>& subpassInfos,
-	const std::vector<LoadStoreInfo>& loadStoreInfos) :
+	const std::vector<LoadStoreInfo>& loadStoreInfos,
+	const std::vector<VkSubpassDependency>& subpassDependencies) :
 	mDevice(device), mSubpassCount(subpassInfos.size())
 {
 	assert(attachments.size() == loadStoreInfos.size() && "A load store info must exist for each attachment!");
@@ -31,12 +32,19 @@ RenderPass::RenderPass(Device& device,
 	{
 		auto& subpassInfo = subpassInfos[i];
 
+		// A depth attachment which is also an input of the subpass can only be read so both references use the read only layout
+		auto readOnlyDepth = [&](uint32_t attachment) {
+			return isDepthStencilFormat(attachmentDescriptions[attachment].format) &&
+				std::find(subpassInfo.inputAttachments.begin(), subpassInfo.inputAttachments.end(), attachment) != subpassInfo.inputAttachments.end() &&
+				std::find(subpassInfo.outputAttachments.begin(), subpassInfo.outputAttachments.end(), attachment) != subpassInfo.outputAttachments.end();
+		};
+
 		// Create input attachment references
+		// Reference layouts only depend on how the subpass uses the attachment, an attachment's initial layout is only its layout on entry
 		for (uint32_t inputAttachment : subpassInfo.inputAttachments)
 		{
-			VkImageLayout defaultLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			VkImageLayout initialLayout = attachments[inputAttachment].initialLayout == VK_IMAGE_LAYOUT_UNDEFINED ? defaultLayout : attachments[inputAttachment].initialLayout;
-			inputAttachmentReferences[i].push_back({ inputAttachment, initialLayout });
+			VkImageLayout layout = readOnlyDepth(inputAttachment) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			inputAttachmentReferences[i].push_back({ inputAttachment, layout });
 		}
 
 		// Store input attachment count for this subpass
@@ -47,16 +55,16 @@ RenderPass::RenderPass(Device& device,
 		{
 			bool isDepth = isDepthStencilFormat(attachmentDescriptions[outputAttachment].format);
 
-			VkImageLayout defaultLayout = isDepth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-			VkImageLayout initialLayout = attachments[outputAttachment].initialLayout == VK_IMAGE_LAYOUT_UNDEFINED ? defaultLayout : attachments[outputAttachment].initialLayout;
+			VkImageLayout layout = !isDepth ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL :
+				readOnlyDepth(outputAttachment) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 			
 			if (isDepth)
 			{
-				depthStencilAttachmentReferences[i].push_back({ outputAttachment, initialLayout });
+				depthStencilAttachmentReferences[i].push_back({ outputAttachment, layout });
 			}
 			else
 			{
-				colourAttachmentReferences[i].push_back({ outputAttachment, initialLayout });
+				colourAttachmentReferences[i].push_back({ outputAttachment, layout });
 			}
 		}
 
@@ -88,9 +96,9 @@ RenderPass::RenderPass(Device& device,
 	}
 
 	// CREATE SUBPASS DEPENDENCIES
-	std::vector<VkSubpassDependency> subpassDependencies = {};
+	std::vector<VkSubpassDependency> defaultSubpassDependencies = {};
 
-	if (subpassInfos.size() > 1)	// Dependencies not required with only 1 subpass
+	if (subpassDependencies.empty() && subpassInfos.size() > 1)	// Dependencies not required with only 1 subpass
 	{
 		VkSubpassDependency subpassDependency = {};
 
@@ -109,7 +117,7 @@ RenderPass::RenderPass(Device& device,
 		// All dependencies should have the below dependency flags
 		subpassDependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;				// makes dependency framebuffer local
 
-		subpassDependencies.push_back(subpassDependency);
+		defaultSubpassDependencies.push_back(subpassDependency);
 
 		// Create intermediate dependencies (from one subpass to another)
 		for (uint32_t i = 0; i < static_cast<uint32_t>(subpassInfos.size() - 1); ++i)
@@ -123,7 +131,7 @@ RenderPass::RenderPass(Device& device,
 			subpassDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |			// Specifies read access to a color attachment
 				VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;										// Specifies write access to a colour, resolve or depth/stencil resolve attachment
 			
-			subpassDependencies.push_back(subpassDependency);
+			defaultSubpassDependencies.push_back(subpassDependency);
 		}
 
 		// Add dependency for final subpass with no output attachments
@@ -140,8 +148,10 @@ RenderPass::RenderPass(Device& device,
 		subpassDependency.dstStageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;			// TOP as dst refers to all stages in commands after vkCmdEndRenderPass
 		subpassDependency.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;				// Specifies all read access types
 
-		subpassDependencies.push_back(subpassDependency);
+		defaultSubpassDependencies.push_back(subpassDependency);
 	}
+
+	const std::vector<VkSubpassDependency>& dependencies = subpassDependencies.empty() ? defaultSubpassDependencies : subpassDependencies;
 	
 	// Create info for renderpass
 	VkRenderPassCreateInfo renderPassCreateInfo = {};
@@ -150,8 +160,8 @@ RenderPass::RenderPass(Device& device,
 	renderPassCreateInfo.pAttachments = attachmentDescriptions.data();
 	renderPassCreateInfo.subpassCount = static_cast<uint32_t>(subpassDescriptions.size());
 	renderPassCreateInfo.pSubpasses = subpassDescriptions.data();
-	renderPassCreateInfo.dependencyCount = static_cast<uint32_t>(subpassDependencies.size());
-	renderPassCreateInfo.pDependencies = subpassDependencies.data();
+	renderPassCreateInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+	renderPassCreateInfo.pDependencies = dependencies.data();
 
 	VkResult result = vkCreateRenderPass(mDevice.logicalDevice(), &renderPassCreateInfo, nullptr, &mHandle);
 	if (result != VK_SUCCESS)
@@ -204,12 +214,13 @@ void RenderPass::createAttachmentDescriptions(const std::vector<Attachment>& att
 	{
 		VkAttachmentDescription attachmentDescription = {};
 
+		attachmentDescription.flags = attachments[i].flags;
 		attachmentDescription.format = attachments[i].format;
 		attachmentDescription.samples = attachments[i].sampleCount;
 		attachmentDescription.initialLayout = attachments[i].initialLayout;
 
-		// Attachment 0 should always be the swapchain image
-		if (i == 0)
+		// Attachment 0 should always be the swapchain image unless the render pass only has depth (e.g. a depth prepass)
+		if (i == 0 && !isDepthStencilFormat(attachments[i].format))
 		{
 			attachmentDescription.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 		}
@@ -218,6 +229,12 @@ void RenderPass::createAttachmentDescriptions(const std::vector<Attachment>& att
 			attachmentDescription.finalLayout = isDepthStencilFormat(attachments[i].format) ?
 				VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 		}
+
+		// Attachments read after the render pass (e.g. sampled by a later render pass) are left in the layout they are read in
+		if (attachments[i].finalLayout != VK_IMAGE_LAYOUT_UNDEFINED)
+		{
+			attachmentDescription.finalLayout = attachments[i].finalLayout;
+		}
 		
 
 		attachmentDescription.loadOp = loadStoreInfos[i].loadOp;
@@ -24,10 +24,12 @@ struct LoadStoreInfo
 class RenderPass
 {
 public:
+	// If no subpass dependencies are given each subpass depends on the previous one
 	RenderPass(Device& device,
 		const std::vector<Attachment>& attachments,
 		const std::vector<SubpassInfo>& subpassInfos,
-		const std::vector<LoadStoreInfo>& loadStoreInfos);
+		const std::vector<LoadStoreInfo>& loadStoreInfos,
+		const std::vector<VkSubpassDependency>& subpassDependencies = {});
 
 	~RenderPass();
 
@@ -51,11 +51,21 @@ const std::vector<uint32_t>& RenderTarget::outputAttachments() const
 	return mOutputAttachments;
 }
 
+Image& RenderTarget::image(uint32_t attachmentIndex)
+{
+	return mImages[attachmentIndex];
+}
+
 void RenderTarget::setLayout(uint32_t attachmentIndex, VkImageLayout layout)
 {
 	mAttachments[attachmentIndex].initialLayout = layout;
 }
 
+void RenderTarget::setFlags(uint32_t attachmentIndex, VkAttachmentDescriptionFlags flags)
+{
+	mAttachments[attachmentIndex].flags = flags;
+}
+
 void RenderTarget::setInputAttachments(const std::vector<uint32_t>& inputAttachments)
 {
 	mInputAttachments = inputAttachments;
@@ -15,6 +15,10 @@ struct Attachment {
 
 	VkImageLayout initialLayout{ VK_IMAGE_LAYOUT_UNDEFINED };
 
+	VkImageLayout finalLayout{ VK_IMAGE_LAYOUT_UNDEFINED };		// Undefined uses the default (present for the swapchain, otherwise the attachment layout)
+
+	VkAttachmentDescriptionFlags flags{ 0 };	// e.g. VK_ATTACHMENT_DESCRIPTION_MAY_ALIAS_BIT if memory is shared with another attachment
+
 	Attachment() = default;
 	Attachment(VkFormat format, VkSampleCountFlagBits sampleCount, VkImageUsageFlags usage);
 };
@@ -35,9 +39,11 @@ public:
 
 	const std::vector<uint32_t>& inputAttachments() const;
 	const std::vector<uint32_t>& outputAttachments() const;
+	Image& image(uint32_t attachmentIndex);		// Used to record barriers for attachments read outside of the render pass
 
 	// - Setters
 	void setLayout(uint32_t attachmentIndex, VkImageLayout layout);
+	void setFlags(uint32_t attachmentIndex, VkAttachmentDescriptionFlags flags);
 
 	// Set target attachments for current subpass
 	void setInputAttachments(const std::vector<uint32_t>& inputAttachments = {});
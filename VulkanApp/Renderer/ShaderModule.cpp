@@ -45,3 +45,48 @@ VkShaderStageFlagBits ShaderModule::stageFlagBits() const
 {
 	return mStageFlagBits;
 }
+
+bool SpecializationConstants::empty() const
+{
+	return mValues.empty();
+}
+
+void SpecializationConstants::generateSpecializationInfo(VkSpecializationInfo& specializationInfo, std::vector<VkSpecializationMapEntry>& mapEntries, std::vector<uint32_t>& data) const
+{
+	mapEntries.clear();
+	data.clear();
+
+	for (auto& value : mValues)
+	{
+		VkSpecializationMapEntry mapEntry = {};
+		mapEntry.constantID = value.first;
+		mapEntry.offset = static_cast<uint32_t>(data.size() * sizeof(uint32_t));
+		mapEntry.size = sizeof(uint32_t);
+
+		mapEntries.push_back(mapEntry);
+		data.push_back(value.second);
+	}
+
+	specializationInfo = {};
+	specializationInfo.mapEntryCount = static_cast<uint32_t>(mapEntries.size());
+	specializationInfo.pMapEntries = mapEntries.data();
+	specializationInfo.dataSize = data.size() * sizeof(uint32_t);
+	specializationInfo.pData = data.data();
+}
+
+size_t SpecializationConstants::hash() const
+{
+	size_t seed = 0;
+	for (auto& value : mValues)
+	{
+		hashCombine(seed, value.first);
+		hashCombine(seed, value.second);
+	}
+
+	return seed;
+}
+
+bool SpecializationConstants::operator==(const SpecializationConstants& other) const
+{
+	return mValues == other.mValues;
+}
@@ -3,6 +3,57 @@
 
 class Device;
 
+// Specialization constant IDs (constant_id in shaders) shared by every shader
+enum SpecializationConstantID : uint32_t {
+	SPECIALIZATION_POINT_LIGHT_COUNT	= 0,
+	SPECIALIZATION_Z_NEAR				= 1,
+	SPECIALIZATION_Z_FAR				= 2,
+	SPECIALIZATION_SSAO_SAMPLE_COUNT	= 5,
+	SPECIALIZATION_CLUSTER_GRID_X		= 6,
+	SPECIALIZATION_CLUSTER_GRID_Y		= 7,
+	SPECIALIZATION_CLUSTER_GRID_Z		= 8,
+	SPECIALIZATION_MAX_LIGHTS_PER_CLUSTER	= 9,
+	SPECIALIZATION_CLUSTERED_LIGHTING	= 10,
+	SPECIALIZATION_SSAO_DOWNSAMPLE		= 11,
+	SPECIALIZATION_SSAO_BLUR_RADIUS		= 12,
+	SPECIALIZATION_SSAO_BLUR_VERTICAL	= 13,
+	SPECIALIZATION_GTAO_SLICE_COUNT		= 14,
+	SPECIALIZATION_GTAO_STEP_COUNT		= 15,
+};
+
+// Specialization constant values for one shader stage keyed by constant ID
+// Every value is 32 bits (int, uint, float or VkBool32) so values are stored as raw 32 bit data
+class SpecializationConstants
+{
+public:
+	SpecializationConstants() = default;
+	~SpecializationConstants() = default;
+
+	// - Getters
+	bool empty() const;
+
+	// - Setters
+	template<typename T>
+	void set(uint32_t constantID, T value)
+	{
+		static_assert(sizeof(T) == sizeof(uint32_t), "Specialization constants must be 32 bit values!");
+
+		uint32_t data;
+		memcpy(&data, &value, sizeof(uint32_t));
+		mValues[constantID] = data;
+	}
+
+	// Fill specialization info, map entries and data must outlive its use
+	void generateSpecializationInfo(VkSpecializationInfo& specializationInfo, std::vector<VkSpecializationMapEntry>& mapEntries, std::vector<uint32_t>& data) const;
+
+	size_t hash() const;
+
+	bool operator==(const SpecializationConstants& other) const;
+
+private:
+	std::map<uint32_t, uint32_t> mValues;
+};
+
 class ShaderModule
 {
 public:
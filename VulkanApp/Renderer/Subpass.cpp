@@ -27,6 +27,26 @@ const std::vector<uint32_t> Subpass::outputAttachments() const
 	return mOutputAttachments;
 }
 
+const SpecializationConstants& Subpass::vertexSpecializationConstants() const
+{
+	return mVertexSpecializationConstants;
+}
+
+const SpecializationConstants& Subpass::fragmentSpecializationConstants() const
+{
+	return mFragmentSpecializationConstants;
+}
+
+const std::vector<uint32_t>& Subpass::sampledAttachments() const
+{
+	return mSampledAttachments;
+}
+
+bool Subpass::coversFramebuffer() const
+{
+	return mCoversFramebuffer;
+}
+
 void Subpass::setInputAttachments(const std::vector<uint32_t>& inputAttachments)
 {
 	mInputAttachments = inputAttachments;
@@ -37,6 +57,26 @@ void Subpass::setOutputAttachments(const std::vector<uint32_t>& outputAttachment
 	mOutputAttachments = outputAttachments;
 }
 
+void Subpass::setSampledAttachments(const std::vector<uint32_t>& sampledAttachments)
+{
+	mSampledAttachments = sampledAttachments;
+}
+
+void Subpass::setCoversFramebuffer(bool coversFramebuffer)
+{
+	mCoversFramebuffer = coversFramebuffer;
+}
+
+void Subpass::setVertexSpecializationConstants(const SpecializationConstants& specializationConstants)
+{
+	mVertexSpecializationConstants = specializationConstants;
+}
+
+void Subpass::setFragmentSpecializationConstants(const SpecializationConstants& specializationConstants)
+{
+	mFragmentSpecializationConstants = specializationConstants;
+}
+
 void Subpass::updateRenderTargetAttachments(RenderTarget& renderTarget)
 {
 	renderTarget.setInputAttachments(mInputAttachments);
@@ -1,12 +1,15 @@
 #pragma once
 #include "Common.h"
 
+#include "ShaderModule.h"
+
 class RenderTarget;
 
 // Object which stores the indices of attachments used for a particular subpass
 class Subpass
 {
 public:
+	// Subpasses without a fragment shader (e.g. a depth prepass) only run the vertex stage
 	Subpass(std::string vertexShaderSource = {}, std::string fragmentShaderSource = {});
 	~Subpass() = default;
 
@@ -17,10 +20,20 @@ public:
 	const std::string& fragmentShaderSource() const;
 	const std::vector<uint32_t> inputAttachments() const;
 	const std::vector<uint32_t> outputAttachments() const;
+	const SpecializationConstants& vertexSpecializationConstants() const;
+	const SpecializationConstants& fragmentSpecializationConstants() const;
+	const std::vector<uint32_t>& sampledAttachments() const;
+	bool coversFramebuffer() const;
 
 	// - Setters
 	void setInputAttachments(const std::vector<uint32_t>& inputAttachments = {});
 	void setOutputAttachments(const std::vector<uint32_t>& outputAttachments = {});
+	// Inputs which are sampled rather than subpass loaded, these must also be set as inputs
+	void setSampledAttachments(const std::vector<uint32_t>& sampledAttachments = {});
+	// Set if every pixel of the outputs is written (e.g. fullscreen pass) so previous contents need not be loaded or cleared
+	void setCoversFramebuffer(bool coversFramebuffer);
+	void setVertexSpecializationConstants(const SpecializationConstants& specializationConstants);
+	void setFragmentSpecializationConstants(const SpecializationConstants& specializationConstants);
 
 	// Update render target with this subpass's attachment indices
 	void updateRenderTargetAttachments(RenderTarget& renderTarget);
@@ -30,10 +43,19 @@ private:
 	std::string mVertexShaderSource{};
 	std::string mFragmentShaderSource{};
 
+	// Constants used to specialise the shaders when the pipeline for this subpass is created
+	SpecializationConstants mVertexSpecializationConstants;
+	SpecializationConstants mFragmentSpecializationConstants;
+
 	// No input attachments by default
 	std::vector<uint32_t> mInputAttachments = {};
 
 	// Default output attachment is swapchain
 	std::vector<uint32_t> mOutputAttachments = { 0 };
+
+	// Sampled inputs may be read at any pixel so dependencies on them cannot be framebuffer local
+	std::vector<uint32_t> mSampledAttachments = {};
+
+	bool mCoversFramebuffer{ false };
 };
 
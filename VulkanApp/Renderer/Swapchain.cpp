@@ -8,7 +8,8 @@ Swapchain::Swapchain(Device& device,
 	const VkExtent2D& extent, 
 	VkSurfaceKHR surface,
 	VkPresentModeKHR presentMode,
-	VkImageUsageFlags usage) :
+	VkImageUsageFlags usage,
+	VkSwapchainKHR oldSwapchain) :
 	mDevice(device),
 	mSurface(surface)
 {
@@ -27,6 +28,9 @@ Swapchain::Swapchain(Device& device,
 	// 4. CHOOSE SWAP CHAIN IMAGE RESOLUTION
 	chooseExtent(surfaceSupport.surfaceCapabilities, extent);
 
+	// Ensure imageCount is at least the minimum required by the surface
+	mDetails.imageCount = std::max(mDetails.imageCount, surfaceSupport.surfaceCapabilities.minImageCount);
+
 	// If imageCount higher than max, then clamp down to max
 	// If 0 then limitless
 	if (surfaceSupport.surfaceCapabilities.maxImageCount > 0
@@ -53,7 +57,7 @@ Swapchain::Swapchain(Device& device,
 	swapChainCreateInfo.pQueueFamilyIndices = nullptr;
 
 	// If old swapchain been destroyed and this one replaces it, then link old one to quickly hand over responsibilities
-	swapChainCreateInfo.oldSwapchain = VK_NULL_HANDLE;
+	swapChainCreateInfo.oldSwapchain = oldSwapchain;
 
 	// Create Swapchain
 	VkResult result = vkCreateSwapchainKHR(mDevice.logicalDevice(), &swapChainCreateInfo, nullptr, &mHandle);
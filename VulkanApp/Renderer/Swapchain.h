@@ -26,12 +26,13 @@ class Swapchain
 {
 public:
 
-	// TODO: need to be able to recreate swapchain and change priorities before creation
+	// Pass the handle of the swapchain being replaced as oldSwapchain when recreating
 	Swapchain(Device& device, 
 		const VkExtent2D& newExtent, 
 		VkSurfaceKHR surface,
 		VkPresentModeKHR presentMode,
-		VkImageUsageFlags usage);
+		VkImageUsageFlags usage,
+		VkSwapchainKHR oldSwapchain = VK_NULL_HANDLE);
 	~Swapchain();
 
 	// - Getters
@@ -0,0 +1,62 @@
+#include "TaskGraph.h"
+
+TaskId TaskGraph::addTask(Job function, const std::vector<TaskId>& dependencies)
+{
+	TaskId id = static_cast<TaskId>(mNodes.size());
+
+	auto node = std::make_unique<Node>();
+	node->function = std::move(function);
+
+	for (TaskId dependency : dependencies)
+	{
+		if (dependency >= id)
+		{
+			throw std::runtime_error("Failed to add task, dependencies must be added to the task graph first!");
+		}
+
+		mNodes[dependency]->dependents.push_back(id);
+		++node->dependencyCount;
+	}
+
+	mNodes.push_back(std::move(node));
+
+	return id;
+}
+
+void TaskGraph::execute(JobSystem& jobSystem)
+{
+	JobCounter counter;
+
+	for (auto& node : mNodes)
+	{
+		node->remainingDependencies = node->dependencyCount;
+	}
+
+	// Submit root tasks, the remaining tasks are submitted as their dependencies complete
+	for (TaskId id = 0; id < mNodes.size(); ++id)
+	{
+		if (mNodes[id]->dependencyCount == 0)
+		{
+			schedule(jobSystem, counter, id);
+		}
+	}
+
+	jobSystem.wait(counter);
+}
+
+// Dependents are submitted from within the job so the counter cannot reach zero until the whole graph is complete
+void TaskGraph::schedule(JobSystem& jobSystem, JobCounter& counter, TaskId task)
+{
+	jobSystem.submit([this, &jobSystem, &counter, task](size_t threadIndex) {
+		Node& node = *mNodes[task];
+		node.function(threadIndex);
+
+		for (TaskId dependent : node.dependents)
+		{
+			if (mNodes[dependent]->remainingDependencies.fetch_sub(1) == 1)
+			{
+				schedule(jobSystem, counter, dependent);
+			}
+		}
+		}, counter);
+}
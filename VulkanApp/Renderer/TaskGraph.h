@@ -0,0 +1,34 @@
+#pragma once
+#include "Common.h"
+
+#include "JobSystem.h"
+
+using TaskId = uint32_t;
+
+// A set of jobs with dependencies between them, executed on a JobSystem
+// A task may only depend on tasks added before it so the graph is always acyclic
+// Once a task completes, any dependents with no remaining dependencies are submitted
+class TaskGraph
+{
+public:
+	TaskGraph() = default;
+	~TaskGraph() = default;
+
+	TaskId addTask(Job function, const std::vector<TaskId>& dependencies = {});
+
+	// Blocks until every task has completed. Rethrows the first exception thrown by a task
+	void execute(JobSystem& jobSystem);
+
+private:
+	struct Node {
+		Job function;
+		std::vector<TaskId> dependents;
+		uint32_t dependencyCount{ 0 };
+		std::atomic<uint32_t> remainingDependencies{ 0 };
+	};
+
+	std::vector<std::unique_ptr<Node>> mNodes;
+
+	void schedule(JobSystem& jobSystem, JobCounter& counter, TaskId task);
+};
+
@@ -1,5 +1,6 @@
 #include "Texture.h"
 
+#include "BarrierBatch.h"
 #include "Buffer.h"
 #include "CommandBuffer.h"
 #include "Device.h"
@@ -86,33 +87,32 @@ void Texture::createTextureImage(void* textureData,
 	
 	// COPY DATA TO IMAGE
 	// Transition image to DST for copy operation (setup image memory barriers)
+	// Every mip level is transitioned at once, the levels below the base become blit destinations
 	std::unique_ptr<CommandBuffer> commandBuffer = mDevice.createAndBeginTemporaryCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+	BarrierBatch barriers(mDevice);
 
-	commandBuffer->transitionImageLayout(mImage->handle(), 
-		VK_IMAGE_LAYOUT_UNDEFINED, 
-		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	barriers.transitionImage(*mImage,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR,
+		VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR);
+	barriers.flush(*commandBuffer);
 
 	// Copy image data
 	commandBuffer->copyBufferToImage(imageStagingBuffer, *mImage);
 
-	// Transition image to be TRANSFER_SRC so that mip blit operations can read from it
-	commandBuffer->transitionImageLayout(mImage->handle(),
-		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-
 	// Generate the mipmaps if supported
 	if (mipmapSupport)
 	{
-		generateMipmaps(mipLevels, width, height, *commandBuffer);
+		generateMipmaps(mipLevels, width, height, *commandBuffer, barriers);
 	}
 
-	// Mipmap levels are now in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL layout
-	// They must be transitioned to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-	commandBuffer->transitionImageLayout(mImage->handle(),
-		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	// Mip levels are left in TRANSFER_SRC (read by the next blit) or TRANSFER_DST (last level)
+	// Both are transitioned to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL in one barrier
+	barriers.transitionImage(*mImage,
 		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-		0,
-		mipLevels);
+		VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR,
+		VK_ACCESS_2_SHADER_READ_BIT_KHR);
+	barriers.flush(*commandBuffer);
 
 	mDevice.endAndSubmitTemporaryCommandBuffer(*commandBuffer);
 
@@ -135,7 +135,8 @@ bool Texture::checkMipmapGenerationSupport(VkFormat format)
 	}
 }
 // Generate mipmaps through blit operations
-void Texture::generateMipmaps(uint32_t mipLevels, uint32_t width, uint32_t height, CommandBuffer& commandBuffer)
+// Each level only needs the level above it made readable, the level itself is already a TRANSFER_DST
+void Texture::generateMipmaps(uint32_t mipLevels, uint32_t width, uint32_t height, CommandBuffer& commandBuffer, BarrierBatch& barriers)
 {
 
 	// For each level copy mipmap i-1 to mipmap i
@@ -165,11 +166,14 @@ void Texture::generateMipmaps(uint32_t mipLevels, uint32_t width, uint32_t heigh
 		imageBlit.dstOffsets[1].y = dstY;
 		imageBlit.dstOffsets[1].z = 1;
 
-		// Transition current mip level to TRANSFER_DST to prepare as the blit operation destination
-		commandBuffer.transitionImageLayout(mImage->handle(),
-			VK_IMAGE_LAYOUT_UNDEFINED,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			i);
+		// Transition previous mip level to TRANSFER_SRC once it has been written
+		barriers.transitionImage(*mImage,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR,
+			VK_ACCESS_2_TRANSFER_READ_BIT_KHR,
+			i - 1,
+			1);
+		barriers.flush(commandBuffer);
 
 		// Blit from mipmap level i-1 to i
 		commandBuffer.blitImage(*mImage,
@@ -177,13 +181,6 @@ void Texture::generateMipmaps(uint32_t mipLevels, uint32_t width, uint32_t heigh
 			*mImage,
 			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 			imageBlit);
-
-
-		// Transition current mip level to SRC layout to prepare for blit of next mip level
-		commandBuffer.transitionImageLayout(mImage->handle(),
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-			i);
 	}
 
 
@@ -1,6 +1,7 @@
 #pragma once
 #include "Common.h"
 
+class BarrierBatch;
 class CommandBuffer;
 class Device;
 class Image;
@@ -39,6 +40,6 @@ private:
 		VkFormat imageFormat);
 	// -- Support
 	bool checkMipmapGenerationSupport(VkFormat format);
-	void generateMipmaps(uint32_t mipLevels, uint32_t width, uint32_t height, CommandBuffer& commandBuffer);
+	void generateMipmaps(uint32_t mipLevels, uint32_t width, uint32_t height, CommandBuffer& commandBuffer, BarrierBatch& barriers);
 };
 
@@ -0,0 +1,54 @@
+#include "TimelineSemaphore.h"
+
+#include "Device.h"
+
+TimelineSemaphore::TimelineSemaphore(Device& device, uint64_t initialValue) :
+	mDevice(device), mPendingValue(initialValue)
+{
+	VkSemaphoreTypeCreateInfo typeCreateInfo = {};
+	typeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	typeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	typeCreateInfo.initialValue = initialValue;
+
+	VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreCreateInfo.pNext = &typeCreateInfo;
+
+	VkResult result = vkCreateSemaphore(mDevice.logicalDevice(), &semaphoreCreateInfo, nullptr, &mHandle);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Could not create a Timeline Semaphore!");
+	}
+}
+
+TimelineSemaphore::~TimelineSemaphore()
+{
+	if (mHandle != VK_NULL_HANDLE)
+	{
+		vkDestroySemaphore(mDevice.logicalDevice(), mHandle, nullptr);
+	}
+}
+
+VkSemaphore TimelineSemaphore::handle() const
+{
+	return mHandle;
+}
+
+// Reserve the next value to be signalled by a submission
+// Values must be signalled in increasing order, so submissions to the owning queue should be made in the order values are requested
+uint64_t TimelineSemaphore::nextSignalValue()
+{
+	return ++mPendingValue;
+}
+
+// Block the host until the device has signalled the given value
+VkResult TimelineSemaphore::wait(uint64_t value, uint64_t timeout) const
+{
+	VkSemaphoreWaitInfo waitInfo = {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &mHandle;
+	waitInfo.pValues = &value;
+
+	return vkWaitSemaphores(mDevice.logicalDevice(), &waitInfo, timeout);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <atomic>
+
+#include "Common.h"
+
+class Device;
+
+// Wrapper for a Vulkan 1.2 timeline semaphore
+// The semaphore holds a monotonically increasing counter which is signalled by queue submissions
+// The host can wait for the counter to reach a specific value rather than waiting on fences
+class TimelineSemaphore
+{
+public:
+	TimelineSemaphore(Device& device, uint64_t initialValue = 0);
+	TimelineSemaphore() = delete;
+	~TimelineSemaphore();
+
+	TimelineSemaphore(const TimelineSemaphore&) = delete;
+	TimelineSemaphore(TimelineSemaphore&&) = delete;
+
+	// - Getters
+	VkSemaphore handle() const;
+
+	// - Management
+	uint64_t nextSignalValue();
+	VkResult wait(uint64_t value, uint64_t timeout = std::numeric_limits<uint64_t>::max()) const;
+
+private:
+	Device& mDevice;
+
+	VkSemaphore mHandle{ VK_NULL_HANDLE };
+
+	std::atomic<uint64_t> mPendingValue{ 0 };
+};
+
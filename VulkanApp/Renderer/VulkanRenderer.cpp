@@ -6,7 +6,7 @@ int VulkanRenderer::init(GLFWwindow* newWindow)
 	mWindow = newWindow;
 
 	try {
-		setupThreadPool();
+		setupJobSystem();
 
 		createInstance();				
 		createSurface();				
@@ -15,7 +15,9 @@ int VulkanRenderer::init(GLFWwindow* newWindow)
 
 		chooseImageFormats();
 		createSwapchain();				
-		createRenderTargetAndFrames();
+		createRenderGraph();
+		createRenderTargets();
+		createFrames();
 		createRenderPass();	
 
 		createPerFrameDescriptorSetLayouts();
@@ -34,8 +36,8 @@ int VulkanRenderer::init(GLFWwindow* newWindow)
 		createPerFrameDescriptorSets();
 		createCamera(90.0f);
 
-		
-
+		// Pipelines compile in the background during the above, every pipeline is needed by the first frame
+		waitForPipelines();
 	}
 	catch (const std::runtime_error& e) {
 		std::cout << "ERROR: " << e.what() << std::endl;
@@ -45,6 +47,156 @@ int VulkanRenderer::init(GLFWwindow* newWindow)
 	return EXIT_SUCCESS;
 }
 
+// Call before input is sampled for the next frame
+// The CPU frame limiter is applied here and, if requested, the CPU also waits for the GPU to finish with the next frame
+// so that this wait does not occur in draw() after input has already been sampled
+void VulkanRenderer::paceFrame()
+{
+	mFramePacer.limit();
+
+	if (mFramePacer.sleepBeforeInput())
+	{
+		mFrames[activeFrameIndex]->wait();
+	}
+}
+
+// Frames in flight are decoupled from the swapchain images:
+// the active frame's last submission is waited on before any of its CPU side resources (command pools, UBOs) are touched
+// and the acquired image index is only used to select the render target and framebuffer
+// Input is sampled on the main thread before draw() as GLFW requires it, the rest of the frame runs as a task graph:
+// UBO update | cull -> sort -> record -> submit
+void VulkanRenderer::draw()
+{
+	// Apply a present mode change or resize before any work for this frame begins
+	// Nothing is drawn while the window is minimised
+	if (mSwapchainOutdated && !recreateSwapchain())
+	{
+		return;
+	}
+
+	auto& activeFrame = mFrames[activeFrameIndex];
+
+	// Wait until the GPU has reached this frame's timeline value then reset command pools + synchronisation objects
+	activeFrame->wait();
+	activeFrame->reset();
+
+	// Get next swapchain image
+	VkSemaphore imageAcquired = activeFrame->requestSemaphore();
+	VkResult result = mSwapchain->acquireNextImageIndex(imageAcquired, activeImageIndex);
+
+	// The surface changed size since the swapchain was created, skip this frame and recreate
+	// The semaphore was not signalled so it can be returned to the frame's pool as normal
+	if (result == VK_ERROR_OUT_OF_DATE_KHR)
+	{
+		mSwapchainOutdated = true;
+		return;
+	}
+	else if (result == VK_SUBOPTIMAL_KHR)
+	{
+		mSwapchainOutdated = true;
+	}
+	else if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Could not acquire next swapchain image!");
+	}
+
+	// Request the required synchronisation objects
+	VkSemaphore renderFinished = activeFrame->requestSemaphore();
+
+	const Queue& queue = mDevice->queue(mGraphicsQueueFamily, 0);
+	CommandBuffer* primaryCmdBuffer = nullptr;
+
+	TaskGraph frameGraph;
+
+	// Safe to write to this frame's buffers now that the frame has been waited on
+	TaskId updateTask = frameGraph.addTask([this](size_t threadIndex) {
+		updatePerFrameResources();
+		});
+
+	TaskId cullTask = frameGraph.addTask([this](size_t threadIndex) {
+		cullMeshes();
+		});
+
+	TaskId sortTask = frameGraph.addTask([this](size_t threadIndex) {
+		sortDrawList();
+		}, { cullTask });
+
+	// The primary command buffer comes from the recording thread's pool so it is never used concurrently with secondary recording
+	// Recording waits on the update so per frame results (e.g. the visible light count) can size draws
+	TaskId recordTask = frameGraph.addTask([&](size_t threadIndex) {
+		primaryCmdBuffer = &activeFrame->requestCommandBuffer(queue, VK_COMMAND_BUFFER_LEVEL_PRIMARY, threadIndex);
+		recordCommands(*primaryCmdBuffer);
+		}, { updateTask, sortTask });
+
+	frameGraph.addTask([&](size_t threadIndex) {
+		uint64_t signalValue = queue.submit(imageAcquired, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, renderFinished,
+			*primaryCmdBuffer);
+		activeFrame->addSubmission(queue, signalValue);
+		mFramePacer.markSubmitted();
+		}, { recordTask });
+
+	frameGraph.execute(*mJobSystem);
+
+	result = queue.present(renderFinished, *mSwapchain, activeImageIndex);
+	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+	{
+		mSwapchainOutdated = true;
+	}
+	mFramePacer.markPresented();
+
+	// Advance to the next frame in the ring
+	activeFrameIndex = (activeFrameIndex + 1) % static_cast<uint32_t>(mFrames.size());
+}
+
+// The swapchain is recreated at the start of the next draw, pipelines are unaffected
+void VulkanRenderer::notifyWindowResized()
+{
+	mSwapchainOutdated = true;
+}
+
+// The swapchain is recreated at the start of the next draw
+void VulkanRenderer::setPresentMode(VkPresentModeKHR presentMode)
+{
+	if (presentMode == mPresentMode)
+	{
+		return;
+	}
+
+	mPresentMode = presentMode;
+	mSwapchainOutdated = true;
+}
+
+// Returns the present mode in use, which may differ from the requested mode if it is not supported
+VkPresentModeKHR VulkanRenderer::presentMode() const
+{
+	return mSwapchain->details().presentMode;
+}
+
+FramePacer& VulkanRenderer::framePacer()
+{
+	return mFramePacer;
+}
+
+void VulkanRenderer::setBindlessMaterials(bool enabled)
+{
+	mBindlessRequested = enabled;
+}
+
+bool VulkanRenderer::bindlessMaterials() const
+{
+	return mBindlessMaterials;
+}
+
+void VulkanRenderer::setPackedGBuffer(bool enabled)
+{
+	mPackedGBuffer = enabled;
+}
+
+bool VulkanRenderer::packedGBuffer() const
+{
+	return mPackedGBuffer;
+}
+
 void VulkanRenderer::updateModel(int modelId, glm::mat4& newModel)
 {
 	if (modelId >= mModelList.size()) return;
@@ -54,11 +206,18 @@ void VulkanRenderer::updateModel(int modelId, glm::mat4& newModel)
 
 void VulkanRenderer::createCamera(float FoVinDegrees)
 {
-	const VkExtent2D& extent = mSwapchain->extent();
+	mFieldOfView = FoVinDegrees;
+	updateCameraProjection();
 
-	mCameraMatrices.P = glm::perspective(glm::radians(FoVinDegrees), (float)extent.width / (float)extent.height, 0.1f, 300.0f);
 	mCameraMatrices.V = glm::lookAt(glm::vec3(0.0f, 0.0f, 20.0f), glm::vec3(0.0f, 0.0f, -2.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+}
 
+// Projection aspect ratio follows the swapchain so this is also called after a resize
+void VulkanRenderer::updateCameraProjection()
+{
+	const VkExtent2D& extent = mSwapchain->extent();
+
+	mCameraMatrices.P = glm::perspective(glm::radians(mFieldOfView), (float)extent.width / (float)extent.height, mNearPlane, mFarPlane);
 	mCameraMatrices.P[1][1] *= -1;
 }
 
@@ -69,6 +228,15 @@ void VulkanRenderer::updateCameraView(glm::mat4& newView)
 
 VulkanRenderer::~VulkanRenderer()
 {
+	// Pipeline jobs may still be running if init failed
+	if (mJobSystem)
+	{
+		try {
+			waitForPipelines();
+		}
+		catch (...) {}
+	}
+
 	if (mDevice)
 	{
 		mDevice->waitIdle();
@@ -78,10 +246,10 @@ VulkanRenderer::~VulkanRenderer()
 	mTextures.clear();
 }
 
-void VulkanRenderer::setupThreadPool()
+void VulkanRenderer::setupJobSystem()
 {
-	mThreadCount = std::thread::hardware_concurrency();
-	mThreadPool.resize(mThreadCount);
+	mThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	mJobSystem = std::make_unique<JobSystem>(mThreadCount);
 }
 
 void VulkanRenderer::createInstance()
@@ -130,7 +298,56 @@ void VulkanRenderer::createDevice()
 
 	getRequiredExtenstionAndFeatures(requiredExtensions, requiredFeatures);
 
-	mDevice = std::make_unique<Device>(*mInstance, mSurface->handle(), requiredExtensions, requiredFeatures);
+	// Descriptor indexing features used by bindless materials, enabled only where supported
+	VkPhysicalDeviceFeatures optionalFeatures = {};
+	VkPhysicalDeviceVulkan12Features optionalFeatures12 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+	if (mBindlessRequested)
+	{
+		optionalFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+		optionalFeatures12.descriptorIndexing = VK_TRUE;
+		optionalFeatures12.runtimeDescriptorArray = VK_TRUE;
+		optionalFeatures12.descriptorBindingPartiallyBound = VK_TRUE;
+		optionalFeatures12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		optionalFeatures12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+	}
+
+	mDevice = std::make_unique<Device>(*mInstance, mSurface->handle(), requiredExtensions, requiredFeatures,
+		VkPhysicalDeviceVulkan12Features{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES }, optionalFeatures, optionalFeatures12);
+
+	mPipelineRegistry = std::make_unique<PipelineRegistry>(*mDevice);
+
+	chooseMaterialMode();
+}
+
+// Use bindless materials only if every descriptor indexing feature they rely on was enabled
+void VulkanRenderer::chooseMaterialMode()
+{
+	const VkPhysicalDeviceFeatures& features = mDevice->enabledFeatures();
+	const VkPhysicalDeviceVulkan12Features& features12 = mDevice->enabledFeatures12();
+
+	mBindlessMaterials = mBindlessRequested &&
+		features.shaderSampledImageArrayDynamicIndexing &&
+		features12.runtimeDescriptorArray &&
+		features12.descriptorBindingPartiallyBound &&
+		features12.descriptorBindingSampledImageUpdateAfterBind &&
+		features12.descriptorBindingUpdateUnusedWhilePending;
+
+	if (!mBindlessMaterials)
+	{
+		return;
+	}
+
+	// Clamp the texture array to the update after bind limits
+	const VkPhysicalDeviceVulkan12Properties& properties12 = mDevice->physicalDevice().properties12();
+	mMaxBindlessTextures = std::min({ MAX_BINDLESS_TEXTURES,
+		properties12.maxDescriptorSetUpdateAfterBindSamplers,
+		properties12.maxDescriptorSetUpdateAfterBindSampledImages,
+		properties12.maxPerStageDescriptorUpdateAfterBindSamplers,
+		properties12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+		properties12.maxPerStageUpdateAfterBindResources - 1 });	// Leave room for the material buffer
+
+	uint32_t maxStorageBufferRange = mDevice->physicalDevice().properties().limits.maxStorageBufferRange;
+	mMaxBindlessMaterials = std::min(MAX_BINDLESS_MATERIALS, maxStorageBufferRange / static_cast<uint32_t>(sizeof(BindlessMaterial)));
 }
 
 // This should be redefined per application
@@ -145,7 +362,10 @@ void VulkanRenderer::createSwapchain()
 	VkExtent2D windowExtent;
 	getWindowExtent(windowExtent);
 
-	mSwapchain = std::make_unique<Swapchain>(*mDevice, windowExtent, mSurface->handle(), VK_PRESENT_MODE_MAILBOX_KHR, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+	// Hand over to the existing swapchain if this is a recreation
+	VkSwapchainKHR oldSwapchain = mSwapchain ? mSwapchain->handle() : VK_NULL_HANDLE;
+
+	mSwapchain = std::make_unique<Swapchain>(*mDevice, windowExtent, mSurface->handle(), mPresentMode, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, oldSwapchain);
 }
 // Set supported formats as default formats
 void VulkanRenderer::chooseImageFormats()
@@ -158,14 +378,68 @@ void VulkanRenderer::chooseImageFormats()
 	);
 
 	// Get supported format for depth buffer
+	// No pass uses stencil so a format without it is preferred
 	mDepthFormat = chooseSupportedFormat(
-		{ VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT },
+		{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
 		VK_IMAGE_TILING_OPTIMAL,
 		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+
+	// Get supported format for packed normals, both formats store the encoding's [-1,1] range directly
+	mPackedNormalFormat = chooseSupportedFormat(
+		{ VK_FORMAT_R16G16_SNORM, VK_FORMAT_R16G16_SFLOAT },
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+}
+
+// Prepare a render target for each swapchain image
+void VulkanRenderer::createRenderTargets()
+{
+	auto& swapchainExtent = mSwapchain->extent();
+	VkFormat swapchainFormat = mSwapchain->format();
+	VkImageUsageFlags swapchainUsage = mSwapchain->usage();
+
+	for (auto& image : mSwapchain->images())
+	{
+		Image swapchainImage(*mDevice,
+			image,
+			swapchainExtent,
+			swapchainFormat,
+			swapchainUsage);
+
+		mRenderTargets.push_back(mRenderGraph->createRenderTarget(std::move(swapchainImage)));
+	}
+}
+
+void VulkanRenderer::createRenderPass()
+{
+	mRenderPass = mRenderGraph->createRenderPass();
 }
 
 void VulkanRenderer::createPerMaterialDescriptorSetLayout()
 {
+	if (mBindlessMaterials)
+	{
+		// TEXTURE ARRAY
+		// Only written slots are valid and new textures can be written while the set is bound in a pending frame
+		ShaderResource textures(0,
+			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			mMaxBindlessTextures,
+			VK_SHADER_STAGE_FRAGMENT_BIT,
+			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT);
+
+		// MATERIAL BUFFER
+		ShaderResource materials(1,
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			1,
+			VK_SHADER_STAGE_FRAGMENT_BIT);
+
+		std::vector<ShaderResource> bindlessResources{ textures, materials };
+
+		mPerMaterialDescriptorSetLayout = std::make_unique<DescriptorSetLayout>(*mDevice, 1, bindlessResources,
+			VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT);
+		return;
+	}
+
 	// TEXTURE SAMPLERS
 	ShaderResource diffuseSampler(0,
 		VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
@@ -189,22 +463,179 @@ void VulkanRenderer::createPerMaterialDescriptorSetLayout()
 
 void VulkanRenderer::createPushConstantRange()
 {
-	mPushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;		// Shader stage push constant will go to
+	mPushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;	// Shader stages push constant will go to
 	mPushConstantRange.offset = 0;									// Offset into given data to pass to push constant
-	mPushConstantRange.size = sizeof(glm::mat4);					// Size of data being passed
+	mPushConstantRange.size = sizeof(DrawPushConstant);				// Size of data being passed
+}
+
+
+// Request the subpass's pipeline from the registry on the job system
+// Each pipeline is a separate job so shader modules and pipelines for different subpasses are created in parallel
+// The pipeline layout must already exist and mPipelines must be sized to hold the pipeline
+// The device's pipeline cache and the pipeline registry are internally synchronised so they are shared by every job
+void VulkanRenderer::createPipelineAsync(uint32_t pipelineIndex, const PipelineState& pipelineState)
+{
+	createPipelineAsync(pipelineIndex, pipelineState, *mRenderPass, pipelineIndex);
 }
 
+void VulkanRenderer::createPipelineAsync(uint32_t pipelineIndex, const PipelineState& pipelineState, const RenderPass& renderPass, uint32_t subpassIndex)
+{
+	mJobSystem->submit([this, pipelineIndex, pipelineState, &renderPass, subpassIndex](size_t threadIndex) {
+		mPipelines[pipelineIndex] = &mPipelineRegistry->request(*mSubpasses[pipelineIndex],
+			*mPipelineLayouts[pipelineIndex],
+			renderPass,
+			subpassIndex,
+			pipelineState);
+		}, mPipelineCounter);
+}
+
+// Block until every submitted pipeline is compiled, rethrows the first compilation error
+void VulkanRenderer::waitForPipelines()
+{
+	mJobSystem->wait(mPipelineCounter);
+}
+
+// Create the ring of frames in flight
+// Each frame can create descriptor sets for every render target
+void VulkanRenderer::createFrames()
+{
+	for (uint32_t i = 0; i < mFramesInFlight; ++i)
+	{
+		mFrames.push_back(std::make_unique<Frame>(*mDevice, mThreadCount, mRenderTargets.size()));
+	}
+}
 
 void VulkanRenderer::createFramebuffers()
 {
+	for (auto& renderTarget : mRenderTargets)
+	{
+		mFramebuffers.push_back(std::make_unique<Framebuffer>(*mDevice, *mRenderPass, *renderTarget));
+	}
+}
+
+// Recreate the swapchain along with everything which references its images
+// Render pass, pipelines and per frame buffers do not depend on the present mode so are kept
+// Only the swapchain and objects sized by it (render targets, framebuffers and the descriptor sets referencing attachments) are recreated
+// Pipelines use dynamic viewport and scissor and the render pass only depends on formats so both are kept
+// Returns false without recreating if the window is minimised, mSwapchainOutdated stays set so this is retried next frame
+bool VulkanRenderer::recreateSwapchain()
+{
+	VkExtent2D windowExtent;
+	getWindowExtent(windowExtent);
+	if (windowExtent.width == 0 || windowExtent.height == 0)
+	{
+		return false;
+	}
+
+	mDevice->waitIdle();
+
+	mFramebuffers.clear();
+	mRenderTargets.clear();
+
+	createSwapchain();
+	createRenderTargets();
+	createFramebuffers();
+
+	// Descriptor sets reference render target attachments so must be recreated
 	for (auto& frame : mFrames)
 	{
-		auto& renderTarget = frame->renderTarget();
+		frame->resetDescriptorSets(mRenderTargets.size());
+	}
+	createPerFrameDescriptorSets();
+
+	updateCameraProjection();
+
+	mSwapchainOutdated = false;
+
+	return true;
+}
+
+// Viewport and scissor are dynamic state and cover the whole swapchain image
+// Must be set in every secondary command buffer and again in the primary after secondary buffers are executed
+void VulkanRenderer::setViewportAndScissor(CommandBuffer& commandBuffer, uint32_t downsample)
+{
+	// Reduced extents are rounded up so every swapchain pixel is covered by a reduced pixel
+	VkExtent2D extent = mSwapchain->extent();
+	extent.width = (extent.width + downsample - 1) / downsample;
+	extent.height = (extent.height + downsample - 1) / downsample;
+
+	VkViewport viewport = {};
+	viewport.x = 0.0f;						// x start coordinate
+	viewport.y = 0.0f;						// y start coordinate
+	viewport.width = (float)extent.width;	// width of viewport
+	viewport.height = (float)extent.height;	// height of viewport
+	viewport.minDepth = 0.0f;				// min framebuffer depth
+	viewport.maxDepth = 1.0f;				// max framebuffer depth
+
+	VkRect2D scissor = {};
+	scissor.offset = { 0, 0 };				// Offset to use region from
+	scissor.extent = extent;				// Extent to describe region to use, starting at offset
+
+	commandBuffer.setViewport(viewport);
+	commandBuffer.setScissor(scissor);
+}
+
+// Test the bounding sphere of every mesh against the camera frustum and store the visible meshes in the draw list
+void VulkanRenderer::cullMeshes()
+{
+	std::vector<std::reference_wrapper<Mesh>> meshes;
+	for (auto& model : mModelList)
+	{
+		for (size_t i = 0; i < model.meshCount(); ++i)
+		{
+			meshes.push_back(model.mesh(i));
+		}
+	}
+
+	std::array<glm::vec4, 6> planes = frustumPlanes(mCameraMatrices.P * mCameraMatrices.V);
 
-		mFramebuffers.push_back(std::make_unique<Framebuffer>(*mDevice, *mRenderPass, renderTarget));
+	std::vector<uint8_t> visible(meshes.size(), 0);
+	uint32_t meshCount = static_cast<uint32_t>(meshes.size());
+	uint32_t batchSize = std::max<uint32_t>(64, meshCount / mThreadCount);
+
+	mJobSystem->parallelFor(meshCount, batchSize, [&](uint32_t start, uint32_t end, size_t threadIndex) {
+		for (uint32_t i = start; i < end; ++i)
+		{
+			const Mesh& mesh = meshes[i];
+			glm::mat4 model = mesh.model();
+
+			// Transform the sphere to world space, scaling the radius by the largest axis scale
+			glm::vec3 centre = glm::vec3(model * glm::vec4(mesh.boundsCentre(), 1.0f));
+			float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+			float radius = mesh.boundsRadius() * scale;
+
+			bool inside = true;
+			for (const auto& plane : planes)
+			{
+				if (glm::dot(glm::vec3(plane), centre) + plane.w < -radius)
+				{
+					inside = false;
+					break;
+				}
+			}
+
+			visible[i] = inside;
+		}
+		});
+
+	mDrawList.clear();
+	for (size_t i = 0; i < meshes.size(); ++i)
+	{
+		if (visible[i])
+		{
+			mDrawList.push_back(meshes[i]);
+		}
 	}
 }
 
+// Group draws by material so that meshes sharing textures are recorded together
+void VulkanRenderer::sortDrawList()
+{
+	std::stable_sort(mDrawList.begin(), mDrawList.end(), [](const Mesh& a, const Mesh& b) {
+		return a.materialID() < b.materialID();
+		});
+}
+
 void VulkanRenderer::createMaterialSamplers()
 {
 	float maxAnisotropy = mDevice->physicalDevice().properties().limits.maxSamplerAnisotropy;
@@ -231,8 +662,36 @@ void VulkanRenderer::createMaterialSamplers()
 
 void VulkanRenderer::createPerMaterialDescriptorPool()
 {
-	// CREATE SAMPLER DESCRIPTOR POOL
-	mPerMaterialDescriptorPool = std::make_unique<DescriptorPool>(*mDevice, *mPerMaterialDescriptorSetLayout, MAX_MATERIALS);
+	if (mBindlessMaterials)
+	{
+		// CREATE BINDLESS DESCRIPTOR POOL
+		// Only one set is needed for every material
+		mPerMaterialDescriptorPool = std::make_unique<DescriptorPool>(*mDevice, *mPerMaterialDescriptorSetLayout, 1,
+			VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT);
+
+		// CREATE MATERIAL BUFFER
+		mMaterialBuffer = std::make_unique<Buffer>(*mDevice,
+			sizeof(BindlessMaterial) * mMaxBindlessMaterials,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+		BindingMap<VkDescriptorBufferInfo> bufferInfos;
+		bufferInfos[1][0] = { mMaterialBuffer->handle(), 0, mMaterialBuffer->size() };
+
+		mBindlessDescriptorSet = std::make_unique<DescriptorSet>(*mDevice, *mPerMaterialDescriptorSetLayout, *mPerMaterialDescriptorPool, bufferInfos);
+		mBindlessDescriptorSet->update({ 1 });
+
+		// Write textures created before the set existed (e.g. the default texture)
+		for (auto& texture : mTextures)
+		{
+			writeBindlessTexture(texture.first);
+		}
+
+		return;
+	}
+
+	// CREATE SAMPLER DESCRIPTOR CACHE
+	mMaterialDescriptorCache = std::make_unique<DescriptorSetCache>(*mDevice, *mPerMaterialDescriptorSetLayout, MATERIAL_DESCRIPTOR_SETS);
 }
 
 VkFormat VulkanRenderer::chooseSupportedFormat(const std::vector<VkFormat>& formats, VkImageTiling tiling, VkFormatFeatureFlags featureFlags)
@@ -265,18 +724,55 @@ uint32_t VulkanRenderer::createTexture(std::string fileName)
 	VkDeviceSize imageSize;
 	stbi_uc* textureData = loadTextureFile(fileName, width, height, imageSize);
 
-	std::unique_ptr<Texture>  texture = std::make_unique<Texture>(*mDevice, textureData, width, height, imageSize);
+	return createTexture(textureData, width, height, imageSize);
+}
+
+uint32_t VulkanRenderer::createTexture(stbi_uc* textureData, int width, int height, VkDeviceSize imageSize)
+{
+	// Pixels are freed once uploaded, or if the upload throws
+	std::unique_ptr<stbi_uc, void(*)(void*)> pixels(textureData, stbi_image_free);
+
+	std::unique_ptr<Texture>  texture = std::make_unique<Texture>(*mDevice, pixels.get(), width, height, imageSize);
+	pixels.reset();
 
 	// Add texture to map of textures
 	int textureID = texture->textureID();;
+	if (mBindlessMaterials && static_cast<uint32_t>(textureID) >= mMaxBindlessTextures)
+	{
+		throw std::runtime_error("Failed to create texture, bindless texture limit reached!");
+	}
+
 	mTextures[textureID] = std::move(texture);
 	assert(!texture); // just checking ownership of the texture ptr has moved to the map
+
+	if (mBindlessDescriptorSet)
+	{
+		writeBindlessTexture(textureID);
+	}
 	
 	return textureID;
 }
 
 uint32_t VulkanRenderer::createMaterialDescriptor(uint32_t diffuseID, uint32_t normalID, uint32_t specularID)
 {
+	// Bindless materials are an entry in the material buffer rather than a descriptor set
+	if (mBindlessMaterials)
+	{
+		if (mMaterialCount >= mMaxBindlessMaterials)
+		{
+			throw std::runtime_error("Failed to create material, bindless material limit reached!");
+		}
+
+		BindlessMaterial material{ diffuseID, normalID, specularID, 0 };
+
+		// Earlier entries may be in use by the GPU but this entry is not yet referenced by any draw
+		uint8_t* data = static_cast<uint8_t*>(mMaterialBuffer->map());
+		memcpy(data + sizeof(BindlessMaterial) * mMaterialCount, &material, sizeof(BindlessMaterial));
+		mMaterialBuffer->unmap();
+
+		return mMaterialCount++;
+	}
+
 	// Create descriptor resource reference
 	DescriptorResourceReference materialResource;
 	// Bind Images
@@ -284,29 +780,24 @@ uint32_t VulkanRenderer::createMaterialDescriptor(uint32_t diffuseID, uint32_t n
 	materialResource.bindImage(mTextures[normalID]->imageView(), *mNormalSampler, 1, 0);
 	materialResource.bindImage(mTextures[specularID]->imageView(), *mSpecularSampler, 2, 0);
 
-	// Generate image infos
-	VkDescriptorImageInfo diffuseInfo = {};
-	VkDescriptorImageInfo normalInfo = {};
-	VkDescriptorImageInfo specularInfo = {};
-	materialResource.generateDescriptorImageInfo(diffuseInfo, 0, 0);
-	materialResource.generateDescriptorImageInfo(normalInfo, 1, 0);
-	materialResource.generateDescriptorImageInfo(specularInfo, 2, 0);
-
-	BindingMap<VkDescriptorImageInfo> imageInfos;
-	imageInfos[0][0] = diffuseInfo;
-	imageInfos[1][0] = normalInfo;
-	imageInfos[2][0] = specularInfo;
-
-	mPerMaterialDescriptorSets.push_back(std::make_unique<DescriptorSet>(*mDevice, *mPerMaterialDescriptorSetLayout, *mPerMaterialDescriptorPool, imageInfos));
-
-	// Update the descriptor sets with new buffer/binding info
-	std::vector<uint32_t> bindingsToUpdate = { 0, 1, 2 };
-	mPerMaterialDescriptorSets.back()->update(bindingsToUpdate);
+	// Materials which bind the same textures share a descriptor set
+	DescriptorSet& descriptorSet = mMaterialDescriptorCache->request(materialResource);
+	mPerMaterialDescriptorSets.push_back(&descriptorSet);
 
 	// Return descriptor set location
 	return mPerMaterialDescriptorSets.size() - 1;
+}
 
+// Write a texture into its slot in the bindless texture array
+// All material samplers share the same settings so the diffuse sampler is used for every texture
+void VulkanRenderer::writeBindlessTexture(uint32_t textureID)
+{
+	VkDescriptorImageInfo imageInfo = {};
+	imageInfo.sampler = mDiffuseSampler->handle();
+	imageInfo.imageView = mTextures[textureID]->imageView().handle();
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
+	mBindlessDescriptorSet->writeImage(0, textureID, imageInfo);
 }
 
 stbi_uc* VulkanRenderer::loadTextureFile(std::string fileName, int& width, int& height, VkDeviceSize& imageSize)
@@ -349,51 +840,54 @@ int VulkanRenderer::createModel(std::string modelFile)
 
 	uint32_t materialCount = scene->mNumMaterials;
 
-	// Conversion from the materials list IDs to texture IDs
-	// Note if a material has a diffuse and normal compopnent they will share the same ID
-	std::vector<uint32_t> materialIDs(materialCount);
-
-	// Loop over textureNames and create textures diffuse and normal components
-	for (uint32_t i = 0; i < materialCount; ++i)
+	// Decode every texture file used by the model in parallel
+	// Texture creation records GPU uploads so is done afterwards on this thread
+	std::vector<std::string> textureNames;
+	for (auto* names : { &diffuseNames, &normalNames, &specularNames })
 	{
-		uint32_t diffuseID;
-		uint32_t normalID;
-		uint32_t specularID;
-
-		// If material has no texture, set '0' to indicate no texture, texture 0 will be reserved for a default texture
-		if (diffuseNames[i].empty())
+		for (auto& name : *names)
 		{
-			diffuseID = 0;
-		}
-		else
-		{
-			// Otherwise, create texture and set value to index of new texture
-			diffuseID = createTexture(diffuseNames[i]);
+			if (!name.second.empty() && std::find(textureNames.begin(), textureNames.end(), name.second) == textureNames.end())
+			{
+				textureNames.push_back(name.second);
+			}
 		}
+	}
 
-		// repeat for normal textures
-		if (normalNames[i].empty())
+	// Decoded pixels are owned until passed to createTexture so every file is freed if a decode or upload throws
+	struct TextureFile {
+		std::unique_ptr<stbi_uc, void(*)(void*)> data{ nullptr, stbi_image_free };
+		int width{ 0 };
+		int height{ 0 };
+		VkDeviceSize size{ 0 };
+	};
+
+	std::vector<TextureFile> textureFiles(textureNames.size());
+	mJobSystem->parallelFor(static_cast<uint32_t>(textureNames.size()), 1, [&](uint32_t start, uint32_t end, size_t threadIndex) {
+		for (uint32_t i = start; i < end; ++i)
 		{
-			normalID = 0;
-		}
-		else
-		{
-			normalID = createTexture(normalNames[i]);
+			auto& file = textureFiles[i];
+			file.data.reset(loadTextureFile(textureNames[i], file.width, file.height, file.size));
 		}
+		});
 
-		// repeat for specular textures
-		if (specularNames[i].empty())
-		{
-			specularID = 0;
-		}
-		else
-		{
-			specularID = createTexture(specularNames[i]);
-		}
+	// Texture '0' is reserved for a default texture so is used if a material has no texture
+	std::map<std::string, uint32_t> textureIDs;
+	textureIDs[""] = 0;
+	for (size_t i = 0; i < textureNames.size(); ++i)
+	{
+		auto& file = textureFiles[i];
+		textureIDs[textureNames[i]] = createTexture(file.data.release(), file.width, file.height, file.size);
+	}
 
+	// Conversion from the materials list IDs to texture IDs
+	// Note if a material has a diffuse and normal compopnent they will share the same ID
+	std::vector<uint32_t> materialIDs(materialCount);
 
+	for (uint32_t i = 0; i < materialCount; ++i)
+	{
 		// Create material descriptor
-		materialIDs[i] = createMaterialDescriptor(diffuseID, normalID, specularID);
+		materialIDs[i] = createMaterialDescriptor(textureIDs[diffuseNames[i]], textureIDs[normalNames[i]], textureIDs[specularNames[i]]);
 	}
 
 	// Load in all our meshes
@@ -6,8 +6,6 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include <ctpl_stl.h>
-
 #include <stb_image.h>
 
 #include "Common.h"
@@ -17,6 +15,9 @@
 #include "Mesh.h"
 #include "MeshModel.h"
 #include "Light.h"
+#include "LightClusters.h"
+#include "LightManager.h"
+#include "GroundTruthAO.h"
 
 #include "Device.h"
 #include "SwapChain.h"
@@ -31,9 +32,13 @@
 #include "DescriptorSetLayout.h"
 #include "DescriptorResourceReference.h"
 #include "DescriptorSet.h"
+#include "DescriptorSetCache.h"
 #include "PhysicalDevice.h"
 #include "Pipeline.h"
 #include "PipelineLayout.h"
+#include "PipelineRegistry.h"
+#include "PipelineState.h"
+#include "RenderGraph.h"
 #include "RenderPass.h"
 #include "RenderTarget.h"
 #include "ShaderModule.h"
@@ -43,6 +48,9 @@
 #include "Texture.h"
 #include "Queue.h"
 #include "CommandBuffer.h"
+#include "FramePacer.h"
+#include "JobSystem.h"
+#include "TaskGraph.h"
 
 // Abstract class to derive vulkan applications from
 // Functionality for model and texture loading and the associated descriptor sets, buffers etc. are implemented here
@@ -63,15 +71,33 @@ public:
 	void createCamera(float FoVinDegrees);
 	void updateCameraView(glm::mat4& newView);
 
-	virtual void draw() = 0;
+	// Frame control
+	void paceFrame();
+	virtual void draw();
+
+	// Presentation Control
+	void notifyWindowResized();		// Call when the framebuffer size changes (e.g. resize or fullscreen toggle)
+	void setPresentMode(VkPresentModeKHR presentMode);
+	VkPresentModeKHR presentMode() const;
+	FramePacer& framePacer();
+
+	// Material Control
+	void setBindlessMaterials(bool enabled);	// Request bindless materials (off by default), call before init()
+	bool bindlessMaterials() const;
+
+	// G-Buffer Control
+	void setPackedGBuffer(bool enabled);		// Use the packed G-buffer layout in deferred apps, call before init()
+	bool packedGBuffer() const;
 
 protected:
 	GLFWwindow* mWindow;
 
-	uint32_t activeFrameIndex{ 0 };
+	uint32_t activeFrameIndex{ 0 };		// Index of the frame in flight being recorded
+	uint32_t activeImageIndex{ 0 };		// Index of the acquired swapchain image (and its render target + framebuffer)
 
 	// Assets
 	std::vector<MeshModel> mModelList;
+	std::vector<std::reference_wrapper<Mesh>> mDrawList;		// Visible meshes for the active frame, sorted by material
 	std::map <uint32_t, std::unique_ptr<Texture>> mTextures;
 
 	// Standard VP matrix struct
@@ -81,6 +107,23 @@ protected:
 	};
 
 	uboVP mCameraMatrices;
+	float mNearPlane{ 0.1f };		// Clip planes, also passed to shaders which linearise depth as specialization constants
+	float mFarPlane{ 300.0f };
+	float mFieldOfView{ 90.0f };	// Vertical field of view in degrees, projection aspect follows the swapchain extent
+
+	// Per draw push constant, the material ID is only read by the bindless shaders
+	struct DrawPushConstant {
+		glm::mat4 model;
+		uint32_t materialID;
+	};
+
+	// Bindless material entry, indices into the bindless texture array
+	struct BindlessMaterial {
+		uint32_t diffuseID;
+		uint32_t normalID;
+		uint32_t specularID;
+		uint32_t padding;
+	};
 
 	// Vulkan Components
 	// - Main
@@ -91,12 +134,21 @@ protected:
 	uint32_t mGraphicsQueueFamily{ 0 };
 
 	std::unique_ptr<Swapchain> mSwapchain{ nullptr };
-	std::vector<std::unique_ptr<Framebuffer>> mFramebuffers;
-	std::vector<std::unique_ptr<Frame>> mFrames;
+	VkPresentModeKHR mPresentMode{ VK_PRESENT_MODE_MAILBOX_KHR };	// Requested present mode, swapchain falls back if unsupported
+	bool mSwapchainOutdated{ false };								// Swapchain is recreated before the next frame if set
+	std::vector<std::unique_ptr<RenderTarget>> mRenderTargets;		// One per swapchain image
+	std::vector<std::unique_ptr<Framebuffer>> mFramebuffers;		// One per render target
+	std::vector<std::unique_ptr<Frame>> mFrames;					// One per frame in flight
+	uint32_t mFramesInFlight{ MAX_FRAMES_IN_FLIGHT };
 	
 	// - Formats
 	VkFormat mColourFormat{ VK_FORMAT_R8G8B8A8_UNORM };
-	VkFormat mDepthFormat{ VK_FORMAT_D32_SFLOAT_S8_UINT };
+	VkFormat mDepthFormat{ VK_FORMAT_D32_SFLOAT };				// Stencil is not used so depth only formats are preferred
+	VkFormat mPackedNormalFormat{ VK_FORMAT_R16G16_SNORM };		// Octahedral encoded normals (packed G-buffer)
+
+	// - Packed G-Buffer
+	// Normals are octahedral encoded in two channels, specular is held in the albedo alpha and position is reconstructed from depth
+	bool mPackedGBuffer{ false };
 
 	// - Descriptors
 	// -- Layouts
@@ -104,10 +156,23 @@ protected:
 	VkPushConstantRange mPushConstantRange;		// push constant acts as per draw descriptor set 
 
 	// -- Pool
-	std::unique_ptr<DescriptorPool> mPerMaterialDescriptorPool;
+	std::unique_ptr<DescriptorPool> mPerMaterialDescriptorPool;		// Bindless only
+	std::unique_ptr<DescriptorSetCache> mMaterialDescriptorCache;	// Shares sets between materials which bind the same textures
 
 	// -- Sets
-	std::vector<std::unique_ptr<DescriptorSet>> mPerMaterialDescriptorSets;		// Descriptor sets holding texture samplers
+	std::vector<DescriptorSet*> mPerMaterialDescriptorSets;						// Descriptor sets holding texture samplers, indexed by material ID and owned by the cache
+	std::unique_ptr<DescriptorSet> mBindlessDescriptorSet;						// Single set holding every texture + the material buffer (bindless only)
+
+	// - Bindless Materials
+	// All textures are held in one runtime sized array indexed through a material buffer so the material set is bound once per pass
+	// Falls back to a descriptor set per material if descriptor indexing is unsupported
+	// Off unless requested as the bindless shader variants (*_bindless_frag.spv) are not shipped precompiled
+	bool mBindlessRequested{ false };
+	bool mBindlessMaterials{ false };
+	uint32_t mMaxBindlessTextures{ 0 };
+	uint32_t mMaxBindlessMaterials{ 0 };
+	uint32_t mMaterialCount{ 0 };
+	std::unique_ptr<Buffer> mMaterialBuffer;
 
 	// Material Samplers
 	std::unique_ptr<Sampler> mDiffuseSampler;
@@ -116,39 +181,54 @@ protected:
 
 
 	// - Pipelines + Layouts
-	std::vector<std::unique_ptr<Pipeline>>	mPipelines;
+	std::unique_ptr<PipelineRegistry> mPipelineRegistry;		// Owns pipelines, identical pipeline requests share one pipeline
+	std::vector<GraphicsPipeline*> mPipelines;
 	std::vector<std::unique_ptr<PipelineLayout>> mPipelineLayouts;
 
 	// - Renderpass
 	std::vector<std::unique_ptr<Subpass>> mSubpasses;
+	std::unique_ptr<RenderGraph> mRenderGraph;				// Derives render targets and the render pass from the subpasses
 	std::unique_ptr<RenderPass> mRenderPass;
 
 	// - Multithreading
-	// Max. number of concurrent threads
+	// Max. number of concurrent threads (including the main thread)
 	uint32_t mThreadCount;
-	ctpl::thread_pool mThreadPool;
+	std::unique_ptr<JobSystem> mJobSystem;
+	JobCounter mPipelineCounter;		// Pipelines being compiled on the job system
+
+	// - Frame pacing + latency instrumentation
+	FramePacer mFramePacer;
 
 	// Vulkan Functions
 	// - Create Functions
-	void setupThreadPool();
+	void setupJobSystem();
 
 	void createInstance();
 	void createSurface();
 	void createDevice();
+	void chooseMaterialMode();
 	virtual void findDesiredQueueFamilies();
 	virtual void createSwapchain();
 
 	void chooseImageFormats();
-	virtual void createRenderTargetAndFrames()	= 0;	// Resource references to attachments should be created here
-	virtual void createRenderPass()				= 0;
+	virtual void createRenderGraph()			= 0;	// Attachments and subpasses should be added here and the graph compiled
+	virtual void createRenderTargets();
+	void createFrames();
+	virtual void createRenderPass();
 
 	// CREATE DESCRIPTOR SET LAYOUTS
 	virtual void createPerFrameDescriptorSetLayouts()	= 0;
 	virtual void createPerMaterialDescriptorSetLayout();
 	virtual void createPushConstantRange();
 
-	virtual void createPipelines()				= 0;
+	virtual void createPipelines()				= 0;	// Pipeline layouts should be created here and pipelines compiled with createPipelineAsync
+	void createPipelineAsync(uint32_t pipelineIndex, const PipelineState& pipelineState);
+	// For subpasses recorded in a render pass other than mRenderPass, subpassIndex is the subpass within that render pass
+	void createPipelineAsync(uint32_t pipelineIndex, const PipelineState& pipelineState, const RenderPass& renderPass, uint32_t subpassIndex);
+	void waitForPipelines();
 	void createFramebuffers();
+	bool recreateSwapchain();
+	void updateCameraProjection();
 
 	// CREATE DESCRIPTOR RESOURCES
 	virtual void createPerFrameResources()	= 0;
@@ -160,6 +240,15 @@ protected:
 	// CREATE DESCRIPTOR SETS
 	virtual void createPerFrameDescriptorSets()		= 0;
 
+	// - Frame Tasks
+	void cullMeshes();
+	void sortDrawList();
+
+	// - Record Functions
+	virtual void recordCommands(CommandBuffer& primaryCmdBuffer) = 0;	// Called after updatePerFrameResources() for the frame
+	// A downsample greater than 1 sets the swapchain extent divided by downsample, rounded up (e.g. for reduced size render targets)
+	void setViewportAndScissor(CommandBuffer& commandBuffer, uint32_t downsample = 1);
+
 	// -- Support
 	virtual void updatePerFrameResources()			= 0;
 	virtual void getRequiredExtenstionAndFeatures(std::vector<const char*>& requiredExtensions,
@@ -173,7 +262,9 @@ protected:
 	VkFormat chooseSupportedFormat(const std::vector<VkFormat> &formats, VkImageTiling tiling, VkFormatFeatureFlags featureFlags);
 
 	uint32_t createTexture(std::string fileName);
+	uint32_t createTexture(stbi_uc* textureData, int width, int height, VkDeviceSize imageSize);
 	uint32_t createMaterialDescriptor(uint32_t diffuseID, uint32_t normalID = 0, uint32_t specularID = 0);
+	void writeBindlessTexture(uint32_t textureID);
 	
 	// -- Loader Functions
 	stbi_uc* loadTextureFile(std::string fileName, int& width, int& height, VkDeviceSize& imageSize);
@@ -1,3 +1,7 @@
-C:/VulkanSDK/1.2.141.2/Bin/glslangValidator.exe -o fullscreen_vert.spv -V fullscreen.vert
-C:/VulkanSDK/1.2.141.2/Bin/glslangValidator.exe -o fullscreen_viewRay_vert.spv -V fullscreen_viewRay.vert
-pause
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -o fullscreen_vert.spv -V fullscreen.vert || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -o fullscreen_viewRay_vert.spv -V fullscreen_viewRay.vert || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -o cluster_lights_comp.spv -V cluster_lights.comp || goto error
+exit /b 0
+
+:error
+exit /b 1
@@ -1,4 +1,14 @@
-C:/VulkanSDK/1.2.141.2/Bin/glslangValidator.exe -o geometry_vert.spv -V geometry.vert
-C:/VulkanSDK/1.2.141.2/Bin/glslangValidator.exe -o geometry_frag.spv -V geometry.frag
-C:/VulkanSDK/1.2.141.2/Bin/glslangValidator.exe -o lighting_frag.spv -V lighting.frag
-pause
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -o geometry_vert.spv -V geometry.vert || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -o geometry_frag.spv -V geometry.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -DBINDLESS -o geometry_bindless_frag.spv -V geometry.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -DPACKED_GBUFFER -o geometry_packed_frag.spv -V geometry.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -DBINDLESS -DPACKED_GBUFFER -o geometry_bindless_packed_frag.spv -V geometry.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -o lighting_frag.spv -V lighting.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -DPACKED_GBUFFER -o lighting_packed_frag.spv -V lighting.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -o light_volume_vert.spv -V light_volume.vert || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -o light_volume_frag.spv -V light_volume.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -DPACKED_GBUFFER -o light_volume_packed_frag.spv -V light_volume.frag || goto error
+exit /b 0
+
+:error
+exit /b 1
@@ -1,5 +1,9 @@
 #version 450
 
+#ifdef BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
 // INPUTS
 // - UV
 layout(location = 0) in vec2 UV;
@@ -10,21 +14,55 @@ layout(location = 2) in vec3 normal_worldSpace;
 layout(location = 3) in vec3 tangent_worldSpace;
 
 // OUTPUTS
+#ifdef PACKED_GBUFFER
+// Octahedral encoded normal + albedo with specular in alpha, position is reconstructed from depth
+layout(location = 0) out vec2 gNormal;
+layout(location = 1) out vec4 gAlbedoSpec;
+#else
 layout(location = 0) out vec4 gPosition;
 layout(location = 1) out vec4 gNormal; 
 layout(location = 2) out vec4 gAlbedo; 
 layout(location = 3) out vec4 gSpecular; 
+#endif
 
 
 // - Descriptor set 1 (texture samplers)
+#ifdef BINDLESS
+// Every texture is held in one array which is indexed through the material buffer using the per draw material ID
+struct Material {
+	uint diffuseID;
+	uint normalID;
+	uint specularID;
+	uint padding;
+};
+
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+layout(set = 1, binding = 1) readonly buffer MaterialBuffer {
+	Material materials[];
+};
+
+layout(push_constant) uniform PushMaterial 
+{
+	layout(offset = 64) uint materialID;
+};
+
+#define albedoSampler textures[materials[materialID].diffuseID]
+#define normalSampler textures[materials[materialID].normalID]
+#define specularSampler textures[materials[materialID].specularID]
+#else
 layout(set = 1, binding = 0) uniform sampler2D albedoSampler;
 layout(set = 1, binding = 1) uniform sampler2D normalSampler;
 layout(set = 1, binding = 2) uniform sampler2D specularSampler;
+#endif
 
+// Function prototypes
+vec2 encodeNormal(vec3 n);
 
 void main () {
+#ifndef PACKED_GBUFFER
 	// Position map
 	gPosition = vec4(fragPos_worldSpace, 1.0);
+#endif
 
 	// Calculate TBN matrix
 	vec3 T = normalize(tangent_worldSpace);
@@ -35,6 +73,12 @@ void main () {
 
 	// Normal map in worldspace - convert from range of [0,1] to [-1,1] when sampling
 	vec3 normal_worldSpace = TBN * (texture(normalSampler, UV).rgb * 2 - 1.0);
+#ifdef PACKED_GBUFFER
+	gNormal = encodeNormal(normalize(normal_worldSpace));
+
+	// Albedo + specular map
+	gAlbedoSpec = vec4(texture(albedoSampler, UV).rgb, texture(specularSampler, UV).r);
+#else
 	// Convert back to range of [0,1] as values will be clamped at 0 when stored in RGB texture
 	normal_worldSpace = normalize(normal_worldSpace) * 0.5 + 0.5;
 	gNormal = vec4(normal_worldSpace, 1.0);
@@ -46,4 +90,16 @@ void main () {
 
 	// Specular map
 	gSpecular = texture(specularSampler, UV).rgba;
+#endif
+}
+
+// Octahedral encoding - project the unit normal onto an octahedron and fold the lower half over the upper half
+// Components are in the range [-1,1]
+vec2 encodeNormal(vec3 n)
+{
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+
+	vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+
+	return n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * signs;
 }
\ No newline at end of file
@@ -0,0 +1,153 @@
+#version 450
+
+// Adds one point light's contribution to the pixels covered by its light volume (blended additively)
+
+layout(location = 0) flat in uint lightIndex;
+layout(location = 1) flat in float lightRadius;
+layout(location = 2) in vec2 fragNDC;
+
+// INPUT ATTACHMENTS
+#ifdef PACKED_GBUFFER
+layout(input_attachment_index = 0, binding = 0) uniform subpassInput inputNormal;		// Octahedral encoded normal output from subpass 0
+layout(input_attachment_index = 1, binding = 1) uniform subpassInput inputAlbedoSpec;	// Specular in alpha
+layout(input_attachment_index = 2, binding = 2) uniform subpassInput inputDepth;
+#else
+layout(input_attachment_index = 0, binding = 0) uniform subpassInput inputPos;			// Position output from subpass 0
+layout(input_attachment_index = 1, binding = 1) uniform subpassInput inputNormal;		// Normal output from subpass 0
+layout(input_attachment_index = 2, binding = 2) uniform subpassInput inputAlbedo;
+layout(input_attachment_index = 3, binding = 3) uniform subpassInput inputSpecular;
+#endif
+
+// UNIFORM DATA
+// - PointLight struct
+struct PointLight
+{
+	vec4 colour;
+	vec4 position;
+	vec4 intensityAndAttenuation;
+};
+
+// - SpotLight struct
+struct SpotLight
+{
+	vec4 colour;
+	vec4 position;
+	vec4 direction;
+	vec4 intensityAndAttenuation;
+	float innerCutOff;
+	float outerCutOff;
+};
+
+// - Lights buffer (view space)
+layout(std430, set = 0, binding = 4) readonly buffer lights
+{
+	uvec4 lightCount;		// x : point light count
+	SpotLight flashLight;
+	PointLight pointLights[];
+};
+
+// - View matrix to transform the g-buffer to view space
+layout(set = 0, binding = 6) uniform viewProjection
+{
+	mat4 P;
+	mat4 V;
+};
+
+// Clip plane near and far distance (view space) (specialization constants)
+layout(constant_id = 1) const float zNear = 0.1;
+layout(constant_id = 2) const float zFar = 300.;
+
+// Attenuated intensity below which a light no longer contributes (must match cluster_lights.comp)
+#define LIGHT_CUTOFF 0.01
+
+layout(location = 0) out vec4 outColour;
+
+// Function prototypes
+vec3 calcPointLight(PointLight light, vec3 fragPos, vec3 normal, vec3 viewDir, vec4 albedoSpecColour);
+float calcAttenuation(vec4 intensityAndAttenuation, float distance);
+vec3 decodeNormal(vec2 f);
+vec3 reconstructPosition(vec2 ndc, float depth);
+
+void main()
+{
+	PointLight light = pointLights[lightIndex];
+
+#ifdef PACKED_GBUFFER
+	vec3 fragPos_viewSpace = reconstructPosition(fragNDC, subpassLoad(inputDepth).x);
+#else
+	vec3 fragPos_viewSpace = (V * vec4(subpassLoad(inputPos).rgb, 1.0)).xyz;
+#endif
+
+	// The depth test only rejects geometry in front of the light, geometry behind its range is discarded here
+	vec3 fragToLight = light.position.xyz - fragPos_viewSpace;
+	if (dot(fragToLight, fragToLight) >= lightRadius * lightRadius)
+	{
+		discard;
+	}
+
+	// The view matrix has no scale so it also transforms normals
+#ifdef PACKED_GBUFFER
+	vec3 fragNormal_viewSpace = normalize(mat3(V) * decodeNormal(subpassLoad(inputNormal).rg));
+
+	vec4 albedoSpec = subpassLoad(inputAlbedoSpec);
+#else
+	vec3 fragNormal_viewSpace = normalize(mat3(V) * (subpassLoad(inputNormal).rgb * 2 - 1));
+
+	vec4 albedoSpec = vec4(subpassLoad(inputAlbedo).rgb, subpassLoad(inputSpecular).r);
+#endif
+
+	vec3 fragToViewDir = normalize(-fragPos_viewSpace);
+
+	outColour = vec4(calcPointLight(light, fragPos_viewSpace, fragNormal_viewSpace, fragToViewDir, albedoSpec), 0.0);
+}
+
+// Calculate a point light's contribution to fragment colour (see lighting.frag)
+vec3 calcPointLight(PointLight light, vec3 fragPos, vec3 normal, vec3 viewDir, vec4 albedoSpecColour)
+{
+	vec3 lightPos = light.position.xyz;
+
+	float distance = length(lightPos - fragPos);
+	vec3 lightDir = normalize(lightPos - fragPos);
+
+	// Blinn-Phong diffuse + specular
+	float diffuseFactor = max(dot(normal, lightDir), 0.0);
+	vec3 halfwayDir = normalize(lightDir + viewDir);
+	float specFactor = pow(max(dot(normal, halfwayDir), 0.0), 32);
+
+	vec3 colour =
+		albedoSpecColour.rgb * diffuseFactor +
+		vec3(albedoSpecColour.a) * specFactor;
+
+	// The cutoff is removed so the light fades to zero at the edge of its volume
+	float attenuation = max(calcAttenuation(light.intensityAndAttenuation, distance) - LIGHT_CUTOFF, 0.0);
+
+	return colour * light.colour.rgb * attenuation;
+}
+
+float calcAttenuation(vec4 intensityAndAttenuation, float distance)
+{
+	float denominator = intensityAndAttenuation.w + intensityAndAttenuation.z * distance + intensityAndAttenuation.y * distance * distance;
+
+	return intensityAndAttenuation.x / denominator;
+}
+
+// Inverse of the octahedral encoding written by geometry.frag
+vec3 decodeNormal(vec2 f)
+{
+	vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+
+	return normalize(n);
+}
+
+// View space position from a pixel's NDC position and depth (see lighting.frag)
+vec3 reconstructPosition(vec2 ndc, float depth)
+{
+	float linearDepth = zNear * zFar / (zFar - depth * (zFar - zNear));
+
+	vec2 viewRay = (ndc + vec2(P[2][0], P[2][1])) / vec2(P[0][0], P[1][1]);
+
+	return vec3(viewRay, -1.0) * linearDepth;
+}
@@ -0,0 +1,126 @@
+#version 450
+
+// Screen space quad bounding one point light's range, one instance is drawn per light
+// The quad is placed at the front of the light's sphere so the depth test rejects pixels whose geometry is in front of the light
+
+// - PointLight struct
+struct PointLight
+{
+	vec4 colour;
+	vec4 position;
+	vec4 intensityAndAttenuation;
+};
+
+// - SpotLight struct
+struct SpotLight
+{
+	vec4 colour;
+	vec4 position;
+	vec4 direction;
+	vec4 intensityAndAttenuation;
+	float innerCutOff;
+	float outerCutOff;
+};
+
+// - Lights buffer (view space)
+layout(std430, set = 0, binding = 4) readonly buffer lights
+{
+	uvec4 lightCount;		// x : point light count
+	SpotLight flashLight;
+	PointLight pointLights[];
+};
+
+layout(set = 0, binding = 6) uniform viewProjection
+{
+	mat4 P;
+	mat4 V;
+};
+
+// Clip plane near distance (view space)
+layout(constant_id = 1) const float zNear = 0.1;
+
+// Attenuated intensity below which a light no longer contributes (must match cluster_lights.comp)
+#define LIGHT_CUTOFF 0.01
+
+layout(location = 0) flat out uint lightIndex;
+layout(location = 1) flat out float lightRadius;
+layout(location = 2) out vec2 fragNDC;			// Quads are drawn with w = 1 so interpolation gives each pixel's NDC position
+
+// Two triangles covering the unit square
+const vec2 quadCorners[6] = vec2[](
+	vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(0.0, 1.0),
+	vec2(0.0, 1.0), vec2(1.0, 0.0), vec2(1.0, 1.0));
+
+// Function prototypes
+float calcLightRadius(PointLight light);
+
+void main()
+{
+	lightIndex = gl_InstanceIndex;
+	lightRadius = 0.0;
+	fragNDC = vec2(0.0);
+
+	PointLight light = pointLights[gl_InstanceIndex];
+	lightRadius = calcLightRadius(light);
+
+	if (lightRadius <= 0.0)
+	{
+		gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+		return;
+	}
+
+	vec3 lightPos_viewSpace = light.position.xyz;
+
+	// A light whose range crosses the near plane may cover any pixel so its quad fills the screen at the near plane
+	vec2 boundsMin = vec2(-1.0);
+	vec2 boundsMax = vec2(1.0);
+	float depth = 0.0;
+
+	if (-(lightPos_viewSpace.z + lightRadius) > zNear)
+	{
+		// Fit the quad around the projected corners of the sphere's view space bounding box
+		boundsMin = vec2(1e30);
+		boundsMax = vec2(-1e30);
+
+		for (uint corner = 0; corner < 8; ++corner)
+		{
+			vec3 cornerSign = vec3(corner & 1, (corner >> 1) & 1, corner >> 2) * 2.0 - 1.0;
+			vec4 corner_clipSpace = P * vec4(lightPos_viewSpace + cornerSign * lightRadius, 1.0);
+			vec2 corner_NDC = corner_clipSpace.xy / corner_clipSpace.w;
+
+			boundsMin = min(boundsMin, corner_NDC);
+			boundsMax = max(boundsMax, corner_NDC);
+		}
+
+		boundsMin = max(boundsMin, vec2(-1.0));
+		boundsMax = min(boundsMax, vec2(1.0));
+
+		// Depth of the nearest point of the sphere
+		vec4 front_clipSpace = P * vec4(0.0, 0.0, lightPos_viewSpace.z + lightRadius, 1.0);
+		depth = front_clipSpace.z / front_clipSpace.w;
+	}
+
+	fragNDC = mix(boundsMin, boundsMax, quadCorners[gl_VertexIndex]);
+	gl_Position = vec4(fragNDC, depth, 1.0);
+}
+
+// Distance at which the light's attenuated intensity falls to LIGHT_CUTOFF (see cluster_lights.comp)
+float calcLightRadius(PointLight light)
+{
+	if (light.colour.w <= 0.0)
+	{
+		return 0.0;
+	}
+
+	float intensity = light.intensityAndAttenuation.x;
+	float Kq = light.intensityAndAttenuation.y;
+	float Kl = light.intensityAndAttenuation.z;
+	float Kc = light.intensityAndAttenuation.w - intensity / LIGHT_CUTOFF;
+
+	if (Kq <= 0.0)
+	{
+		return Kl > 0.0 ? -Kc / Kl : 1e30;
+	}
+
+	return (-Kl + sqrt(max(Kl * Kl - 4.0 * Kq * Kc, 0.0))) / (2.0 * Kq);
+}
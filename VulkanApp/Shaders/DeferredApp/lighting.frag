@@ -3,10 +3,16 @@
 layout(location = 0) in vec2 UV;
 
 // INPUT ATTACHMENTS
+#ifdef PACKED_GBUFFER
+layout(input_attachment_index = 0, binding = 0) uniform subpassInput inputNormal;		// Octahedral encoded normal output from subpass 0
+layout(input_attachment_index = 1, binding = 1) uniform subpassInput inputAlbedoSpec;	// Specular in alpha
+layout(input_attachment_index = 2, binding = 2) uniform subpassInput inputDepth;
+#else
 layout(input_attachment_index = 0, binding = 0) uniform subpassInput inputPos;			// Position output from subpass 0
 layout(input_attachment_index = 1, binding = 1) uniform subpassInput inputNormal;		// Normal output from subpass 0
 layout(input_attachment_index = 2, binding = 2) uniform subpassInput inputAlbedo;	
 layout(input_attachment_index = 3, binding = 3) uniform subpassInput inputSpecular;	
+#endif
 
 // UNIFORM DATA
 // - PointLight struct
@@ -28,49 +34,98 @@ struct SpotLight
 	float outerCutOff;
 };
 
-// - Lights ubo
-#define POINT_LIGHT_COUNT 3
-layout(set = 0, binding = 4) uniform lights 
+// - Lights buffer (view space)
+layout(std430, set = 0, binding = 4) readonly buffer lights 
 {
-	PointLight pointLights[POINT_LIGHT_COUNT];
+	uvec4 lightCount;		// x : point light count
 	SpotLight flashLight;	
+	PointLight pointLights[];
 };
 
+// - Light clusters, each holds its light count followed by MAX_LIGHTS_PER_CLUSTER light indices
+layout(std430, set = 0, binding = 5) readonly buffer clusters
+{
+	uint clusterData[];
+};
+
+// - View matrix to transform the g-buffer to view space
+layout(set = 0, binding = 6) uniform viewProjection 
+{
+	mat4 P;
+	mat4 V;
+};
+
+// Clip plain near and far distance (view space) and cluster grid (specialization constants)
+layout(constant_id = 1) const float zNear = 0.1;
+layout(constant_id = 2) const float zFar = 300.;
+layout(constant_id = 6) const uint CLUSTER_GRID_X = 16;
+layout(constant_id = 7) const uint CLUSTER_GRID_Y = 9;
+layout(constant_id = 8) const uint CLUSTER_GRID_Z = 24;
+layout(constant_id = 9) const uint MAX_LIGHTS_PER_CLUSTER = 256;
+
+// Point lights are skipped when they are drawn as light volumes (light_volume.vert)
+layout(constant_id = 10) const bool CLUSTERED_LIGHTING = true;
+
+// Attenuated intensity below which a light no longer contributes (must match cluster_lights.comp)
+#define LIGHT_CUTOFF 0.01
+
 layout(location = 0) out vec4 outColour;
 
 // Function prototypes
 vec3 calcPointLight(PointLight light, vec3 fragPos, vec3 normal, vec3 viewDir, vec4 albedoSpecColour);
 vec3 calcSpotLight(SpotLight light, vec3 fragPos, vec3 normal, vec3 viewDir, vec4 albedoSpecColour);
 float calcAttenuation(vec4 intensityAndAttenuation, float distance);
+uint clusterOffset(vec2 uv, float viewDepth);
+vec3 decodeNormal(vec2 f);
+vec3 reconstructPosition(vec2 ndc, float depth);
 
 void main()
 {
 	// Get g-buffer data
+	// Lights are in view space so the g-buffer data is transformed to match
+	// The view matrix has no scale so it also transforms normals
+#ifdef PACKED_GBUFFER
+	vec3 fragPos_viewSpace = reconstructPosition(UV * 2.0 - 1.0, subpassLoad(inputDepth).x);
+
+	vec3 fragNormal_viewSpace = normalize(mat3(V) * decodeNormal(subpassLoad(inputNormal).rg));
+
+	vec4 albedoSpec = subpassLoad(inputAlbedoSpec);
+#else
 	vec3 fragPos_worldSpace = subpassLoad(inputPos).rgb;
 
 	vec3 fragNormal_worldSpace = normalize(subpassLoad(inputNormal).rgb * 2 - 1);
 
 	vec4 albedoSpec = vec4(subpassLoad(inputAlbedo).rgb, subpassLoad(inputSpecular).r);
 
+	vec3 fragPos_viewSpace = (V * vec4(fragPos_worldSpace, 1.0)).xyz;
+	vec3 fragNormal_viewSpace = normalize(mat3(V) * fragNormal_worldSpace);
+#endif
+
 	// Calculate Lighting
 	// view direction towards camera
-	vec3 viewPos_worldSpace = flashLight.position.xyz;
-	vec3 fragToViewDir = normalize(viewPos_worldSpace - fragPos_worldSpace);
+	vec3 fragToViewDir = normalize(-fragPos_viewSpace);
 
 	vec3 colour = 0.1 * albedoSpec.rgb; // default colour is ambient light
 
-	for (int i = 0; i < POINT_LIGHT_COUNT; ++i)
+	// Only the lights assigned to this fragment's cluster are evaluated
+	if (CLUSTERED_LIGHTING)
 	{
-		colour += calcPointLight(pointLights[i], 
-								fragPos_worldSpace,
-								fragNormal_worldSpace, 
-								fragToViewDir, 
-								albedoSpec);
+		uint cluster = clusterOffset(UV, -fragPos_viewSpace.z);
+		uint clusterLightCount = clusterData[cluster];
+
+		for (uint i = 0; i < clusterLightCount; ++i)
+		{
+			colour += calcPointLight(pointLights[clusterData[cluster + 1 + i]], 
+									fragPos_viewSpace,
+									fragNormal_viewSpace, 
+									fragToViewDir, 
+									albedoSpec);
+		}
 	}
 
 	colour += calcSpotLight(flashLight,
-							fragPos_worldSpace,
-							fragNormal_worldSpace, 
+							fragPos_viewSpace,
+							fragNormal_viewSpace, 
 							fragToViewDir, 
 							albedoSpec);
 
@@ -109,7 +164,8 @@ vec3 calcPointLight(PointLight light, vec3 fragPos, vec3 normal, vec3 viewDir, v
 
 
 	// Calculate attenuation factor
-	float attenuation = calcAttenuation(light.intensityAndAttenuation, distance);
+	// The cutoff is removed so the light fades to zero at the edge of the clusters it was assigned to
+	float attenuation = max(calcAttenuation(light.intensityAndAttenuation, distance) - LIGHT_CUTOFF, 0.0);
 
 	// Factor in light intensity, colour and attenuation
 	return colour * light.colour.rgb * attenuation;
@@ -163,4 +219,40 @@ float calcAttenuation(vec4 intensityAndAttenuation, float distance)
 	float denominator = intensityAndAttenuation.w + intensityAndAttenuation.z * distance + intensityAndAttenuation.y * distance * distance;
 
 	return intensityAndAttenuation.x / denominator;
+}
+
+// Offset of the cluster containing the fragment in the cluster buffer
+// Slices are spaced exponentially between the clip planes to match cluster_lights.comp
+uint clusterOffset(vec2 uv, float viewDepth)
+{
+	uvec2 tile = min(uvec2(uv * vec2(CLUSTER_GRID_X, CLUSTER_GRID_Y)), uvec2(CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1));
+
+	float slice = log(max(viewDepth, zNear) / zNear) * float(CLUSTER_GRID_Z) / log(zFar / zNear);
+	uint depthSlice = min(uint(slice), CLUSTER_GRID_Z - 1);
+
+	uint clusterIndex = tile.x + CLUSTER_GRID_X * (tile.y + CLUSTER_GRID_Y * depthSlice);
+
+	return clusterIndex * (MAX_LIGHTS_PER_CLUSTER + 1);
+}
+
+// Inverse of the octahedral encoding written by geometry.frag
+vec3 decodeNormal(vec2 f)
+{
+	vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+
+	return normalize(n);
+}
+
+// View space position from a pixel's NDC position and depth
+// The projection has no skew so the view ray at a depth of 1 only needs the diagonal and off-centre terms
+vec3 reconstructPosition(vec2 ndc, float depth)
+{
+	float linearDepth = zNear * zFar / (zFar - depth * (zFar - zNear));
+
+	vec2 viewRay = (ndc + vec2(P[2][0], P[2][1])) / vec2(P[0][0], P[1][1]);
+
+	return vec3(viewRay, -1.0) * linearDepth;
 }
\ No newline at end of file
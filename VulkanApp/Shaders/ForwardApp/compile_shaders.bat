@@ -1,4 +1,9 @@
-C:/VulkanSDK/1.2.141.2/Bin/glslangValidator.exe -V shader.vert
-C:/VulkanSDK/1.2.141.2/Bin/glslangValidator.exe -V shader.frag
-C:/VulkanSDK/1.2.141.2/Bin/glslangValidator.exe -o second_frag.spv -V second.frag
-pause
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -V shader.vert || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -V shader.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -DBINDLESS -o bindless_frag.spv -V shader.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -o depth_vert.spv -V depth.vert || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -o second_frag.spv -V second.frag || goto error
+exit /b 0
+
+:error
+exit /b 1
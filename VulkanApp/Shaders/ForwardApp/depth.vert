@@ -0,0 +1,29 @@
+#version 450		// Use GLSL 4.5
+
+// Depth prepass - only positions are transformed so the forward pass shades each visible fragment once
+
+// Vertex Input Bindings (bound in pipeline creation)
+layout(location = 0) in vec3 vertexPos;
+
+// UNIFORM DATA
+// - Matrices
+layout(set = 0, binding = 0) uniform viewProjection 
+{
+	mat4 P;
+	mat4 V;
+};
+
+// Push constant data
+// - Model matrix
+layout(push_constant) uniform PushModel 
+{
+	mat4 M;
+};
+
+// Depth must match the forward pass exactly as it is tested with VK_COMPARE_OP_EQUAL
+// The position is computed with the same expression as shader.vert
+invariant gl_Position;
+
+void main() {
+	gl_Position = P * (V * (M * vec4(vertexPos, 1.0)));
+}
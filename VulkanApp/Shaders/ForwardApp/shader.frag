@@ -1,18 +1,18 @@
 #version 450
 
+#ifdef BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
 // INPUTS
 // - UV
 layout(location = 0) in vec2 UV;
 
-// - worldSpace inputs
-layout(location = 1) in vec3 fragPos_worldSpace;
-
-// - tangentSpace inputs
-#define POINT_LIGHT_COUNT 3
-layout(location = 2) in vec3 viewPos_tangentSpace;
-layout(location = 3) in vec3 fragPos_tangentSpace;
-layout(location = 4) in vec3 viewDir_tangentSpace;
-layout(location = 5) in vec3 lightPos_tangentSpace[POINT_LIGHT_COUNT];
+// - viewSpace inputs
+layout(location = 1) in vec3 fragPos_viewSpace;
+layout(location = 2) in vec3 fragNormal_viewSpace;
+layout(location = 3) in vec3 fragTangent_viewSpace;
+layout(location = 4) in vec3 fragBitangent_viewSpace;
 
 // OUTPUTS
 layout(location = 0) out vec4 outColour; // Final output colour (must also have location)
@@ -38,24 +38,76 @@ struct SpotLight
 };
 
 // - Descriptor set data
+// - Matrices (projection is used to find the fragment's tile)
+layout(set = 0, binding = 0) uniform viewProjection 
+{
+	mat4 P;
+	mat4 V;
+};
 
-// - Lights
-layout(set = 0, binding = 1) uniform lights 
+// - Lights buffer (view space)
+layout(std430, set = 0, binding = 1) readonly buffer lights 
 {
-	PointLight pointLights[POINT_LIGHT_COUNT];
+	uvec4 lightCount;		// x : point light count
 	SpotLight flashLight;	
+	PointLight pointLights[];
+};
+
+// - Light clusters, each holds its light count followed by MAX_LIGHTS_PER_CLUSTER light indices
+layout(std430, set = 0, binding = 2) readonly buffer clusters
+{
+	uint clusterData[];
 };
 
 // - Descriptor set 1 ( texture samplers)
+#ifdef BINDLESS
+// Every texture is held in one array which is indexed through the material buffer using the per draw material ID
+struct Material {
+	uint diffuseID;
+	uint normalID;
+	uint specularID;
+	uint padding;
+};
+
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+layout(set = 1, binding = 1) readonly buffer MaterialBuffer {
+	Material materials[];
+};
+
+layout(push_constant) uniform PushMaterial 
+{
+	layout(offset = 64) uint materialID;
+};
+
+#define diffuseSampler textures[materials[materialID].diffuseID]
+#define normalSampler textures[materials[materialID].normalID]
+#define specularSampler textures[materials[materialID].specularID]
+#else
 layout(set = 1, binding = 0) uniform sampler2D diffuseSampler;
 layout(set = 1, binding = 1) uniform sampler2D normalSampler;
 layout(set = 1, binding = 2) uniform sampler2D specularSampler;
+#endif
 
 // Function prototypes
-vec3 calcPointLight(PointLight light, vec3 normal, vec3 viewDir, vec3 fragPos_tangentSpace, vec3 lightPos_tangentSpace, vec4 diffuseSpecColour);
-vec3 calcSpotLight(SpotLight light, vec3 normal, vec3 viewDir, vec3 lightDir_tangentSpace, vec3 fragPos_tangentSpace, vec3 lightPos_tangentSpace, vec4 diffuseSpecColour);
+vec3 calcPointLight(PointLight light, vec3 fragPos, vec3 normal, vec4 diffuseSpecColour);
+vec3 calcSpotLight(SpotLight light, vec3 fragPos, vec3 normal, vec4 diffuseSpecColour);
 float calcAttenuation(vec4 intensityAndAttenuation, float distance);
 
+uint clusterOffset(vec2 uv, float viewDepth);
+
+// Clip plain near and far distance (view space) (specialization constants)
+layout(constant_id = 1) const float zNear = 0.1;
+layout(constant_id = 2) const float zFar = 300.;
+
+// Cluster grid (specialization constants)
+layout(constant_id = 6) const uint CLUSTER_GRID_X = 16;
+layout(constant_id = 7) const uint CLUSTER_GRID_Y = 9;
+layout(constant_id = 8) const uint CLUSTER_GRID_Z = 24;
+layout(constant_id = 9) const uint MAX_LIGHTS_PER_CLUSTER = 256;
+
+// Attenuated intensity below which a light no longer contributes (must match cluster_lights.comp)
+#define LIGHT_CUTOFF 0.01
+
 void main () {
 	// Material Properties
 	vec4 diffuseSpecColour;
@@ -63,31 +115,37 @@ void main () {
 	diffuseSpecColour.a = texture(specularSampler, UV).r;
 	vec3 ambientColour = vec3(0.1, 0.1, 0.1) * diffuseSpecColour.rgb;
 
-	// Local normal (tangent space)
-	// Normal from normal map = 2*colour - 1 -> convert from range of [0,1] to [-1,1]
-	vec3 normal = normalize(texture(normalSampler, UV).rgb * 2 - 1);
+	// TBN matrix transforms from tangent to view space
+	// Interpolated vectors are renormalised and the tangent is re-orthogonalised against the normal
+	vec3 N = normalize(fragNormal_viewSpace);
+	vec3 T = normalize(fragTangent_viewSpace - dot(fragTangent_viewSpace, N) * N);
+	vec3 B = normalize(fragBitangent_viewSpace);
+	mat3 TBN = mat3(T, B, N);
 
-	// view direction towards camera
-	vec3 fragToViewDir = normalize(viewPos_tangentSpace - fragPos_tangentSpace);
+	// Normal from normal map = 2*colour - 1 -> convert from range of [0,1] to [-1,1]
+	vec3 normal = normalize(TBN * (texture(normalSampler, UV).rgb * 2 - 1));
 
 	vec3 colour = ambientColour;
 
-	for (int i = 0; i < POINT_LIGHT_COUNT; ++i)
+	// Find the fragment's tile from its projected position and its slice from view depth
+	vec4 fragPos_clipSpace = P * vec4(fragPos_viewSpace, 1.0);
+	vec2 screenUV = fragPos_clipSpace.xy / fragPos_clipSpace.w * 0.5 + 0.5;
+
+	// Only the lights assigned to this fragment's cluster are evaluated
+	uint cluster = clusterOffset(screenUV, -fragPos_viewSpace.z);
+	uint clusterLightCount = clusterData[cluster];
+
+	for (uint i = 0; i < clusterLightCount; ++i)
 	{
-		colour += calcPointLight(pointLights[i], 
+		colour += calcPointLight(pointLights[clusterData[cluster + 1 + i]], 
+								fragPos_viewSpace,
 								normal, 
-								fragToViewDir, 
-								fragPos_tangentSpace,
-								lightPos_tangentSpace[i], 
 								diffuseSpecColour);
 	}
 
 	colour += calcSpotLight(flashLight,
+							fragPos_viewSpace,
 							normal,
-							fragToViewDir,
-							viewDir_tangentSpace,
-							fragPos_tangentSpace,
-							viewPos_tangentSpace,
 							diffuseSpecColour);
 
 	// Set alpha channel to 1 default for all opaque
@@ -95,10 +153,16 @@ void main () {
 }
 
 // Calculate a point light's contribution to fragment colour
-vec3 calcPointLight(PointLight light, vec3 normal, vec3 viewDir, vec3 fragPos_tangentSpace, vec3 lightPos_tangentSpace, vec4 diffuseSpecColour)
+vec3 calcPointLight(PointLight light, vec3 fragPos, vec3 normal, vec4 diffuseSpecColour)
 {
-	// Direction of the light (tangent space)
-	vec3 lightDir = normalize(lightPos_tangentSpace - fragPos_tangentSpace);
+	vec3 lightPos = light.position.xyz;
+	vec3 viewDir = normalize(-fragPos);
+
+	// Distance to light
+	float distance = length(lightPos - fragPos);
+
+	// Direction of the light (view space)
+	vec3 lightDir = normalize(lightPos - fragPos);
 
 	// Lambert cosine - Light intensity directly proportional to n.l
 	// Clamped between 1 and 0
@@ -106,10 +170,6 @@ vec3 calcPointLight(PointLight light, vec3 normal, vec3 viewDir, vec3 fragPos_ta
 	// Min is 0 since when theta >= 90 the light is either perpendicular to the surface or not incident
 	float diffuseFactor = max(dot(normal, lightDir), 0.0);
 
-	// Direction in which triangle reflects light
-	// Note that -l is the direction of the incident light on the triangle
-	vec3 reflectDir = reflect(-lightDir, normal);
-
 	// Half way vector for Blinn-Phong model of specular component
 	// This is the average between the lightDir and viewDir
 	vec3 halfwayDir = normalize(lightDir + viewDir);
@@ -121,25 +181,27 @@ vec3 calcPointLight(PointLight light, vec3 normal, vec3 viewDir, vec3 fragPos_ta
 	vec3 colour =
 		diffuseSpecColour.rgb * diffuseFactor +
 		vec3(diffuseSpecColour.a) * pow(specFactor,32);
-	
-	// Distance to light (calculate in world space)
-	float distance = length(light.position.xyz - fragPos_worldSpace);
 
 	// Calculate attenuation factor
-	float attenuation = calcAttenuation(light.intensityAndAttenuation, distance);
+	// The cutoff is removed so the light fades to zero at the edge of the clusters it was assigned to
+	float attenuation = max(calcAttenuation(light.intensityAndAttenuation, distance) - LIGHT_CUTOFF, 0.0);
 
 	// Factor in light intensity, colour and attenuation
 	return colour * light.colour.rgb * attenuation;
 
 }
 
-vec3 calcSpotLight(SpotLight light, vec3 normal, vec3 viewDir, vec3 lightDir_tangentSpace, vec3 fragPos_tangentSpace, vec3 lightPos_tangentSpace, vec4 diffuseSpecColour)
+vec3 calcSpotLight(SpotLight light, vec3 fragPos, vec3 normal, vec4 diffuseSpecColour)
 {
-	// Direction of the light (tangent space)
-	vec3 fragToLightDir = normalize(lightPos_tangentSpace - fragPos_tangentSpace);
+	vec3 lightPos = light.position.xyz;
+	vec3 lightDir = light.direction.xyz;
+	vec3 viewDir = normalize(-fragPos);
+
+	// Direction of the light (view space)
+	vec3 fragToLightDir = normalize(lightPos - fragPos);
 
 	// Get angle between spotDir (direction spot light is pointing) and lightDir (fragment to light )
-	float cosTheta = dot(lightDir_tangentSpace, normalize(-fragToLightDir));
+	float cosTheta = dot(lightDir, normalize(-fragToLightDir));
 
 	// if cosTheta greater than cosPhi (light cutoff) then the fragment is lit by the spot light
 	if (cosTheta > light.outerCutOff)
@@ -150,15 +212,14 @@ vec3 calcSpotLight(SpotLight light, vec3 normal, vec3 viewDir, vec3 lightDir_tan
 
 		// Standard light calculations
 		float diffuseFactor = max(dot(normal, fragToLightDir), 0.0);
-		vec3 reflectDir = reflect(-fragToLightDir, normal);
 		vec3 halfwayDir = normalize(fragToLightDir + viewDir);
 		float specFactor = max(dot(normal, halfwayDir), 0.0);
 		vec3 colour =
 		diffuseSpecColour.rgb * diffuseFactor +
 		vec3(diffuseSpecColour.a) * pow(specFactor,32);
 	
-		// Distance to light (calculate in world space)
-		float distance = length(light.position.xyz - fragPos_worldSpace);
+		// Distance to light
+		float distance = length(lightPos - fragPos);
 
 		// Calculate attenuation factor
 		float attenuation = calcAttenuation(light.intensityAndAttenuation, distance);
@@ -179,3 +240,17 @@ float calcAttenuation(vec4 intensityAndAttenuation, float distance)
 
 	return intensityAndAttenuation.x / denominator;
 }
+
+// Offset of the cluster containing the fragment in the cluster buffer
+// Slices are spaced exponentially between the clip planes to match cluster_lights.comp
+uint clusterOffset(vec2 uv, float viewDepth)
+{
+	uvec2 tile = min(uvec2(clamp(uv, 0.0, 1.0) * vec2(CLUSTER_GRID_X, CLUSTER_GRID_Y)), uvec2(CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1));
+
+	float slice = log(max(viewDepth, zNear) / zNear) * float(CLUSTER_GRID_Z) / log(zFar / zNear);
+	uint depthSlice = min(uint(slice), CLUSTER_GRID_Z - 1);
+
+	uint clusterIndex = tile.x + CLUSTER_GRID_X * (tile.y + CLUSTER_GRID_Y * depthSlice);
+
+	return clusterIndex * (MAX_LIGHTS_PER_CLUSTER + 1);
+}
@@ -11,37 +11,13 @@ layout(location = 4) in vec2 UV;
 // OUTPUTS
 layout(location = 0) out vec2 vertexUV;
 
-// - worldSpace outputs
-layout(location = 1) out vec3 vertexPos_worldSpace;
-
-// - tangentSpace outputs
-#define POINT_LIGHT_COUNT 3
-layout(location = 2) out vec3 viewPos_tangentSpace;
-layout(location = 3) out vec3 vertexPos_tangentSpace;
-layout(location = 4) out vec3 viewDir_tangentSpace;
-layout(location = 5) out vec3 lightPos_tangentSpace[POINT_LIGHT_COUNT]; // Place last as this consumes several locations
+// - viewSpace outputs, the TBN matrix is built per fragment so the outputs do not grow with the light count
+layout(location = 1) out vec3 vertexPos_viewSpace;
+layout(location = 2) out vec3 vertexNormal_viewSpace;
+layout(location = 3) out vec3 vertexTangent_viewSpace;
+layout(location = 4) out vec3 vertexBitangent_viewSpace;
 
 // UNIFORM DATA
-
-// - PointLight struct
-struct PointLight
-{
-	vec4 colour;
-	vec4 position;
-	vec4 intensityAndAttenuation;
-};
-
-// - SpotLight struct
-struct SpotLight
-{
-	vec4 colour;
-	vec4 position;
-	vec4 direction;
-	vec4 intensityAndAttenuation;
-	float innerCutOff;
-	float outerCutOff;
-};
-
 // - Descriptor set data
 // - Matrices
 layout(set = 0, binding = 0) uniform viewProjection 
@@ -50,13 +26,6 @@ layout(set = 0, binding = 0) uniform viewProjection
 	mat4 V;
 };
 
-// - Lights
-layout(set = 0, binding = 1) uniform lights 
-{
-	PointLight pointLights[POINT_LIGHT_COUNT];
-	SpotLight flashLight;	
-};
-
 // Push constant data
 // - Model matrix
 layout(push_constant) uniform PushModel 
@@ -64,8 +33,8 @@ layout(push_constant) uniform PushModel
 	mat4 M;
 };
 
-// Function prototypes
-mat3 calculateInverseTBN(mat3 MV);
+// Depth must match the prepass exactly as it is tested with VK_COMPARE_OP_EQUAL (see depth.vert)
+invariant gl_Position;
 
 void main() {
 	// Shortcuts
@@ -74,53 +43,18 @@ void main() {
 	// Vertex UV
 	vertexUV = UV;
 
-	// Vertex position (world space)
-	vertexPos_worldSpace = (M * vec4(vertexPos, 1.0)).xyz;
-	
-	// Get positions in view space
-	vec3 vertexPos_viewSpace = (V * vec4(vertexPos_worldSpace, 1.0)).xyz;
-	vec3 viewPos_viewSpace = vec3(0.0, 0.0, 0.0);
+	// Vertex position (view space)
+	vertexPos_viewSpace = (V * (M * vec4(vertexPos, 1.0))).xyz;
 
-	// View direction in view space
-	vec3 viewDir_viewSpace = vec3(0.0, 0.0, -1.0);
-
-	// Get inverse TBN matrix
-	mat3 invTBN = calculateInverseTBN(mat3(MV));
-	
-	// Convert relevant vectors to tangent space
-	viewPos_tangentSpace = invTBN * viewPos_viewSpace;
-	vertexPos_tangentSpace = invTBN * vertexPos_viewSpace;
-	viewDir_tangentSpace = invTBN * viewDir_viewSpace;
-
-	for (int i = 0; i < POINT_LIGHT_COUNT; ++i)
-	{
-		vec3 lightPos_viewSpace = (V * pointLights[i].position).xyz;
-		lightPos_tangentSpace[i] = invTBN * lightPos_viewSpace;
-	}
-
-	// Vertex position (clip space)
-	gl_Position = P * vec4(vertexPos_viewSpace, 1.0); 
-}
-
-// Use this matrix to transform from view space to tangent space
-mat3 calculateInverseTBN(mat3 MV)
-{
 	// Create normal matrix from MV matrix
 	// Must take inverse transpose to correct any scaling
 	// Consider perforiming this operation outside of shaders as inverse is costly
 	mat3 normalMatrix = transpose(inverse(mat3(MV)));
 
-	vec3 tangent_viewSpace = normalize(normalMatrix * tangent);
-	vec3 bitangent_viewSpace = normalize(normalMatrix * bitangent);
-	vec3 normal_viewSpace = normalize(normalMatrix * normal);
-
-	// Create TBN matrix (transform tangent to camera space)
-	// Get inverse of TBN matrix to transfrom camera to tangent space
-	// (components are othogonal so can take transpose)
-	mat3 invTBN = transpose(mat3(
-		tangent_viewSpace,
-		bitangent_viewSpace,
-		normal_viewSpace));
+	vertexNormal_viewSpace = normalMatrix * normal;
+	vertexTangent_viewSpace = normalMatrix * tangent;
+	vertexBitangent_viewSpace = normalMatrix * bitangent;
 
-	return invTBN;
-}
\ No newline at end of file
+	// Vertex position (clip space)
+	gl_Position = P * (V * (M * vec4(vertexPos, 1.0)));
+}
@@ -1,5 +1,8 @@
 #version 450
 
+// One direction of a separable bilateral blur, the blur subpasses run it horizontally then vertically
+// Taps are weighted by distance and by how closely their depth and normal match the centre pixel so occlusion does not bleed across edges
+
 // INPUTS
 // - UV
 layout(location = 0) in vec2 UV;
@@ -7,23 +10,92 @@ layout(location = 0) in vec2 UV;
 // OUTPUTS
 layout(location = 0) out vec4 blurOut;
 
-// - Descriptor set 1 (texture samplers)
+// - Descriptor set bindings
+// Occlusion, depth and normals are read texel for texel, all three match the SSAO resolution
 layout(set = 0, binding = 0) uniform sampler2D ssaoSampler;
+layout(set = 0, binding = 1) uniform sampler2D depthSampler;
+layout(set = 0, binding = 2) uniform sampler2D normalSampler;
+
+// PARAMETERS
+// Clip plane near and far distance (view space), kernel radius in texels and direction (specialization constants)
+layout(constant_id = 1) const float zNear = 0.1;
+layout(constant_id = 2) const float zFar = 300.;
+layout(constant_id = 12) const int BLUR_RADIUS = 4;
+layout(constant_id = 13) const bool BLUR_VERTICAL = false;
+
+// Relative depth difference at which a tap's weight is halved
+#define DEPTH_TOLERANCE 0.02
+// Sharpness of the normal weight
+#define NORMAL_POWER 8.0
+
+// FUNCTION PROTOTYPES
+float lineariseDepth(float depth);
+vec3 fetchNormal(ivec2 texel);
+vec3 decodeNormal(vec2 f);
 
-// Average a 4x4 rectangle around each pixel to create a blur 
-// (box blur kernel)
 void main () {
-	vec2 texelSize = 1. / vec2(textureSize(ssaoSampler, 0)); // TextureSize retrieves texture dimensions
+	ivec2 targetSize = textureSize(ssaoSampler, 0);
+
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	ivec2 direction = BLUR_VERTICAL ? ivec2(0, 1) : ivec2(1, 0);
+
+	float centreDepth = lineariseDepth(texelFetch(depthSampler, pixel, 0).x);
+	vec3 centreNormal = fetchNormal(pixel);
+
+	// Gaussian falloff reaching roughly 10% at the kernel edge
+	float sigma = max(float(BLUR_RADIUS) * 0.5, 0.5);
+	float falloff = 1.0 / (2.0 * sigma * sigma);
 
 	float result = 0.0;
-	for (int x = -2; x < 2; ++x)
+	float totalWeight = 0.0;
+
+	for (int i = -BLUR_RADIUS; i <= BLUR_RADIUS; ++i)
 	{
-		for (int y = -2; y < 2; ++y)
-		{
-			vec2 offset = vec2(float(x), float(y)) * texelSize;
-			result += texture(ssaoSampler, UV + offset).r;
-		}
+		ivec2 texel = clamp(pixel + direction * i, ivec2(0), targetSize - 1);
+
+		float depth = lineariseDepth(texelFetch(depthSampler, texel, 0).x);
+		vec3 normal = fetchNormal(texel);
+
+		float spatialWeight = exp(-float(i * i) * falloff);
+		float depthWeight = DEPTH_TOLERANCE / (DEPTH_TOLERANCE + abs(depth - centreDepth) / centreDepth);
+		float normalWeight = pow(max(dot(normal, centreNormal), 0.0), NORMAL_POWER);
+
+		// The centre tap always has full weight so the total is never zero
+		float weight = spatialWeight * depthWeight * normalWeight;
+		result += texelFetch(ssaoSampler, texel, 0).r * weight;
+		totalWeight += weight;
 	}
+
 	// Normalize and output result
-	blurOut = vec4(vec3(result / (4. * 4.)), 1.0);
-}
\ No newline at end of file
+	blurOut = vec4(vec3(result / totalWeight), 1.0);
+}
+
+float lineariseDepth(float depth)
+{
+	// Convert depth to NDC
+	float z = depth * 2. - 1.;
+
+	float linearDepth = (2. * zNear * zFar) / (zFar + zNear - z * (zFar - zNear));
+
+	return linearDepth;
+}
+
+vec3 fetchNormal(ivec2 texel)
+{
+#ifdef PACKED_GBUFFER
+	return decodeNormal(texelFetch(normalSampler, texel, 0).rg);
+#else
+	return normalize(texelFetch(normalSampler, texel, 0).rgb * 2 - 1);
+#endif
+}
+
+// Inverse of the octahedral encoding written by geometry.frag
+vec3 decodeNormal(vec2 f)
+{
+	vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+
+	return normalize(n);
+}
@@ -1,6 +1,18 @@
-C:/VulkanSDK/1.2.141.2/Bin/glslangValidator.exe -o geometry_vert.spv -V geometry.vert
-C:/VulkanSDK/1.2.141.2/Bin/glslangValidator.exe -o geometry_frag.spv -V geometry.frag
-C:/VulkanSDK/1.2.141.2/Bin/glslangValidator.exe -o ssao_frag.spv -V ssao.frag
-C:/VulkanSDK/1.2.141.2/Bin/glslangValidator.exe -o blur_frag.spv -V blur.frag
-C:/VulkanSDK/1.2.141.2/Bin/glslangValidator.exe -o lighting_frag.spv -V lighting.frag
-pause
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -o geometry_vert.spv -V geometry.vert || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -o geometry_frag.spv -V geometry.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -DBINDLESS -o geometry_bindless_frag.spv -V geometry.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -DPACKED_GBUFFER -o geometry_packed_frag.spv -V geometry.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -DBINDLESS -DPACKED_GBUFFER -o geometry_bindless_packed_frag.spv -V geometry.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -o ssao_frag.spv -V ssao.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -DPACKED_GBUFFER -o ssao_packed_frag.spv -V ssao.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -o downsample_frag.spv -V downsample.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -o blur_frag.spv -V blur.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -DPACKED_GBUFFER -o blur_packed_frag.spv -V blur.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -o upsample_frag.spv -V upsample.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -o gtao_comp.spv -V gtao.comp || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -o lighting_frag.spv -V lighting.frag || goto error
+C:/VulkanSDK/1.2.170.0/Bin/glslangValidator.exe -DPACKED_GBUFFER -o lighting_packed_frag.spv -V lighting.frag || goto error
+exit /b 0
+
+:error
+exit /b 1
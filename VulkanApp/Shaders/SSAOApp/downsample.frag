@@ -0,0 +1,51 @@
+#version 450
+
+// Downsample depth and normals for reduced resolution SSAO
+// Each output pixel picks one depth from its DOWNSAMPLE x DOWNSAMPLE footprint, alternating the nearest and farthest in a checkerboard
+// so both the foreground and background of a depth edge survive, the normal of the chosen texel is copied unchanged
+
+// INPUTS
+// - UV
+layout(location = 0) in vec2 UV;
+
+// OUTPUTS
+layout(location = 0) out vec4 depthOut;
+layout(location = 1) out vec4 normalOut;		// Same encoding as the G-buffer normal
+
+// - Descriptor set bindings (full resolution)
+layout(set = 0, binding = 0) uniform sampler2D depthSampler;
+layout(set = 0, binding = 1) uniform sampler2D normalSampler;
+
+// Resolution divisor (specialization constant)
+layout(constant_id = 11) const int DOWNSAMPLE = 2;
+
+void main () {
+	ivec2 targetSize = textureSize(depthSampler, 0);
+
+	// First texel of the footprint centred on this pixel
+	ivec2 footprint = ivec2(floor(UV * vec2(targetSize) - 0.5 * float(DOWNSAMPLE) + 0.5));
+
+	bool selectFarthest = ((int(gl_FragCoord.x) + int(gl_FragCoord.y)) & 1) != 0;
+
+	ivec2 selectedTexel = clamp(footprint, ivec2(0), targetSize - 1);
+	float selectedDepth = texelFetch(depthSampler, selectedTexel, 0).x;
+
+	for (int y = 0; y < DOWNSAMPLE; ++y)
+	{
+		for (int x = 0; x < DOWNSAMPLE; ++x)
+		{
+			ivec2 texel = clamp(footprint + ivec2(x, y), ivec2(0), targetSize - 1);
+			float depth = texelFetch(depthSampler, texel, 0).x;
+
+			// Depth is non-linear but monotonic so the comparison matches view space distance
+			if (selectFarthest ? depth > selectedDepth : depth < selectedDepth)
+			{
+				selectedDepth = depth;
+				selectedTexel = texel;
+			}
+		}
+	}
+
+	depthOut = vec4(selectedDepth);
+	normalOut = texelFetch(normalSampler, selectedTexel, 0);
+}
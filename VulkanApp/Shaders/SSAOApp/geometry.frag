@@ -1,5 +1,9 @@
 #version 450
 
+#ifdef BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
 // INPUTS
 // - UV
 layout(location = 0) in vec2 UV;
@@ -10,23 +14,60 @@ layout(location = 2) in vec3 normal_viewSpace;
 layout(location = 3) in vec3 tangent_viewSpace;
 
 // OUTPUTS
+#ifdef PACKED_GBUFFER
+// Octahedral encoded normal + albedo with specular in alpha
+layout(location = 0) out vec2 gNormal;
+layout(location = 1) out vec4 gAlbedoSpec;
+#else
 layout(location = 0) out vec4 gNormal; 
 layout(location = 1) out vec4 gAlbedo; 
 layout(location = 2) out vec4 gSpecular; 
+#endif
 
 
 // - Descriptor set 1 (texture samplers)
+#ifdef BINDLESS
+// Every texture is held in one array which is indexed through the material buffer using the per draw material ID
+struct Material {
+	uint diffuseID;
+	uint normalID;
+	uint specularID;
+	uint padding;
+};
+
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+layout(set = 1, binding = 1) readonly buffer MaterialBuffer {
+	Material materials[];
+};
+
+layout(push_constant) uniform PushMaterial 
+{
+	layout(offset = 64) uint materialID;
+};
+
+#define albedoSampler textures[materials[materialID].diffuseID]
+#define normalSampler textures[materials[materialID].normalID]
+#define specularSampler textures[materials[materialID].specularID]
+#else
 layout(set = 1, binding = 0) uniform sampler2D albedoSampler;
 layout(set = 1, binding = 1) uniform sampler2D normalSampler;
 layout(set = 1, binding = 2) uniform sampler2D specularSampler;
+#endif
 
+// Function prototypes
+vec2 encodeNormal(vec3 n);
 
 void main () {
+#ifdef PACKED_GBUFFER
+	// Albedo + specular map
+	gAlbedoSpec = vec4(texture(albedoSampler, UV).rgb, texture(specularSampler, UV).r);
+#else
 	// Albedo map
 	gAlbedo = texture(albedoSampler, UV);
 
 	// Specular map
 	gSpecular = texture(specularSampler, UV).rgba;
+#endif
 
 	// Calculate TBN matrix
 	vec3 T = normalize(tangent_viewSpace);
@@ -37,11 +78,22 @@ void main () {
 
 	// Normal map in viewspace - convert from range of [0,1] to [-1,1] when sampling
 	vec3 normal_viewSpace = TBN * (texture(normalSampler, UV).rgb * 2 - 1.0);
+#ifdef PACKED_GBUFFER
+	gNormal = encodeNormal(normalize(normal_viewSpace));
+#else
 	// Convert back to range of [0,1] as values will be clamped at 0 when stored in RGB texture
 	normal_viewSpace = normalize(normal_viewSpace) * 0.5 + 0.5;
 	gNormal = vec4(normal_viewSpace, 1.0);
+#endif
+}
 
+// Octahedral encoding - project the unit normal onto an octahedron and fold the lower half over the upper half
+// Components are in the range [-1,1]
+vec2 encodeNormal(vec3 n)
+{
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
 
+	vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
 
-	
+	return n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * signs;
 }
\ No newline at end of file
@@ -34,6 +34,10 @@ layout(push_constant) uniform PushModel
 // Function prototypes
 mat3 calculateTBN(mat3 M);
 
+// With GTAO the G-buffer pass tests against the depth prepass with VK_COMPARE_OP_EQUAL
+// Both pipelines use this shader but depth must still match exactly between them
+invariant gl_Position;
+
 void main() {
 	// Vertex UV
 	vertexUV = UV;
@@ -8,9 +8,14 @@ layout(location = 1) in vec4 viewRay;
 // INPUT ATTACHMENTS
 layout(input_attachment_index = 0, binding = 1) uniform subpassInput inputDepth;	
 layout(input_attachment_index = 1, binding = 2) uniform subpassInput inputNormal;		
+#ifdef PACKED_GBUFFER
+layout(input_attachment_index = 2, binding = 3) uniform subpassInput inputAlbedoSpec;	// Specular in alpha
+layout(input_attachment_index = 3, binding = 4) uniform subpassInput inputBlur;	
+#else
 layout(input_attachment_index = 2, binding = 3) uniform subpassInput inputAlbedo;	
 layout(input_attachment_index = 3, binding = 4) uniform subpassInput inputSpecular;	
-layout(input_attachment_index = 5, binding = 5) uniform subpassInput inputBlur;	
+layout(input_attachment_index = 4, binding = 5) uniform subpassInput inputBlur;	
+#endif
 
 // UNIFORM DATA
 // - PointLight struct
@@ -32,12 +37,18 @@ struct SpotLight
 	float outerCutOff;
 };
 
-// - Lights ubo
-#define POINT_LIGHT_COUNT 3
-layout(set = 0, binding = 6) uniform lights 
+// - Lights buffer (view space)
+layout(std430, set = 0, binding = 6) readonly buffer lights 
 {
-	PointLight pointLights[POINT_LIGHT_COUNT];
+	uvec4 lightCount;		// x : point light count
 	SpotLight flashLight;	
+	PointLight pointLights[];
+};
+
+// - Light clusters, each holds its light count followed by MAX_LIGHTS_PER_CLUSTER light indices
+layout(std430, set = 0, binding = 7) readonly buffer clusters
+{
+	uint clusterData[];
 };
 
 layout(location = 0) out vec4 outColour;
@@ -48,10 +59,21 @@ vec3 calcSpotLight(SpotLight light, vec3 fragPos, vec3 normal, vec4 albedoSpecCo
 float calcAttenuation(vec4 intensityAndAttenuation, float distance);
 
 float lineariseDepth(float depth);
+vec3 decodeNormal(vec2 f);
+uint clusterOffset(vec2 uv, float viewDepth);
+
+// Clip plain near and far distance (view space) (specialization constants)
+layout(constant_id = 1) const float zNear = 0.1;
+layout(constant_id = 2) const float zFar = 300.;
+
+// Cluster grid (specialization constants)
+layout(constant_id = 6) const uint CLUSTER_GRID_X = 16;
+layout(constant_id = 7) const uint CLUSTER_GRID_Y = 9;
+layout(constant_id = 8) const uint CLUSTER_GRID_Z = 24;
+layout(constant_id = 9) const uint MAX_LIGHTS_PER_CLUSTER = 256;
 
-// Clip plain near and far distance (view space)
-const float zNear = 0.1;
-const float zFar = 300.;
+// Attenuated intensity below which a light no longer contributes (must match cluster_lights.comp)
+#define LIGHT_CUTOFF 0.01
 
 void main()
 {
@@ -62,9 +84,15 @@ void main()
 
 	vec3 fragPos_viewSpace = viewRay.xyz * linearDepth;
 
+#ifdef PACKED_GBUFFER
+	vec3 fragNormal_viewSpace = decodeNormal(subpassLoad(inputNormal).rg);
+
+	vec4 albedoSpec = subpassLoad(inputAlbedoSpec);
+#else
 	vec3 fragNormal_viewSpace = normalize(subpassLoad(inputNormal).rgb * 2 - 1);
 
 	vec4 albedoSpec = vec4(subpassLoad(inputAlbedo).rgb, subpassLoad(inputSpecular).r);
+#endif
 
 	// Get SSAO data
 	float ambientOcclusion = subpassLoad(inputBlur).r;
@@ -72,9 +100,13 @@ void main()
 	// Calculate Lighting
 	vec3 colour = 0.3 * albedoSpec.rgb * ambientOcclusion; // default colour is ambient light * AO factor
 
-	for (int i = 0; i < POINT_LIGHT_COUNT; ++i)
+	// Only the lights assigned to this fragment's cluster are evaluated
+	uint cluster = clusterOffset(UV, linearDepth);
+	uint clusterLightCount = clusterData[cluster];
+
+	for (uint i = 0; i < clusterLightCount; ++i)
 	{
-		colour += calcPointLight(pointLights[i], 
+		colour += calcPointLight(pointLights[clusterData[cluster + 1 + i]], 
 								fragPos_viewSpace,
 								fragNormal_viewSpace, 
 								albedoSpec);
@@ -121,7 +153,8 @@ vec3 calcPointLight(PointLight light, vec3 fragPos, vec3 normal, vec4 albedoSpec
 
 
 	// Calculate attenuation factor
-	float attenuation = calcAttenuation(light.intensityAndAttenuation, distance);
+	// The cutoff is removed so the light fades to zero at the edge of the clusters it was assigned to
+	float attenuation = max(calcAttenuation(light.intensityAndAttenuation, distance) - LIGHT_CUTOFF, 0.0);
 
 	// Factor in light intensity, colour and attenuation
 	return colour * light.colour.rgb * attenuation;
@@ -186,4 +219,29 @@ float lineariseDepth(float depth)
 	float linearDepth = (2. * zNear * zFar) / (zFar + zNear - z * (zFar - zNear));
 
 	return linearDepth;
+}
+
+// Inverse of the octahedral encoding written by geometry.frag
+vec3 decodeNormal(vec2 f)
+{
+	vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+
+	return normalize(n);
+}
+
+// Offset of the cluster containing the fragment in the cluster buffer
+// Slices are spaced exponentially between the clip planes to match cluster_lights.comp
+uint clusterOffset(vec2 uv, float viewDepth)
+{
+	uvec2 tile = min(uvec2(uv * vec2(CLUSTER_GRID_X, CLUSTER_GRID_Y)), uvec2(CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1));
+
+	float slice = log(max(viewDepth, zNear) / zNear) * float(CLUSTER_GRID_Z) / log(zFar / zNear);
+	uint depthSlice = min(uint(slice), CLUSTER_GRID_Z - 1);
+
+	uint clusterIndex = tile.x + CLUSTER_GRID_X * (tile.y + CLUSTER_GRID_Y * depthSlice);
+
+	return clusterIndex * (MAX_LIGHTS_PER_CLUSTER + 1);
 }
\ No newline at end of file
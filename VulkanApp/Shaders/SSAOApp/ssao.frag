@@ -20,10 +20,13 @@ layout(set = 0, binding = 1) uniform sampler2D depthSampler;
 layout(set = 0, binding = 2) uniform sampler2D normalSampler;
 layout(set = 0, binding = 3) uniform sampler2D noiseSampler;
 
-#define SAMPLE_COUNT 64
+// Kernel holds up to MAX_SAMPLE_COUNT samples, SAMPLE_COUNT are used (specialization constant)
+#define MAX_SAMPLE_COUNT 64
+layout(constant_id = 5) const int SAMPLE_COUNT = MAX_SAMPLE_COUNT;
+
 layout(set = 0, binding = 4) uniform uboSSAO 
 {
-	vec4 ssaoKernel[SAMPLE_COUNT];		// Positions to sample
+	vec4 ssaoKernel[MAX_SAMPLE_COUNT];		// Positions to sample
 	float radius;						// Affects radius sampled for SSAO
 	float bias;							// Bias introduced to reduce shadow acne
 	float power;						// Raise the occlusion factor by this power
@@ -31,23 +34,27 @@ layout(set = 0, binding = 4) uniform uboSSAO
 
 // FUNCTION PROTOTYPES
 float lineariseDepth(float depth);
+vec3 decodeNormal(vec2 f);
 
 // PARAMETERS
-// tile noise texture over screen, based on screen dimensions divided by noise size (noise should be a 4x4 texture)
-#define SCREEN_WIDTH 1920
-#define SCREEN_HEIGHT 1080
-const vec2 noiseScale = vec2(SCREEN_WIDTH/4.0, SCREEN_HEIGHT/4.0); 
-
-// Clip plain near and far distance (view space)
-const float zNear = 0.1;
-const float zFar = 300.;
+// Clip plain near and far distance (view space) (specialization constants)
+layout(constant_id = 1) const float zNear = 0.1;
+layout(constant_id = 2) const float zFar = 300.;
 
 void main () {
+	// Depth and normals match the SSAO resolution (full or downsampled) so screen UVs are used directly
 	// Get sample values - reconstruct view space position from depth
 	float depth = texture(depthSampler, UV).x;
 	vec3 fragPos = viewRay.xyz * lineariseDepth(depth);
 
+#ifdef PACKED_GBUFFER
+	vec3 normal = decodeNormal(texture(normalSampler, UV).rg);
+#else
 	vec3 normal = normalize(texture(normalSampler, UV).rgb * 2 - 1);
+#endif
+	// tile noise texture over screen, based on screen dimensions divided by noise size
+	// Sizes are queried from the textures so nothing needs rebuilding when the window is resized
+	vec2 noiseScale = vec2(textureSize(depthSampler, 0)) / vec2(textureSize(noiseSampler, 0));
 	vec3 randomRotationVector = texture(noiseSampler, UV * noiseScale).xyz;
 
 	// Create TBN: Tangent -> View space
@@ -75,7 +82,8 @@ void main () {
 		offset.xyz = offset.xyz * 0.5 + 0.5;	// transform to range [0,1] to sample texture correctly
 
 		// Get sample depth - muliply by view ray to get view space depth
-		float sampleDepth = viewRay.z * lineariseDepth(texture(depthSampler, offset.xy).x);
+		vec2 sampleUV = clamp(offset.xy, 0.0, 1.0);
+		float sampleDepth = viewRay.z * lineariseDepth(texture(depthSampler, sampleUV).x);
 
 		// Range check
 		float rangeCheck = smoothstep(0.0, 1.0, radius / abs(fragPos.z - sampleDepth));
@@ -84,7 +92,7 @@ void main () {
 	}
 
 	// Take 1 - normalized occlusion factor to find contribution to ambient lighting
-	float occlusion = 1 - (occlusionFactor / SAMPLE_COUNT);
+	float occlusion = 1 - (occlusionFactor / float(SAMPLE_COUNT));
 	occlusion = pow(occlusion, power);
 	occlusionOut = vec4(vec3(occlusion), 1.0);	
 }
@@ -97,4 +105,15 @@ float lineariseDepth(float depth)
 	float linearDepth = (2. * zNear * zFar) / (zFar + zNear - z * (zFar - zNear));
 
 	return linearDepth;
+}
+
+// Inverse of the octahedral encoding written by geometry.frag
+vec3 decodeNormal(vec2 f)
+{
+	vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+
+	return normalize(n);
 }
\ No newline at end of file
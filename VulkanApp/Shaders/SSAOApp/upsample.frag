@@ -0,0 +1,82 @@
+#version 450
+
+// Depth aware upsample of reduced resolution SSAO
+// The four nearest low resolution texels are weighted bilinearly and by how close their depth is to the full resolution depth
+// so occlusion does not bleed across depth edges
+
+// INPUTS
+// - UV
+layout(location = 0) in vec2 UV;
+
+// INPUT ATTACHMENTS
+layout(input_attachment_index = 0, binding = 0) uniform subpassInput inputDepth;		// Full resolution depth
+
+// - Descriptor set bindings (low resolution)
+layout(set = 0, binding = 1) uniform sampler2D lowDepthSampler;
+layout(set = 0, binding = 2) uniform sampler2D occlusionSampler;
+
+// OUTPUTS
+layout(location = 0) out vec4 occlusionOut;
+
+// PARAMETERS
+// Clip plane near and far distance (view space) (specialization constants)
+layout(constant_id = 1) const float zNear = 0.1;
+layout(constant_id = 2) const float zFar = 300.;
+
+// Relative depth difference at which a texel's weight is halved
+#define DEPTH_TOLERANCE 0.01
+
+// FUNCTION PROTOTYPES
+float lineariseDepth(float depth);
+
+void main () {
+	ivec2 lowSize = textureSize(lowDepthSampler, 0);
+
+	// Position in low resolution texels, relative to the first of the four texels surrounding this pixel
+	vec2 lowPos = UV * vec2(lowSize) - 0.5;
+	ivec2 lowTexel = ivec2(floor(lowPos));
+	vec2 f = lowPos - vec2(lowTexel);
+
+	float depth = lineariseDepth(subpassLoad(inputDepth).x);
+
+	const ivec2 offsets[4] = ivec2[](ivec2(0, 0), ivec2(1, 0), ivec2(0, 1), ivec2(1, 1));
+	float bilinearWeights[4] = float[]((1.0 - f.x) * (1.0 - f.y), f.x * (1.0 - f.y), (1.0 - f.x) * f.y, f.x * f.y);
+
+	float occlusion = 0.0;
+	float totalWeight = 0.0;
+
+	// Fallback when every texel is rejected (e.g. thin geometry missing from the low resolution depth)
+	float nearestOcclusion = 1.0;
+	float nearestDifference = 1e30;
+
+	for (int i = 0; i < 4; ++i)
+	{
+		ivec2 texel = clamp(lowTexel + offsets[i], ivec2(0), lowSize - 1);
+
+		float sampleOcclusion = texelFetch(occlusionSampler, texel, 0).r;
+		float difference = abs(lineariseDepth(texelFetch(lowDepthSampler, texel, 0).x) - depth) / depth;
+
+		float weight = bilinearWeights[i] * DEPTH_TOLERANCE / (DEPTH_TOLERANCE + difference);
+		occlusion += sampleOcclusion * weight;
+		totalWeight += weight;
+
+		if (difference < nearestDifference)
+		{
+			nearestDifference = difference;
+			nearestOcclusion = sampleOcclusion;
+		}
+	}
+
+	occlusion = totalWeight > 1e-4 ? occlusion / totalWeight : nearestOcclusion;
+	occlusionOut = vec4(vec3(occlusion), 1.0);
+}
+
+float lineariseDepth(float depth)
+{
+	// Convert depth to NDC
+	float z = depth * 2. - 1.;
+
+	float linearDepth = (2. * zNear * zFar) / (zFar + zNear - z * (zFar - zNear));
+
+	return linearDepth;
+}
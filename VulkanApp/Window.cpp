@@ -26,6 +26,28 @@ bool Window::createWindow()
 	return window != nullptr;
 }
 
+void Window::toggleFullscreen()
+{
+	if (fullscreen())
+	{
+		glfwSetWindowMonitor(window, nullptr, mWindowedX, mWindowedY, mWidth, mHeight, GLFW_DONT_CARE);
+	}
+	else
+	{
+		glfwGetWindowPos(window, &mWindowedX, &mWindowedY);
+		glfwGetWindowSize(window, &mWidth, &mHeight);
+
+		GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+		const GLFWvidmode* mode = glfwGetVideoMode(monitor);
+		glfwSetWindowMonitor(window, monitor, 0, 0, mode->width, mode->height, mode->refreshRate);
+	}
+}
+
+bool Window::fullscreen() const
+{
+	return glfwGetWindowMonitor(window) != nullptr;
+}
+
 void Window::defaultInit()
 {
 	// Initialise GLFW
@@ -34,8 +56,8 @@ void Window::defaultInit()
 	// Set GLFW to not work with OpenGL
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 
-	// don't allow window resize to prevent everything being redrawn
-	glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+	// Resizing only recreates the swapchain and size dependent attachments (pipelines use dynamic viewport/scissor)
+	glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
 	glfwWindowHint(GLFW_DOUBLEBUFFER, GL_FALSE);
 }
@@ -12,6 +12,9 @@ public:
 
 	bool createWindow();
 
+	// Switch between windowed and fullscreen on the primary monitor
+	void toggleFullscreen();
+	bool fullscreen() const;
 
 
 	GLFWwindow* window;
@@ -20,6 +23,10 @@ private:
 	int mWidth;
 	int mHeight;
 
+	// Windowed placement restored when leaving fullscreen
+	int mWindowedX{ 0 };
+	int mWindowedY{ 0 };
+
 	void defaultInit();
 };
 
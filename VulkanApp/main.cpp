@@ -1,6 +1,8 @@
 #include <stdexcept>
 #include <vector>
 #include <iostream>
+#include <iomanip>
+#include <sstream>
 
 #include "Applications/ForwardApp.h"
 #include "Applications/DeferredApp.h"
@@ -9,6 +11,78 @@
 #include "Pawn.h"
 #include "InputHandlerMouse.h"
 
+// Returns true on the frame a key is first pressed
+bool keyPressed(GLFWwindow* window, int key, std::map<int, int>& lastState)
+{
+	int state = glfwGetKey(window, key);
+	bool pressed = state == GLFW_PRESS && lastState[key] != GLFW_PRESS;
+	lastState[key] = state;
+
+	return pressed;
+}
+
+// F1-F3 : select present mode (FIFO, MAILBOX, IMMEDIATE)
+// F4 : toggle waiting for the GPU before input is sampled
+// F5 : cycle the CPU frame limit
+// F11 : toggle fullscreen
+void handlePresentationControls(Window& displayWindow, VulkanRenderer& renderer, std::map<int, int>& lastState)
+{
+	GLFWwindow* window = displayWindow.window;
+
+	const std::vector<float> frameLimits = { 0.0f, 60.0f, 120.0f, 144.0f };
+
+	if (keyPressed(window, GLFW_KEY_F1, lastState)) renderer.setPresentMode(VK_PRESENT_MODE_FIFO_KHR);
+	if (keyPressed(window, GLFW_KEY_F2, lastState)) renderer.setPresentMode(VK_PRESENT_MODE_MAILBOX_KHR);
+	if (keyPressed(window, GLFW_KEY_F3, lastState)) renderer.setPresentMode(VK_PRESENT_MODE_IMMEDIATE_KHR);
+
+	FramePacer& pacer = renderer.framePacer();
+
+	if (keyPressed(window, GLFW_KEY_F4, lastState))
+	{
+		pacer.setSleepBeforeInput(!pacer.sleepBeforeInput());
+	}
+
+	if (keyPressed(window, GLFW_KEY_F5, lastState))
+	{
+		auto current = std::find(frameLimits.begin(), frameLimits.end(), pacer.targetFrameRate());
+		size_t next = current == frameLimits.end() ? 0 : (current - frameLimits.begin() + 1) % frameLimits.size();
+		pacer.setTargetFrameRate(frameLimits[next]);
+	}
+
+	if (keyPressed(window, GLFW_KEY_F11, lastState))
+	{
+		displayWindow.toggleFullscreen();
+	}
+}
+
+// Display present mode, pacing settings and latency in the window title
+void updateWindowTitle(GLFWwindow* window, VulkanRenderer& renderer)
+{
+	const FramePacer& pacer = renderer.framePacer();
+	const LatencyStats& stats = pacer.latencyStats();
+
+	std::string presentMode;
+	switch (renderer.presentMode())
+	{
+	case VK_PRESENT_MODE_FIFO_KHR:			presentMode = "FIFO";			break;
+	case VK_PRESENT_MODE_FIFO_RELAXED_KHR:	presentMode = "FIFO_RELAXED";	break;
+	case VK_PRESENT_MODE_MAILBOX_KHR:		presentMode = "MAILBOX";		break;
+	case VK_PRESENT_MODE_IMMEDIATE_KHR:		presentMode = "IMMEDIATE";		break;
+	default:								presentMode = "UNKNOWN";		break;
+	}
+
+	std::ostringstream title;
+	title << std::fixed << std::setprecision(2)
+		<< "Vulkan Renderer | " << presentMode
+		<< " | limit: " << (pacer.targetFrameRate() > 0.0f ? std::to_string(static_cast<int>(pacer.targetFrameRate())) : "off")
+		<< " | sleep before input: " << (pacer.sleepBeforeInput() ? "on" : "off")
+		<< " | frame: " << stats.frameTime << "ms"
+		<< " | input->submit: " << stats.inputToSubmit << "ms"
+		<< " | input->present: " << stats.inputToPresent << "ms";
+
+	glfwSetWindowTitle(window, title.str().c_str());
+}
+
 int main()
 {
 	Window displayWindow("Vulkan Renderer", 1920, 1080);
@@ -27,6 +101,12 @@ int main()
 		return EXIT_FAILURE;
 	}
 
+	// Recreate the swapchain when the framebuffer is resized (window resize, fullscreen toggle)
+	glfwSetWindowUserPointer(displayWindow.window, &vulkanRenderer);
+	glfwSetFramebufferSizeCallback(displayWindow.window, [](GLFWwindow* window, int width, int height) {
+		static_cast<VulkanRenderer*>(glfwGetWindowUserPointer(window))->notifyWindowResized();
+		});
+
 	float angle = 0.0f;
 	float deltaTime = 0.0f;
 	float lastTime = 0.0f;
@@ -46,12 +126,18 @@ int main()
 	std::unique_ptr<InputHandler> inputHandler(new InputHandlerMouse(displayWindow.window));
 	inputHandler->init();
 
+	std::map<int, int> lastKeyState;
+	float lastTitleUpdate = 0.0f;
 
 	// Loop until closed
 	while (glfwGetKey(displayWindow.window, GLFW_KEY_ESCAPE) != GLFW_PRESS
 		&& !glfwWindowShouldClose(displayWindow.window))
 	{
+		// Limit frame rate (and optionally wait for the GPU) before sampling input
+		vulkanRenderer.paceFrame();
+
 		glfwPollEvents();
+		handlePresentationControls(displayWindow, vulkanRenderer, lastKeyState);
 
 		float now = glfwGetTime();
 		deltaTime = now - lastTime;
@@ -66,6 +152,8 @@ int main()
 				command->execute(player);
 			}
 		}
+		vulkanRenderer.framePacer().markInputSampled(inputHandler->sampleTime());
+
 		cameraView = player.generateView();
 		vulkanRenderer.updateCameraView(cameraView);
 
@@ -74,6 +162,12 @@ int main()
 
 
 		vulkanRenderer.draw();
+
+		if (now - lastTitleUpdate > 0.5f)
+		{
+			updateWindowTitle(displayWindow.window, vulkanRenderer);
+			lastTitleUpdate = now;
+		}
 	}
 
 